@@ -0,0 +1,155 @@
+/**
+ *  @filename   :   api_json.h
+ *  @brief      :   Slideshow API responses parsed into fixed structs
+ *
+ *  The body is read into a fixed buffer and parsed in place with a field
+ *  filter, so only the fields below take room in the document and every
+ *  value is copied into an array owned by the result. No String holds the
+ *  body and nothing points into a shared document afterwards.
+ *
+ *  The parsers only need ArduinoJson, tools/api_json_bench.cpp builds
+ *  them on a PC.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef API_JSON_H
+#define API_JSON_H
+
+#include <string.h>
+#include <ArduinoJson.h>
+
+// largest API body kept, longer ones fail to parse
+#define API_BODY_SIZE       768
+// filtered documents hold a handful of values, strings stay in the body
+#define API_DOC_SIZE        128
+#define API_FILENAME_LEN    64
+#define API_FIELD_LEN       51      // EEPROM fields take up to 50 chars
+
+struct SlideShowStatus {
+    char filename[API_FILENAME_LEN];
+    bool gotosleep;
+    long secondsdelay;
+    bool didcall;
+    bool retry;
+};
+
+struct DeviceInfo {
+    char accountId[API_FIELD_LEN];
+    char slideShowId[API_FIELD_LEN];
+    char subscriptionKey[API_FIELD_LEN];
+};
+
+// copy a string value, false when it is missing or does not fit
+static inline bool CopyField(char* dst, size_t size, JsonVariantConst value) {
+    const char* s = value.as<const char*>();
+    if (s == NULL || strlen(s) >= size) {
+        dst[0] = 0;
+        return false;
+    }
+    strcpy(dst, s);
+    return true;
+}
+
+/**
+ *  @brief: DSlideShowStart/DSlideShow answer. json is parsed in place and
+ *          changed; missing fields read as empty, false and 0.
+ */
+static inline DeserializationError ParseSlideShow(char* json, size_t len, SlideShowStatus* status) {
+    StaticJsonDocument<64> filter;
+    filter["fileName"] = true;
+    filter["gotoSleep"] = true;
+    filter["secondsDelay"] = true;
+
+    StaticJsonDocument<API_DOC_SIZE> doc;
+    DeserializationError err = deserializeJson(doc, json, len, DeserializationOption::Filter(filter));
+    if (err) {
+        return err;
+    }
+    CopyField(status->filename, sizeof(status->filename), doc["fileName"]);
+    status->gotosleep = doc["gotoSleep"].as<bool>();
+    status->secondsdelay = doc["secondsDelay"].as<long>();
+    return err;
+}
+
+/**
+ *  @brief: GetDeviceInfo answer, parsed in place. Returns false unless all
+ *          three fields are there and fit.
+ */
+static inline bool ParseDeviceInfo(char* json, size_t len, DeviceInfo* info, DeserializationError* err) {
+    StaticJsonDocument<64> filter;
+    filter["AccountID"] = true;
+    filter["SlideShowId"] = true;
+    filter["subscriptionKey"] = true;
+
+    StaticJsonDocument<API_DOC_SIZE> doc;
+    *err = deserializeJson(doc, json, len, DeserializationOption::Filter(filter));
+    if (*err) {
+        return false;
+    }
+    bool ok = CopyField(info->accountId, sizeof(info->accountId), doc["AccountID"]);
+    ok &= CopyField(info->slideShowId, sizeof(info->slideShowId), doc["SlideShowId"]);
+    ok &= CopyField(info->subscriptionKey, sizeof(info->subscriptionKey), doc["subscriptionKey"]);
+    return ok;
+}
+
+#ifdef ARDUINO
+/**
+ *  @brief: fixed buffer HTTPClient::writeToStream() reads the body into.
+ *          writeToStream() undoes chunked transfer encoding and reads to
+ *          the end, so the keep-alive socket stays usable.
+ */
+class BodyBuffer : public Stream {
+public:
+    BodyBuffer() : len(0), overflow(false) { data[0] = 0; }
+
+    size_t write(uint8_t c) {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* buf, size_t size) {
+        // keep reading past the end so the connection is drained
+        size_t n = size;
+        if (n > sizeof(data) - 1 - len) {
+            n = sizeof(data) - 1 - len;
+            overflow = true;
+        }
+        memcpy(data + len, buf, n);
+        len += n;
+        data[len] = 0;
+        return size;
+    }
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    void flush() {}
+
+    char data[API_BODY_SIZE];
+    size_t len;
+    bool overflow;
+};
+#endif
+
+#endif
+
+/* END OF FILE */
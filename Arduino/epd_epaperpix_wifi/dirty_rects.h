@@ -0,0 +1,165 @@
+/**
+ *  @filename   :   dirty_rects.h
+ *  @brief      :   Changed areas of a frame, merged into few upload windows
+ *
+ *  Rectangles are in the panel's native layout: byte columns and rows of
+ *  one plane, so a window never splits a byte. Two rectangles are merged
+ *  when the bytes the union adds cost less than a window of its own
+ *  (DIRTY_WINDOW_COST); past DIRTY_MAX_RECTS the cheapest pair is merged
+ *  regardless. Only depends on the C standard library so it can be built
+ *  on a host, see tools/framebuffer_bench.cpp.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DIRTY_RECTS_H
+#define DIRTY_RECTS_H
+
+#include <stdint.h>
+
+// windows kept apart before new ones are merged into their cheapest
+// neighbour; scattered pixels need many, 8 bytes each
+#define DIRTY_MAX_RECTS     256
+// what one more window costs in bytes: window, counter and data commands
+#define DIRTY_WINDOW_COST   24
+
+struct DirtyRect {
+    uint16_t col0;              // first byte column
+    uint16_t row0;              // first row
+    uint16_t col1;              // byte column after the last one
+    uint16_t row1;              // row after the last one
+
+    uint32_t Bytes(void) const {
+        return (uint32_t)(col1 - col0) * (row1 - row0);
+    }
+};
+
+class DirtyRects {
+public:
+    DirtyRects() : count(0) {}
+
+    void Clear(void) {
+        count = 0;
+    }
+
+    int Count(void) const {
+        return count;
+    }
+
+    const DirtyRect& operator[](int i) const {
+        return rects[i];
+    }
+
+    /**
+     *  @brief: bytes of one plane the windows cover
+     */
+    uint32_t Bytes(void) const {
+        uint32_t n = 0;
+        for (int i = 0; i < count; i++) {
+            n += rects[i].Bytes();
+        }
+        return n;
+    }
+
+    /**
+     *  @brief: mark byte columns [col0, col1) of rows [row0, row1)
+     */
+    void Add(uint16_t col0, uint16_t row0, uint16_t col1, uint16_t row1) {
+        if (col0 >= col1 || row0 >= row1) {
+            return;
+        }
+        DirtyRect r = { col0, row0, col1, row1 };
+        Absorb(&r);
+        if (count == DIRTY_MAX_RECTS) {
+            MergeCheapest(&r);
+        }
+        rects[count++] = r;
+    }
+
+private:
+    static uint16_t Min(uint16_t a, uint16_t b) {
+        return a < b ? a : b;
+    }
+
+    static uint16_t Max(uint16_t a, uint16_t b) {
+        return a > b ? a : b;
+    }
+
+    static DirtyRect Union(const DirtyRect& a, const DirtyRect& b) {
+        DirtyRect u = { Min(a.col0, b.col0), Min(a.row0, b.row0), Max(a.col1, b.col1), Max(a.row1, b.row1) };
+        return u;
+    }
+
+    static uint32_t Overlap(const DirtyRect& a, const DirtyRect& b) {
+        uint16_t c0 = Max(a.col0, b.col0), c1 = Min(a.col1, b.col1);
+        uint16_t r0 = Max(a.row0, b.row0), r1 = Min(a.row1, b.row1);
+        return c0 < c1 && r0 < r1 ? (uint32_t)(c1 - c0) * (r1 - r0) : 0;
+    }
+
+    /**
+     *  @brief: bytes merging a and b adds to the upload, less the window
+     *          it saves. Merging pays when this is not above 0.
+     */
+    static long MergeCost(const DirtyRect& a, const DirtyRect& b) {
+        long covered = (long)a.Bytes() + b.Bytes() - Overlap(a, b);
+        return (long)Union(a, b).Bytes() - covered - DIRTY_WINDOW_COST;
+    }
+
+    // merge every rectangle into r that is cheaper together with it; a
+    // grown r may make earlier ones cheap too, so start over after each
+    void Absorb(DirtyRect* r) {
+        for (int i = 0; i < count; i++) {
+            if (MergeCost(rects[i], *r) <= 0) {
+                *r = Union(rects[i], *r);
+                rects[i] = rects[--count];
+                i = -1;
+            }
+        }
+    }
+
+    // full: merge r with the window that grows least from it. Only
+    // pairs with r are tried, so a long run of scattered pixels stays
+    // linear in the windows kept
+    void MergeCheapest(DirtyRect* r) {
+        int bi = 0;
+        long best = MergeCost(rects[0], *r);
+        for (int i = 1; i < count; i++) {
+            long cost = MergeCost(rects[i], *r);
+            if (cost < best) {
+                best = cost;
+                bi = i;
+            }
+        }
+        *r = Union(rects[bi], *r);
+        rects[bi] = rects[--count];
+        Absorb(r);
+    }
+
+    int count;
+    DirtyRect rects[DIRTY_MAX_RECTS];
+};
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,262 @@
+/**
+ *  @filename   :   dither.h
+ *  @brief      :   Dithers 8-bit RGB or gray rows to a colour panel's
+ *                  palette, packed in its native format
+ *
+ *  Floyd-Steinberg error diffusion in fixed point: errors are kept in
+ *  16ths in two rows of int16, the row being drawn and the one below.
+ *  Ordered dithering adds an 8x8 Bayer threshold instead and needs no
+ *  error rows. Pixels fill a byte from its top bits down, like the
+ *  drivers' Clear(). Only depends on the C standard library so it can be
+ *  built on a host, see tools/dither_bench.cpp.
+ *
+ *  Two threads can share a frame, one on the even rows and one on the
+ *  odd ones: a row only reads error cells the row above has finished
+ *  with, so each waits for the other to be two pixels ahead. The output
+ *  is the same as from one thread.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DITHER_H
+#define DITHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DITHER_MAX_COLOURS      8
+// pixels between two progress updates when rows are shared by threads
+#define DITHER_SYNC_PIXELS      16
+// ordered dithering: threshold range, the step between palette colours
+#define DITHER_ORDERED_SPREAD   255
+// what a thread does while the other one is not far enough ahead; the
+// other core really runs, so spinning is the quickest
+#ifndef DITHER_WAIT
+#define DITHER_WAIT()
+#endif
+
+enum DitherMode { DITHER_FLOYD_STEINBERG, DITHER_ORDERED };
+
+/**
+ *  Colours a panel shows; code i of the native format is rgb[i]
+ */
+struct DitherPalette {
+    const char* name;
+    uint8_t bpp;                // bits per pixel of the native format
+    uint8_t count;              // colours in use
+    uint8_t white;              // code that pads the last byte of a row
+    uint8_t rgb[DITHER_MAX_COLOURS][3];
+};
+
+// 7-colour ACeP, 4 bpp: epd7in3f, epd4in01f
+static const DitherPalette ditherAcep = {
+    "ACeP", 4, 7, 1,
+    { { 0, 0, 0 }, { 255, 255, 255 }, { 0, 255, 0 }, { 0, 0, 255 },
+      { 255, 0, 0 }, { 255, 255, 0 }, { 255, 128, 0 } }
+};
+
+// black, white, yellow, red, 2 bpp: epd7in3g, epd3in97g, epd2in66g, epd2in13g
+static const DitherPalette ditherBwry = {
+    "BWRY", 2, 4, 1,
+    { { 0, 0, 0 }, { 255, 255, 255 }, { 255, 255, 0 }, { 255, 0, 0 } }
+};
+
+// ordered dithering thresholds, 0-63
+static const uint8_t ditherBayer[8][8] = {
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+class Ditherer {
+public:
+    Ditherer() : palette(NULL), width(0), channels(3), mode(DITHER_FLOYD_STEINBERG), errors(NULL) {}
+
+    /**
+     *  @brief: int16 entries of the error rows for width pixels
+     */
+    static size_t ErrorSize(unsigned long width) {
+        return 2 * 3 * width;
+    }
+
+    /**
+     *  @brief: rows of width pixels with ch bytes each, 3 for RGB and 1
+     *          for gray. errors holds ErrorSize(width) entries; ordered
+     *          dithering does not use it and may pass NULL.
+     */
+    bool Begin(const DitherPalette& pal, unsigned long w, uint8_t ch, DitherMode m, int16_t* err) {
+        if (pal.bpp == 0 || 8 % pal.bpp != 0 || pal.count == 0 || pal.count > DITHER_MAX_COLOURS ||
+            w == 0 || (ch != 1 && ch != 3) || (m == DITHER_FLOYD_STEINBERG && err == NULL)) {
+            return false;
+        }
+        palette = &pal;
+        width = w;
+        channels = ch;
+        mode = m;
+        errors = err;
+        if (errors != NULL) {
+            memset(errors, 0, ErrorSize(width) * sizeof(int16_t));
+        }
+        return true;
+    }
+
+    /**
+     *  @brief: native bytes of one row
+     */
+    unsigned long RowBytes(void) const {
+        return (width * palette->bpp + 7) / 8;
+    }
+
+    /**
+     *  @brief: dither row y of src into RowBytes() bytes at dst. Rows go
+     *          in order from 0, a new frame starts with Begin().
+     */
+    void Row(unsigned long y, const uint8_t* src, uint8_t* dst) {
+        Row(y, src, dst, NULL, NULL);
+    }
+
+    /**
+     *  @brief: Row() for a thread sharing the frame. done is where this
+     *          thread publishes y * width + pixels finished, above where
+     *          the thread on the rows next to it does.
+     */
+    void Row(unsigned long y, const uint8_t* src, uint8_t* dst, const uint32_t* above, uint32_t* done) {
+        const int ppb = 8 / palette->bpp;
+        const bool diffuse = mode == DITHER_FLOYD_STEINBERG;
+        int16_t* cur = diffuse ? errors + (y & 1) * 3 * width : NULL;
+        int16_t* next = diffuse ? errors + ((y + 1) & 1) * 3 * width : NULL;
+        int16_t threshold[8];
+        if (!diffuse) {
+            for (int i = 0; i < 8; i++) {
+                int t = (2 * ditherBayer[y & 7][i] + 1 - 64) * DITHER_ORDERED_SPREAD;
+                threshold[i] = (t + (t < 0 ? -64 : 64)) / 128;
+            }
+        }
+        const uint32_t base = y * width;
+        uint32_t ready = 0;
+        int32_t carry[3] = { 0, 0, 0 };
+        uint8_t acc = 0;
+        int filled = 0;
+        for (unsigned long x = 0; x < width; x++) {
+            if (diffuse && above != NULL && y > 0) {
+                // the row above has added its last error to cell x at x + 1
+                uint32_t want = base - width + (x + 2 < width ? x + 2 : width);
+                while (ready < want) {
+                    ready = __atomic_load_n(above, __ATOMIC_ACQUIRE);
+                    if (ready < want) {
+                        DITHER_WAIT();
+                    }
+                }
+            }
+            const uint8_t* s = src + x * channels;
+            int v[3];
+            int32_t fine[3];        // diffusion: v in 16ths of a level, before rounding
+            for (int c = 0; c < 3; c++) {
+                int in = s[channels == 3 ? c : 0];
+                if (diffuse) {
+                    // taken and cleared, the row below this one's adds to it next
+                    int16_t* e = cur + x * 3 + c;
+                    int32_t f = in * 16 + *e + carry[c];
+                    *e = 0;
+                    fine[c] = f < 0 ? 0 : (f > 255 * 16 ? 255 * 16 : f);
+                    v[c] = (fine[c] + 8) >> 4;
+                    continue;
+                }
+                in += threshold[x & 7];
+                v[c] = in < 0 ? 0 : (in > 255 ? 255 : in);
+            }
+            uint8_t code = Nearest(v);
+            if (diffuse) {
+                const uint8_t* p = palette->rgb[code];
+                for (int c = 0; c < 3; c++) {
+                    // error of the unrounded value, in 16ths; the 1/16 share
+                    // takes what rounding the others left, none is lost
+                    int32_t err = fine[c] - p[c] * 16;
+                    int32_t e3 = (3 * err + 8) >> 4;
+                    int32_t e5 = (5 * err + 8) >> 4;
+                    int32_t e7 = (7 * err + 8) >> 4;
+                    if (x > 0) {
+                        next[(x - 1) * 3 + c] += e3;
+                    }
+                    next[x * 3 + c] += e5;
+                    if (x + 1 < width) {
+                        next[(x + 1) * 3 + c] += err - e3 - e5 - e7;
+                    }
+                    carry[c] = e7;
+                }
+            }
+            acc = (acc << palette->bpp) | code;
+            if (++filled == ppb) {
+                *dst++ = acc;
+                acc = 0;
+                filled = 0;
+            }
+            if (done != NULL && (x + 1) % DITHER_SYNC_PIXELS == 0) {
+                __atomic_store_n(done, base + x + 1, __ATOMIC_RELEASE);
+            }
+        }
+        if (filled > 0) {
+            while (filled++ < ppb) {
+                acc = (acc << palette->bpp) | palette->white;
+            }
+            *dst = acc;
+        }
+        if (done != NULL) {
+            __atomic_store_n(done, base + width, __ATOMIC_RELEASE);
+        }
+    }
+
+private:
+    // palette code closest to v in RGB
+    uint8_t Nearest(const int* v) const {
+        uint8_t best = 0;
+        int32_t bestDist = INT32_MAX;
+        for (uint8_t i = 0; i < palette->count; i++) {
+            const uint8_t* p = palette->rgb[i];
+            int32_t dr = v[0] - p[0], dg = v[1] - p[1], db = v[2] - p[2];
+            int32_t dist = dr * dr + dg * dg + db * db;
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    const DitherPalette* palette;
+    unsigned long width;
+    uint8_t channels;
+    DitherMode mode;
+    int16_t* errors;
+};
+
+#endif
+
+/* END OF FILE */
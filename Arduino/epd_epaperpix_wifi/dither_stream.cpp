@@ -0,0 +1,232 @@
+/**
+ *  @filename   :   dither_stream.cpp
+ *  @brief      :   Dithered rows streamed to the panel, on one or two cores
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <esp_heap_caps.h>
+#include "dither_stream.h"
+
+DitherStream::DitherStream() : elapsedMs(0), epd(NULL), palette(NULL), mode(DITHER_FLOYD_STEINBERG), channels(3),
+    errors(NULL), rowBytes(0), rowsPerStage(0), sent(0), read(NULL), readArg(NULL), shared(false), failed(false),
+    helperDone(NULL) {
+    memset(input, 0, sizeof(input));
+    memset(stage, 0, sizeof(stage));
+    memset(progress, 0, sizeof(progress));
+}
+
+DitherStream::~DitherStream() {
+    End();
+}
+
+/**
+ *  @brief: set up for panel, whose native format must be the palette's.
+ *          channels is 3 for RGB rows and 1 for gray ones.
+ */
+bool DitherStream::Begin(Epd& panel, const DitherPalette& pal, uint8_t ch, DitherMode m) {
+    End();
+    // drivers that leave the format open have it in the plane size
+    unsigned char bpp = panel.bits_per_pixel;
+    if (bpp == 0 && panel.width > 0 && panel.height > 0) {
+        bpp = panel.blockSize * 8 / (panel.width * panel.height);
+    }
+    if (bpp != pal.bpp || panel.steps != 1) {
+        Serial.printf("[DITHER] %s palette does not fit the panel\n", pal.name);
+        return false;
+    }
+    // the error rows are read and written for every pixel, internal RAM
+    errors = (int16_t*)heap_caps_malloc(Ditherer::ErrorSize(panel.width) * sizeof(int16_t),
+                                        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (errors == NULL || !ditherer.Begin(pal, panel.width, ch, m, errors)) {
+        End();
+        return false;
+    }
+    rowBytes = ditherer.RowBytes();
+    rowsPerStage = panel.streamBufferSize / rowBytes;
+    if (rowBytes * panel.height != panel.blockSize || rowsPerStage == 0) {
+        Serial.println("[DITHER] rows do not fit the plane or the stage");
+        End();
+        return false;
+    }
+    for (int i = 0; i < DITHER_STAGES; i++) {
+        stage[i] = (uint8_t*)heap_caps_malloc(rowsPerStage * rowBytes, MALLOC_CAP_DMA);
+        if (stage[i] == NULL) {
+            End();
+            return false;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        input[i] = (uint8_t*)heap_caps_malloc(panel.width * ch, MALLOC_CAP_8BIT);
+        if (input[i] == NULL) {
+            End();
+            return false;
+        }
+    }
+    helperDone = xSemaphoreCreateBinary();
+    epd = &panel;
+    palette = &pal;
+    channels = ch;
+    mode = m;
+    return true;
+}
+
+void DitherStream::End(void) {
+    heap_caps_free(errors);
+    errors = NULL;
+    for (int i = 0; i < DITHER_STAGES; i++) {
+        heap_caps_free(stage[i]);
+        stage[i] = NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(input[i]);
+        input[i] = NULL;
+    }
+    if (helperDone != NULL) {
+        vSemaphoreDelete(helperDone);
+        helperDone = NULL;
+    }
+    epd = NULL;
+}
+
+uint8_t* DitherStream::StageRow(unsigned long row) {
+    return stage[(row / rowsPerStage) % DITHER_STAGES] + (row % rowsPerStage) * rowBytes;
+}
+
+// true when every row in [row0, row1) is dithered
+bool DitherStream::RowsDone(unsigned long row0, unsigned long row1) {
+    for (int core = 0; core < (shared ? 2 : 1); core++) {
+        // the last row of the range this core does
+        unsigned long last = row1 - 1;
+        if (shared && (int)(last & 1) != core) {
+            if (last == row0) {
+                continue;
+            }
+            last--;
+        }
+        if (__atomic_load_n(&progress[core], __ATOMIC_ACQUIRE) < (last + 1) * epd->width) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// hands every finished stage to the SPI, in order; only the caller's
+// core talks to the panel
+void DitherStream::SendReady(void) {
+    unsigned long stages = (epd->height + rowsPerStage - 1) / rowsPerStage;
+    while (sent < stages && !__atomic_load_n(&failed, __ATOMIC_ACQUIRE)) {
+        unsigned long row0 = sent * rowsPerStage;
+        unsigned long row1 = min(row0 + rowsPerStage, epd->height);
+        if (!RowsDone(row0, row1)) {
+            return;
+        }
+        epd->SendBufferAsync(stage[sent % DITHER_STAGES], (row1 - row0) * rowBytes);
+        __atomic_store_n(&sent, sent + 1, __ATOMIC_RELEASE);
+    }
+}
+
+// rows first, first + step, ... on this core
+bool DitherStream::RunRows(int first, int step) {
+    uint8_t* src = input[first];
+    uint32_t* done = &progress[first];
+    const uint32_t* above = shared ? &progress[1 - first] : NULL;
+    for (unsigned long row = first; row < epd->height; row += step) {
+        // the stage last held the one DITHER_STAGES before, whose DMA is
+        // only known to be done once the stage after it has been queued
+        unsigned long s = row / rowsPerStage;
+        while (s >= DITHER_STAGES && __atomic_load_n(&sent, __ATOMIC_ACQUIRE) + DITHER_STAGES - 2 < s &&
+               !__atomic_load_n(&failed, __ATOMIC_ACQUIRE)) {
+            if (first == 0) {
+                SendReady();
+            } else {
+                DITHER_WAIT();
+            }
+        }
+        if (__atomic_load_n(&failed, __ATOMIC_ACQUIRE) || !read(row, src, readArg)) {
+            // lets the other core run to its end instead of waiting
+            __atomic_store_n(&failed, true, __ATOMIC_RELEASE);
+            __atomic_store_n(done, UINT32_MAX, __ATOMIC_RELEASE);
+            return false;
+        }
+        ditherer.Row(row, src, StageRow(row), above, done);
+        if (first == 0) {
+            SendReady();
+        }
+    }
+    return true;
+}
+
+void DitherStream::HelperTask(void* arg) {
+    DitherStream* self = (DitherStream*)arg;
+    self->RunRows(1, 2);
+    xSemaphoreGive(self->helperDone);
+    vTaskDelete(NULL);
+}
+
+/**
+ *  @brief: dither the frame from read and send it to the panel's data
+ *          command; the refresh is left to the caller. With twoCores
+ *          a helper task dithers the odd rows on the other core.
+ */
+bool DitherStream::Send(DitherRowRead r, void* arg, bool twoCores) {
+    if (epd == NULL) {
+        return false;
+    }
+    ditherer.Begin(*palette, epd->width, channels, mode, errors);
+    read = r;
+    readArg = arg;
+    progress[0] = 0;
+    progress[1] = 0;
+    failed = false;
+    sent = 0;
+#if CONFIG_FREERTOS_UNICORE
+    shared = false;
+#else
+    shared = twoCores;
+#endif
+    unsigned long start = millis();
+    epd->SendCommand(epd->stepCommands[0]);
+    epd->SetToDataMode();
+    if (shared && xTaskCreatePinnedToCore(HelperTask, "dither", DITHER_HELPER_STACK, this, uxTaskPriorityGet(NULL),
+                                          NULL, DITHER_HELPER_CORE) != pdPASS) {
+        shared = false;
+    }
+    bool ok = RunRows(0, shared ? 2 : 1);
+    if (shared) {
+        xSemaphoreTake(helperDone, portMAX_DELAY);
+        ok = ok && !failed;
+    }
+    if (ok) {
+        // stages the helper finished last
+        SendReady();
+    }
+    epd->WaitBuffer();
+    elapsedMs = millis() - start;
+    Serial.printf("[DITHER] %lu rows, %s, in %lu ms%s\n", epd->height, palette->name, elapsedMs,
+                  shared ? " on two cores" : "");
+    return ok;
+}
+
+/* END OF FILE */
@@ -0,0 +1,98 @@
+/**
+ *  @filename   :   dither_stream.h
+ *  @brief      :   Header file of dither_stream.cpp, sends 8-bit RGB or
+ *                  gray rows to a colour panel, dithered on the way
+ *
+ *  The server no longer has to render exact panel bytes: rows come from a
+ *  DitherRowRead callback, go through the Ditherer (dither.h) into DMA
+ *  staging buffers and out to the panel's data command while the next
+ *  rows are dithered. On the S3 a helper task on the other core can take
+ *  the odd rows; the frame is the same, only sooner. The callback is
+ *  then called from both cores, e.g. reading an image held in PSRAM.
+ *  With DITHER_ON_DEVICE the sketch dithers slide bodies as they arrive.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef DITHER_STREAM_H
+#define DITHER_STREAM_H
+
+#include <Arduino.h>
+#include "epd_base.h"
+#include "dither.h"
+
+// ask for image/x-epd-rgb and -gray slides and dither them here, on
+// single-plane colour panels (uncomment to enable)
+//#define DITHER_ON_DEVICE
+
+// staging buffers: one being sent, one queued behind it, one being filled
+#define DITHER_STAGES           3
+#define DITHER_HELPER_STACK     4096
+// the helper runs on the core the caller does not
+#define DITHER_HELPER_CORE      (1 - xPortGetCoreID())
+
+// fills dst with row of the source image, width pixels of 3 bytes (RGB)
+// or 1 (gray); false stops the frame
+typedef bool (*DitherRowRead)(unsigned long row, uint8_t* dst, void* arg);
+
+class DitherStream {
+public:
+    DitherStream();
+    ~DitherStream();
+
+    bool Begin(Epd& panel, const DitherPalette& palette, uint8_t channels, DitherMode mode = DITHER_FLOYD_STEINBERG);
+    void End(void);
+    bool Send(DitherRowRead read, void* arg, bool twoCores = false);
+
+    unsigned long elapsedMs;        // the last Send(), first row to last byte out
+
+private:
+    static void HelperTask(void* arg);
+    bool RunRows(int first, int step);
+    bool RowsDone(unsigned long row0, unsigned long row1);
+    void SendReady(void);
+    uint8_t* StageRow(unsigned long row);
+
+    Epd* epd;
+    const DitherPalette* palette;
+    DitherMode mode;
+    uint8_t channels;
+    Ditherer ditherer;
+    int16_t* errors;
+    uint8_t* input[2];              // one source row per core
+    uint8_t* stage[DITHER_STAGES];
+    unsigned long rowBytes;
+    unsigned long rowsPerStage;
+    unsigned long sent;             // stage loads handed to the SPI
+    DitherRowRead read;
+    void* readArg;
+    bool shared;                    // rows split between two cores
+    uint32_t progress[2];           // per core: row * width + pixels done
+    bool failed;
+    SemaphoreHandle_t helperDone;
+};
+
+#endif
+
+/* END OF FILE */
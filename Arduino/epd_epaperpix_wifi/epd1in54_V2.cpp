@@ -65,6 +65,28 @@
 #define EPD_HEIGHT      200
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  5000
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    20000000,   // max write clock (SSD1681, 50 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          HIGH    // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     15000   // longest monochrome refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    10,     // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    0,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 extern unsigned char WF_Full_1IN54[];
 extern unsigned char WF_PARTIAL_1IN54_0[];
@@ -81,54 +103,39 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x24;
+    // RAM rows as set up by the init script, see ResumeStep()
+    ramRowBytes = 25;
+    ramYStart = 199;
+    ramYDown = true;
+};
+
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, SW_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, DRIVER_OUTPUT_CONTROL, EPD_DATA, 3, 0xC7, 0x00, 0x01,
+    EPD_CMD, DATA_ENTRY_MODE_SETTING, EPD_DATA, 1, 0x01,
+    EPD_CMD, SET_RAM_X_ADDRESS_START_END_POSITION, EPD_DATA, 2, 0x00, 0x18,  // 0x18-->(24+1)*8=200
+    EPD_CMD, SET_RAM_Y_ADDRESS_START_END_POSITION, EPD_DATA, 4, 0xC7, 0x00, 0x00, 0x00,  // 0xC7-->(199+1)=200
+    EPD_CMD, BORDER_WAVEFORM_CONTROL, EPD_DATA, 1, 0x01,
+    EPD_CMD, TEMPERATURE_SENSOR_CONTROL, EPD_DATA, 1, 0x80,
+    EPD_CMD, DISPLAY_UPDATE_CONTROL_2, EPD_DATA, 1, 0xB1,
+    EPD_CMD, MASTER_ACTIVATION,
+    EPD_CMD, SET_RAM_X_ADDRESS_COUNTER, EPD_DATA, 1, 0x00,
+    EPD_CMD, SET_RAM_Y_ADDRESS_COUNTER, EPD_DATA, 2, 0xC7, 0x00,
+    EPD_WAIT_BUSY,
+    EPD_END
 };
 
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-
-    WaitUntilIdle();
-    SendCommand(SW_RESET);
-    WaitUntilIdle();
-
-    SendCommand(DRIVER_OUTPUT_CONTROL);
-    SendData(0xC7);
-    SendData(0x00);
-    SendData(0x01);
-
-    SendCommand(DATA_ENTRY_MODE_SETTING);
-    SendData(0x01);
-
-    SendCommand(SET_RAM_X_ADDRESS_START_END_POSITION);
-    SendData(0x00);
-    SendData(0x18);    //0x18-->(24+1)*8=200
-
-    SendCommand(SET_RAM_Y_ADDRESS_START_END_POSITION);
-    SendData(0xC7);   //0xC7-->(199+1)=200
-    SendData(0x00);
-    SendData(0x00);
-    SendData(0x00);
-
-    SendCommand(BORDER_WAVEFORM_CONTROL);
-    SendData(0x01);
-
-    SendCommand(TEMPERATURE_SENSOR_CONTROL);
-    SendData(0x80);
-
-    SendCommand(DISPLAY_UPDATE_CONTROL_2); 
-    SendData(0xB1);
-    SendCommand(MASTER_ACTIVATION);
-
-    SendCommand(SET_RAM_X_ADDRESS_COUNTER);
-    SendData(0x00);
-    SendCommand(SET_RAM_Y_ADDRESS_COUNTER);
-    SendData(0xC7);
-    SendData(0x00);
-    WaitUntilIdle();
-
+    RunScript(initScript);
     SetLut();
     return 0;
 }
@@ -161,10 +168,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == 1) {      //LOW: idle, HIGH: busy
-        DelayMs(100);
-    }
-    DelayMs(200);
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -173,12 +177,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);
     DigitalWrite(reset_pin, LOW);
-    DelayMs(5);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -214,17 +217,11 @@ void Epd::ClearFrame() {
     int h = height;
  
     SendCommand(WRITE_RAM);
-    for (int j = 0; j < h; j++) {
-        for (int i = 0; i < w; i++) {
-            SendData(0xff);
-        }
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xff, (unsigned long)w * h);
     SendCommand(WRITE_RAM_RED);
-    for (int j = 0; j < h; j++) {
-        for (int i = 0; i < w; i++) {
-            SendData(0xff);
-        }
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xff, (unsigned long)w * h);
 }
 
 void Epd::Clear(unsigned char color) {
@@ -241,7 +238,7 @@ void Epd::Clear(unsigned char color) {
 void Epd::Sleep() {
     SendCommand(DEEP_SLEEP_MODE);
     SendData(0x01);
-    DelayMs(200);
+    DelayMs(epdTiming.sleepWaitMs);
     DigitalWrite(reset_pin, LOW);
 }
 
@@ -96,6 +96,28 @@
 #define EPD_HEIGHT      200
 #define EPD_STEPS      2
 #define EPD_BLOCK_SIZE  5000
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    10000000,   // max write clock (IL0376F, 100 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 extern const unsigned char lut_vcom0[];
 extern const unsigned char lut_w[];
@@ -118,43 +140,32 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x10;
     stepCommands[1] = 0x13;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, POWER_SETTING, EPD_DATA, 4, 0x07, 0x00, 0x08, 0x00,
+    EPD_CMD, BOOSTER_SOFT_START, EPD_DATA, 3, 0x07, 0x07, 0x07,
+    EPD_CMD, POWER_ON,
+    EPD_WAIT_BUSY,
+    EPD_CMD, PANEL_SETTING, EPD_DATA, 1, 0xcf,
+    EPD_CMD, VCOM_AND_DATA_INTERVAL_SETTING, EPD_DATA, 1, 0x17,
+    EPD_CMD, PLL_CONTROL, EPD_DATA, 1, 0x39,
+    EPD_CMD, TCON_RESOLUTION, EPD_DATA, 3, 0xC8, 0x00, 0xC8,
+    EPD_CMD, VCM_DC_SETTING_REGISTER, EPD_DATA, 1, 0x0E,
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-    SendCommand(POWER_SETTING);
-    SendData(0x07);
-    SendData(0x00);
-    SendData(0x08);
-    SendData(0x00);
-    SendCommand(BOOSTER_SOFT_START);
-    SendData(0x07);
-    SendData(0x07);
-    SendData(0x07);
-    SendCommand(POWER_ON);
-
-    WaitUntilIdle();
-
-    SendCommand(PANEL_SETTING);
-    SendData(0xcf);
-    SendCommand(VCOM_AND_DATA_INTERVAL_SETTING);
-    SendData(0x17);
-    SendCommand(PLL_CONTROL);
-    SendData(0x39);
-    SendCommand(TCON_RESOLUTION);
-    SendData(0xC8);
-    SendData(0x00);
-    SendData(0xC8);
-    SendCommand(VCM_DC_SETTING_REGISTER);
-    SendData(0x0E);
-
+    RunScript(initScript);
     SetLut();
-
     return 0;
 }
 
@@ -186,9 +197,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == 0) {      //0: busy, 1: idle
-        DelayMs(100);
-    }      
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -197,10 +206,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(200);
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);    
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -250,20 +260,11 @@ void Epd::SetLut(void) {
 
 void Epd::ClearFrame() {
     SendCommand(DATA_START_TRANSMISSION_1);
-    DelayMs(2);
     SetToDataMode();
-    for (int i = 0; i < EPD_BLOCK_SIZE; i++) {
-        SendDataFast(0xFF);
-         SendDataFast(0xFF);
-    }
-    DelayMs(2);
+    SpiTransferRepeat(0xFF, 2 * EPD_BLOCK_SIZE);
     SendCommand(DATA_START_TRANSMISSION_2);
     SetToDataMode();
-    DelayMs(2);
-    for (int i = 0; i < EPD_BLOCK_SIZE; i++) {
-        SendDataFast(0xFF);
-    }
-    DelayMs(2);
+    SpiTransferRepeat(0xFF, EPD_BLOCK_SIZE);
 }
 
 void Epd::Clear(unsigned char color) {
@@ -39,6 +39,28 @@
 #define EPD_HEIGHT      250
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  3812
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    20000000,   // max write clock (SSD1680, 50 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          HIGH    // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     15000   // longest monochrome refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    10,     // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    0,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 Epd::~Epd()
 {
@@ -54,6 +76,7 @@ Epd::Epd()
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x24;
 };
 
@@ -65,7 +88,7 @@ void Epd::SendCommand(unsigned char command)
 
 void Epd::SendData(unsigned char data)
 {
-     DigitalWrite(dc_pin, LOW);
+     DigitalWrite(dc_pin, HIGH);
     SpiTransfer(data);
 }
 
@@ -78,58 +101,40 @@ void Epd::SetToDataMode() {
     DigitalWrite(dc_pin, HIGH);
 }
 
-void Epd::WaitUntilIdle(void)
-{
-    while(1) {      //LOW: idle, HIGH: busy
-        if(DigitalRead(busy_pin) == 0)
-            break;
-        DelayMs(10);
-    }
+void Epd::WaitUntilIdle(void) {
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0x12,                            // soft reset
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0x01, EPD_DATA, 3, 0xF9, 0x00, 0x00,  // Driver output control
+    EPD_CMD, 0x11, EPD_DATA, 1, 0x03,         // data entry mode
+    EPD_CMD, 0x3C, EPD_DATA, 1, 0x05,         // BorderWavefrom
+    EPD_CMD, 0x21, EPD_DATA, 2, 0x00, 0x80,   // Display update control
+    EPD_CMD, 0x18, EPD_DATA, 1, 0x80,         // Read built-in temperature sensor
+    EPD_WAIT_BUSY,
+    EPD_END
+};
+
 int Epd::Init(void)
 {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    
-    Reset();
-    
-    WaitUntilIdle();
-    SendCommand(0x12); // soft reset
-    WaitUntilIdle();
-
-    SendCommand(0x01); //Driver output control
-    SendData(0xF9);
-    SendData(0x00);
-    SendData(0x00);
-
-    SendCommand(0x11); //data entry mode
-    SendData(0x03);
-
-    SendCommand(0x3C); //BorderWavefrom
-    SendData(0x05);	
-
-    SendCommand(0x21); //  Display update control
-    SendData(0x00);
-    SendData(0x80);	
-
-    SendCommand(0x18); //Read built-in temperature sensor
-    SendData(0x80);	
-
-    WaitUntilIdle();
-
+    RunScript(initScript);
     return 0;
 }
 
-void Epd::Reset(void)
-{
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);
-    DigitalWrite(reset_pin, LOW);                //module reset
-    DelayMs(2);
+void Epd::Reset(void) {
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -145,11 +150,8 @@ void Epd::ClearFrame()
     w = (EPD_WIDTH % 8 == 0)? (EPD_WIDTH / 8 ): (EPD_WIDTH / 8 + 1);
     h = EPD_HEIGHT;
     SendCommand(0x24);
-    for (int j = 0; j < h; j++) {
-        for (int i = 0; i < w; i++) {
-            SendData(0xff);
-        }
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xff, (unsigned long)w * h);
 }
 
 void Epd::Clear(unsigned char color)
@@ -161,7 +163,7 @@ void Epd::Sleep()
 {
     SendCommand(0x10); //enter deep sleep
     SendData(0x01);
-    DelayMs(200);
+    DelayMs(epdTiming.sleepWaitMs);
 
     DigitalWrite(reset_pin, LOW);
 }
@@ -40,6 +40,28 @@
 
 #define EPD_STEPS       1
 #define EPD_BLOCK_SIZE  8000 // 7625  // (122 * 250) / 4 (4 pixels per byte for 2-bit color)
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    8000000,    // max write clock (no datasheet figure, known good)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    100     // power off/deep sleep command until the next step (ms)
+};
 
 // Pixel format for this display
 #define EPD_BITS_PER_PIXEL 2    // 4 colors: 2 bits per pixel
@@ -59,76 +81,39 @@ Epd::Epd() {
     pixels_per_byte = EPD_PIXELS_PER_BYTE;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x10;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0x4D, EPD_DATA, 1, 0x78,
+    EPD_CMD, 0x00, EPD_DATA, 2, 0x0F, 0x29,   // PSR
+    EPD_CMD, 0x01, EPD_DATA, 2, 0x07, 0x00,   // PWRR
+    EPD_CMD, 0x03, EPD_DATA, 3, 0x10, 0x54, 0x44,  // POFS
+    EPD_CMD, 0x06, EPD_DATA, 7, 0x05, 0x00, 0x3F, 0x0A, 0x25, 0x12, 0x1A,  // BTST_P
+    EPD_CMD, 0x50, EPD_DATA, 1, 0x37,         // CDI
+    EPD_CMD, 0x60, EPD_DATA, 2, 0x02, 0x02,   // TCON
+    EPD_CMD, 0x61, EPD_DATA, 4, EPD_WIDTH/256, EPD_WIDTH%256, EPD_HEIGHT/256, EPD_HEIGHT%256,  // TRES - resolution setting
+    EPD_CMD, 0xE7, EPD_DATA, 1, 0x1C,
+    EPD_CMD, 0xE3, EPD_DATA, 1, 0x22,
+    EPD_CMD, 0xB4, EPD_DATA, 1, 0xD0,
+    EPD_CMD, 0xB5, EPD_DATA, 1, 0x03,
+    EPD_CMD, 0xE9, EPD_DATA, 1, 0x01,
+    EPD_CMD, 0x30, EPD_DATA, 1, 0x08,
+    EPD_CMD, 0x04,
+    EPD_WAIT_BUSY,
+    EPD_END
+};
+
 int Epd::Init(void) {
     /* this calls the peripheral hardware interface, see epdif */
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    
-    Reset();
-    WaitUntilIdle();
-    
-    SendCommand(0x4D);
-    SendData(0x78);
-
-    SendCommand(0x00);	//PSR
-    SendData(0x0F);
-    SendData(0x29);
-
-    SendCommand(0x01);	//PWRR
-    SendData(0x07);
-    SendData(0x00);
-
-    SendCommand(0x03);	//POFS
-    SendData(0x10);
-    SendData(0x54);
-    SendData(0x44);
-
-    SendCommand(0x06);	//BTST_P
-    SendData(0x05);
-    SendData(0x00);
-    SendData(0x3F);
-    SendData(0x0A);
-    SendData(0x25);
-    SendData(0x12);
-    SendData(0x1A); 
-
-    SendCommand(0x50);	//CDI
-    SendData(0x37);
-
-    SendCommand(0x60);	//TCON
-    SendData(0x02);
-    SendData(0x02);
-
-    SendCommand(0x61); //TRES - resolution setting
-    SendData(width/256);
-    SendData(width%256);
-    SendData(height/256);
-    SendData(height%256);
-
-    SendCommand(0xE7);
-    SendData(0x1C);
-
-    SendCommand(0xE3);	
-    SendData(0x22);
-
-    SendCommand(0xB4);
-    SendData(0xD0);
-    SendCommand(0xB5);
-    SendData(0x03);
-
-    SendCommand(0xE9);
-    SendData(0x01); 
-
-    SendCommand(0x30);
-    SendData(0x08);  
-
-    SendCommand(0x04);
-    WaitUntilIdle(); 
-    
+    RunScript(initScript);
     return 0;
 }
 
@@ -160,9 +145,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == LOW) {      //LOW: busy, HIGH: idle
-        DelayMs(5);
-    }
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -171,12 +154,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);
     DigitalWrite(reset_pin, LOW);
-    DelayMs(2);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 /******************************************************************************
@@ -207,11 +189,7 @@ void Epd::Clear(unsigned char color)
 
     SendCommand(0x10);
     SetToDataMode();
-    for (int j = 0; j < Height; j++) {
-        for (int i = 0; i < Width; i++) {
-            SendData((color << 6) | (color << 4) | (color << 2) | color);
-        }
-    }
+    SpiTransferRepeat((color << 6) | (color << 4) | (color << 2) | color, (unsigned long)Width * Height);
 
     TurnOnDisplay();
 }
@@ -224,7 +202,7 @@ void Epd::Sleep(void)
 {
     SendCommand(0x02); //power off
     WaitUntilIdle();       //waiting for the electronic paper IC to release the idle signal
-    DelayMs(100);           //!!!The delay here is necessary,100mS at least!!! 
+    DelayMs(epdTiming.sleepWaitMs);           //!!!The delay here is necessary,100mS at least!!!
     
     SendCommand(0x07);  //deep sleep
     SendData(0xA5);
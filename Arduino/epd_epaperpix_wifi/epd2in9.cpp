@@ -62,10 +62,42 @@
 #define EPD_HEIGHT      296
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  4736  // 128 * 296 / 8
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    10000000,   // max write clock (IL3820, 100 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          HIGH    // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     15000   // longest monochrome refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    10,     // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    0,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 extern const unsigned char lut_full_update[];
 extern const unsigned char lut_partial_update[];
 
+// The waveform is all that differs between a partial and a full refresh,
+// see Epd::SetPartial()
+static void PartialMode(Epd& epd, bool partial) {
+    const unsigned char* lut = partial ? lut_partial_update : lut_full_update;
+    epd.SendCommand(WRITE_LUT_REGISTER);
+    for (int i = 0; i < 30; i++) {
+        epd.SendData(lut[i]);
+    }
+}
+
 Epd::~Epd() {
 };
 
@@ -78,30 +110,35 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x24;
+    // RAM rows as set up by ClearFrame(), see SetWindow()
+    ramRowBytes = 16;
+    ramYStart = 0;
+    ramYDown = false;
+    // partial refresh with the second LUT; the two RAMs swap on refresh
+    partialMode = PartialMode;
+    partialRefresh = 0xC4;
+    previousRam = 0;
+};
+
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, DRIVER_OUTPUT_CONTROL, EPD_DATA, 3, (EPD_HEIGHT - 1) & 0xFF, ((EPD_HEIGHT - 1) >> 8) & 0xFF, 0x00,  // GD = 0; SM = 0; TB = 0;
+    EPD_CMD, BOOSTER_SOFT_START_CONTROL, EPD_DATA, 3, 0xD7, 0xD6, 0x9D,
+    EPD_CMD, WRITE_VCOM_REGISTER, EPD_DATA, 1, 0xA8,  // VCOM 7C
+    EPD_CMD, SET_DUMMY_LINE_PERIOD, EPD_DATA, 1, 0x1A,  // 4 dummy lines per gate
+    EPD_CMD, SET_GATE_TIME, EPD_DATA, 1, 0x08,  // 2us per line
+    EPD_CMD, DATA_ENTRY_MODE_SETTING, EPD_DATA, 1, 0x03,  // X increment; Y increment
+    EPD_END
 };
 
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-    SendCommand(DRIVER_OUTPUT_CONTROL);
-    SendData((EPD_HEIGHT - 1) & 0xFF);
-    SendData(((EPD_HEIGHT - 1) >> 8) & 0xFF);
-    SendData(0x00);                     // GD = 0; SM = 0; TB = 0;
-    SendCommand(BOOSTER_SOFT_START_CONTROL);
-    SendData(0xD7);
-    SendData(0xD6);
-    SendData(0x9D);
-    SendCommand(WRITE_VCOM_REGISTER);
-    SendData(0xA8);                     // VCOM 7C
-    SendCommand(SET_DUMMY_LINE_PERIOD);
-    SendData(0x1A);                     // 4 dummy lines per gate
-    SendCommand(SET_GATE_TIME);
-    SendData(0x08);                     // 2us per line
-    SendCommand(DATA_ENTRY_MODE_SETTING);
-    SendData(0x03);                     // X increment; Y increment
+    RunScript(initScript);
     SetLut();
     return 0;
 }
@@ -134,9 +171,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes LOW
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == HIGH) {      //LOW: idle, HIGH: busy
-        DelayMs(100);
-    }      
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -146,9 +181,10 @@ void Epd::WaitUntilIdle(void) {
  */
 void Epd::Reset(void) {
     DigitalWrite(reset_pin, LOW);
-    DelayMs(200);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);    
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -187,9 +223,8 @@ void Epd::ClearFrame() {
     WaitUntilIdle();
     
     SendCommand(WRITE_RAM);
-    for (int i = 0; i < width / 8 * height; i++) {
-        SendData(0xFF);
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xFF, width / 8 * height);
 }
 
 void Epd::Clear(unsigned char color) {
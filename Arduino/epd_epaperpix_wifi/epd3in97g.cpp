@@ -41,6 +41,28 @@
 
 #define EPD_STEPS       1
 #define EPD_BLOCK_SIZE  96000
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    8000000,    // max write clock (no datasheet figure, known good)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 // Pixel format for this display
 #define EPD_BITS_PER_PIXEL 2    // Color: 4 bits per pixel
 #define EPD_PIXELS_PER_BYTE 4   // Each byte contains 4 pixels
@@ -60,70 +82,35 @@ Epd::Epd() {
     pixels_per_byte = EPD_PIXELS_PER_BYTE;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x10;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, 0x00, EPD_DATA, 2, 0x2B, 0x29,   // 0x00
+    EPD_CMD, 0x06, EPD_DATA, 4, 0x0F, 0x8B, 0x93, 0xC1,  // 0x06
+    EPD_CMD, 0x50, EPD_DATA, 1, 0x37,         // 0x50
+    EPD_CMD, 0x30, EPD_DATA, 1, 0x08,         // 0x30
+    EPD_CMD, 0x61, EPD_DATA, 4, EPD_WIDTH/256, EPD_WIDTH%256, EPD_HEIGHT_INIT/256, EPD_HEIGHT_INIT%256,  // 0x61
+    EPD_CMD, 0x62, EPD_DATA, 8, 0x76, 0x76, 0x76, 0x5A, 0x9D, 0x8A, 0x76, 0x62,
+    EPD_CMD, 0x65, EPD_DATA, 4, 0x00, 0x00, 0x00, 0x00,  // 0x65
+    EPD_CMD, 0xE0, EPD_DATA, 1, 0x10,         // 0xE3
+    EPD_CMD, 0xE7, EPD_DATA, 1, 0xA4,         // 0xE7
+    EPD_CMD, 0xE9, EPD_DATA, 1, 0x01,
+    EPD_CMD, 0x04,                            // Power on
+    EPD_DELAY_MS(epdTiming.busyStartMs),
+    EPD_WAIT_BUSY,
+    EPD_END
+};
+
 int Epd::Init(void) {
     /* this calls the peripheral hardware interface, see epdif */
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-
-    Reset();
-
-    SendCommand(0x00);	//0x00
-    SendData(0x2B);	
-    SendData(0x29);	
-
-    SendCommand(0x06);	//0x06
-    SendData(0x0F);	
-    SendData(0x8B);	
-    SendData(0x93);	
-    SendData(0xC1);
-
-    SendCommand(0x50);	//0x50
-    SendData(0x37);	
-
-    SendCommand(0x30);	//0x30
-    SendData(0x08);	
-
-    SendCommand(0x61);//0x61	
-    SendData(EPD_WIDTH/256);	
-    SendData(EPD_WIDTH%256);	
-    SendData(EPD_HEIGHT_INIT/256);	
-    SendData(EPD_HEIGHT_INIT%256);	
-
-    SendCommand(0x62);
-    SendData(0x76); 
-    SendData(0x76);
-    SendData(0x76); 
-    SendData(0x5A);
-    SendData(0x9D); 
-    SendData(0x8A);	
-    SendData(0x76); 
-    SendData(0x62); 
-
-    SendCommand(0x65);	//0x65
-    SendData(0x00);	
-    SendData(0x00);	
-    SendData(0x00);	
-    SendData(0x00);	
-
-    SendCommand(0xE0);	//0xE3
-    SendData(0x10);	
-
-    SendCommand(0xE7);	//0xE7
-    SendData(0xA4);	
-
-    SendCommand(0xE9);	
-    SendData(0x01);
-
-    SendCommand(0x04); //Power on
-    WaitUntilIdle();          //waiting for the electronic paper IC to release the idle signal
-    
-    
-    
-    
+    RunScript(initScript);
     return 0;
 }
 
@@ -155,9 +142,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == LOW) {      //LOW: busy, HIGH: idle
-        DelayMs(5);
-    }
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -166,12 +151,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);    
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(2);
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);     
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 /******************************************************************************
@@ -182,10 +166,12 @@ void Epd::TurnOnDisplay(void)
 {
     SendCommand(0x12); // DISPLAY_REFRESH
     SendData(0x01);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 
     SendCommand(0x02); // POWER_OFF
     SendData(0X00);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 }
 
@@ -205,15 +191,12 @@ void Epd::Clear(unsigned char color)
     Height = height;
     
     SendCommand(0x04);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 
     SendCommand(0x10);
     SetToDataMode();
-    for (int j = 0; j < Height; j++) {
-        for (int i = 0; i < Width; i++) {
-            SendData((color<<6) | (color<<4) | (color<<2) | color);
-        }
-    }
+    SpiTransferRepeat((color<<6) | (color<<4) | (color<<2) | color, (unsigned long)Width * Height);
 
     TurnOnDisplay();
 }
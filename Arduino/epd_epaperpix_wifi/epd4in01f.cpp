@@ -38,6 +38,28 @@
 #define EPD_HEIGHT      400
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  128000
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    8000000,    // max write clock (no datasheet figure, known good)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     60000   // longest 7-colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 // Pixel format for this display
 #define EPD_BITS_PER_PIXEL 4    // Color: 4 bits per pixel
@@ -58,42 +80,31 @@ Epd::Epd() {
     steps = EPD_STEPS;
     stepCommands[0] = 0x10;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     ShowDebug = false;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0x00, EPD_DATA, 2, 0x2f, 0x00,
+    EPD_CMD, 0x01, EPD_DATA, 4, 0x37, 0x00, 0x05, 0x05,
+    EPD_CMD, 0x03, EPD_DATA, 1, 0x00,
+    EPD_CMD, 0x06, EPD_DATA, 3, 0xC7, 0xC7, 0x1D,
+    EPD_CMD, 0x41, EPD_DATA, 1, 0x00,
+    EPD_CMD, 0x50, EPD_DATA, 1, 0x37,
+    EPD_CMD, 0x60, EPD_DATA, 1, 0x22,
+    EPD_CMD, 0x61, EPD_DATA, 4, 0x02, 0x80, 0x01, 0x90,
+    EPD_CMD, 0xE3, EPD_DATA, 1, 0xAA,
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-    WaitUntilIdle();
-    SendCommand(0x00);
-    SendData(0x2f);
-    SendData(0x00);
-    SendCommand(0x01);
-    SendData(0x37);
-    SendData(0x00);
-    SendData(0x05);
-    SendData(0x05);
-    SendCommand(0x03);
-    SendData(0x00);
-    SendCommand(0x06);
-    SendData(0xC7);
-    SendData(0xC7);
-    SendData(0x1D);
-    SendCommand(0x41);
-    SendData(0x00);
-    SendCommand(0x50);
-    SendData(0x37);
-    SendCommand(0x60);
-    SendData(0x22);
-    SendCommand(0x61);
-    SendData(0x02);
-    SendData(0x80);
-    SendData(0x01);
-    SendData(0x90);
-    SendCommand(0xE3);
-    SendData(0xAA);
+    RunScript(initScript);
     return 0;
 }
 
@@ -116,26 +127,28 @@ void Epd::SetToDataMode() {
 }
 
 void Epd::WaitUntilIdle(void) {
-    while(!(DigitalRead(busy_pin)));
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);   
     DigitalWrite(reset_pin, LOW);
-    DelayMs(1);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);    
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
     SendCommand(0x04);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
     SendCommand(0x12);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
     SendCommand(0x02);
-    while(DigitalRead(busy_pin));
-    DelayMs(200);
+    // BUSY goes low once power off starts
+    WaitBusy(busy_pin, HIGH, EPD_BUSY_TIMEOUT_MS);
+    DelayMs(epdTiming.busyStartMs);
 }
 
 void Epd::Clear(unsigned char color) {
@@ -145,19 +158,15 @@ void Epd::Clear(unsigned char color) {
     SendData(0x01);
     SendData(0x90);
     SendCommand(0x10);
-    for(int i=0; i<height; i++) {
-        for(int j=0; j<width/2; j++) {
-            SendData((color<<4)|color);
-        }
-    }
+    SetToDataMode();
+    SpiTransferRepeat((color<<4)|color, height * width / 2);
     TurnOnDisplay();
 }
 
 void Epd::Sleep(void) {
-    DelayMs(100);
     SendCommand(0x07);
     SendData(0xA5);
-    DelayMs(100);
+    DelayMs(epdTiming.sleepWaitMs);
     DigitalWrite(reset_pin, 0);
 }
 
@@ -168,11 +177,8 @@ void Epd::ClearFrame(void) {
     SendData(0x01);
     SendData(0x90);
     SendCommand(0x10);
-    for(int i=0; i<height; i++) {
-        for(int j=0; j<width/2; j++) {
-            SendData(0x11);
-        }
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0x11, height * width / 2);
 }
 
 void Epd::SetLut(void) {
@@ -185,12 +191,6 @@ void Epd::SetFrameStart(char mode, unsigned char command) {
     SendCommand(command);
 }
 
-void Epd::SendBuffer(unsigned char* buffer, int size) {
-    for(int i = 0; i < size; i++) {
-        SendDataFast(buffer[i]);
-    }
-}
-
 
 #endif
 
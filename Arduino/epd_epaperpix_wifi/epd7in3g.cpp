@@ -39,6 +39,28 @@
 #define EPD_HEIGHT      480
 #define EPD_STEPS       1
 #define EPD_BLOCK_SIZE  96000
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    8000000,    // max write clock (no datasheet figure, known good)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 Epd::~Epd() {
 };
@@ -52,81 +74,41 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x10;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0xAA, EPD_DATA, 6, 0x49, 0x55, 0x20, 0x08, 0x09, 0x18,
+    EPD_CMD, 0x01, EPD_DATA, 1, 0x3F,
+    EPD_CMD, 0x00, EPD_DATA, 2, 0x4F, 0x69,
+    EPD_CMD, 0x05, EPD_DATA, 4, 0x40, 0x1F, 0x1F, 0x2C,
+    EPD_CMD, 0x08, EPD_DATA, 4, 0x6F, 0x1F, 0x1F, 0x22,
+    // ===================
+    // 20211212
+    // First setting
+    EPD_CMD, 0x06, EPD_DATA, 4, 0x6F, 0x1F, 0x14, 0x14,
+    // ===================
+    EPD_CMD, 0x03, EPD_DATA, 4, 0x00, 0x54, 0x00, 0x44,
+    EPD_CMD, 0x60, EPD_DATA, 2, 0x02, 0x00,
+    // Please notice that PLL must be set for version 2 IC
+    EPD_CMD, 0x30, EPD_DATA, 1, 0x08,
+    EPD_CMD, 0x50, EPD_DATA, 1, 0x3F,
+    EPD_CMD, 0x61, EPD_DATA, 4, 0x03, 0x20, 0x01, 0xE0,
+    EPD_CMD, 0xE3, EPD_DATA, 1, 0x2F,
+    EPD_CMD, 0x84, EPD_DATA, 1, 0x01,
+    EPD_END
+};
+
 int Epd::Init(void) {
     /* this calls the peripheral hardware interface, see epdif */
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-    WaitUntilIdle();
-
-    SendCommand(0xAA);
-    SendData(0x49);
-    SendData(0x55);
-    SendData(0x20);
-    SendData(0x08);
-    SendData(0x09);
-    SendData(0x18);
-
-    SendCommand(0x01);
-    SendData(0x3F);
-
-    SendCommand(0x00);
-    SendData(0x4F);
-    SendData(0x69);
-
-    SendCommand(0x05);
-    SendData(0x40);
-    SendData(0x1F);
-    SendData(0x1F);
-    SendData(0x2C);
-
-    SendCommand(0x08);
-    SendData(0x6F);
-    SendData(0x1F);
-    SendData(0x1F);
-    SendData(0x22);
-
-    //===================
-    //20211212
-    //First setting
-    SendCommand(0x06);
-    SendData(0x6F);
-    SendData(0x1F);
-    SendData(0x14);
-    SendData(0x14);
-    //===================
-
-    SendCommand(0x03);
-    SendData(0x00);
-    SendData(0x54);
-    SendData(0x00);
-    SendData(0x44);
-
-    SendCommand(0x60);
-    SendData(0x02);
-    SendData(0x00);
-    //Please notice that PLL must be set for version 2 IC
-    SendCommand(0x30);
-    SendData(0x08);
-
-    SendCommand(0x50);
-    SendData(0x3F);
-
-    SendCommand(0x61);
-    SendData(0x03);
-    SendData(0x20);
-    SendData(0x01); 
-    SendData(0xE0); 
-
-    SendCommand(0xE3);
-    SendData(0x2F);
-
-    SendCommand(0x84);
-    SendData(0x01);
+    RunScript(initScript);
     return 0;
 }
 
@@ -158,9 +140,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == LOW) {      //LOW: busy, HIGH: idle
-        DelayMs(5);
-    }
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -169,12 +149,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);    
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(2);
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);     
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 /******************************************************************************
@@ -185,10 +164,12 @@ void Epd::TurnOnDisplay(void)
 {
     SendCommand(0x12); // DISPLAY_REFRESH
     SendData(0x01);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 
     SendCommand(0x02); // POWER_OFF
     SendData(0X00);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 }
 
@@ -200,15 +181,12 @@ void Epd::Clear()
     Height = height;
     
     SendCommand(0x04);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 
     SendCommand(0x10);
     SetToDataMode();
-    for (int j = 0; j < Height; j++) {
-        for (int i = 0; i < Width; i++) {
-            SendData(0);
-        }
-    }
+    SpiTransferRepeat(0, (unsigned long)Width * Height);
 
     TurnOnDisplay();
 }
@@ -223,15 +201,12 @@ void Epd::Clear(unsigned char color)
     Height = height;
     
     SendCommand(0x04);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 
     SendCommand(0x10);
     SetToDataMode();
-    for (int j = 0; j < Height; j++) {
-        for (int i = 0; i < Width; i++) {
-            SendData((color<<6) | (color<<4) | (color<<2) | color);
-        }
-    }
+    SpiTransferRepeat((color<<6) | (color<<4) | (color<<2) | color, (unsigned long)Width * Height);
 
     TurnOnDisplay();
 }
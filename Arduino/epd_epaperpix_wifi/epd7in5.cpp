@@ -59,6 +59,28 @@
 #define EPD_HEIGHT      384
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  61440
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    10000000,   // max write clock (IL0371, 100 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     15000   // longest monochrome refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 Epd::~Epd() {
 };
@@ -72,55 +94,33 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x10;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, POWER_SETTING, EPD_DATA, 2, 0x37, 0x00,
+    EPD_CMD, PANEL_SETTING, EPD_DATA, 2, 0xCF, 0x08,
+    EPD_CMD, BOOSTER_SOFT_START, EPD_DATA, 3, 0xc7, 0xcc, 0x28,
+    EPD_CMD, POWER_ON,
+    EPD_WAIT_BUSY,
+    EPD_CMD, PLL_CONTROL, EPD_DATA, 1, 0x3c,
+    EPD_CMD, TEMPERATURE_CALIBRATION, EPD_DATA, 1, 0x00,
+    EPD_CMD, VCOM_AND_DATA_INTERVAL_SETTING, EPD_DATA, 1, 0x77,
+    EPD_CMD, TCON_SETTING, EPD_DATA, 1, 0x22,
+    EPD_CMD, TCON_RESOLUTION, EPD_DATA, 4, 0x02, 0x80, 0x01, 0x80,  // source 640; gate 384
+    EPD_CMD, VCM_DC_SETTING, EPD_DATA, 1, 0x1E,  // decide by LUT file
+    EPD_CMD, 0xe5, EPD_DATA, 1, 0x03,         // FLASH MODE
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-
-    SendCommand(POWER_SETTING); 
-    SendData(0x37);
-    SendData(0x00);
-
-    SendCommand(PANEL_SETTING);
-    SendData(0xCF);
-    SendData(0x08);
-    
-    SendCommand(BOOSTER_SOFT_START);
-    SendData(0xc7);     
-    SendData(0xcc);
-    SendData(0x28);
-
-    SendCommand(POWER_ON);
-    WaitUntilIdle();
-
-    SendCommand(PLL_CONTROL);
-    SendData(0x3c);        
-
-    SendCommand(TEMPERATURE_CALIBRATION);
-    SendData(0x00);
-
-    SendCommand(VCOM_AND_DATA_INTERVAL_SETTING);
-    SendData(0x77);
-
-    SendCommand(TCON_SETTING);
-    SendData(0x22);
-
-    SendCommand(TCON_RESOLUTION);
-    SendData(0x02);     //source 640
-    SendData(0x80);
-    SendData(0x01);     //gate 384
-    SendData(0x80);
-
-    SendCommand(VCM_DC_SETTING);
-    SendData(0x1E);      //decide by LUT file
-
-    SendCommand(0xe5);           //FLASH MODE            
-    SendData(0x03);  
-
+    RunScript(initScript);
     return 0;
 }
 
@@ -136,6 +136,7 @@ void Epd::SendCommand(unsigned char command) {
  *  @brief: basic function for sending data
  */
 void Epd::SendData(unsigned char data) {
+    DigitalWrite(dc_pin, HIGH);
     SpiTransfer(data);
 }
 
@@ -147,9 +148,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == 0) {      //0: busy, 1: idle
-        DelayMs(100);
-    }      
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -158,12 +157,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);   
     DigitalWrite(reset_pin, LOW);
-    DelayMs(10);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);   
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -39,14 +39,36 @@
 // Display resolution
 #define EPD_WIDTH       800
 #define EPD_HEIGHT      480
-#define EPD_STEPS      1
-#define EPD_BLOCK_SIZE  96000
+#define EPD_STEPS      2
+#define EPD_BLOCK_SIZE  48000   // 96000 byte download: old data (0x10), then new (0x13)
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    10000000,   // max write clock (UC8179, 100 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     15000   // longest monochrome refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    20,     // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 // Pixel format for this display
 #define EPD_BITS_PER_PIXEL 1    // Monochrome: 1 byte per pixel  
 #define EPD_PIXELS_PER_BYTE 8   // Each byte is one pixel
 
-unsigned char Voltage_Frame_7IN5_V2[]={
+static constexpr unsigned char Voltage_Frame_7IN5_V2[]={
 	0x6, 0x3F, 0x3F, 0x11, 0x24, 0x7, 0x17,
 };
 
@@ -100,6 +122,41 @@ unsigned char LUT_BB_7IN5_V2[]={
 	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	
 };
 
+// Partial waveform: a single group of 30, 5, 30 and 5 frames; only pixels
+// that change colour are driven, WW and BB hold, so nothing else flashes
+unsigned char LUT_VCOM_PARTIAL_7IN5_V2[42]={
+	0x0,	0x1E,	0x5,	0x1E,	0x5,	0x1,
+};
+
+unsigned char LUT_WW_PARTIAL_7IN5_V2[42]={
+	0x0,	0x1E,	0x5,	0x1E,	0x5,	0x1,
+};
+
+unsigned char LUT_BW_PARTIAL_7IN5_V2[42]={
+	0x48,	0x1E,	0x5,	0x1E,	0x5,	0x1,
+};
+
+unsigned char LUT_WB_PARTIAL_7IN5_V2[42]={
+	0x84,	0x1E,	0x5,	0x1E,	0x5,	0x1,
+};
+
+unsigned char LUT_BB_PARTIAL_7IN5_V2[42]={
+	0x0,	0x1E,	0x5,	0x1E,	0x5,	0x1,
+};
+
+// Partial refresh: partial LUT and a floating border, see Epd::SetPartial()
+static void PartialMode(Epd& epd, bool partial) {
+    if (partial) {
+        epd.SetLut_by_host(LUT_VCOM_PARTIAL_7IN5_V2, LUT_WW_PARTIAL_7IN5_V2, LUT_BW_PARTIAL_7IN5_V2,
+                           LUT_WB_PARTIAL_7IN5_V2, LUT_BB_PARTIAL_7IN5_V2);
+    } else {
+        epd.SetLut_by_host(LUT_VCOM_7IN5_V2, LUT_WW_7IN5_V2, LUT_BW_7IN5_V2, LUT_WB_7IN5_V2, LUT_BB_7IN5_V2);
+    }
+    epd.SendCommand(0x50);      // VCOM AND DATA INTERVAL SETTING; BDZ=1 while partial
+    epd.SendData(partial ? 0x90 : 0x10);
+    epd.SendData(0x00);
+}
+
 Epd::~Epd() {
 };
 
@@ -114,97 +171,44 @@ Epd::Epd() {
     pixels_per_byte = EPD_PIXELS_PER_BYTE;
     steps=EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
-    stepCommands[0]=0x13;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
+    // the same two steps as the serial sketch, the second one is shown
+    stepCommands[0]=0x10;
+    stepCommands[1]=0x13;
+    ramPartialWindow = true;
+    // partial refresh compares new data (0x13) with the old data in 0x10,
+    // refreshing the window set before it
+    partialMode = PartialMode;
+    partialRefresh = 0;
+    previousRam = 0x10;
     ShowDebug = false;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, 0x01, EPD_DATA, 5, 0x17, Voltage_Frame_7IN5_V2[6], Voltage_Frame_7IN5_V2[1], Voltage_Frame_7IN5_V2[2], Voltage_Frame_7IN5_V2[3],  // power setting; 1-0=11: internal power; VGH&VGL; VSH; VSL; VSHR
+    EPD_CMD, 0x82, EPD_DATA, 1, Voltage_Frame_7IN5_V2[4],  // VCOM DC Setting; VCOM
+    EPD_CMD, 0x06, EPD_DATA, 4, 0x27, 0x27, 0x2F, 0x17,  // Booster Setting
+    EPD_CMD, 0x30, EPD_DATA, 1, Voltage_Frame_7IN5_V2[0],  // OSC Setting; 2-0=100: N=4  ; 5-3=111: M=7  ;  3C=50Hz     3A=100HZ
+    EPD_CMD, 0x04,                            // POWER ON
+    EPD_DELAY_MS(epdTiming.busyStartMs),
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0X00, EPD_DATA, 1, 0x3F,         // PANNEL SETTING; KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
+    EPD_CMD, 0x61, EPD_DATA, 4, 0x03, 0x20, 0x01, 0xE0,  // tres; source 800; gate 480
+    EPD_CMD, 0X15, EPD_DATA, 1, 0x00,
+    EPD_CMD, 0X50, EPD_DATA, 2, 0x10, 0x00,   // VCOM AND DATA INTERVAL SETTING
+    EPD_CMD, 0X60, EPD_DATA, 1, 0x22,         // TCON SETTING
+    EPD_CMD, 0x65, EPD_DATA, 4, 0x00, 0x00, 0x00, 0x00,  // Resolution setting; 800*480
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-
-    // SendCommand(0x01); 
-    // SendData(0x07);
-    // SendData(0x07);
-    // SendData(0x3f);
-    // SendData(0x3f);
-
-    // SendCommand(0x04);
-    // DelayMs(100);
-    // WaitUntilIdle();
-    
-    // SendCommand(0X00);			//PANNEL SETTING
-    // SendData(0x1F);   //KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
-
-    // SendCommand(0x61);        	//tres
-    // SendData(0x03);		//source 800
-    // SendData(0x20);
-    // SendData(0x01);		//gate 480
-    // SendData(0xE0);
-
-    // SendCommand(0X15);
-    // SendData(0x00);
-
-    // SendCommand(0X50);			//VCOM AND DATA INTERVAL SETTING
-    // SendData(0x10);
-    // SendData(0x07);
-
-    // SendCommand(0X60);			//TCON SETTING
-    // SendData(0x22);
-
-    // return 0;
-
-	SendCommand(0x01);  // power setting
-	SendData(0x17);  // 1-0=11: internal power
-	SendData(*(Voltage_Frame_7IN5_V2+6));  // VGH&VGL
-	SendData(*(Voltage_Frame_7IN5_V2+1));  // VSH
-	SendData(*(Voltage_Frame_7IN5_V2+2));  //  VSL
-	SendData(*(Voltage_Frame_7IN5_V2+3));  //  VSHR
-	
-	SendCommand(0x82);  // VCOM DC Setting
-	SendData(*(Voltage_Frame_7IN5_V2+4));  // VCOM
-
-	SendCommand(0x06);  // Booster Setting
-	SendData(0x27);
-	SendData(0x27);
-	SendData(0x2F);
-	SendData(0x17);
-	
-	SendCommand(0x30);   // OSC Setting
-	SendData(*(Voltage_Frame_7IN5_V2+0));  // 2-0=100: N=4  ; 5-3=111: M=7  ;  3C=50Hz     3A=100HZ
-
-    SendCommand(0x04); //POWER ON
-    DelayMs(100);
-    WaitUntilIdle();
-
-    SendCommand(0X00);			//PANNEL SETTING
-    SendData(0x3F);   //KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
-
-    SendCommand(0x61);        	//tres
-    SendData(0x03);		//source 800
-    SendData(0x20);
-    SendData(0x01);		//gate 480
-    SendData(0xE0);
-
-    SendCommand(0X15);
-    SendData(0x00);
-
-    SendCommand(0X50);			//VCOM AND DATA INTERVAL SETTING
-    SendData(0x10);
-    SendData(0x00);
-
-    SendCommand(0X60);			//TCON SETTING
-    SendData(0x22);
-
-    SendCommand(0x65);  // Resolution setting
-    SendData(0x00);
-    SendData(0x00);//800*480
-    SendData(0x00);
-    SendData(0x00);
-
+    RunScript(initScript);
     SetLut_by_host(LUT_VCOM_7IN5_V2, LUT_WW_7IN5_V2, LUT_BW_7IN5_V2, LUT_WB_7IN5_V2, LUT_BB_7IN5_V2);
-
     return 0;
 }
 
@@ -234,7 +238,7 @@ void Epd::SetLut_by_host(unsigned char* lut_vcom,  unsigned char* lut_ww, unsign
 }
 /*
 int Epd::Init4G(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
     Reset();
@@ -246,7 +250,7 @@ int Epd::Init4G(void) {
     SendData(0x3f);
 
     SendCommand(0x04);
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
     
     SendCommand(0x00);      //PANNEL SETTING
@@ -316,14 +320,10 @@ void Epd::SendDataFast(unsigned char data) {
 //     DelayMs(200);
 // }
 void Epd::WaitUntilIdle(void) {
-    unsigned char busy;
     Serial.print("e-Paper Busy\r\n ");
-    do{
-        SendCommand(0x71);
-        busy = DigitalRead(busy_pin);
-    }while(busy == 0);
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
     Serial.print("e-Paper Busy Release\r\n ");
-    DelayMs(20);
+    DelayMs(epdTiming.busySettleMs);
 }
 /**
  *  @brief: module reset.
@@ -331,18 +331,16 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-   Serial.print("e-Paper Reset\r\n ");
-   DelayMs(40);
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(4);
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);    
-    Serial.print("e-Paper Reset Release\r\n ");
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 void Epd::TurnOnDisplay(void) {
    Serial.print("e-Paper TurnOnDisplay\r\n ");
    SendCommand(0x12);
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
    
   Serial.print("e-Paper TurnOnDisplay  Release\r\n ");
@@ -369,16 +367,12 @@ void Epd::Clear( unsigned char color) {
     
     SendCommand(0x10);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++) {
-        SendData(color);
-    }
+    SpiTransferRepeat(color, height*width / 8);
     SendCommand(0x13);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++)	{
-        SendData(color);
-    }
+    SpiTransferRepeat(color, height*width / 8);
     SendCommand(0x12);
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 }
 
@@ -386,9 +380,7 @@ void Epd::ClearFrame() {
     
     SendCommand(0x10);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++) {
-        SendData(0xff);
-    }
+    SpiTransferRepeat(0xff, height*width / 8);
     // SendCommand(0x13);
     // SetToDataMode();
     // for(unsigned long i=0; i<height*width / 8; i++)	{
@@ -22,6 +22,15 @@ const unsigned int wifi_qrcode_32x32_size = 128;
 // };
 // const unsigned int wifi_qrcode6_64x64_size = 512;
 
+/* Opcodes for the controller scripts run by Epd::RunScript() */
+#define EPD_END         0x00    /* end of script */
+#define EPD_CMD         0x01    /* EPD_CMD, command */
+#define EPD_DATA        0x02    /* EPD_DATA, n, n data bytes */
+#define EPD_DELAY       0x03    /* EPD_DELAY, ms high byte, ms low byte */
+#define EPD_WAIT_BUSY   0x04    /* WaitUntilIdle() */
+#define EPD_RESET       0x05    /* Reset() */
+#define EPD_DELAY_MS(ms) EPD_DELAY, (((ms) >> 8) & 0xFF), ((ms) & 0xFF)
+
 class Epd : EpdIf {
 public:
     unsigned long width;
@@ -29,6 +38,22 @@ public:
     unsigned char steps;
     unsigned char stepCommands[4];
     unsigned long blockSize;
+    unsigned long streamBufferSize;
+    // SSD168x RAM geometry for ResumeStep(), 0 bytes per row when unknown
+    unsigned char ramRowBytes = 0;
+    unsigned int ramYStart = 0;
+    bool ramYDown = false;
+    // UC81xx: SetWindow() through the partial window (0x90/0x91/0x92),
+    // which limits the data commands and the refresh
+    bool ramPartialWindow = false;
+    // partial refresh, set by drivers that have one: switches the waveform
+    // and what goes with it, see SetPartial()
+    void (*partialMode)(Epd& epd, bool partial) = NULL;
+    unsigned char partialRefresh = 0;   // DISPLAY_UPDATE_CONTROL_2 of a partial refresh, 0 for TurnOnDisplay()
+    unsigned char previousRam = 0;      // RAM the controller compares with, 0 when its two RAMs swap
+    // native pixel format, 0 when the driver leaves it to blockSize
+    unsigned char bits_per_pixel = 0;
+    unsigned char pixels_per_byte = 0;
     Epd();
     ~Epd();
     int  Init(void);
@@ -49,14 +74,20 @@ public:
     uint8_t get_bit(const uint8_t *array, size_t bit_position);
     void SetFrameStart(char mode, unsigned char command);
     void SendBuffer(unsigned char* buffer, int size);
+    void SendBufferAsync(unsigned char* buffer, int size);
+    void WaitBuffer(void);
+    void RunScript(const unsigned char* script);
+    long ResumeStep(int step, unsigned long offset);
+    bool SetWindow(unsigned long col, unsigned long row, unsigned long cols, unsigned long rows);
+    bool SetPartialWindow(unsigned long col, unsigned long row, unsigned long cols, unsigned long rows);
+    bool SetPartial(bool partial);
+    void TurnOnPartial(void);
     bool ShowDebug;
 private:
     unsigned int reset_pin;
     unsigned int dc_pin;
     unsigned int cs_pin;
     unsigned int busy_pin;
-    unsigned char bits_per_pixel;
-    unsigned char pixels_per_byte;
     unsigned char qr_color;
 
 };
@@ -19,6 +19,7 @@
 #include <WiFi.h>
 #include <WiFiMulti.h>
 #include <ArduinoJson.h>
+#include "api_json.h"
 #include <HTTPClient.h>
 #include <WebServer.h>
 #include <EEPROM.h>
@@ -26,6 +27,25 @@
 
 
 #include <WiFiClientSecure.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+
+// On dual-core chips the download and the panel upload run as two tasks on
+// their own cores, joined by a lock-free ring (comment out to use one loop)
+#if !CONFIG_FREERTOS_UNICORE
+#define USE_PIPELINE_TASKS
+#include "spsc_ring.h"
+#endif
+#include "https_pool.h"
+#include "slide_codec.h"
+#include "mirror_select.h"
+#include "wifi_fast.h"
+#include "wall_clock.h"
+#include "slide_store.h"
+#include "frame_store.h"
+#include "slide_pump.h"
+#include "framebuffer.h"
+#include "dither_stream.h"
 
 #define uS_TO_S_FACTOR 1000000ULL  /* Conversion factor for micro seconds to seconds */
 #define TIME_TO_SLEEP  180        /* Time ESP32 will go to sleep (in seconds) */
@@ -46,7 +66,6 @@
 #define WIFI_TIMEOUT 10000        /* WiFi connection timeout in milliseconds */
 #define RETRY_DELAY 500           /* Delay between retries in milliseconds */
 #define LOOP_DELAY 10000          /* Main loop delay in milliseconds */
-#define DOWNLOAD_BUFFER_SIZE 128  /* Buffer size for downloading data */
 #define LARGE_BUFFER_SIZE 1024    /* Large buffer size for data processing */
 #define DEFAULT_SLEEP_TIME 60     /* Default sleep time in seconds */
 #define RETRY_SLEEP_TIME 120      /* Sleep time after retry in seconds */
@@ -59,8 +78,17 @@
 #define DOWNLOAD_DELAY 100        /* Delay after download completion */
 #define EEPROM_STRING_SIZE 32     /* Maximum size for EEPROM strings */
 #define EEPROM_PASS_SIZE 64       /* Maximum size for EEPROM password */
-#define JSON_DOC_SIZE 200         /* JSON document size for parsing */
-#define TIMEOUT_COUNTER 20000     /* Timeout counter for operations */
+#define PIPE_RING_SIZE 32768      /* Ring between network and panel task, power of two */
+#define PIPE_NET_STACK 12288      /* Network task stack, TLS needs the room */
+#define PIPE_PANEL_STACK 4096     /* Panel task stack */
+#define PIPE_NET_CORE 0           /* WiFi stack already lives on core 0 */
+#define PIPE_PANEL_CORE 1         /* Panel upload on the application core */
+#define SLIDE_NOT_MODIFIED 2      /* Download result: server answered 304 */
+#define PREFETCH_STACK 12288      /* Prefetch task stack, TLS needs the room */
+#define PREFETCH_TIMEOUT 60000    /* Wait for the prefetch after the refresh, in ms */
+#define PREFETCH_IO_TIMEOUT 3000  /* Prefetch TCP connect and response waits, in ms */
+/* Then for it to give up: the longest wait the prefetch can be stuck in */
+#define PREFETCH_ABORT_WAIT (TLS_HANDSHAKE_TIMEOUT + TLS_WRITE_TIMEOUT + 2 * PREFETCH_IO_TIMEOUT)
 
 // API endpoints
 #define API_BASE_URL "https://api.epaperpix.app"
@@ -68,8 +96,12 @@
 #define API_START_ENDPOINT "/epaper2/DSlideShowStart/"   
 #define API_FILE_ENDPOINT "/epaper2/DSlideShow/"     
 #define API_DEVICE_ENDPOINT "/epaper3/GetDeviceInfo/id/"
+#ifndef BLOB_URL_PRIMARY
 #define BLOB_URL_PRIMARY "https://blob.epaperpix.app/epaperfiles/"
+#endif
+#ifndef BLOB_URL_SECONDARY
 #define BLOB_URL_SECONDARY "https://epaperstore.blob.core.windows.net/epaperfiles/"
+#endif
 
 // Access Point settings for configuration mode
 const char* AP_SSID = "epaperpix_WiFi_Setup";
@@ -119,40 +151,31 @@ String storedScreenName = "";
 bool configComplete = false;
 bool apconnected =false;
 
-struct SlideShowStatus
-{
-  const char *filename;
-  bool gotosleep;
-  long secondsdelay;
-  bool didcall;
-  bool retry;
-} ;
-
- StaticJsonDocument<JSON_DOC_SIZE> doc;
-
-void setClock() {
-  configTime(0, 0, "pool.ntp.org");
-
-  USE_SERIAL.print(F("Waiting for NTP time sync: "));
-  time_t nowSecs = time(nullptr);
-  while (nowSecs < 8 * 3600 * 2) {
-    delay(500);
-    USE_SERIAL.print(F("."));
-    yield();
-    nowSecs = time(nullptr);
-  }
-
-  USE_SERIAL.println();
-  struct tm timeinfo;
-  gmtime_r(&nowSecs, &timeinfo);
-  USE_SERIAL.print(F("Current time: "));
-  USE_SERIAL.print(asctime(&timeinfo));
-}
-
 
 WiFiMulti WiFiMulti;
+WiFiFast wifiFast;
+WallClock wallClock;
+SlideStore slideStore;
+FrameStore frameStore;
 uint8_t screenbuf1[LARGE_BUFFER_SIZE];
 Epd epd;
+bool panelReady = false;
+
+// Blob mirrors, tried in the order MirrorSelect finds fastest
+const char* const blobMirrors[MIRROR_COUNT] = { BLOB_URL_PRIMARY, BLOB_URL_SECONDARY };
+MirrorSelect mirrors;
+
+// Last slide put on the panel. RTC memory survives deep sleep, so the next
+// wake can ask the blob store whether it changed since (ETag/Last-Modified)
+struct LastSlide {
+  char filename[64];
+  char etag[80];
+  char lastModified[40];
+  uint32_t imageCrc;    // CRC32 of the image bytes sent to the panel
+  uint32_t check;       // CRC32 of the fields above, garbage after power-on
+};
+RTC_DATA_ATTR LastSlide lastSlide;
+
 int loopCount=0;
 int needDeviceIfo=0;
 
@@ -194,14 +217,6 @@ void setup() {
   USE_SERIAL.print("needDeviceIfo =");
   USE_SERIAL.println(needDeviceIfo);
   
-  if (epd.Init() != 0) {
-    USE_SERIAL.println("Failed to initialize EPD");
-    return;
-  }
-  
-  // Enable debug output for troubleshooting
-  epd.ShowDebug = true;
-  
   //epd.TurnOnDisplay();
 
   //epd.Reset();
@@ -210,6 +225,12 @@ void setup() {
 
 
   print_wakeup_reason();
+  mirrors.Begin((unsigned long)epd.steps * epd.blockSize);
+#ifdef PREFETCH_NEXT
+  // the slide fetched during the last refresh goes up without WiFi
+  if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER && storedSSID.length() > 0)
+    ShowStoredSlide();
+#endif
   if (storedSSID.length() > 0 && EEPROM.read(CONFIG_FLAG_ADDR) == 1) {
     WiFi.onEvent(WiFiEvent);
     WiFi.mode(WIFI_STA);
@@ -220,6 +241,9 @@ void setup() {
     return;
   }
   
+  if (!EnsurePanel()) {
+    return;
+  }
   epd.ClearFrame();
   //epd.Clear(0xFF);      // Clear to white background (handles dual-buffer prep)
   epd.QRset(6);    // Draw QR code (single step)
@@ -265,11 +289,453 @@ void WiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
 
 
 HTTPClient https;
+const char* slideHeaders[] = {"ETag", "Last-Modified", "Content-Encoding", "Content-Type"};
+// slide body as panel bytes, decompressed when the blob is encoded
+SlideSource slideSource;
+
+// Where an interrupted download stopped, so the next attempt continues
+// there instead of sending every plane again
+struct DownloadResume {
+  String filename;
+  long done;            // panel bytes already written
+  bool raw;             // body was not compressed, Range offsets match
+  String etag;          // If-Range guard against a changed blob
+} downloadResume;
+// one kept TLS session per host, shared by every request of a wake
+HttpsPool httpsPool;
+#ifdef FRAME_BUFFER
+// The download goes into the frame buffer when it starts out as what the
+// panel shows; RefreshPanel() then uploads and refreshes what changed
+FrameBuffer frameBuffer;
+bool frameBuffered = false;
+long frameBufferAt;             // panel offset of the next downloaded byte
+#endif
+
+// The panel is only woken when there is something to draw, a wake that
+// ends in 304 Not Modified leaves it in deep sleep
+bool EnsurePanel()
+{
+  if (panelReady)
+    return true;
+  if (epd.Init() != 0) {
+    USE_SERIAL.println("Failed to initialize EPD");
+    return false;
+  }
+  // Enable debug output for troubleshooting
+  epd.ShowDebug = true;
+  panelReady = true;
+  return true;
+}
+
+uint32_t LastSlideCheck()
+{
+  return esp_rom_crc32_le(0, (const uint8_t*)&lastSlide, offsetof(LastSlide, check));
+}
+
+// true when the panel still shows filename and this wake may rely on it;
+// any other wake than the timer (power on, reset) forces a redraw
+bool PanelShows(const String& filename)
+{
+  return wakeup_reason != ESP_SLEEP_WAKEUP_UNDEFINED &&
+         lastSlide.check == LastSlideCheck() && filename == lastSlide.filename;
+}
+
+void SaveLastSlide(const String& filename, const String& etag, const String& lastModified, uint32_t imageCrc)
+{
+  memset(&lastSlide, 0, sizeof(lastSlide));
+  strncpy(lastSlide.filename, filename.c_str(), sizeof(lastSlide.filename) - 1);
+  strncpy(lastSlide.etag, etag.c_str(), sizeof(lastSlide.etag) - 1);
+  strncpy(lastSlide.lastModified, lastModified.c_str(), sizeof(lastSlide.lastModified) - 1);
+  lastSlide.imageCrc = imageCrc;
+  lastSlide.check = LastSlideCheck();
+}
+
+#ifdef PREFETCH_NEXT
+SemaphoreHandle_t prefetchDone;
+TaskHandle_t prefetchTask;
+long prefetchShowIn;
+// the prefetch has its own request and body, and stops at the next read
+// once RefreshPanel() gives up on it
+HTTPClient prefetchHttps;
+SlideSource prefetchSource;
+volatile bool prefetchAbort;
+// still inside a request when the wake ended, it owns its session and
+// WiFi until the deep sleep
+bool prefetchStuck = false;
+
+// Show the slide stored by the last wake and go back to sleep. Returns
+// only when there is none for this wake or it could not be shown.
+void ShowStoredSlide()
+{
+  if (!slideStore.Ready())
+    return;
+  unsigned long startMs = millis();
+  String filename = slideStore.Filename();
+  if (!EnsurePanel() || !slideStore.Upload(epd)) {
+    USE_SERIAL.println("Stored slide not shown, going online");
+    slideStore.Drop();
+    return;
+  }
+  long seconds = slideStore.SecondsDelay();
+  uint32_t imageCrc = slideStore.Crc();
+  // the stored file is the frame on the panel now, the next diff base
+  frameStore.Adopt(SLIDE_STORE_PATH, (uint32_t)epd.steps * epd.blockSize, imageCrc);
+  slideStore.Drop();
+  USE_SERIAL.printf("Stored slide %s sent in %lu ms, WiFi left off\n", filename.c_str(), millis() - startMs);
+  epd.TurnOnDisplay();
+  SaveLastSlide(filename, "", "", imageCrc);
+  GoToSleep(seconds);
+}
+
+// Download the next slide into the slide store
+bool PrefetchSlide(const SlideShowStatus& next)
+{
+  int mirror;
+  String fullPath = MirrorPath(next.filename, 0, &mirror);
+  httpsPool.Begin(prefetchHttps, fullPath);
+  PrepareSlideRequest(prefetchHttps, next.filename, false, false);
+  int httpCode = prefetchHttps.GET();
+  if (httpCode != HTTP_CODE_OK || !slideStore.Create()) {
+    prefetchHttps.end();
+    httpsPool.Close(fullPath);
+    return false;
+  }
+  long total = (long)epd.steps * epd.blockSize;
+  long stored = 0;
+  uint8_t buf[512];
+  unsigned long lastData = millis();
+  BeginSlideSource(prefetchSource, prefetchHttps, prefetchHttps.getStreamPtr(), prefetchHttps.getSize());
+  while (stored < total && !prefetchAbort && prefetchSource.More()) {
+    size_t n = prefetchSource.Read(buf, min((long)sizeof(buf), total - stored));
+    if (n) {
+      if (!slideStore.Append(buf, n))
+        break;
+      stored += n;
+      lastData = millis();
+    } else if (millis() - lastData > WIFI_TIMEOUT) {
+      break;
+    } else {
+      delay(1);
+    }
+  }
+  prefetchHttps.end();
+  if (stored != total) {
+    USE_SERIAL.printf("Prefetch stopped after %ld of %ld bytes\n", stored, total);
+    httpsPool.Close(fullPath);
+    slideStore.Drop();
+    return false;
+  }
+  return slideStore.Commit(next.filename, next.secondsdelay, prefetchShowIn);
+}
+
+void PrefetchTask(void* arg)
+{
+  // every blocking call ends in time to see prefetchAbort
+  prefetchHttps.setConnectTimeout(PREFETCH_IO_TIMEOUT);
+  prefetchHttps.setTimeout(PREFETCH_IO_TIMEOUT);
+  SlideShowStatus next = GetFile(prefetchHttps);
+  if (!prefetchAbort && !next.retry && next.filename[0] != 0 && next.gotosleep)
+    PrefetchSlide(next);
+  xSemaphoreGive(prefetchDone);
+  vTaskDelete(NULL);
+}
+#endif
+
+#ifdef PREFETCH_NEXT
+// Stop a prefetch that overran before GoToSleep() closes the sessions and
+// WiFi. The download loop sees prefetchAbort at its next read; a request
+// in HTTPClient or the TLS handshake gets PREFETCH_ABORT_WAIT to time out.
+// The task is never deleted, it may hold the TLS context or the lwIP
+// core lock. If it is still running GoToSleep() leaves everything as it
+// is. SlideStore::Create() dropped the old slide, so a half file is never
+// shown.
+void StopPrefetch()
+{
+  prefetchAbort = true;
+  if (xSemaphoreTake(prefetchDone, pdMS_TO_TICKS(PREFETCH_ABORT_WAIT)) == pdTRUE)
+    return;
+  prefetchStuck = true;
+  USE_SERIAL.println("Prefetch did not stop, sleeping around it");
+}
+#endif
+
+// Refresh the panel. With PREFETCH_NEXT the next slide downloads while
+// the panel is busy, so the next wake can skip WiFi. Without a prefetch
+// the radio goes off first: EpdIf::WaitBusy() only light-sleeps with
+// WiFi off, else the CPU idles with the radio on for the whole refresh.
+void RefreshPanel(long sleepseconds)
+{
+  bool prefetching = false;
+  bool radioOff = false;
+#ifdef PREFETCH_NEXT
+  prefetchDone = xSemaphoreCreateBinary();
+  prefetchShowIn = sleepseconds;
+  prefetchAbort = false;
+  prefetching = xTaskCreate(PrefetchTask, "prefetch", PREFETCH_STACK, NULL, 1, &prefetchTask) == pdPASS;
+#endif
+#ifdef EPD_BUSY_SLEEP
+  if (!prefetching) {
+    // an SNTP sync still running is dropped, the next wake retries it
+    httpsPool.CloseAll();
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    radioOff = true;
+  }
+#endif
+  unsigned long refreshMs = millis();
+#ifdef FRAME_BUFFER
+  if (frameBuffered) {
+    frameBuffer.Refresh();
+    USE_SERIAL.printf("[FB] %lu bytes in %lu windows, %s refresh\n", frameBuffer.uploaded, frameBuffer.windows,
+                      frameBuffer.lastPartial ? "partial" : "full");
+  } else
+#endif
+  epd.TurnOnDisplay();
+  // refresh time with the radio on (prefetch) or off, for the power budget
+  USE_SERIAL.printf("Refresh took %lu ms, WiFi %s\n", millis() - refreshMs, radioOff ? "off" : "on");
+#ifdef PREFETCH_NEXT
+  unsigned long waitMs = millis();
+  if (prefetching && xSemaphoreTake(prefetchDone, pdMS_TO_TICKS(PREFETCH_TIMEOUT)) != pdTRUE) {
+    USE_SERIAL.println("Prefetch did not finish, sleeping without it");
+    StopPrefetch();
+  } else if (prefetching)
+    USE_SERIAL.printf("Prefetch done %lu ms after the refresh\n", millis() - waitMs);
+#endif
+}
+
+// Compression ratio and decoder time of the last body
+void PrintSlideSource()
+{
+  if (slideSource.GetCodec() == SlideDecoder::RAW)
+    return;
+  USE_SERIAL.printf("Compressed %ld -> %ld bytes, decode time %lu ms\n",
+                    slideSource.received, slideSource.produced, slideSource.decodeUs / 1000);
+}
+
+// Start on a slide body. A diff is applied to the frame in flash; one
+// made for another frame fails, see FrameStore.
+void BeginSlideSource(SlideSource& source, HTTPClient& client, WiFiClient* stream, long len)
+{
+  SlideDecoder::Codec codec = SlideDecoder::ForEncoding(client.header("Content-Encoding"));
+  if (codec == SlideDecoder::DIFF)
+    source.SetBase(frameStore.OpenBase(), frameStore.Crc());
+  source.Begin(stream, len, codec);
+}
+
+// After a body: keep what went to the panel as the next diff base, or
+// forget the base when a diff did not fit it
+void FinishFrame(bool complete)
+{
+  if (slideSource.Failed()) {
+    USE_SERIAL.println("Diff does not fit the stored frame, full slide next");
+    frameStore.Abort();
+    frameStore.Forget();
+  } else if (complete) {
+    frameStore.Keep((uint32_t)epd.steps * epd.blockSize);
+    if (slideSource.GetCodec() == SlideDecoder::DIFF)
+      frameStore.Applied(slideSource.received, slideSource.produced);
+  } else {
+    frameStore.Abort();
+  }
+}
+
+// Ask for the rest of the body, If-Range falls back to the full body
+// (200) when the blob changed in between
+void AddRangeHeader(long from, const String& etag)
+{
+  https.addHeader("Range", "bytes=" + String(from) + "-");
+  if (etag.length() > 0)
+    https.addHeader("If-Range", etag);
+}
+
+// SlidePump callbacks: the slide body in, panel bytes out
+int ReadSlide(uint8_t* dst, size_t len, void* arg)
+{
+  SlideSource* source = (SlideSource*)arg;
+  if (!source->More())
+    return -1;
+  return source->Read(dst, len);
+}
+
+// every panel byte is hashed and kept in flash as the next diff base
+void TapFrame(const uint8_t* src, size_t len, void* arg)
+{
+  uint32_t* crc = (uint32_t*)arg;
+  *crc = esp_rom_crc32_le(*crc, src, len);
+  frameStore.Write(src, len);
+}
+
+void StartPanelStep(int step, void* arg)
+{
+  USE_SERIAL.printf("Processing step %d\n", step);
+  epd.SendCommand(epd.stepCommands[step]);
+  epd.SetToDataMode();
+}
+
+// DMA: the buffer goes out while the pump fills the other one
+void SendPanelAsync(const uint8_t* src, size_t len, void* arg)
+{
+  epd.SendBufferAsync((unsigned char*)src, len);
+  TapFrame(src, len, arg);
+}
+
+void WaitPanel(void* arg)
+{
+  epd.WaitBuffer();
+}
+
+void NoWait(void* arg)
+{
+}
+
+#ifdef FRAME_BUFFER
+bool LoadStoredFrame(int step, unsigned long offset, uint8_t* dst, size_t len, void* arg)
+{
+  return frameStore.Read(step * epd.blockSize + offset, dst, len);
+}
+
+// The frame in flash is what the panel shows when the last wake kept and
+// refreshed it and the panel slept since. Without PSRAM the frame would
+// be banded, which the download cannot fill, so the panel gets it as usual.
+void BeginFrameBuffer()
+{
+  frameBuffered = wakeup_reason != ESP_SLEEP_WAKEUP_UNDEFINED && lastSlide.check == LastSlideCheck() &&
+                  lastSlide.imageCrc != 0 && frameStore.Has((uint32_t)epd.steps * epd.blockSize) &&
+                  frameStore.Crc() == lastSlide.imageCrc && frameBuffer.Begin(epd, LoadStoredFrame, NULL);
+  if (frameBuffered && frameBuffer.Banded()) {
+    frameBuffer.End();
+    frameBuffered = false;
+  }
+}
+
+void StartFrameStep(int step, void* arg)
+{
+  frameBufferAt = (long)step * epd.blockSize;
+}
+
+void UpdateFrame(const uint8_t* src, size_t len, void* arg)
+{
+  frameBuffer.Update(frameBufferAt, src, len);
+  frameBufferAt += len;
+}
+
+void UpdateFrameTap(const uint8_t* src, size_t len, void* arg)
+{
+  UpdateFrame(src, len, arg);
+  TapFrame(src, len, arg);
+}
+#endif
+
+// where DownloadAndDisplay() sends the panel bytes, hashed into crc
+PumpSink DownloadSink(uint32_t* crc)
+{
+#ifdef FRAME_BUFFER
+  if (frameBuffered) {
+    PumpSink sink = { StartFrameStep, UpdateFrameTap, NoWait, crc };
+    return sink;
+  }
+#endif
+  PumpSink sink = { StartPanelStep, SendPanelAsync, WaitPanel, crc };
+  return sink;
+}
+
+#ifdef DITHER_ON_DEVICE
+// The palette of a panel that takes one plane of ACeP or BWRY codes, NULL
+// for the others, which only take panel bytes
+const DitherPalette* PanelPalette()
+{
+  unsigned char bpp = epd.bits_per_pixel;
+  if (bpp == 0 && epd.width > 0 && epd.height > 0)
+    bpp = epd.blockSize * 8 / (epd.width * epd.height);
+  if (epd.steps != 1)
+    return NULL;
+  if (bpp == ditherAcep.bpp)
+    return &ditherAcep;
+  if (bpp == ditherBwry.bpp)
+    return &ditherBwry;
+  return NULL;
+}
+
+// bytes per pixel of a body to dither, 0 for panel bytes
+uint8_t DitherChannels(const String& contentType)
+{
+  if (contentType.startsWith("image/x-epd-rgb"))
+    return 3;
+  if (contentType.startsWith("image/x-epd-gray"))
+    return 1;
+  return 0;
+}
+
+struct DitherSource {
+  SlidePump* pump;
+  size_t rowBytes;
+};
+
+bool ReadDitherRow(unsigned long row, uint8_t* dst, void* arg)
+{
+  DitherSource* source = (DitherSource*)arg;
+  return source->pump->ReadFull(dst, source->rowBytes);
+}
+
+// Dither the slide body to the panel's palette on the way in. The rows
+// come in order from one stream, so they are not shared between cores.
+bool DitherSlide(uint8_t channels)
+{
+  DitherStream dither;
+  if (PanelPalette() == NULL || !dither.Begin(epd, *PanelPalette(), channels))
+    return false;
+  SlidePump pump(1, epd.blockSize, WIFI_TIMEOUT);
+  pump.Source(ReadSlide, &slideSource);
+  DitherSource source = { &pump, (size_t)epd.width * channels };
+  bool ok = dither.Send(ReadDitherRow, &source, false);
+  if (pump.stalled)
+    USE_SERIAL.printf("[HTTPS] no data for %d ms\n", WIFI_TIMEOUT);
+  return ok;
+}
+#endif
+
+// Call between begin() and GET(): collect the validators of the answer
+// and make the request conditional when the panel shows this file already.
+// With dither and DITHER_ON_DEVICE the server may send pixels instead.
+void PrepareSlideRequest(HTTPClient& client, const String& filename, bool conditional, bool dither)
+{
+  client.collectHeaders(slideHeaders, sizeof(slideHeaders) / sizeof(slideHeaders[0]));
+#ifdef DITHER_ON_DEVICE
+  if (dither && PanelPalette() != NULL)
+    client.addHeader("Accept", "image/x-epd-rgb, image/x-epd-gray, */*");
+#endif
+#ifdef FRAME_DIFF
+  // name the frame in flash, the server may answer with a diff against it
+  if (frameStore.Has((uint32_t)epd.steps * epd.blockSize)) {
+    char base[9];
+    snprintf(base, sizeof(base), "%08lx", (unsigned long)frameStore.Crc());
+    client.addHeader("X-Epd-Base", base);
+  }
+#endif
+  if (!conditional || !PanelShows(filename))
+    return;
+  if (lastSlide.etag[0])
+    client.addHeader("If-None-Match", lastSlide.etag);
+  if (lastSlide.lastModified[0])
+    client.addHeader("If-Modified-Since", lastSlide.lastModified);
+}
+
+// Read an API answer into body, false when it did not fit
+bool ReadApiBody(HTTPClient& client, BodyBuffer& body)
+{
+  client.writeToStream(&body);
+  USE_SERIAL.println(body.data);
+  if (body.overflow) {
+    USE_SERIAL.printf("API answer longer than %d bytes\n", API_BODY_SIZE - 1);
+    return false;
+  }
+  return true;
+}
 
 SlideShowStatus GetStart()
 {
   SlideShowStatus slideshowstatus;
-  String result = "";
+  slideshowstatus.filename[0] = 0;
  String message = "{}";
   
   //default if errors
@@ -280,7 +746,7 @@ SlideShowStatus GetStart()
       USE_SERIAL.print("[HTTPS] begin...\n");
       String url =String(API_BASE_URL) + String(API_START_ENDPOINT) + String(storedUserId)+String("/") +String(storedScreenName)+String("/")+String("?subscription-key=")+String(storedSubId) ;
        USE_SERIAL.println(url);
-      if (  https.begin(url ) ) {  
+      if (  httpsPool.Begin(https, url) ) {  
         USE_SERIAL.print("[HTTPS] POST...\n");
         // start connection and send HTTP header
          https.addHeader("Content-Type", "application/json");
@@ -292,9 +758,11 @@ SlideShowStatus GetStart()
   
           // file found at server
           if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY) {
-            result = https.getString();
-             USE_SERIAL.println(result.c_str());
-            DeserializationError err = deserializeJson(doc, result.c_str());
+            BodyBuffer body;
+            SlideShowStatus parsed = slideshowstatus;
+            DeserializationError err = DeserializationError::IncompleteInput;
+            if (ReadApiBody(https, body))
+              err = ParseSlideShow(body.data, body.len, &parsed);
             if (err) {
                   USE_SERIAL.print(F("deserializeJson() failed: "));
                   USE_SERIAL.println(err.c_str());
@@ -305,15 +773,16 @@ SlideShowStatus GetStart()
             {
                 slideshowstatus.retry = false;
             
-                slideshowstatus.gotosleep = doc["gotoSleep"];
-                slideshowstatus.secondsdelay = doc["secondsDelay"];
+                slideshowstatus.gotosleep = parsed.gotosleep;
+                slideshowstatus.secondsdelay = parsed.secondsdelay;
             
                
                 USE_SERIAL.println(slideshowstatus.gotosleep);
                 USE_SERIAL.println(slideshowstatus.secondsdelay);
             }
 
-
+            // body fully read, end() keeps the socket for the next request
+            https.end();
             return slideshowstatus;
           }
         } else {
@@ -330,10 +799,10 @@ SlideShowStatus GetStart()
     return slideshowstatus;
 }
 
-SlideShowStatus GetFile()
+SlideShowStatus GetFile(HTTPClient& client)
 {
   SlideShowStatus slideshowstatus;
-  String result = "";
+  slideshowstatus.filename[0] = 0;
  String message = "{}";
   
   //default if errors
@@ -345,11 +814,11 @@ SlideShowStatus GetFile()
       USE_SERIAL.print("[HTTPS] begin...\n");
       String url =String(API_BASE_URL) + String(API_FILE_ENDPOINT) + String(storedUserId)+String("/") +String(storedScreenName)+String("/")+String("?subscription-key=")+String(storedSubId) ;
       USE_SERIAL.println(url);
-      if (  https.begin(url) ) {  
+      if (  httpsPool.Begin(client, url) ) {  
         USE_SERIAL.print("[HTTPS] POST...\n");
         // start connection and send HTTP header
-         https.addHeader("Content-Type", "application/json");
-    int httpCode = https.POST(message);
+         client.addHeader("Content-Type", "application/json");
+    int httpCode = client.POST(message);
   
         // httpCode will be negative on error
         if (httpCode > 0) {
@@ -358,9 +827,11 @@ SlideShowStatus GetFile()
   
           // file found at server
           if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY) {
-            result = https.getString();
-             USE_SERIAL.println(result.c_str());
-            DeserializationError err = deserializeJson(doc, result.c_str());
+            BodyBuffer body;
+            SlideShowStatus parsed = slideshowstatus;
+            DeserializationError err = DeserializationError::IncompleteInput;
+            if (ReadApiBody(client, body))
+              err = ParseSlideShow(body.data, body.len, &parsed);
             if (err) {
                   USE_SERIAL.print(F("deserializeJson() failed: "));
                   USE_SERIAL.println(err.c_str());
@@ -369,24 +840,23 @@ SlideShowStatus GetFile()
 
             }else
             {
+                slideshowstatus = parsed;
                 slideshowstatus.retry = false;
-                slideshowstatus.filename = doc["fileName"];
-                slideshowstatus.gotosleep = doc["gotoSleep"];
-                slideshowstatus.secondsdelay = doc["secondsDelay"];
                 slideshowstatus.didcall = true;
                 USE_SERIAL.println(slideshowstatus.filename);
                 USE_SERIAL.println(slideshowstatus.gotosleep);
                 USE_SERIAL.println(slideshowstatus.secondsdelay);
             }
 
-
+            // body fully read, end() keeps the socket for the next request
+            client.end();
             return slideshowstatus;
           }
         } else {
-          USE_SERIAL.printf("[HTTPS] GET... failed, code: %d  error: %s\n",httpCode, https.errorToString(httpCode).c_str());
+          USE_SERIAL.printf("[HTTPS] GET... failed, code: %d  error: %s\n",httpCode, client.errorToString(httpCode).c_str());
         }
   
-        https.end();
+        client.end();
       } else {
         USE_SERIAL.printf("[HTTPS] Unable to connect\n");
       }
@@ -396,10 +866,33 @@ SlideShowStatus GetFile()
 
 void GoToSleep(long seconds)
 {
+#ifdef PREFETCH_NEXT
+                if (prefetchStuck) {
+                  // the prefetch task may be inside lwIP or mbedtls: no
+                  // session or WiFi teardown, deep sleep powers them off
+                  if (panelReady)
+                    epd.Sleep();
+                  esp_sleep_enable_timer_wakeup(seconds * uS_TO_S_FACTOR);
+                  USE_SERIAL.flush();
+                  esp_deep_sleep_start();
+                }
+#endif
   
+                // close the kept sessions while the link is still up
+                httpsPool.CloseAll();
+                USE_SERIAL.printf("[HTTPS] %d requests, %d TLS handshakes (%d resumed) this wake\n", httpsPool.requests, httpsPool.handshakes, TlsClient::resumedCount);
+                mirrors.Print();
+                wifiFast.Print();
+                wallClock.Print();
+                frameStore.Print();
                 WiFi.disconnect(true);
                 WiFi.mode(WIFI_OFF);
-                epd.Sleep();
+                if (panelReady)
+                  epd.Sleep();
+#ifdef EPD_SPI_TRACE
+                // the ring covers the whole wake cycle, dump it before it is lost
+                EpdIf::TraceDump();
+#endif
                 esp_sleep_enable_timer_wakeup(seconds * uS_TO_S_FACTOR);
                 USE_SERIAL.println("Setup ESP32 to sleep for every " + String(seconds) +  " Seconds");
                 USE_SERIAL.println("Going to sleep now");
@@ -428,9 +921,10 @@ void loop() {
     if(loopcount > LOOP_TIMEOUT) {
     GoToSleep(TIMEOUT_SLEEP);  
   }  
-  if(WiFiMulti.run() == WL_CONNECTED) {
-      setClock();  
-      delay(200);
+  if(wifiFast.Run(WiFiMulti, storedSSID.c_str(), storedPassword.c_str()) == WL_CONNECTED) {
+      // NTP runs in the background, nothing here waits for it
+      wallClock.Start();
+      wallClock.Print();
       USE_SERIAL.print("Device Id = ");
       USE_SERIAL.println(storedDeviceId);
       if(needDeviceIfo)
@@ -475,9 +969,13 @@ void loop() {
       {
         GoToSleep(slideShowStatus.secondsdelay);  
       }  
-      slideShowStatus= GetFile(); 
-      if(slideShowStatus.filename != "")
+      slideShowStatus= GetFile(https); 
+      if(slideShowStatus.filename[0] != 0)
       {
+ #ifdef USE_PIPELINE_TASKS
+         // retries and mirror fallback are handled by the network task
+         dstatus = DownloadAndDisplayPipelined(slideShowStatus.filename,slideShowStatus.secondsdelay);
+#else
          for(int i=0;i< MAX_RETRIES ; i++)
         {
            dstatus = DownloadAndDisplay(slideShowStatus.filename,slideShowStatus.secondsdelay,i);
@@ -490,10 +988,12 @@ void loop() {
             }
              
         }
+#endif
        
       }else
       {
-          epd.Clear(0x1);
+          if (EnsurePanel())
+            epd.Clear(0x1);
          delay(500);
       }
   } else {
@@ -509,120 +1009,227 @@ void Download2(String filename)
       USE_SERIAL.println(fullPath);
 }      
 
+// URL of the slide on the mirror picked for this attempt
+String MirrorPath(String filename, int retrycnt, int* mirror)
+{
+  *mirror = mirrors.Pick(retrycnt);
+#ifdef MIRROR_RACE
+  if(retrycnt == 0) {
+    int other = mirrors.Pick(1);
+    int won = httpsPool.Race(String(blobMirrors[*mirror]) + filename, String(blobMirrors[other]) + filename);
+    if(won == 1)
+      *mirror = other;
+    USE_SERIAL.printf("[MIRROR] race won by %d\n", *mirror);
+  }
+#endif
+  return String(blobMirrors[*mirror]) + filename;
+}
+
 int DownloadAndDisplay(String filename, long sleepseconds, int retrycnt) {
   int displaycnt = 0;
-      String fullPath = String(BLOB_URL_PRIMARY) + filename;
-      String fullPath2 = String(BLOB_URL_SECONDARY) + filename;
-
-      if(retrycnt > 1)
-        fullPath = fullPath2;
+      int mirror;
+      String fullPath = MirrorPath(filename, retrycnt, &mirror);
       USE_SERIAL.println("[fullPath]");
       USE_SERIAL.println(fullPath);
 
-      https.begin(fullPath);
+      // put the panel write pointer back to where the last attempt stopped
+      long startAt = 0;
+      if(panelReady && downloadResume.done > 0 && downloadResume.filename == filename) {
+        int step = downloadResume.done / epd.blockSize;
+        long at = epd.ResumeStep(step, downloadResume.done % epd.blockSize);
+        if(at < 0) {
+          // no way to reposition this controller, initialise it again
+          panelReady = false;
+        } else {
+          startAt = step * epd.blockSize + at;
+        }
+      }
+
+      httpsPool.Begin(https, fullPath);
+      // a dithered slide cannot be resumed, only a fresh download offers it
+      PrepareSlideRequest(https, filename, startAt == 0, startAt == 0);
+      if(startAt > 0 && downloadResume.raw) {
+        AddRangeHeader(startAt, downloadResume.etag);
+      }
 
         USE_SERIAL.print("[HTTP] GET...\n");
         // start connection and send HTTP header
+        unsigned long requestMs = millis();
         int httpCode = https.GET();
+        unsigned long connectMs = millis() - requestMs;
           USE_SERIAL.printf("[HTTPS] A GET... code: %d\n", httpCode);
         if(httpCode > 0) {
              USE_SERIAL.printf("[HTTPS] B GET... code: %d\n", httpCode);
-               if(httpCode == HTTP_CODE_OK) {
+               if(httpCode == HTTP_CODE_NOT_MODIFIED) {
+                 https.end();
+                 mirrors.Record(mirror, connectMs, 0, 0, true);
+                 USE_SERIAL.println("Slide not modified, panel left asleep");
+                 GoToSleep(sleepseconds);
+                 return SLIDE_NOT_MODIFIED;
+               }
+               if(httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_PARTIAL_CONTENT) {
+                String etag = https.header("ETag");
+                String lastModified = https.header("Last-Modified");
+                uint32_t imageCrc = 0;
+                if(startAt > 0 && httpCode == HTTP_CODE_OK && etag != downloadResume.etag) {
+                  // the blob changed since the first part, start over on a fresh panel
+                  USE_SERIAL.println("Slide changed during resume, starting over");
+                  downloadResume.done = 0;
+                  panelReady = false;
+                  https.end();
+                  httpsPool.Close(fullPath);
+                  return 0;
+                }
 
                 // get length of document (is -1 when Server sends no Content-Length header)
                 int len = https.getSize();
                 USE_SERIAL.printf("[HTTPS] Len: %d\n", len);
  
                
-                int offset1=0;
-                // create buffer for read
-                uint8_t buff[DOWNLOAD_BUFFER_SIZE] = { 0 };
-                int maxread = sizeof(buff);
-                int timeoutcnt = TIMEOUT_COUNTER;
                 // get tcp stream
                 WiFiClient * stream = https.getStreamPtr();
-                  if(!https.connected())
+                  if(!https.connected()) {
+                    https.end();
+                    mirrors.Record(mirror, connectMs, 0, 0, false);
                     return -2;
+                  }
+                  if(!EnsurePanel()) {
+                    https.end();
+                    httpsPool.Close(fullPath);
+                    return -4;
+                  }
+#ifdef DITHER_ON_DEVICE
+                uint8_t channels = startAt == 0 ? DitherChannels(https.header("Content-Type")) : 0;
+                if(channels != 0) {
+                  // the panel bytes are made here: nothing to resume, and
+                  // the frame in flash is no longer on the panel
+                  downloadResume.done = 0;
+                  frameStore.Forget();
+                  BeginSlideSource(slideSource, https, stream, len);
+                  unsigned long startMs = millis();
+                  bool ok = DitherSlide(channels);
+                  https.end();
+                  if(!ok) {
+                    mirrors.Record(mirror, connectMs, 0, 0, false);
+                    httpsPool.Close(fullPath);
+                    return 0;
+                  }
+                  mirrors.Record(mirror, connectMs, slideSource.received, millis() - startMs, true);
+                  PrintSlideSource();
+                  delay(DOWNLOAD_DELAY);
+                  USE_SERIAL.println("Turning on display...");
+                  RefreshPanel(sleepseconds);
+                  SaveLastSlide(filename, etag, lastModified, 0);
+                  GoToSleep(sleepseconds);
+                  return 1;
+                }
+#endif
+#ifdef FRAME_BUFFER
+                // before the diff decoder opens the stored frame as its base
+                if(startAt == 0)
+                  BeginFrameBuffer();
+                frameBufferAt = startAt;
+#endif
+                BeginSlideSource(slideSource, https, stream, len);
+                if(startAt > 0) {
+                  USE_SERIAL.printf("Resuming at byte %ld%s\n", startAt,
+                                    httpCode == HTTP_CODE_PARTIAL_CONTENT ? "" : " (full body, skipping)");
+                }
+
+                // Ping-pong buffers: one fills from the network while the
+                // other is still going out to the panel by SPI DMA
+                size_t bufSize = epd.streamBufferSize;
+                uint8_t* bufs[2];
+                bufs[0] = (uint8_t*)heap_caps_malloc(bufSize, MALLOC_CAP_DMA);
+                bufs[1] = (uint8_t*)heap_caps_malloc(bufSize, MALLOC_CAP_DMA);
+                if(bufs[0] == NULL || bufs[1] == NULL) {
+                  USE_SERIAL.println("Unable to allocate download buffers");
+                  heap_caps_free(bufs[0]);
+                  heap_caps_free(bufs[1]);
+                  // the body was not read, the socket cannot be reused
+                  https.end();
+                  httpsPool.Close(fullPath);
+                  return -3;
+                }
                  USE_SERIAL.println("Starting display update");
                  USE_SERIAL.print("Steps: ");
                  USE_SERIAL.println(epd.steps);
                  USE_SERIAL.print("Block size: ");
                  USE_SERIAL.println(epd.blockSize);
+                 USE_SERIAL.print("Buffer size: ");
+                 USE_SERIAL.println(bufSize);
+#ifdef EPD_SPI_STATS
+                 EpdIf::SpiStatsReset();
+#endif
+                 unsigned long startMs = millis();
+                 // a body that stops sending gives up after WIFI_TIMEOUT
+                 SlidePump pump(epd.steps, epd.blockSize, WIFI_TIMEOUT);
+                 pump.Source(ReadSlide, &slideSource);
                  
-                 // Use step-based approach like working serial version
-                 for(int step = 0; step < epd.steps; step++) {
-                   long stepLen = epd.blockSize;
-                   epd.SendCommand(epd.stepCommands[step]);
-                   epd.SetToDataMode();
-                   
-                   USE_SERIAL.print("Processing step  BBB ");
-                   USE_SERIAL.print(step);
-                   USE_SERIAL.print(" with ");
-                   USE_SERIAL.print(stepLen);
-                   USE_SERIAL.println(" bytes");
-                   
-                   if (len == -1) {
-                     // Unknown length - read all available data
-                     while (https.connected() && (stream->available() || stream->connected()) && stepLen > 0) {
-                       size_t size = stream->available();
-                       if (size > 0) {
-                         size_t readBytes = stream->readBytes(buff, min(size, min((size_t)sizeof(buff), (size_t)stepLen)));
-                         for(int i = 0; i < readBytes; i++) {
-                            if(step==0) 
-                             
-                              epd.SendDataFast(buff[i]);
-                            
-                            else
-                             epd.SendDataFast(buff[i]);
-                         }
-                         stepLen -= readBytes;
-                         offset1 += readBytes;
-                       }
-                       delay(1);
-                     }
-                   } else {
-                     // Known length - read exactly what we need
-                     while(https.connected() && len > 0 && stepLen > 0) {
-                       size_t size = stream->available();
-                       if(size) {
-                         int c = stream->readBytes(buff, min(size, min(sizeof(buff), min((size_t)len, (size_t)stepLen))));
-                         for(int i = 0; i < c; i++) {
-                           if(step==0) 
-                              
-                              epd.SendDataFast(buff[i]);
-                            
-                            else
-                             epd.SendDataFast(buff[i]);
-                         
-                         }
-                         offset1 += c;
-                         stepLen -= c;
-                         if(len > 0) {
-                           len -= c;
-                         }
-                       } else {
-                         timeoutcnt--;
-                         delay(2);
-                       }
-                       delay(1);
-                     }
-                   }
+                 // a full body has to be read up to the resume point first
+                 if(httpCode == HTTP_CODE_OK && startAt > 0 && !pump.Skip(startAt)) {
+                   heap_caps_free(bufs[0]);
+                   heap_caps_free(bufs[1]);
+                   https.end();
+                   httpsPool.Close(fullPath);
+                   return 0;
                  }
+
+                 // a resumed image is not whole in flash, keep the old base then
+                 if(startAt == 0)
+                   frameStore.Record();
+
+                 // Use step-based approach like working serial version
+                 bool whole = pump.Run(bufs, bufSize, DownloadSink(&imageCrc), startAt);
+                 if(pump.stalled)
+                   USE_SERIAL.printf("[HTTPS] no data for %d ms\n", WIFI_TIMEOUT);
+                 long offset1 = pump.moved;
+                heap_caps_free(bufs[0]);
+                heap_caps_free(bufs[1]);
+                // short of a whole frame is cut, also when the length was unknown
+                bool cut = !whole || slideSource.Failed();
+                https.end();
+                if(cut) {
+                  FinishFrame(false);
+                  mirrors.Record(mirror, connectMs, 0, 0, false);
+                  // the body ended early, remember how far the panel got
+                  downloadResume.filename = filename;
+                  downloadResume.done = startAt + offset1;
+                  downloadResume.raw = slideSource.GetCodec() == SlideDecoder::RAW;
+                  downloadResume.etag = etag;
+                  httpsPool.Close(fullPath);
+                  USE_SERIAL.printf("[HTTPS] connection lost after %ld bytes\n", downloadResume.done);
+                  return 0;
+                }
+                downloadResume.done = 0;
+                mirrors.Record(mirror, connectMs, slideSource.received, millis() - startMs, true);
           
 
 
                 USE_SERIAL.println();
-                USE_SERIAL.printf("Total bytes processed: %d\n", offset1);
+                USE_SERIAL.printf("Total bytes processed: %ld\n", offset1);
+                USE_SERIAL.printf("Transfer time: %lu ms\n", millis() - startMs);
+                PrintSlideSource();
+#ifdef EPD_SPI_STATS
+                EpdIf::SpiStatsPrint();
+#endif
                 USE_SERIAL.print("[HTTP] connection closed or file end.\n");
                 delay(DOWNLOAD_DELAY);
                 
-                // Turn on display to show the downloaded image
-                USE_SERIAL.println("Turning on display...");
-                epd.TurnOnDisplay();
-                USE_SERIAL.println("Display updated successfully");
+                if(startAt == 0 && PanelShows(filename) && imageCrc == lastSlide.imageCrc) {
+                  // same bytes as on screen, the server just had no validator
+                  USE_SERIAL.println("Image unchanged, refresh skipped");
+                } else {
+                  // Turn on display to show the downloaded image
+                  USE_SERIAL.println("Turning on display...");
+                  RefreshPanel(sleepseconds);
+                  USE_SERIAL.println("Display updated successfully");
+                }
+                // after the refresh, a partial one may read the old frame
+                FinishFrame(true);
+                // a resumed image was only partly hashed here
+                SaveLastSlide(filename, etag, lastModified, startAt == 0 ? imageCrc : 0);
                 
-                WiFi.disconnect(true);
-                WiFi.mode(WIFI_OFF);
                 USE_SERIAL.println("GoToSleep");
                 GoToSleep(sleepseconds);
                   
@@ -630,14 +1237,282 @@ int DownloadAndDisplay(String filename, long sleepseconds, int retrycnt) {
           return 1;
         }  
       }
+        https.end();
+        // no answer or an error status, count it against the mirror
+        mirrors.Record(mirror, connectMs, 0, 0, false);
         return 0;
   }        
 
+#ifdef USE_PIPELINE_TASKS
+/**
+ * Network task fills the ring from HTTPS, panel task drains it to the panel.
+ * Each side only touches its own end of the ring, the semaphores are only
+ * used to sleep while the ring is empty or full.
+ */
+struct ImagePipe {
+  SpscRing ring;
+  String filename;
+  SemaphoreHandle_t dataReady;   // given by the network task after a write
+  SemaphoreHandle_t spaceReady;  // given by the panel task after a read
+  SemaphoreHandle_t finished;    // given once by each task when it exits
+  int status;                    // network result, > 0 on success
+  long sent;                     // bytes the panel task pushed to the panel
+  volatile bool accepted;        // server answered 200, the panel is needed
+  String etag;                   // validators of the answer
+  String lastModified;
+  uint32_t imageCrc;             // CRC32 of the bytes put in the ring
+  bool raw;                      // last body was not compressed
+};
+
+ImagePipe imagePipe;
+
+// SlidePump links across the ring, each task sleeps on its semaphore
+void WaitRingSpace(void* arg)
+{
+  xSemaphoreTake(imagePipe.spaceReady, pdMS_TO_TICKS(10));
+}
+
+void SignalRingData(void* arg)
+{
+  xSemaphoreGive(imagePipe.dataReady);
+}
+
+void WaitRingData(void* arg)
+{
+  xSemaphoreTake(imagePipe.dataReady, pdMS_TO_TICKS(10));
+}
+
+void SignalRingSpace(void* arg)
+{
+  xSemaphoreGive(imagePipe.spaceReady);
+}
+
+// the panel task sends from the ring, each chunk is out before it is freed
+void SendPanel(const uint8_t* src, size_t len, void* arg)
+{
+  epd.SendBuffer((unsigned char*)src, len);
+}
+
+// One attempt against one mirror. produced counts bytes already in the ring
+// from earlier attempts; that many bytes are skipped so a retry resumes.
+int StreamToRing(String filename, int retrycnt, long* produced) {
+  int mirror;
+  String fullPath = MirrorPath(filename, retrycnt, &mirror);
+  USE_SERIAL.println("[fullPath]");
+  USE_SERIAL.println(fullPath);
+
+  httpsPool.Begin(https, fullPath);
+  // once part of the image is in the ring only a full answer will do
+  // the ring carries panel bytes, the pipeline does not dither
+  PrepareSlideRequest(https, filename, *produced == 0, false);
+  if(*produced > 0 && imagePipe.raw) {
+    AddRangeHeader(*produced, imagePipe.etag);
+  }
+  unsigned long requestMs = millis();
+  int httpCode = https.GET();
+  unsigned long connectMs = millis() - requestMs;
+  USE_SERIAL.printf("[HTTPS] GET... code: %d\n", httpCode);
+  if(httpCode == HTTP_CODE_NOT_MODIFIED) {
+    https.end();
+    mirrors.Record(mirror, connectMs, 0, 0, true);
+    return SLIDE_NOT_MODIFIED;
+  }
+  if(httpCode != HTTP_CODE_OK && httpCode != HTTP_CODE_PARTIAL_CONTENT) {
+    https.end();
+    mirrors.Record(mirror, connectMs, 0, 0, false);
+    // the error body may still be in flight, do not reuse the socket
+    httpsPool.Close(fullPath);
+    return httpCode > 0 ? 0 : httpCode;
+  }
+
+  if(*produced > 0 && httpCode == HTTP_CODE_OK && https.header("ETag") != imagePipe.etag) {
+    // the ring already holds the start of the old blob, retrying cannot help
+    USE_SERIAL.println("Slide changed during resume");
+    https.end();
+    httpsPool.Close(fullPath);
+    return -5;
+  }
+  imagePipe.etag = https.header("ETag");
+  imagePipe.lastModified = https.header("Last-Modified");
+  if(!imagePipe.accepted) {
+    // let the panel task wake the panel while the body streams in
+    imagePipe.accepted = true;
+    xSemaphoreGive(imagePipe.dataReady);
+  }
+
+  // get length of document (is -1 when Server sends no Content-Length header)
+  int len = https.getSize();
+  USE_SERIAL.printf("[HTTPS] Len: %d\n", len);
+  // a 206 starts where the ring stopped, a full body repeats the start
+  long skip = httpCode == HTTP_CODE_PARTIAL_CONTENT ? 0 : *produced;
+  unsigned long bodyMs = millis();
+  BeginSlideSource(slideSource, https, https.getStreamPtr(), len);
+  if(*produced == 0)
+    frameStore.Record();
+  imagePipe.raw = slideSource.GetCodec() == SlideDecoder::RAW;
+
+  // skipped in panel bytes, so a compressed body resumes at the same point
+  SlidePump pump(epd.steps, epd.blockSize, WIFI_TIMEOUT);
+  pump.Source(ReadSlide, &slideSource);
+  PumpLink link = { WaitRingSpace, SignalRingData, NULL };
+  bool whole = pump.Fill(imagePipe.ring, produced, skip, link, TapFrame, &imagePipe.imageCrc);
+  if(pump.stalled)
+    USE_SERIAL.printf("[HTTPS] no data for %d ms\n", WIFI_TIMEOUT);
+  https.end();
+  PrintSlideSource();
+
+  if(slideSource.Failed()) {
+    // the ring holds what the diff produced so far, the retry skips it
+    FinishFrame(false);
+    mirrors.Record(mirror, connectMs, 0, 0, true);
+    httpsPool.Close(fullPath);
+    return -2;
+  }
+  // a closed connection ends an unknown length too, whole only with every byte
+  if(whole) {
+    // FinishFrame() once the frame is on the panel
+    mirrors.Record(mirror, connectMs, slideSource.received, millis() - bodyMs, true);
+    return 1;
+  }
+  mirrors.Record(mirror, connectMs, 0, 0, false);
+  USE_SERIAL.printf("[HTTPS] connection lost after %ld bytes\n", *produced);
+  httpsPool.Close(fullPath);
+  return -2;
+}
+
+void NetTask(void* arg) {
+  long produced = 0;
+  int status = 0;
+  for(int i = 0; i < MAX_RETRIES; i++) {
+    status = StreamToRing(imagePipe.filename, i, &produced);
+    if(status > 0 || status == -5)
+      break;
+    USE_SERIAL.print("Retry download, status: ");
+    USE_SERIAL.println(status);
+    delay(5000);
+  }
+  if(status <= 0)
+    frameStore.Abort();
+  imagePipe.status = status;
+  imagePipe.ring.Close();
+  xSemaphoreGive(imagePipe.dataReady);
+  xSemaphoreGive(imagePipe.finished);
+  vTaskDelete(NULL);
+}
+
+void PanelTask(void* arg) {
+  long sent = 0;
+  while(!imagePipe.accepted && !imagePipe.ring.Drained()) {
+    xSemaphoreTake(imagePipe.dataReady, pdMS_TO_TICKS(10));
+  }
+  if(imagePipe.accepted && !EnsurePanel()) {
+    // nowhere to put the image, keep the network task from blocking
+    while(!imagePipe.ring.Drained()) {
+      size_t n;
+      imagePipe.ring.ReadPtr(&n);
+      imagePipe.ring.Consume(n);
+      xSemaphoreGive(imagePipe.spaceReady);
+      xSemaphoreTake(imagePipe.dataReady, pdMS_TO_TICKS(10));
+    }
+  }
+  if(panelReady) {
+    SlidePump pump(epd.steps, epd.blockSize, WIFI_TIMEOUT);
+    PumpSink sink = { StartPanelStep, SendPanel, NoWait, NULL };
+#ifdef FRAME_BUFFER
+    if(frameBuffered) {
+      PumpSink frameSink = { StartFrameStep, UpdateFrame, NoWait, NULL };
+      sink = frameSink;
+    }
+#endif
+    PumpLink link = { WaitRingData, SignalRingSpace, NULL };
+    sent = pump.Drain(imagePipe.ring, epd.streamBufferSize, sink, link);
+  }
+  imagePipe.sent = sent;
+  xSemaphoreGive(imagePipe.finished);
+  vTaskDelete(NULL);
+}
+
+int DownloadAndDisplayPipelined(String filename, long sleepseconds) {
+  uint8_t* ringBuf = (uint8_t*)heap_caps_malloc(PIPE_RING_SIZE, MALLOC_CAP_DMA);
+  if(ringBuf == NULL) {
+    USE_SERIAL.println("Unable to allocate ring buffer");
+    return -3;
+  }
+  imagePipe.ring.Init(ringBuf, PIPE_RING_SIZE);
+  imagePipe.filename = filename;
+  imagePipe.status = 0;
+  imagePipe.sent = 0;
+  imagePipe.accepted = false;
+  imagePipe.imageCrc = 0;
+  imagePipe.raw = false;
+  imagePipe.dataReady = xSemaphoreCreateBinary();
+  imagePipe.spaceReady = xSemaphoreCreateBinary();
+  imagePipe.finished = xSemaphoreCreateCounting(2, 0);
+
+  USE_SERIAL.println("Starting display update");
+  USE_SERIAL.print("Steps: ");
+  USE_SERIAL.println(epd.steps);
+  USE_SERIAL.print("Block size: ");
+  USE_SERIAL.println(epd.blockSize);
+#ifdef EPD_SPI_STATS
+  EpdIf::SpiStatsReset();
+#endif
+  unsigned long startMs = millis();
+#ifdef FRAME_BUFFER
+  // read from flash before the network task may open it as a diff base
+  BeginFrameBuffer();
+#endif
+
+  xTaskCreatePinnedToCore(PanelTask, "epdPanel", PIPE_PANEL_STACK, NULL, 2, NULL, PIPE_PANEL_CORE);
+  xTaskCreatePinnedToCore(NetTask, "epdNet", PIPE_NET_STACK, NULL, 2, NULL, PIPE_NET_CORE);
+  xSemaphoreTake(imagePipe.finished, portMAX_DELAY);
+  xSemaphoreTake(imagePipe.finished, portMAX_DELAY);
+
+  vSemaphoreDelete(imagePipe.dataReady);
+  vSemaphoreDelete(imagePipe.spaceReady);
+  vSemaphoreDelete(imagePipe.finished);
+  heap_caps_free(ringBuf);
+
+  USE_SERIAL.printf("Total bytes processed: %ld\n", imagePipe.sent);
+  USE_SERIAL.printf("Transfer time: %lu ms\n", millis() - startMs);
+#ifdef EPD_SPI_STATS
+  EpdIf::SpiStatsPrint();
+#endif
+  if(imagePipe.status == SLIDE_NOT_MODIFIED) {
+    USE_SERIAL.println("Slide not modified, panel left asleep");
+    GoToSleep(sleepseconds);
+    return SLIDE_NOT_MODIFIED;
+  }
+  if(imagePipe.status <= 0 || !panelReady) {
+    FinishFrame(false);
+    USE_SERIAL.print("DownloadAndDisplay failed, status: ");
+    USE_SERIAL.println(imagePipe.status);
+    return imagePipe.status;
+  }
+  delay(DOWNLOAD_DELAY);
+
+  if(PanelShows(filename) && imagePipe.imageCrc == lastSlide.imageCrc) {
+    // same bytes as on screen, the server just had no validator
+    USE_SERIAL.println("Image unchanged, refresh skipped");
+  } else {
+    USE_SERIAL.println("Turning on display...");
+    RefreshPanel(sleepseconds);
+    USE_SERIAL.println("Display updated successfully");
+  }
+  // after the refresh, a partial one may read the old frame
+  FinishFrame(true);
+  SaveLastSlide(filename, imagePipe.etag, imagePipe.lastModified, imagePipe.imageCrc);
+
+  USE_SERIAL.println("GoToSleep");
+  GoToSleep(sleepseconds);
+  return 1;
+}
+#endif
+
 int getDeviceInfo(String deviceId) {
-     String result = "";
 
        USE_SERIAL.print("[HTTPS] begin...\n");
-      if (  https.begin(String(API_BASE_URL) + String(API_DEVICE_ENDPOINT)+String(deviceId) ) ) {  
+      if (  httpsPool.Begin(https, String(API_BASE_URL) + String(API_DEVICE_ENDPOINT)+String(deviceId)) ) {  
         USE_SERIAL.print("[HTTPS] GET...\n");
         // start connection and send HTTP header
         // https.addHeader("Content-Type", "application/json");
@@ -649,26 +1524,23 @@ int getDeviceInfo(String deviceId) {
   
           // file found at server
           if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_MOVED_PERMANENTLY) {
-            result = https.getString();
-             USE_SERIAL.println(result.c_str());
-            DeserializationError err = deserializeJson(doc, result.c_str());
+            BodyBuffer body;
+            DeviceInfo info;
+            DeserializationError err = DeserializationError::IncompleteInput;
+            bool complete = false;
+            if (ReadApiBody(https, body))
+              complete = ParseDeviceInfo(body.data, body.len, &info, &err);
             if (err) {
                   USE_SERIAL.print(F("deserializeJson() failed: "));
                   USE_SERIAL.println(err.c_str());
+                  https.end();
                   return 0;
 
             } else {
-                // Check if required fields exist in JSON response
-                if (doc.containsKey("AccountID") && doc.containsKey("SlideShowId") && doc.containsKey("subscriptionKey")) {
-                    // Safely extract values with null checks
-                    const char* accountId = doc["AccountID"];
-                    const char* slideShowId = doc["SlideShowId"];
-                    const char* subscriptionKey = doc["subscriptionKey"];
-                    
-                    if (accountId != nullptr && slideShowId != nullptr && subscriptionKey != nullptr) {
-                        storedUserId = String(accountId);
-                        storedScreenName = String(slideShowId);
-                        storedSubId = String(subscriptionKey);
+                    if (complete) {
+                        storedUserId = String(info.accountId);
+                        storedScreenName = String(info.slideShowId);
+                        storedSubId = String(info.subscriptionKey);
                         
                         USE_SERIAL.println("Device info extracted successfully:");
                         USE_SERIAL.print("AccountID: ");
@@ -680,23 +1552,22 @@ int getDeviceInfo(String deviceId) {
                         
                         saveDeviceInfo(storedSubId, storedUserId, storedScreenName);
                     } else {
-                        USE_SERIAL.println("Error: One or more fields contain null values");
+                        USE_SERIAL.println("Error: Missing or oversized fields in JSON response");
+                        USE_SERIAL.println("Expected fields: AccountID, SlideShowId, subscriptionKey");
                     }
-                } else {
-                    USE_SERIAL.println("Error: Missing required fields in JSON response");
-                    USE_SERIAL.println("Expected fields: AccountID, SlideShowId, subscriptionKey");
-                }
             }
 
-
+            https.end();
             return 1;
           }
         } else {
           USE_SERIAL.printf("[HTTPS] GET... failed, code: %d  error: %s\n",httpCode, https.errorToString(httpCode).c_str());
+          https.end();
           return -2;
         }
   
         https.end();
+        return 0;
       } else {
         USE_SERIAL.printf("[HTTPS] Unable to connect\n");
          return -1;
@@ -993,6 +1864,8 @@ void handleSave() {
     if (ssid.length() > 0 && ssid.length() <= EEPROM_STRING_SIZE - 1 && 
         password.length() <= EEPROM_PASS_SIZE - 1) {
       saveCredentials(ssid, password,deviceid);
+      // the cached access point belongs to the old network
+      wifiFast.Forget();
       
       String html;
       char buffer[2048];
@@ -33,10 +33,132 @@
 #include <SPI.h>
 
 #if CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3  || CONFIG_IDF_TARGET_ESP32C3
-static const int spiClk = 1000000; // 1 MHz
 SPIClass *vspi;
 #endif
 
+#ifdef EPD_FAST_GPIO
+#include "hal/gpio_ll.h"
+#include "soc/gpio_struct.h"
+#endif
+
+EpdSpiProfile EpdIf::spiProfile = { 8000000, 0, 0, 0 };
+unsigned long EpdIf::spiClockHz = 0;
+
+// Last level written to DC, -1 when unknown
+static int dcLevel = -1;
+
+// Pin write used for CS/DC/RST. The fast path sets the GPIO set/clear
+// registers directly, digitalWrite() stays as the portable fallback.
+static inline void GpioWrite(int pin, int value) {
+#ifdef EPD_FAST_GPIO
+    gpio_ll_set_level(&GPIO, (gpio_num_t)pin, value ? 1 : 0);
+#else
+    digitalWrite(pin, value);
+#endif
+}
+
+// Sub-microsecond datasheet minimums are met by the GPIO call overhead
+static inline void SpiWaitNs(unsigned int ns) {
+    if (ns >= 1000) {
+        delayMicroseconds(ns / 1000);
+    }
+}
+
+#ifdef EPD_SPI_TRACE
+static EpdTraceEvent traceRing[EPD_TRACE_EVENTS];
+static unsigned long traceCount = 0;    // events recorded since TraceReset()
+static long traceAsync = -1;            // event of the DMA burst in flight
+
+static EpdTraceEvent* TraceAdd(uint8_t type, uint8_t value, unsigned long startUs, unsigned long len) {
+    EpdTraceEvent* e = &traceRing[traceCount % EPD_TRACE_EVENTS];
+    e->startUs = startUs;
+    e->durUs = micros() - startUs;
+    e->len = len;
+    e->type = type;
+    e->value = value;
+    e->reserved = 0;
+    traceCount++;
+    return e;
+}
+
+// A transfer that ends now. Single data bytes straight after other data
+// (SendData loops) extend that event instead of filling the ring.
+static void TraceTransfer(const unsigned char* data, unsigned long startUs, unsigned long len) {
+    if (dcLevel == LOW) {
+        TraceAdd(EPD_TRACE_CMD, data[0], startUs, len);
+        return;
+    }
+    if (len == 1 && traceCount > 0) {
+        EpdTraceEvent* last = &traceRing[(traceCount - 1) % EPD_TRACE_EVENTS];
+        if (last->type == EPD_TRACE_DATA && (long)(traceCount - 1) != traceAsync) {
+            last->durUs = micros() - last->startUs;
+            last->len++;
+            return;
+        }
+    }
+    TraceAdd(EPD_TRACE_DATA, data[0], startUs, len);
+}
+#define TRACE_START() unsigned long traceStart = micros()
+#else
+#define TRACE_START()
+#endif
+
+#ifdef EPD_SPI_STATS
+// One SPI call of len bytes with CS held low for all of them
+static inline void SpiStatsCount(unsigned long len) {
+    EpdIf::spiStats.calls++;
+    EpdIf::spiStats.bytes += len;
+    EpdIf::spiStats.csToggles++;
+    if (dcLevel == LOW) {
+        EpdIf::spiStats.commands += len;
+    }
+    EpdIf::spiStats.wireNs += len * 8ULL * 1000000000ULL / EpdIf::spiClockHz;
+}
+#endif
+
+#ifdef EPD_SPI_DMA
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+
+#define EPD_SPI_DMA_FILL_SIZE 512
+
+static bool spiBusReady = false;
+static spi_device_handle_t spiDev;
+static spi_transaction_t spiAsyncTrans;
+static bool spiAsyncPending = false;
+static DMA_ATTR unsigned char spiFillBuf[EPD_SPI_DMA_FILL_SIZE];
+
+// Blocking DMA write of up to EPD_SPI_DMA_MAX_TRANSFER bytes, CS handled by caller
+static void SpiDmaWrite(const unsigned char* data, unsigned long len) {
+    spi_transaction_t t;
+    memset(&t, 0, sizeof(t));
+    t.length = len * 8;
+    t.tx_buffer = data;
+    spi_device_polling_transmit(spiDev, &t);
+}
+#endif
+
+#ifdef EPD_BUSY_SLEEP
+#include "esp_sleep.h"
+#include "esp_wifi.h"
+#include "driver/gpio.h"
+#endif
+
+#ifdef ESP_PLATFORM
+// Task blocked in WaitBusy(), woken from the BUSY pin interrupt
+static TaskHandle_t busyTask = NULL;
+
+static void ARDUINO_ISR_ATTR BusyIsr(void) {
+    BaseType_t woken = pdFALSE;
+    if (busyTask != NULL) {
+        vTaskNotifyGiveFromISR(busyTask, &woken);
+    }
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+#endif
+
 EpdIf::EpdIf() {
 };
 
@@ -44,7 +166,30 @@ EpdIf::~EpdIf() {
 };
 
 void EpdIf::DigitalWrite(int pin, int value) {
-    digitalWrite(pin, value);
+    if (pin == DC_PIN) {
+        // SendData() sets DC for every byte, only the first one changes it
+        if (value == dcLevel) {
+#ifdef EPD_SPI_STATS
+            spiStats.dcSkipped++;
+#endif
+            return;
+        }
+        dcLevel = value;
+#ifdef EPD_SPI_STATS
+        spiStats.dcWrites++;
+#endif
+    }
+    // DC/RST must not change while a DMA burst is still going out
+    SpiTransferWait();
+    GpioWrite(pin, value);
+    if (pin == DC_PIN) {
+        SpiWaitNs(spiProfile.settleNs);
+    }
+#ifdef EPD_SPI_TRACE
+    if (pin == DC_PIN || pin == RST_PIN) {
+        TraceAdd(pin == DC_PIN ? EPD_TRACE_DC : EPD_TRACE_RST, value, micros(), 0);
+    }
+#endif
 }
 
 int EpdIf::DigitalRead(int pin) {
@@ -52,15 +197,87 @@ int EpdIf::DigitalRead(int pin) {
 }
 
 void EpdIf::DelayMs(unsigned int delaytime) {
+    if (delaytime == 0) {
+        return;
+    }
+    TRACE_START();
     delay(delaytime);
+#ifdef EPD_SPI_TRACE
+    TraceAdd(EPD_TRACE_DELAY, 0, traceStart, 0);
+#endif
 }
 
-int EpdIf::IfInit(void) {
+/**
+ *  @brief: wait until pin leaves busyLevel or timeoutMs has passed.
+ *          The CPU goes to light sleep with a GPIO wakeup on the pin when
+ *          EPD_BUSY_SLEEP is set and the radio is off; otherwise the task
+ *          blocks on the pin interrupt. Returns 0 once idle, -1 on timeout.
+ */
+int EpdIf::WaitBusy(int pin, int busyLevel, unsigned long timeoutMs) {
+    if (DigitalRead(pin) != busyLevel) {
+        return 0;
+    }
+    // the bus must be quiet before the CPU sleeps
+    SpiTransferWait();
+    unsigned long start = millis();
+    TRACE_START();
+
+#ifdef EPD_BUSY_SLEEP
+    // light sleep drops the WiFi connection, so only use it with the radio off
+    wifi_mode_t mode;
+    if (esp_wifi_get_mode(&mode) != ESP_OK || mode == WIFI_MODE_NULL) {
+        gpio_wakeup_enable((gpio_num_t)pin, busyLevel == HIGH ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+        while (DigitalRead(pin) == busyLevel && millis() - start < timeoutMs) {
+            esp_sleep_enable_timer_wakeup((uint64_t)(timeoutMs - (millis() - start)) * 1000);
+            esp_light_sleep_start();
+        }
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+        esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+        gpio_wakeup_disable((gpio_num_t)pin);
+#ifdef EPD_SPI_STATS
+        spiStats.busyMs += millis() - start;
+#endif
+#ifdef EPD_SPI_TRACE
+        TraceAdd(EPD_TRACE_BUSY, DigitalRead(pin) == busyLevel, traceStart, 0);
+#endif
+        return DigitalRead(pin) == busyLevel ? -1 : 0;
+    }
+#endif
+
+#ifdef ESP_PLATFORM
+    busyTask = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);
+    attachInterrupt(digitalPinToInterrupt(pin), BusyIsr, busyLevel == HIGH ? FALLING : RISING);
+    // re-read after arming in case the edge came first
+    while (DigitalRead(pin) == busyLevel && millis() - start < timeoutMs) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs - (millis() - start)));
+    }
+    detachInterrupt(digitalPinToInterrupt(pin));
+    busyTask = NULL;
+#else
+    while (DigitalRead(pin) == busyLevel && millis() - start < timeoutMs) {
+        delay(1);
+    }
+#endif
+#ifdef EPD_SPI_STATS
+    spiStats.busyMs += millis() - start;
+#endif
+#ifdef EPD_SPI_TRACE
+    TraceAdd(EPD_TRACE_BUSY, DigitalRead(pin) == busyLevel, traceStart, 0);
+#endif
+    return DigitalRead(pin) == busyLevel ? -1 : 0;
+}
+
+int EpdIf::IfInit(const EpdSpiProfile& profile) {
+    spiProfile = profile;
+
     // Initialize common pins
     pinMode(CS_PIN, OUTPUT);
     pinMode(RST_PIN, OUTPUT);
     pinMode(DC_PIN, OUTPUT);
     pinMode(BUSY_PIN, INPUT);
+    dcLevel = -1;
     
 #ifdef PWR_PIN
     pinMode(PWR_PIN, OUTPUT);
@@ -75,27 +292,295 @@ int EpdIf::IfInit(void) {
     digitalWrite(PIN_SPI_SCK, LOW);
     digitalWrite(PIN_SPI_RST, LOW);
     
+#ifdef EPD_SPI_DMA
+    // SPI master driver with DMA, CS is driven by hand so it can span a burst
+    spi_bus_config_t buscfg;
+    memset(&buscfg, 0, sizeof(buscfg));
+    buscfg.mosi_io_num = VSPI_MOSI;
+    buscfg.miso_io_num = -1;
+    buscfg.sclk_io_num = VSPI_SCLK;
+    buscfg.quadwp_io_num = -1;
+    buscfg.quadhd_io_num = -1;
+    buscfg.max_transfer_sz = EPD_SPI_DMA_MAX_TRANSFER;
+
+    if (!spiBusReady) {
+        if (spi_bus_initialize(SPI2_HOST, &buscfg, SPI_DMA_CH_AUTO) != ESP_OK) {
+            return -1;
+        }
+        spiBusReady = true;
+    }
+#else
     // Initialize VSPI
     vspi = new SPIClass(SPI);
     vspi->begin(VSPI_SCLK, VSPI_MISO, VSPI_MOSI, VSPI_SS);
     pinMode(vspi->pinSS(), OUTPUT);
     vspi->setDataMode(SPI_MODE0);
-    vspi->setClockDivider(SPI_CLOCK_DIV2);
+#endif
 #else
     // Standard SPI initialization
     SPI.begin();
-    SPI.beginTransaction(SPISettings(2000000, MSBFIRST, SPI_MODE0));
 #endif
     
+    return SetSpiClock(profile.maxClockHz);
+}
+
+/**
+ *  @brief: change the SPI write clock, e.g. to step through clocks when
+ *          benchmarking a panel. IfInit() sets the profile's maximum.
+ */
+int EpdIf::SetSpiClock(unsigned long hz) {
+    SpiTransferWait();
+#if defined(EPD_SPI_DMA)
+    // the clock is fixed per device, so re-add the device
+    if (spiDev != NULL) {
+        spi_bus_remove_device(spiDev);
+        spiDev = NULL;
+    }
+    spi_device_interface_config_t devcfg;
+    memset(&devcfg, 0, sizeof(devcfg));
+    devcfg.clock_speed_hz = hz;
+    devcfg.mode = 0;
+    devcfg.spics_io_num = -1;
+    devcfg.queue_size = 2;
+    if (spi_bus_add_device(SPI2_HOST, &devcfg, &spiDev) != ESP_OK) {
+        return -1;
+    }
+#elif CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32C3
+    vspi->setFrequency(hz);
+#else
+    if (spiClockHz != 0) {
+        SPI.endTransaction();
+    }
+    SPI.beginTransaction(SPISettings(hz, MSBFIRST, SPI_MODE0));
+#endif
+    spiClockHz = hz;
     return 0;
 }
 
 void EpdIf::SpiTransfer(unsigned char data) {
-    digitalWrite(CS_PIN, LOW);
-#if CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32C3
+    SpiTransferWait();
+    TRACE_START();
+    GpioWrite(CS_PIN, LOW);
+    SpiWaitNs(spiProfile.csSetupNs);
+#if defined(EPD_SPI_DMA)
+    spi_transaction_t t;
+    memset(&t, 0, sizeof(t));
+    t.flags = SPI_TRANS_USE_TXDATA;
+    t.length = 8;
+    t.tx_data[0] = data;
+    spi_device_polling_transmit(spiDev, &t);
+#elif CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32C3
     vspi->transfer(data);
 #else
     SPI.transfer(data);
 #endif
-    digitalWrite(CS_PIN, HIGH);
+    SpiWaitNs(spiProfile.csHoldNs);
+    GpioWrite(CS_PIN, HIGH);
+#ifdef EPD_SPI_STATS
+    SpiStatsCount(1);
+#endif
+#ifdef EPD_SPI_TRACE
+    TraceTransfer(&data, traceStart, 1);
+#endif
 }
+
+/**
+ *  @brief: send a whole block with CS held low for the entire transfer.
+ *          On ESP32 the bytes go through the SPI FIFO with writeBytes().
+ */
+void EpdIf::SpiTransferBuffer(const unsigned char* data, unsigned long len) {
+    SpiTransferWait();
+    if (len == 0) {
+        return;
+    }
+    TRACE_START();
+    GpioWrite(CS_PIN, LOW);
+    SpiWaitNs(spiProfile.csSetupNs);
+#if defined(EPD_SPI_DMA)
+    for (unsigned long sent = 0; sent < len; sent += EPD_SPI_DMA_MAX_TRANSFER) {
+        SpiDmaWrite(data + sent, min(len - sent, (unsigned long)EPD_SPI_DMA_MAX_TRANSFER));
+    }
+#elif CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32C3
+    vspi->writeBytes(data, len);
+#else
+    for (unsigned long i = 0; i < len; i++) {
+        SPI.transfer(data[i]);
+    }
+#endif
+    SpiWaitNs(spiProfile.csHoldNs);
+    GpioWrite(CS_PIN, HIGH);
+#ifdef EPD_SPI_STATS
+    SpiStatsCount(len);
+#endif
+#ifdef EPD_SPI_TRACE
+    TraceTransfer(data, traceStart, len);
+#endif
+}
+
+/**
+ *  @brief: send the same byte count times with CS held low,
+ *          used to fill panel RAM in Clear/ClearFrame.
+ */
+void EpdIf::SpiTransferRepeat(unsigned char data, unsigned long count) {
+    SpiTransferWait();
+    if (count == 0) {
+        return;
+    }
+    TRACE_START();
+    GpioWrite(CS_PIN, LOW);
+    SpiWaitNs(spiProfile.csSetupNs);
+#if defined(EPD_SPI_DMA)
+    memset(spiFillBuf, data, sizeof(spiFillBuf));
+    for (unsigned long sent = 0; sent < count; sent += sizeof(spiFillBuf)) {
+        SpiDmaWrite(spiFillBuf, min(count - sent, (unsigned long)sizeof(spiFillBuf)));
+    }
+#elif CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32C3
+    vspi->writePattern(&data, 1, count);
+#else
+    for (unsigned long i = 0; i < count; i++) {
+        SPI.transfer(data);
+    }
+#endif
+    SpiWaitNs(spiProfile.csHoldNs);
+    GpioWrite(CS_PIN, HIGH);
+#ifdef EPD_SPI_STATS
+    SpiStatsCount(count);
+#endif
+#ifdef EPD_SPI_TRACE
+    TraceTransfer(&data, traceStart, count);
+#endif
+}
+
+/**
+ *  @brief: start sending a block and return while it goes out by DMA.
+ *          CS stays low until SpiTransferWait(); the buffer must not be
+ *          touched before then. Without EPD_SPI_DMA this is a plain
+ *          blocking SpiTransferBuffer.
+ */
+void EpdIf::SpiTransferBufferAsync(const unsigned char* data, unsigned long len) {
+#ifdef EPD_SPI_DMA
+    SpiTransferWait();
+    if (len == 0) {
+        return;
+    }
+    if (len > EPD_SPI_DMA_MAX_TRANSFER) {
+        SpiTransferBuffer(data, len);
+        return;
+    }
+    TRACE_START();
+    GpioWrite(CS_PIN, LOW);
+    SpiWaitNs(spiProfile.csSetupNs);
+    memset(&spiAsyncTrans, 0, sizeof(spiAsyncTrans));
+    spiAsyncTrans.length = len * 8;
+    spiAsyncTrans.tx_buffer = data;
+    spi_device_queue_trans(spiDev, &spiAsyncTrans, portMAX_DELAY);
+    spiAsyncPending = true;
+#ifdef EPD_SPI_STATS
+    SpiStatsCount(len);
+#endif
+#ifdef EPD_SPI_TRACE
+    // the duration is filled in by SpiTransferWait()
+    TraceTransfer(data, traceStart, len);
+    traceAsync = traceCount - 1;
+#endif
+#else
+    SpiTransferBuffer(data, len);
+#endif
+}
+
+/**
+ *  @brief: wait for the burst started by SpiTransferBufferAsync and release CS
+ */
+void EpdIf::SpiTransferWait(void) {
+#ifdef EPD_SPI_DMA
+    if (!spiAsyncPending) {
+        return;
+    }
+    spi_transaction_t *done;
+    spi_device_get_trans_result(spiDev, &done, portMAX_DELAY);
+    spiAsyncPending = false;
+    SpiWaitNs(spiProfile.csHoldNs);
+    GpioWrite(CS_PIN, HIGH);
+#ifdef EPD_SPI_TRACE
+    if (traceAsync >= 0) {
+        EpdTraceEvent* e = &traceRing[traceAsync % EPD_TRACE_EVENTS];
+        e->durUs = micros() - e->startUs;
+        traceAsync = -1;
+    }
+#endif
+#endif
+}
+
+#ifdef EPD_SPI_STATS
+EpdSpiStats EpdIf::spiStats;
+
+void EpdIf::SpiStatsReset(void) {
+    spiStats.calls = 0;
+    spiStats.bytes = 0;
+    spiStats.csToggles = 0;
+    spiStats.dcWrites = 0;
+    spiStats.dcSkipped = 0;
+    spiStats.commands = 0;
+    spiStats.wireNs = 0;
+    spiStats.busyMs = 0;
+}
+
+void EpdIf::SpiStatsPrint(void) {
+    Serial.print("SPI calls: ");
+    Serial.print(spiStats.calls);
+    Serial.print(", bytes: ");
+    Serial.print(spiStats.bytes);
+    Serial.print(", commands: ");
+    Serial.print(spiStats.commands);
+    Serial.print(", CS toggles: ");
+    Serial.print(spiStats.csToggles);
+    Serial.print(", bytes/call: ");
+    Serial.print(spiStats.calls ? spiStats.bytes / spiStats.calls : 0);
+    Serial.print(", DC writes: ");
+    Serial.print(spiStats.dcWrites);
+    Serial.print(", DC skipped: ");
+    Serial.println(spiStats.dcSkipped);
+    Serial.print("SPI wire time: ");
+    Serial.print((unsigned long)(spiStats.wireNs / 1000000ULL));
+    Serial.print(" ms at ");
+    Serial.print(spiClockHz / 1000);
+    Serial.print(" kHz, busy wait: ");
+    Serial.print(spiStats.busyMs);
+    Serial.println(" ms");
+}
+#endif
+
+#ifdef EPD_SPI_TRACE
+void EpdIf::TraceReset(void) {
+    SpiTransferWait();
+    traceCount = 0;
+    traceAsync = -1;
+}
+
+/**
+ *  @brief: write the ring to Serial, oldest event first. A text line
+ *          announces it, then a 16 byte header ("EPDT", version, event
+ *          size, event count, events dropped, SPI clock) and the events.
+ */
+void EpdIf::TraceDump(void) {
+    SpiTransferWait();
+    unsigned long count = traceCount < EPD_TRACE_EVENTS ? traceCount : EPD_TRACE_EVENTS;
+    uint8_t header[16] = { 'E', 'P', 'D', 'T', 1, sizeof(EpdTraceEvent) };
+    uint32_t dropped = traceCount - count;
+    uint32_t clock = spiClockHz;
+    header[6] = count & 0xFF;
+    header[7] = (count >> 8) & 0xFF;
+    memcpy(header + 8, &dropped, 4);
+    memcpy(header + 12, &clock, 4);
+
+    Serial.print("EPD trace: ");
+    Serial.print(count);
+    Serial.println(" events");
+    Serial.write(header, sizeof(header));
+    for (unsigned long i = traceCount - count; i < traceCount; i++) {
+        Serial.write((const uint8_t*)&traceRing[i % EPD_TRACE_EVENTS], sizeof(EpdTraceEvent));
+    }
+    Serial.println();
+    Serial.flush();
+}
+#endif
@@ -74,6 +74,19 @@
   #define VSPI_MOSI       MOSI
   #define VSPI_SCLK       SCK
   #define VSPI_SS         CS_PIN
+
+  // Send frame data with the ESP-IDF SPI master driver so bursts go out by
+  // DMA and can overlap with the network (comment out to use SPIClass)
+  #define EPD_SPI_DMA
+  #define EPD_SPI_DMA_MAX_TRANSFER  4096   // largest single DMA burst in bytes
+
+  // Drive CS/DC/RST through the GPIO set/clear registers instead of
+  // digitalWrite() (comment out to use digitalWrite)
+  #define EPD_FAST_GPIO
+
+  // Light-sleep the CPU while the panel is busy and wake on the BUSY pin
+  // (comment out to keep the CPU and USB serial awake during a refresh)
+  #define EPD_BUSY_SLEEP
 #else
   // Default pin definitions (Arduino/ESP32)
   #define RST_PIN         8
@@ -87,17 +100,104 @@
 
 
 
+// Define EPD_SPI_STATS to count SPI calls, bytes, commands and CS toggles
+// and the time they take on the wire (e.g. to compare per-byte and burst
+// transfers, or clocks, on a given panel)
+//#define EPD_SPI_STATS
+
+#ifdef EPD_SPI_STATS
+struct EpdSpiStats {
+    unsigned long calls;        // SpiTransfer* invocations
+    unsigned long bytes;        // bytes clocked out
+    unsigned long commands;     // bytes sent with DC low
+    unsigned long csToggles;    // CS low/high pairs
+    unsigned long dcWrites;     // DC level changes that reached the pin
+    unsigned long dcSkipped;    // DC writes dropped because the level was already set
+    unsigned long long wireNs;  // time the bytes take at the clock they went out with
+    unsigned long busyMs;       // time spent in WaitBusy()
+};
+#endif
+
+// Define EPD_SPI_TRACE to record timestamped SPI/GPIO events in a RAM ring
+// and dump them over serial with TraceDump(); tools/epd_trace.py turns a
+// dump into a Chrome/Perfetto trace
+//#define EPD_SPI_TRACE
+
+#ifdef EPD_SPI_TRACE
+#define EPD_TRACE_EVENTS    512     // ring size, the oldest events are overwritten
+
+enum {
+    EPD_TRACE_CMD = 1,      // byte(s) sent with DC low, value = first byte
+    EPD_TRACE_DATA,         // byte(s) sent with DC high, back-to-back bytes are merged
+    EPD_TRACE_DC,           // DC edge, value = new level
+    EPD_TRACE_RST,          // RST edge, value = new level
+    EPD_TRACE_DELAY,        // DelayMs()
+    EPD_TRACE_BUSY          // WaitBusy(), value = 1 on timeout
+};
+
+// Dumped as is (little-endian) after a 16 byte "EPDT" header
+struct EpdTraceEvent {
+    uint32_t startUs;       // micros() at the start, CS low for transfers
+    uint32_t durUs;         // 0 for edges
+    uint32_t len;           // bytes for transfers
+    uint8_t  type;
+    uint8_t  value;
+    uint16_t reserved;
+};
+#endif
+
+/**
+ *  SPI timing a controller can take, from its datasheet. Each driver
+ *  declares one and passes it to IfInit(). Waits below a microsecond are
+ *  already covered by the time the GPIO calls take.
+ */
+struct EpdSpiProfile {
+    unsigned long maxClockHz;   // fastest write clock
+    unsigned int  settleNs;     // DC change to first data clock (command-to-data)
+    unsigned int  csSetupNs;    // CS low to first clock
+    unsigned int  csHoldNs;     // last clock to CS high
+};
+
+/**
+ *  Waits a controller needs around reset, BUSY and sleep. Each driver
+ *  declares one so it only waits as long as its controller requires.
+ */
+struct EpdTiming {
+    unsigned int resetPulseMs;  // RST low
+    unsigned int resetWaitMs;   // RST high until BUSY is valid
+    unsigned int busyStartMs;   // refresh/power command until BUSY is asserted
+    unsigned int busySettleMs;  // BUSY released until the next command
+    unsigned int sleepWaitMs;   // power off/deep sleep command until the next step
+};
+
 class EpdIf {
 public:
     EpdIf(void);
     ~EpdIf(void);
 
       
-    static int  IfInit(void);
+    static int  IfInit(const EpdSpiProfile& profile);
+    static int  SetSpiClock(unsigned long hz);
     static void DigitalWrite(int pin, int value); 
     static int  DigitalRead(int pin);
     static void DelayMs(unsigned int delaytime);
+    static int  WaitBusy(int pin, int busyLevel, unsigned long timeoutMs);
     static void SpiTransfer(unsigned char data);
+    static void SpiTransferBuffer(const unsigned char* data, unsigned long len);
+    static void SpiTransferRepeat(unsigned char data, unsigned long count);
+    static void SpiTransferBufferAsync(const unsigned char* data, unsigned long len);
+    static void SpiTransferWait(void);
+    static EpdSpiProfile spiProfile;    // timing applied by the last IfInit()
+    static unsigned long spiClockHz;    // clock the bus is running at
+#ifdef EPD_SPI_STATS
+    static EpdSpiStats spiStats;
+    static void SpiStatsReset(void);
+    static void SpiStatsPrint(void);
+#endif
+#ifdef EPD_SPI_TRACE
+    static void TraceReset(void);
+    static void TraceDump(void);
+#endif
 };
 
 #endif
@@ -0,0 +1,239 @@
+/**
+ *  @filename   :   frame_store.cpp
+ *  @brief      :   The frame on the panel kept in flash as a diff base
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include "frame_store.h"
+
+/**
+ *  What FRAME_STORE_PATH holds. RTC slow memory keeps it through deep
+ *  sleep but holds garbage after power-on, hence the checksum.
+ */
+struct StoredFrame {
+    uint32_t size;              // panel bytes in the file, 0 for none
+    uint32_t crc;               // CRC32 of those bytes, the base id
+    uint32_t diffs;             // slides that arrived as a diff
+    uint32_t saved;             // body bytes those diffs saved
+    uint32_t check;
+};
+
+RTC_DATA_ATTR static StoredFrame storedFrame;
+
+static uint32_t FrameCheck(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&storedFrame, offsetof(StoredFrame, check));
+}
+
+// start from nothing when RTC memory did not survive
+static void LoadFrame(void) {
+    if (storedFrame.check != FrameCheck()) {
+        memset(&storedFrame, 0, sizeof(storedFrame));
+        storedFrame.check = FrameCheck();
+    }
+}
+
+bool FrameStore::Mount(void) {
+    if (!mounted) {
+        mounted = LittleFS.begin(true);
+        if (!mounted) {
+            Serial.println("[FRAME] no flash file system");
+        }
+    }
+    return mounted;
+}
+
+/**
+ *  @brief: true when a complete frame of frameSize bytes is stored
+ */
+bool FrameStore::Has(uint32_t frameSize) {
+    LoadFrame();
+    return storedFrame.size != 0 && storedFrame.size == frameSize;
+}
+
+uint32_t FrameStore::Crc(void) {
+    return storedFrame.crc;
+}
+
+/**
+ *  @brief: the stored frame, read from its start, NULL when there is none
+ */
+Stream* FrameStore::OpenBase(void) {
+    CloseBase();
+    LoadFrame();
+    if (storedFrame.size == 0 || !Mount()) {
+        return NULL;
+    }
+    base = LittleFS.open(FRAME_STORE_PATH, "r");
+    if (!base || base.size() != storedFrame.size) {
+        CloseBase();
+        return NULL;
+    }
+    return &base;
+}
+
+/**
+ *  @brief: len bytes of the stored frame from offset, e.g. to put the
+ *          frame back into controller RAM after deep sleep
+ */
+bool FrameStore::Read(uint32_t offset, uint8_t* dst, size_t len) {
+    LoadFrame();
+    if (storedFrame.size == 0 || offset + len > storedFrame.size || !Mount()) {
+        return false;
+    }
+    if (!base) {
+        base = LittleFS.open(FRAME_STORE_PATH, "r");
+        if (!base) {
+            return false;
+        }
+    }
+    return base.seek(offset) && base.read(dst, len) == len;
+}
+
+/**
+ *  @brief: the stored frame is of no use as a base any more
+ */
+void FrameStore::Forget(void) {
+    CloseBase();
+    LoadFrame();
+    Serial.printf("[FRAME] base %08lx dropped\n", (unsigned long)storedFrame.crc);
+    storedFrame.size = 0;
+    storedFrame.crc = 0;
+    storedFrame.check = FrameCheck();
+}
+
+/**
+ *  @brief: start writing the frame that goes to the panel next. The
+ *          stored one stays the base until Keep().
+ */
+void FrameStore::Record(void) {
+    Abort();
+    if (!Mount()) {
+        return;
+    }
+    next = LittleFS.open(FRAME_STORE_TEMP, "w");
+    recording = (bool)next;
+    size = 0;
+    crc = 0;
+}
+
+void FrameStore::Write(const uint8_t* buf, size_t len) {
+    if (!recording) {
+        return;
+    }
+    if (next.write(buf, len) != len) {
+        // a full partition only costs the next diff
+        Serial.println("[FRAME] flash write failed");
+        Abort();
+        return;
+    }
+    crc = esp_rom_crc32_le(crc, buf, len);
+    size += len;
+}
+
+/**
+ *  @brief: make the recorded frame the base, if all frameSize bytes of it
+ *          were written
+ */
+void FrameStore::Keep(uint32_t frameSize) {
+    if (!recording) {
+        return;
+    }
+    next.close();
+    recording = false;
+    if (size != frameSize) {
+        LittleFS.remove(FRAME_STORE_TEMP);
+        return;
+    }
+    CloseBase();
+    LoadFrame();
+    LittleFS.remove(FRAME_STORE_PATH);
+    if (!LittleFS.rename(FRAME_STORE_TEMP, FRAME_STORE_PATH)) {
+        Forget();
+        return;
+    }
+    storedFrame.size = size;
+    storedFrame.crc = crc;
+    storedFrame.check = FrameCheck();
+}
+
+void FrameStore::Abort(void) {
+    if (recording) {
+        next.close();
+        LittleFS.remove(FRAME_STORE_TEMP);
+        recording = false;
+    }
+}
+
+/**
+ *  @brief: take over a checked file of the whole frame, e.g. the slide
+ *          store's after it went to the panel. The file is moved, not
+ *          copied.
+ */
+bool FrameStore::Adopt(const char* path, uint32_t frameSize, uint32_t frameCrc) {
+    Abort();
+    CloseBase();
+    if (!Mount()) {
+        return false;
+    }
+    LoadFrame();
+    LittleFS.remove(FRAME_STORE_PATH);
+    if (!LittleFS.rename(path, FRAME_STORE_PATH)) {
+        Forget();
+        return false;
+    }
+    storedFrame.size = frameSize;
+    storedFrame.crc = frameCrc;
+    storedFrame.check = FrameCheck();
+    return true;
+}
+
+/**
+ *  @brief: count a slide that arrived as a diff
+ */
+void FrameStore::Applied(long received, long produced) {
+    LoadFrame();
+    storedFrame.diffs++;
+    if (produced > received) {
+        storedFrame.saved += produced - received;
+    }
+    storedFrame.check = FrameCheck();
+}
+
+void FrameStore::Print(void) {
+    LoadFrame();
+    Serial.printf("[FRAME] base %08lx (%lu bytes), %lu diffs saved %lu KB\n",
+                  (unsigned long)storedFrame.crc, (unsigned long)storedFrame.size,
+                  (unsigned long)storedFrame.diffs, (unsigned long)(storedFrame.saved / 1024));
+}
+
+void FrameStore::CloseBase(void) {
+    if (base) {
+        base.close();
+    }
+}
+
+/* END OF FILE */
@@ -0,0 +1,82 @@
+/**
+ *  @filename   :   frame_store.h
+ *  @brief      :   Header file of frame_store.cpp, the frame on the panel
+ *                  kept in flash as the base of diff updates
+ *
+ *  Every slide that reaches the panel in full is also written to flash.
+ *  Requests then name that frame by its CRC32 (X-Epd-Base) and a server
+ *  that knows it may answer with a diff (Content-Encoding x-epd-diff,
+ *  see slide_codec.h) instead of the whole slide. A diff for another
+ *  base fails before anything is drawn and the frame is forgotten, so
+ *  the next attempt gets the full slide.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef FRAME_STORE_H
+#define FRAME_STORE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// offer the stored frame as a diff base (comment out to disable)
+#define FRAME_DIFF
+
+#define FRAME_STORE_PATH        "/frame.bin"
+#define FRAME_STORE_TEMP        "/frame.new"
+
+class FrameStore {
+public:
+    FrameStore() : mounted(false), recording(false), size(0), crc(0) {}
+
+    bool Has(uint32_t frameSize);
+    uint32_t Crc(void);
+    Stream* OpenBase(void);
+    bool Read(uint32_t offset, uint8_t* dst, size_t len);
+    void Forget(void);
+
+    void Record(void);
+    void Write(const uint8_t* buf, size_t len);
+    void Keep(uint32_t frameSize);
+    void Abort(void);
+    bool Adopt(const char* path, uint32_t frameSize, uint32_t frameCrc);
+
+    void Applied(long received, long produced);
+    void Print(void);
+
+private:
+    bool Mount(void);
+    void CloseBase(void);
+
+    bool mounted;
+    bool recording;
+    File base;
+    File next;
+    uint32_t size;
+    uint32_t crc;
+};
+
+#endif
+
+/* END OF FILE */
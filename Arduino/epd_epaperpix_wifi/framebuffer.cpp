@@ -0,0 +1,627 @@
+/**
+ *  @filename   :   framebuffer.cpp
+ *  @brief      :   Frame in the panel's native format with dirty windows
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include "framebuffer.h"
+
+/**
+ *  Partial refreshes since the last full one. RTC slow memory keeps it
+ *  through deep sleep; after power-on the check fails and the count
+ *  starts at the limit, so the first refresh is a full one.
+ */
+struct PartialCount {
+    uint32_t sinceFull;
+    uint32_t check;
+};
+
+RTC_DATA_ATTR static PartialCount partialCount;
+
+static uint32_t PartialCheck(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&partialCount, offsetof(PartialCount, check));
+}
+
+static void SetPartials(uint32_t n) {
+    partialCount.sinceFull = n;
+    partialCount.check = PartialCheck();
+}
+
+FrameBuffer::FrameBuffer() : uploaded(0), windows(0), lastPartial(false), epd(NULL), band(NULL), stage(NULL), stageSize(0),
+    load(NULL), loadArg(NULL), firstStep(0), planeCount(0), bpp(0), ppb(0), rowBytes(0), rows(0), bandStart(0), bandRows(0),
+    banded(false), collecting(true), partial(false), ramSynced(false) {
+    memset(planes, 0, sizeof(planes));
+    memset(background, 0xFF, sizeof(background));
+}
+
+FrameBuffer::~FrameBuffer() {
+    End();
+}
+
+/**
+ *  @brief: set the frame up for panel. load, if given, provides what the
+ *          panel shows (e.g. from the frame kept in flash); without it the
+ *          frame starts white and the first upload is a full one.
+ */
+bool FrameBuffer::Begin(Epd& panel, FrameLoad loader, void* arg) {
+    End();
+    epd = &panel;
+    load = loader;
+    loadArg = arg;
+    // drivers that leave the format open have it in the plane size
+    bpp = panel.bits_per_pixel;
+    if (bpp == 0 && panel.width > 0 && panel.height > 0) {
+        bpp = panel.blockSize * 8 / (panel.width * panel.height);
+    }
+    if (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8) {
+        Serial.println("[FB] unknown pixel format");
+        return false;
+    }
+    ppb = 8 / bpp;
+    rowBytes = (panel.width + ppb - 1) / ppb;
+    rows = panel.height;
+    // a monochrome panel whose download starts with the old data (0x10
+    // before 0x13 on the 7.5" V2) has one frame plane, the second step
+    firstStep = panel.steps > 1 && panel.previousRam != 0 && panel.stepCommands[0] == panel.previousRam ? 1 : 0;
+    planeCount = panel.steps - firstStep;
+    if (rowBytes * rows != panel.blockSize || planeCount > FB_MAX_PLANES) {
+        Serial.println("[FB] planes are not whole rows, no frame buffer");
+        return false;
+    }
+    stageSize = panel.streamBufferSize;
+    stage = (uint8_t*)heap_caps_malloc(stageSize, MALLOC_CAP_DMA);
+    if (stage == NULL) {
+        return false;
+    }
+
+    // PSRAM when there is some, the S3 boards have it
+    banded = false;
+    for (int p = 0; p < planeCount; p++) {
+        planes[p] = (uint8_t*)heap_caps_malloc(panel.blockSize, MALLOC_CAP_SPIRAM);
+        if (planes[p] == NULL) {
+            banded = true;
+        }
+    }
+    if (banded) {
+        for (int p = 0; p < FB_MAX_PLANES; p++) {
+            heap_caps_free(planes[p]);
+            planes[p] = NULL;
+        }
+        band = (uint8_t*)heap_caps_malloc(FB_BAND_ROWS * rowBytes * planeCount, MALLOC_CAP_8BIT);
+        if (band == NULL) {
+            End();
+            return false;
+        }
+    }
+    bandStart = 0;
+    bandRows = 0;
+    collecting = true;
+    partial = false;
+    ramSynced = false;
+    dirty.Clear();
+
+    if (!banded) {
+        for (int p = 0; p < planeCount; p++) {
+            if (load == NULL || !load(firstStep + p, 0, planes[p], panel.blockSize, loadArg)) {
+                memset(planes[p], background[p], panel.blockSize);
+                MarkDirty(0, 0, rowBytes, rows);
+            }
+        }
+    } else if (load == NULL) {
+        MarkDirty(0, 0, rowBytes, rows);
+    }
+    Serial.printf("[FB] %lux%lu, %d bpp, %s\n", panel.width, panel.height, bpp,
+                  banded ? "banded" : "in PSRAM");
+    return true;
+}
+
+void FrameBuffer::End(void) {
+    for (int p = 0; p < FB_MAX_PLANES; p++) {
+        heap_caps_free(planes[p]);
+        planes[p] = NULL;
+    }
+    heap_caps_free(band);
+    band = NULL;
+    heap_caps_free(stage);
+    stage = NULL;
+    epd = NULL;
+}
+
+/**
+ *  @brief: line of plane, NULL when banded and row is not in the band
+ */
+uint8_t* FrameBuffer::Row(int plane, unsigned long row) {
+    if (!banded) {
+        return planes[plane] + row * rowBytes;
+    }
+    if (row < bandStart || row >= bandStart + bandRows) {
+        return NULL;
+    }
+    return band + (plane * FB_BAND_ROWS + row - bandStart) * rowBytes;
+}
+
+// pixels fill a byte from its top bits down
+void FrameBuffer::PutPixel(uint8_t* line, unsigned long x, uint8_t value) {
+    uint8_t shift = (ppb - 1 - x % ppb) * bpp;
+    uint8_t mask = ((1 << bpp) - 1) << shift;
+    uint8_t* b = line + x / ppb;
+    *b = (*b & ~mask) | ((value << shift) & mask);
+}
+
+void FrameBuffer::MarkDirty(unsigned long col0, unsigned long row0, unsigned long col1, unsigned long row1) {
+    if (collecting) {
+        dirty.Add(col0, row0, col1, row1);
+    }
+}
+
+/**
+ *  @brief: set pixel (x, y) of plane to value, in the panel's own coding
+ */
+void FrameBuffer::SetPixel(unsigned long x, unsigned long y, uint8_t value, int plane) {
+    if (epd == NULL || x >= epd->width || y >= rows || plane >= planeCount) {
+        return;
+    }
+    MarkDirty(x / ppb, y, x / ppb + 1, y + 1);
+    uint8_t* line = Row(plane, y);
+    if (line != NULL) {
+        PutPixel(line, x, value);
+    }
+}
+
+uint8_t FrameBuffer::GetPixel(unsigned long x, unsigned long y, int plane) {
+    if (epd == NULL || x >= epd->width || y >= rows || plane >= planeCount) {
+        return 0;
+    }
+    uint8_t* line = Row(plane, y);
+    if (line == NULL) {
+        return 0;
+    }
+    uint8_t shift = (ppb - 1 - x % ppb) * bpp;
+    return (line[x / ppb] >> shift) & ((1 << bpp) - 1);
+}
+
+void FrameBuffer::FillRect(unsigned long x, unsigned long y, unsigned long w, unsigned long h, uint8_t value, int plane) {
+    if (epd == NULL || x >= epd->width || y >= rows || plane >= planeCount || w == 0 || h == 0) {
+        return;
+    }
+    w = min(w, epd->width - x);
+    h = min(h, rows - y);
+    unsigned long x1 = x + w;
+    MarkDirty(x / ppb, y, (x1 + ppb - 1) / ppb, y + h);
+
+    // whole bytes in the middle are set at once
+    uint8_t fill = 0;
+    for (int i = 0; i < ppb; i++) {
+        fill = (fill << bpp) | (value & ((1 << bpp) - 1));
+    }
+    unsigned long head = min(x1, (x + ppb - 1) / ppb * ppb);
+    unsigned long tail = max(head, x1 / ppb * ppb);
+    for (unsigned long row = y; row < y + h; row++) {
+        uint8_t* line = Row(plane, row);
+        if (line == NULL) {
+            continue;
+        }
+        for (unsigned long px = x; px < head; px++) {
+            PutPixel(line, px, value);
+        }
+        memset(line + head / ppb, fill, (tail - head) / ppb);
+        for (unsigned long px = tail; px < x1; px++) {
+            PutPixel(line, px, value);
+        }
+    }
+}
+
+/**
+ *  @brief: copy native bytes to byte column col of row, cols bytes per
+ *          row, e.g. a region the server rendered
+ */
+void FrameBuffer::Blit(unsigned long col, unsigned long row, unsigned long cols, unsigned long count,
+                       const uint8_t* src, int plane) {
+    if (epd == NULL || col + cols > rowBytes || row + count > rows || plane >= planeCount) {
+        return;
+    }
+    MarkDirty(col, row, col + cols, row + count);
+    for (unsigned long r = 0; r < count; r++) {
+        uint8_t* line = Row(plane, row + r);
+        if (line != NULL) {
+            memcpy(line + col, src + r * cols, cols);
+        }
+    }
+}
+
+/**
+ *  @brief: set the whole plane to value, also what bands start from when
+ *          there is nothing to load them from
+ */
+void FrameBuffer::Fill(uint8_t value, int plane) {
+    if (epd == NULL || plane >= planeCount) {
+        return;
+    }
+    uint8_t fill = 0;
+    for (int i = 0; i < ppb; i++) {
+        fill = (fill << bpp) | (value & ((1 << bpp) - 1));
+    }
+    background[plane] = fill;
+    if (!banded) {
+        memset(planes[plane], fill, epd->blockSize);
+    }
+    MarkDirty(0, 0, rowBytes, rows);
+}
+
+/**
+ *  @brief: len bytes of a download from offset, in the order the panel
+ *          would get them. Per row only the span from the first to the
+ *          last changed byte is marked dirty; a step that is no plane
+ *          (the old data of the 7.5" V2) is dropped. Only for a frame in
+ *          PSRAM.
+ */
+void FrameBuffer::Update(unsigned long offset, const uint8_t* src, size_t len) {
+    if (epd == NULL || banded) {
+        return;
+    }
+    while (len > 0) {
+        int plane = offset / epd->blockSize - firstStep;
+        unsigned long at = offset % epd->blockSize;
+        unsigned long row = at / rowBytes;
+        size_t n = min(len, (size_t)(rowBytes - at % rowBytes));
+        if (plane >= 0 && plane < planeCount) {
+            uint8_t* dst = planes[plane] + at;
+            size_t first = 0;
+            while (first < n && dst[first] == src[first]) {
+                first++;
+            }
+            if (first < n) {
+                size_t last = n - 1;
+                while (dst[last] == src[last]) {
+                    last--;
+                }
+                memcpy(dst + first, src + first, last + 1 - first);
+                MarkDirty(at % rowBytes + first, row, at % rowBytes + last + 1, row + 1);
+            }
+        }
+        offset += n;
+        src += n;
+        len -= n;
+    }
+}
+
+/**
+ *  @brief: true when the windows are worth it and the controller has a
+ *          RAM window; checking resets it to the whole plane
+ */
+bool FrameBuffer::Windowed(void) {
+    unsigned long cost = dirty.Bytes() + (unsigned long)dirty.Count() * DIRTY_WINDOW_COST;
+    return cost < epd->blockSize && epd->SetWindow(0, 0, rowBytes, rows);
+}
+
+// data command of step, after the window w when there is one
+void FrameBuffer::StartPlane(int step, const DirtyRect* w) {
+    if (w != NULL) {
+        epd->SetWindow(w->col0, w->row0, w->col1 - w->col0, w->row1 - w->row0);
+    }
+    epd->SendCommand(epd->stepCommands[firstStep + step]);
+    epd->SetToDataMode();
+}
+
+// cols bytes from col of rows [row0, row1) of plane, gathered in the DMA
+// staging buffer since window rows are not contiguous in the frame
+void FrameBuffer::SendRows(int plane, unsigned long col, unsigned long cols, unsigned long row0, unsigned long row1) {
+    size_t fill = 0;
+    for (unsigned long row = row0; row < row1; row++) {
+        const uint8_t* src = Row(plane, row) + col;
+        unsigned long left = cols;
+        while (left > 0) {
+            size_t n = min((size_t)left, stageSize - fill);
+            memcpy(stage + fill, src, n);
+            fill += n;
+            src += n;
+            left -= n;
+            if (fill == stageSize) {
+                epd->SendBuffer(stage, fill);
+                fill = 0;
+            }
+        }
+    }
+    epd->SendBuffer(stage, fill);
+    uploaded += cols * (row1 - row0);
+}
+
+bool FrameBuffer::LoadBand(unsigned long row) {
+    bandStart = row;
+    bandRows = min((unsigned long)FB_BAND_ROWS, rows - row);
+    for (int p = 0; p < planeCount; p++) {
+        uint8_t* dst = band + p * FB_BAND_ROWS * rowBytes;
+        if (load != NULL) {
+            if (!load(firstStep + p, row * rowBytes, dst, bandRows * rowBytes, loadArg)) {
+                return false;
+            }
+        } else {
+            memset(dst, background[p], bandRows * rowBytes);
+        }
+    }
+    return true;
+}
+
+/**
+ *  @brief: send what changed since the last upload, each plane through
+ *          the merged windows or whole. Only for a frame in PSRAM, a
+ *          banded one uploads through Render().
+ */
+bool FrameBuffer::Flush(void) {
+    uploaded = 0;
+    windows = 0;
+    if (epd == NULL || banded) {
+        return false;
+    }
+    if (dirty.Count() == 0) {
+        return true;
+    }
+    bool windowed = Windowed();
+    for (int step = 0; step < planeCount; step++) {
+        if (!windowed) {
+            StartPlane(step, NULL);
+            SendRows(step, 0, rowBytes, 0, rows);
+            continue;
+        }
+        for (int i = 0; i < dirty.Count(); i++) {
+            StartPlane(step, &dirty[i]);
+            SendRows(step, dirty[i].col0, dirty[i].col1 - dirty[i].col0, dirty[i].row0, dirty[i].row1);
+        }
+    }
+    if (windowed) {
+        windows = dirty.Count();
+        epd->SetWindow(0, 0, rowBytes, rows);
+    }
+    dirty.Clear();
+    return true;
+}
+
+/**
+ *  @brief: draw the frame with draw and upload what it changed. Banded,
+ *          draw runs once to find the dirty rectangles, then again for
+ *          every band of every window of every plane, drawing into a band
+ *          that starts from what the panel holds.
+ */
+bool FrameBuffer::Render(FrameDraw draw, void* arg) {
+    if (epd == NULL) {
+        return false;
+    }
+    if (!banded) {
+        draw(*this, arg);
+        return Flush();
+    }
+    uploaded = 0;
+    windows = 0;
+    // nothing is held while collecting, every pixel is clipped
+    bandStart = 0;
+    bandRows = 0;
+    draw(*this, arg);
+    if (dirty.Count() == 0) {
+        return true;
+    }
+    bool windowed = Windowed();
+    DirtyRect whole = { 0, 0, (uint16_t)rowBytes, (uint16_t)rows };
+    int count = windowed ? dirty.Count() : 1;
+    bool ok = true;
+    collecting = false;
+    for (int step = 0; ok && step < planeCount; step++) {
+        for (int i = 0; ok && i < count; i++) {
+            const DirtyRect& w = windowed ? dirty[i] : whole;
+            StartPlane(step, windowed ? &w : NULL);
+            for (unsigned long row = w.row0; row < w.row1; row += FB_BAND_ROWS) {
+                if (!LoadBand(row)) {
+                    ok = false;
+                    break;
+                }
+                draw(*this, arg);
+                SendRows(step, w.col0, w.col1 - w.col0, row, min(row + FB_BAND_ROWS, (unsigned long)w.row1));
+            }
+        }
+    }
+    collecting = true;
+    bandRows = 0;
+    if (windowed) {
+        windows = dirty.Count();
+        epd->SetWindow(0, 0, rowBytes, rows);
+    }
+    dirty.Clear();
+    return ok;
+}
+
+const uint8_t* FrameBuffer::Plane(int plane) const {
+    return banded || plane >= FB_MAX_PLANES ? NULL : planes[plane];
+}
+
+/**
+ *  @brief: make the next Refresh() a full one, e.g. on a schedule
+ */
+void FrameBuffer::ForceFull(void) {
+    SetPartials(FB_MAX_PARTIALS);
+}
+
+// every dirty window of plane into command's RAM
+void FrameBuffer::SendWindows(int plane, unsigned char command) {
+    for (int i = 0; i < dirty.Count(); i++) {
+        const DirtyRect& w = dirty[i];
+        epd->SetWindow(w.col0, w.row0, w.col1 - w.col0, w.row1 - w.row0);
+        epd->SendCommand(command);
+        epd->SetToDataMode();
+        SendRows(plane, w.col0, w.col1 - w.col0, w.row0, w.row1);
+    }
+}
+
+// partial refresh of the box around all windows; UC81xx refresh just
+// that, SSD168x ignore the window
+void FrameBuffer::RefreshWindows(void) {
+    DirtyRect box = dirty[0];
+    for (int i = 1; i < dirty.Count(); i++) {
+        box.col0 = min(box.col0, dirty[i].col0);
+        box.row0 = min(box.row0, dirty[i].row0);
+        box.col1 = max(box.col1, dirty[i].col1);
+        box.row1 = max(box.row1, dirty[i].row1);
+    }
+    epd->SetWindow(box.col0, box.row0, box.col1 - box.col0, box.row1 - box.row0);
+    epd->TurnOnPartial();
+}
+
+/**
+ *  @brief: write the frame the panel shows, from the FrameLoad, to the
+ *          RAM the partial waveform compares with. Controllers whose two
+ *          RAMs swap on refresh get it in both, around a refresh that
+ *          changes nothing on screen.
+ */
+bool FrameBuffer::RestoreRam(void) {
+    if (load == NULL) {
+        return false;
+    }
+    int passes = epd->previousRam ? 1 : 2;
+    for (int pass = 0; pass < passes; pass++) {
+        if (pass > 0) {
+            epd->TurnOnPartial();
+        }
+        epd->SetWindow(0, 0, rowBytes, rows);
+        epd->SendCommand(epd->previousRam ? epd->previousRam : epd->stepCommands[firstStep]);
+        epd->SetToDataMode();
+        for (unsigned long offset = 0; offset < epd->blockSize; offset += stageSize) {
+            size_t n = min((unsigned long)stageSize, epd->blockSize - offset);
+            if (!load(firstStep, offset, stage, n, loadArg)) {
+                return false;
+            }
+            epd->SendBuffer(stage, n);
+        }
+    }
+    if (epd->previousRam) {
+        // the whole new frame, outside the windows it equals the old one
+        epd->SendCommand(epd->stepCommands[firstStep]);
+        epd->SetToDataMode();
+        SendRows(0, 0, rowBytes, 0, rows);
+    }
+    return true;
+}
+
+/**
+ *  @brief: the partial path of Refresh(), false when it cannot be taken
+ */
+bool FrameBuffer::Partial(void) {
+    // colour panels have no previous image to compare with; their partial
+    // refresh is the normal waveform inside the window, which does not
+    // ghost and needs nothing restored but the planes themselves
+    bool colour = planeCount > 1;
+    if (colour && epd->partialRefresh != 0) {
+        return false;
+    }
+    if ((!colour && partialCount.sinceFull >= FB_MAX_PARTIALS) || !Windowed()) {
+        return false;
+    }
+    if (!partial) {
+        partial = epd->SetPartial(true);
+        if (!partial) {
+            return false;
+        }
+    }
+    if (colour) {
+        for (int step = 0; step < planeCount; step++) {
+            if (ramSynced) {
+                SendWindows(step, epd->stepCommands[firstStep + step]);
+            } else {
+                StartPlane(step, NULL);
+                SendRows(step, 0, rowBytes, 0, rows);
+            }
+        }
+        RefreshWindows();
+        windows = dirty.Count();
+        epd->SetWindow(0, 0, rowBytes, rows);
+        ramSynced = true;
+        return true;
+    }
+    bool restored = false;
+    if (!ramSynced) {
+        if (!RestoreRam()) {
+            return false;
+        }
+        restored = true;
+    }
+    if (!restored || epd->previousRam == 0) {
+        SendWindows(0, epd->stepCommands[firstStep]);
+    }
+    RefreshWindows();
+    windows = dirty.Count();
+    // the next partial compares with what is on screen now; swapping
+    // RAMs get the windows again, the other one was written before
+    SendWindows(0, epd->previousRam ? epd->previousRam : epd->stepCommands[firstStep]);
+    epd->SetWindow(0, 0, rowBytes, rows);
+    ramSynced = true;
+    SetPartials(partialCount.sinceFull + 1);
+    return true;
+}
+
+/**
+ *  @brief: upload what changed and show it, with the partial waveform
+ *          when the panel has one and the ghosting budget allows. Only
+ *          for a frame in PSRAM.
+ */
+bool FrameBuffer::Refresh(void) {
+    uploaded = 0;
+    windows = 0;
+    if (epd == NULL || banded) {
+        return false;
+    }
+    if (dirty.Count() == 0) {
+        return true;
+    }
+    if (partialCount.check != PartialCheck()) {
+        SetPartials(FB_MAX_PARTIALS);
+    }
+    lastPartial = Partial();
+    if (!lastPartial) {
+        if (partial) {
+            epd->SetPartial(false);
+            partial = false;
+        }
+        epd->SetWindow(0, 0, rowBytes, rows);
+        for (int step = 0; step < planeCount; step++) {
+            StartPlane(step, NULL);
+            SendRows(step, 0, rowBytes, 0, rows);
+        }
+        epd->TurnOnDisplay();
+        if (epd->partialMode != NULL) {
+            if (planeCount == 1) {
+                // the RAM the next partial compares with gets the frame too
+                epd->SendCommand(epd->previousRam ? epd->previousRam : epd->stepCommands[firstStep]);
+                epd->SetToDataMode();
+                SendRows(0, 0, rowBytes, 0, rows);
+            }
+            ramSynced = true;
+        }
+        SetPartials(0);
+    }
+    dirty.Clear();
+    return true;
+}
+
+/* END OF FILE */
@@ -0,0 +1,138 @@
+/**
+ *  @filename   :   framebuffer.h
+ *  @brief      :   Header file of framebuffer.cpp, an optional frame in
+ *                  the panel's native format that uploads only what changed
+ *
+ *  Drawing marks dirty rectangles (dirty_rects.h); Flush() sends just the
+ *  merged windows through Epd::SetWindow() and falls back to the whole
+ *  plane on controllers without a RAM window. On the S3 the frame lives
+ *  in PSRAM. Without PSRAM, e.g. on the C3, only FB_BAND_ROWS rows are
+ *  held at a time and Render() draws the frame band by band. With
+ *  FRAME_BUFFER the sketch downloads into the frame through Update(), so
+ *  a slide that changes little uploads and refreshes just that.
+ *
+ *  Refresh() shows the changes with the panel's partial waveform when it
+ *  has one (Epd::SetPartial), at most FB_MAX_PARTIALS times in a row
+ *  before a full refresh clears the ghosting; the count survives deep
+ *  sleep. After a wake the controller RAM no longer holds the previous
+ *  frame, the first partial refresh rewrites it from the FrameLoad.
+ *  Colour panels with a partial window (UC81xx) refresh only the box
+ *  around the windows, with their normal waveform and no such limit.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <Arduino.h>
+#include "epd_base.h"
+#include "dirty_rects.h"
+
+// download slides into the frame and refresh only what changed, needs
+// PSRAM (uncomment to enable)
+//#define FRAME_BUFFER
+
+// rows held at a time when the frame does not fit
+#define FB_BAND_ROWS        32
+#define FB_MAX_PLANES       4
+// partial refreshes before a full one
+#define FB_MAX_PARTIALS     8
+
+class FrameBuffer;
+
+// draws the frame; called once per band when banded
+typedef void (*FrameDraw)(FrameBuffer& fb, void* arg);
+// fills dst with len bytes of download step from offset, what the panel
+// holds, e.g. from FrameStore::Read()
+typedef bool (*FrameLoad)(int step, unsigned long offset, uint8_t* dst, size_t len, void* arg);
+
+class FrameBuffer {
+public:
+    FrameBuffer();
+    ~FrameBuffer();
+
+    bool Begin(Epd& panel, FrameLoad load = NULL, void* loadArg = NULL);
+    void End(void);
+    bool Banded(void) const {
+        return banded;
+    }
+
+    void SetPixel(unsigned long x, unsigned long y, uint8_t value, int plane = 0);
+    uint8_t GetPixel(unsigned long x, unsigned long y, int plane = 0);
+    void FillRect(unsigned long x, unsigned long y, unsigned long w, unsigned long h, uint8_t value, int plane = 0);
+    void Blit(unsigned long col, unsigned long row, unsigned long cols, unsigned long rows,
+              const uint8_t* src, int plane = 0);
+    void Fill(uint8_t value, int plane = 0);
+    void Update(unsigned long offset, const uint8_t* src, size_t len);
+
+    bool Flush(void);
+    bool Render(FrameDraw draw, void* arg);
+    bool Refresh(void);
+    void ForceFull(void);
+    const uint8_t* Plane(int plane) const;
+
+    DirtyRects dirty;
+    unsigned long uploaded;         // plane bytes sent by the last Flush/Render
+    unsigned long windows;          // windows used for it, 0 for a full upload
+    bool lastPartial;               // the last Refresh() was a partial one
+
+private:
+    uint8_t* Row(int plane, unsigned long row);
+    void PutPixel(uint8_t* line, unsigned long x, uint8_t value);
+    void MarkDirty(unsigned long col0, unsigned long row0, unsigned long col1, unsigned long row1);
+    bool Windowed(void);
+    void StartPlane(int step, const DirtyRect* w);
+    void SendRows(int plane, unsigned long col, unsigned long cols, unsigned long row0, unsigned long row1);
+    bool LoadBand(unsigned long row);
+    void SendWindows(int plane, unsigned char command);
+    void RefreshWindows(void);
+    bool RestoreRam(void);
+    bool Partial(void);
+
+    Epd* epd;
+    uint8_t* planes[FB_MAX_PLANES];
+    uint8_t* band;
+    uint8_t* stage;
+    size_t stageSize;
+    uint8_t background[FB_MAX_PLANES];
+    FrameLoad load;
+    void* loadArg;
+    int firstStep;                  // download step of plane 0
+    int planeCount;                 // planes drawn, steps from firstStep
+    unsigned char bpp;
+    unsigned char ppb;
+    unsigned long rowBytes;
+    unsigned long rows;
+    unsigned long bandStart;
+    unsigned long bandRows;
+    bool banded;
+    bool collecting;
+    bool partial;                   // controller has the partial waveform loaded
+    bool ramSynced;                 // controller RAM holds the frame before the changes
+};
+
+#endif
+
+/* END OF FILE */
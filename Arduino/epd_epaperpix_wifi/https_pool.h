@@ -0,0 +1,184 @@
+/**
+ *  @filename   :   https_pool.h
+ *  @brief      :   Keep-alive HTTPS connections, one per host
+ *
+ *  The API calls and the blob download of one wake go through the same
+ *  few TLS sessions instead of a new handshake per request.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef HTTPS_POOL_H
+#define HTTPS_POOL_H
+
+#include <HTTPClient.h>
+#include "tls_session.h"
+
+// Sessions kept open at once, each holds its TLS buffers (~40 KB)
+#define HTTPS_POOL_SIZE 2
+
+/**
+ *  @brief: HTTPClient reuses a connected client without checking which
+ *          host it is connected to, so every host gets its own client
+ *          here. When all slots are taken the least recently used one
+ *          is closed. Call end() after every request as usual; a fully
+ *          read keep-alive response leaves the socket open.
+ */
+class HttpsPool {
+public:
+    HttpsPool() : handshakes(0), requests(0), useCount(0) {}
+
+    /**
+     *  @brief: point http at the kept session for the URL's host
+     */
+    bool Begin(HTTPClient& http, const String& url) {
+        Slot* slot = Claim(HostOf(url));
+        requests++;
+        if (!slot->client.connected()) {
+            handshakes++;
+        }
+        http.setReuse(true);
+        return http.begin(slot->client, url);
+    }
+
+    /**
+     *  @brief: handshake with the hosts of both URLs side by side and keep
+     *          the session that is up first, the other one is closed.
+     *          Returns 0 or 1 for the winning URL, -1 when both failed.
+     *          Begin() then reuses the winner's connection.
+     */
+    int Race(const String& urlA, const String& urlB) {
+        const String* urls[2] = { &urlA, &urlB };
+        Slot* slot[2];
+        String name[2];
+        uint16_t port[2];
+        bool running[2];
+        for (int i = 0; i < 2; i++) {
+            String host = HostOf(*urls[i]);
+            slot[i] = Claim(host);
+            if (slot[i]->client.connected()) {
+                // a kept session beats any new handshake
+                return i;
+            }
+            int colon = host.indexOf(':');
+            name[i] = colon < 0 ? host : host.substring(0, colon);
+            port[i] = colon < 0 ? 443 : host.substring(colon + 1).toInt();
+        }
+        for (int i = 0; i < 2; i++) {
+            handshakes++;
+            running[i] = slot[i]->client.ConnectStart(name[i].c_str(), port[i], TLS_HANDSHAKE_TIMEOUT);
+        }
+        int winner = -1;
+        while (winner < 0 && (running[0] || running[1])) {
+            for (int i = 0; i < 2 && winner < 0; i++) {
+                if (!running[i]) {
+                    continue;
+                }
+                int ret = slot[i]->client.ConnectStep(name[i].c_str());
+                if (ret > 0) {
+                    winner = i;
+                } else if (ret < 0) {
+                    running[i] = false;
+                }
+            }
+            delay(1);
+        }
+        if (winner >= 0) {
+            slot[1 - winner]->client.stop();
+        }
+        return winner;
+    }
+
+    /**
+     *  @brief: drop the session of the URL's host, e.g. after a response
+     *          that was not read to the end
+     */
+    void Close(const String& url) {
+        String host = HostOf(url);
+        for (int i = 0; i < HTTPS_POOL_SIZE; i++) {
+            if (slots[i].host == host) {
+                slots[i].client.stop();
+            }
+        }
+    }
+
+    /**
+     *  @brief: close every session while WiFi is still up
+     */
+    void CloseAll(void) {
+        for (int i = 0; i < HTTPS_POOL_SIZE; i++) {
+            slots[i].client.stop();
+            slots[i].host = "";
+            slots[i].lastUse = 0;
+        }
+    }
+
+    int handshakes;     // TLS connections opened this wake
+    int requests;       // Begin() calls this wake
+
+private:
+    struct Slot {
+        Slot() : lastUse(0) {}
+        String host;
+        TlsClient client;
+        unsigned long lastUse;
+    };
+
+    // slot of the host, else the least recently used one is taken over
+    Slot* Claim(const String& host) {
+        Slot* slot = NULL;
+        for (int i = 0; i < HTTPS_POOL_SIZE; i++) {
+            if (slots[i].host == host) {
+                slot = &slots[i];
+            }
+        }
+        if (slot == NULL) {
+            slot = &slots[0];
+            for (int i = 1; i < HTTPS_POOL_SIZE; i++) {
+                if (slots[i].lastUse < slot->lastUse) {
+                    slot = &slots[i];
+                }
+            }
+            slot->client.stop();
+            slot->host = host;
+        }
+        slot->lastUse = ++useCount;
+        return slot;
+    }
+
+    // "https://host:port/path" -> "host:port"
+    static String HostOf(const String& url) {
+        int start = url.indexOf("://");
+        start = start < 0 ? 0 : start + 3;
+        int end = url.indexOf('/', start);
+        return end < 0 ? url.substring(start) : url.substring(start, end);
+    }
+
+    Slot slots[HTTPS_POOL_SIZE];
+    unsigned long useCount;
+};
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,137 @@
+/**
+ *  @filename   :   mirror_select.cpp
+ *  @brief      :   Picks the blob mirror expected to deliver a slide first
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include "mirror_select.h"
+
+/**
+ *  RTC slow memory keeps the stats through deep sleep but holds garbage
+ *  after power-on, hence the checksum.
+ */
+struct MirrorState {
+    MirrorStats mirror[MIRROR_COUNT];
+    uint32_t wakes;
+    uint32_t check;
+};
+
+RTC_DATA_ATTR static MirrorState mirrorState;
+
+static uint32_t StateCrc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&mirrorState, offsetof(MirrorState, check));
+}
+
+// new samples count a quarter, one slow download does not flip the choice
+static uint32_t Smooth(uint32_t old, uint32_t sample, bool first) {
+    return first ? sample : (old * 3 + sample) / 4;
+}
+
+/**
+ *  @brief: load the stats and pick the mirror for this wake
+ */
+void MirrorSelect::Begin(unsigned long bytes) {
+    slideBytes = bytes;
+    if (mirrorState.check != StateCrc()) {
+        memset(&mirrorState, 0, sizeof(mirrorState));
+    }
+    mirrorState.wakes++;
+    mirrorState.check = StateCrc();
+
+    int best = 0;
+    for (int i = 1; i < MIRROR_COUNT; i++) {
+        if (Expected(i) < Expected(best)) {
+            best = i;
+        }
+    }
+    preferred = best;
+    probing = false;
+    if (mirrorState.wakes % MIRROR_PROBE_EVERY == 0) {
+        preferred = (best + 1) % MIRROR_COUNT;
+        probing = true;
+    }
+}
+
+/**
+ *  @brief: mirror for a download attempt, the others take turns on retries
+ */
+int MirrorSelect::Pick(int attempt) {
+    return (preferred + attempt) % MIRROR_COUNT;
+}
+
+/**
+ *  @brief: expected ms to fetch a slide, 0 for a mirror never tried so
+ *          each one gets measured once
+ */
+unsigned long MirrorSelect::Expected(int mirror) {
+    const MirrorStats& m = mirrorState.mirror[mirror];
+    if (m.samples == 0) {
+        return 0;
+    }
+    unsigned long ms = m.connectMs + (unsigned long)m.failures * MIRROR_FAIL_PENALTY;
+    if (m.bytesPerSec > 0) {
+        ms += (unsigned long)((uint64_t)slideBytes * 1000 / m.bytesPerSec);
+    }
+    return ms;
+}
+
+/**
+ *  @brief: note one attempt. bytes and ms describe the body and are 0
+ *          when none was read (e.g. 304 or an error status).
+ */
+void MirrorSelect::Record(int mirror, unsigned long connectMs, long bytes, unsigned long ms, bool ok) {
+    MirrorStats& m = mirrorState.mirror[mirror];
+    if (m.samples < 0xFFFF) {
+        m.samples++;
+    }
+    if (!ok) {
+        if (m.failures < 0xFFFF) {
+            m.failures++;
+        }
+    } else {
+        m.failures = 0;
+        m.connectMs = Smooth(m.connectMs, connectMs, m.connectMs == 0);
+        // short bodies say more about latency than about bandwidth
+        if (bytes >= 4096 && ms > 0) {
+            m.bytesPerSec = Smooth(m.bytesPerSec, (uint32_t)((uint64_t)bytes * 1000 / ms), m.bytesPerSec == 0);
+        }
+    }
+    mirrorState.check = StateCrc();
+}
+
+void MirrorSelect::Print(void) {
+    Serial.printf("[MIRROR] wake %lu started on %d%s\n", (unsigned long)mirrorState.wakes, preferred,
+                  probing ? " (probe)" : "");
+    for (int i = 0; i < MIRROR_COUNT; i++) {
+        const MirrorStats& m = mirrorState.mirror[i];
+        Serial.printf("[MIRROR] %d: connect %lu ms, %lu B/s, %u failures, %u samples, expect %lu ms\n",
+                      i, (unsigned long)m.connectMs, (unsigned long)m.bytesPerSec, m.failures, m.samples,
+                      Expected(i));
+    }
+}
+
+/* END OF FILE */
@@ -0,0 +1,79 @@
+/**
+ *  @filename   :   mirror_select.h
+ *  @brief      :   Header file of mirror_select.cpp, picks the blob mirror
+ *                  expected to deliver a slide first
+ *
+ *  Every download records how long the mirror took to answer and how fast
+ *  the body came in. The stats live in RTC memory, so each wake starts on
+ *  the mirror that did best lately instead of always on the primary.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef MIRROR_SELECT_H
+#define MIRROR_SELECT_H
+
+#include <Arduino.h>
+
+#define MIRROR_COUNT            2
+// every Nth wake starts on a mirror that is not the best, so its stats
+// do not go stale
+#define MIRROR_PROBE_EVERY      8
+// added to the expected time per failure in a row, in ms
+#define MIRROR_FAIL_PENALTY     4000
+// connect to both mirrors side by side and keep the first one up
+// (costs a second handshake per wake)
+//#define MIRROR_RACE
+
+/**
+ *  @brief: per mirror stats, smoothed over the last few downloads
+ */
+struct MirrorStats {
+    uint32_t connectMs;         // request sent to status line, handshake included
+    uint32_t bytesPerSec;       // body throughput, 0 until a body was read
+    uint16_t failures;          // failed attempts in a row
+    uint16_t samples;           // attempts recorded
+};
+
+class MirrorSelect {
+public:
+    MirrorSelect() : preferred(0), probing(false) {}
+
+    void Begin(unsigned long slideBytes);
+    int Pick(int attempt);
+    void Record(int mirror, unsigned long connectMs, long bytes, unsigned long ms, bool ok);
+    void Print(void);
+
+    int preferred;              // mirror tried first this wake
+    bool probing;               // preferred is not the expected best
+
+private:
+    unsigned long Expected(int mirror);
+
+    unsigned long slideBytes;
+};
+
+#endif
+
+/* END OF FILE */
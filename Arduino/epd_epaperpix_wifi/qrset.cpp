@@ -33,6 +33,9 @@
 #ifndef QRSET_C
 #define QRSET_C
 
+// Pixel bytes are collected into chunks of this size and sent as one SPI burst
+#define QR_CHUNK_SIZE 128
+
 void Epd::QRset( int scale) {
     // QRset using steps/stepCommands (Clear-then-QRset approach)
     if(ShowDebug) {
@@ -82,6 +85,9 @@ void Epd::QRset( int scale) {
             Serial.println(stepCommands[steps-1], HEX);
         }
         
+        UBYTE chunk[QR_CHUNK_SIZE];
+        int chunk_len = 0;
+
         // Generate QR data based on pixel format
         if(bits_per_pixel == 4) {
             // 4-bit color (2 pixels per byte)
@@ -126,7 +132,11 @@ void Epd::QRset( int scale) {
                         }
                     }
                     
-                    SendData(pixel_pair);
+                    chunk[chunk_len++] = pixel_pair;
+                    if(chunk_len == QR_CHUNK_SIZE) {
+                        SendBuffer(chunk, chunk_len);
+                        chunk_len = 0;
+                    }
                 }
             }
             
@@ -170,7 +180,11 @@ void Epd::QRset( int scale) {
                         }
                     }
                     
-                    SendData(packed_byte);
+                    chunk[chunk_len++] = packed_byte;
+                    if(chunk_len == QR_CHUNK_SIZE) {
+                        SendBuffer(chunk, chunk_len);
+                        chunk_len = 0;
+                    }
                 }
             }
             
@@ -208,10 +222,15 @@ void Epd::QRset( int scale) {
                         }
                     }
                     
-                    SendData(packed_byte);
+                    chunk[chunk_len++] = packed_byte;
+                    if(chunk_len == QR_CHUNK_SIZE) {
+                        SendBuffer(chunk, chunk_len);
+                        chunk_len = 0;
+                    }
                 }
             }
         }
+        SendBuffer(chunk, chunk_len);
     //}
     
     if(ShowDebug) {
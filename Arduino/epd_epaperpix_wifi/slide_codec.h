@@ -0,0 +1,407 @@
+/**
+ *  @filename   :   slide_codec.h
+ *  @brief      :   Streaming decoders for compressed slide downloads
+ *
+ *  Slides are stored in panel-native bytes, mostly flat areas, so they
+ *  compress well. The blob's Content-Encoding selects the codec:
+ *
+ *    x-epd-packbits  PackBits runs, no state beyond the current run
+ *    x-epd-lz        byte oriented LZ77 with a SLIDE_LZ_WINDOW history
+ *    x-epd-diff      copy/literal ops against the frame shown before,
+ *                    read back from flash (see FrameStore)
+ *
+ *  tools/epd_pack.py writes the first two, tools/epd_diff.py the diff.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef SLIDE_CODEC_H
+#define SLIDE_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <WiFi.h>
+
+// LZ history the encoder may refer back to, power of two
+#define SLIDE_LZ_WINDOW     4096
+// LZ token: 0x00-0x7F literal run of c+1 bytes, 0x80-0xFF match of
+// (c & 0x7F) + SLIDE_LZ_MIN_MATCH bytes followed by offset-1 (16 bit LE)
+#define SLIDE_LZ_MIN_MATCH  4
+// compressed bytes read from the socket at a time
+#define SLIDE_INPUT_SIZE    512
+// diff body: "EPDF", CRC32 of the base frame (LE), then ops
+#define SLIDE_DIFF_HEADER   8
+#define SLIDE_DIFF_COPY     0x00    // + varint n: n bytes of the base
+#define SLIDE_DIFF_LITERAL  0x01    // + varint n + n bytes replacing the base
+
+/**
+ *  @brief: decoder state machine. Input and output can be cut anywhere,
+ *          a run that does not fit the output continues on the next call.
+ */
+class SlideDecoder {
+public:
+    enum Codec { RAW, PACKBITS, LZ, DIFF };
+
+    SlideDecoder() : codec(RAW), state(HEADER), count(0), value(0), offset(0), pos(0), shift(0), copy(false),
+        base(NULL), baseCrc(0) {}
+
+    /**
+     *  @brief: codec for a Content-Encoding value, RAW when unknown
+     */
+    static Codec ForEncoding(const String& encoding) {
+        if (encoding.equalsIgnoreCase("x-epd-packbits")) {
+            return PACKBITS;
+        }
+        if (encoding.equalsIgnoreCase("x-epd-lz")) {
+            return LZ;
+        }
+        if (encoding.equalsIgnoreCase("x-epd-diff")) {
+            return DIFF;
+        }
+        return RAW;
+    }
+
+    /**
+     *  @brief: frame a diff applies to, read from its start. A diff made
+     *          against another CRC fails instead of drawing garbage.
+     */
+    void SetBase(Stream* frame, uint32_t crc) {
+        base = frame;
+        baseCrc = crc;
+    }
+
+    void Begin(Codec c) {
+        codec = c;
+        state = codec == DIFF ? MAGIC : HEADER;
+        count = 0;
+        pos = 0;
+    }
+
+    Codec GetCodec(void) const {
+        return codec;
+    }
+
+    /**
+     *  @brief: true while a run is still owed to the output
+     */
+    bool Pending(void) const {
+        return state == REPEAT || state == COPY || state == BASE;
+    }
+
+    /**
+     *  @brief: true once a diff turned out not to fit the base frame
+     */
+    bool Failed(void) const {
+        return state == FAILED;
+    }
+
+    /**
+     *  @brief: decode in[0..inLen) into out[0..room). Returns the bytes
+     *          written, *used is set to the input bytes consumed.
+     */
+    size_t Decode(const uint8_t* in, size_t inLen, size_t* used, uint8_t* out, size_t room) {
+        size_t i = 0;
+        size_t o = 0;
+        while (o < room) {
+            if (state == HEADER) {
+                if (i == inLen) {
+                    break;
+                }
+                uint8_t c = in[i++];
+                if (codec == DIFF) {
+                    if (c != SLIDE_DIFF_COPY && c != SLIDE_DIFF_LITERAL) {
+                        state = FAILED;
+                        break;
+                    }
+                    copy = c == SLIDE_DIFF_COPY;
+                    count = 0;
+                    shift = 0;
+                    state = LENGTH;
+                } else if (codec == PACKBITS) {
+                    if (c < 0x80) {
+                        count = c + 1;
+                        state = LITERAL;
+                    } else if (c > 0x80) {
+                        count = 257 - c;
+                        state = VALUE;
+                    }
+                    // 0x80 is a no-op
+                } else if (c < 0x80) {
+                    count = c + 1;
+                    state = LITERAL;
+                } else {
+                    count = (c & 0x7F) + SLIDE_LZ_MIN_MATCH;
+                    state = OFFSET_LO;
+                }
+            } else if (state == LITERAL) {
+                size_t n = Min(Min(count, room - o), inLen - i);
+                if (n == 0) {
+                    break;
+                }
+                if (codec == DIFF && !SkipBase(out + o, n)) {
+                    break;
+                }
+                memcpy(out + o, in + i, n);
+                Remember(out + o, n);
+                i += n;
+                o += n;
+                count -= n;
+                if (count == 0) {
+                    state = HEADER;
+                }
+            } else if (state == MAGIC) {
+                if (i == inLen) {
+                    break;
+                }
+                header[count++] = in[i++];
+                if (count == SLIDE_DIFF_HEADER) {
+                    uint32_t crc = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+                    bool ok = memcmp(header, "EPDF", 4) == 0 && base != NULL && crc == baseCrc;
+                    state = ok ? HEADER : FAILED;
+                    count = 0;
+                }
+            } else if (state == LENGTH) {
+                if (i == inLen) {
+                    break;
+                }
+                uint8_t b = in[i++];
+                count |= (size_t)(b & 0x7F) << shift;
+                shift += 7;
+                if (b & 0x80) {
+                    continue;
+                }
+                state = count == 0 ? HEADER : (copy ? BASE : LITERAL);
+            } else if (state == BASE) {
+                // unchanged bytes come from the stored frame
+                size_t n = Min(count, room - o);
+                if (base->readBytes(out + o, n) != n) {
+                    state = FAILED;
+                    break;
+                }
+                o += n;
+                count -= n;
+                if (count == 0) {
+                    state = HEADER;
+                }
+            } else if (state == FAILED) {
+                break;
+            } else if (state == VALUE) {
+                if (i == inLen) {
+                    break;
+                }
+                value = in[i++];
+                state = REPEAT;
+            } else if (state == REPEAT) {
+                size_t n = Min(count, room - o);
+                memset(out + o, value, n);
+                o += n;
+                count -= n;
+                if (count == 0) {
+                    state = HEADER;
+                }
+            } else if (state == OFFSET_LO) {
+                if (i == inLen) {
+                    break;
+                }
+                offset = in[i++];
+                state = OFFSET_HI;
+            } else if (state == OFFSET_HI) {
+                if (i == inLen) {
+                    break;
+                }
+                offset |= (size_t)in[i++] << 8;
+                offset += 1;
+                state = COPY;
+            } else {
+                // COPY: byte by byte, a match may overlap its own output
+                while (count > 0 && o < room) {
+                    uint8_t b = window[(pos - offset) & (SLIDE_LZ_WINDOW - 1)];
+                    window[pos++ & (SLIDE_LZ_WINDOW - 1)] = b;
+                    out[o++] = b;
+                    count--;
+                }
+                if (count == 0) {
+                    state = HEADER;
+                }
+            }
+        }
+        *used = i;
+        return o;
+    }
+
+private:
+    enum State { HEADER, LITERAL, VALUE, REPEAT, OFFSET_LO, OFFSET_HI, COPY, MAGIC, LENGTH, BASE, FAILED };
+
+    static size_t Min(size_t a, size_t b) {
+        return a < b ? a : b;
+    }
+
+    // a diff literal replaces base bytes, read past them; out is the
+    // place the literal goes to, so no scratch buffer is needed
+    bool SkipBase(uint8_t* out, size_t n) {
+        if (base->readBytes(out, n) != n) {
+            state = FAILED;
+            return false;
+        }
+        return true;
+    }
+
+    void Remember(const uint8_t* p, size_t n) {
+        if (codec != LZ) {
+            return;
+        }
+        for (size_t k = 0; k < n; k++) {
+            window[pos++ & (SLIDE_LZ_WINDOW - 1)] = p[k];
+        }
+    }
+
+    Codec codec;
+    State state;
+    size_t count;
+    uint8_t value;
+    size_t offset;
+    size_t pos;
+    uint8_t shift;
+    bool copy;
+    Stream* base;
+    uint32_t baseCrc;
+    uint8_t header[SLIDE_DIFF_HEADER];
+    uint8_t window[SLIDE_LZ_WINDOW];
+};
+
+/**
+ *  @brief: the response body as panel bytes. Reads what the socket has,
+ *          decodes it when the blob is compressed and never blocks.
+ */
+class SlideSource {
+public:
+    SlideSource() : received(0), produced(0), decodeUs(0), stream(NULL), remaining(-1), inPos(0), inLen(0) {}
+
+    /**
+     *  @brief: length is the Content-Length, -1 when the server sent none
+     */
+    void Begin(WiFiClient* s, long length, SlideDecoder::Codec codec) {
+        stream = s;
+        remaining = length;
+        inPos = 0;
+        inLen = 0;
+        received = 0;
+        produced = 0;
+        decodeUs = 0;
+        decoder.Begin(codec);
+    }
+
+    /**
+     *  @brief: false once the body is used up and nothing is left to decode
+     */
+    bool More(void) {
+        if (decoder.Failed()) {
+            return false;
+        }
+        if (inPos < inLen || decoder.Pending()) {
+            return true;
+        }
+        return remaining != 0 && (stream->available() || stream->connected());
+    }
+
+    /**
+     *  @brief: up to room panel bytes, 0 when the socket has nothing yet
+     */
+    size_t Read(uint8_t* dst, size_t room) {
+        if (decoder.GetCodec() == SlideDecoder::RAW) {
+            size_t n = Fetch(dst, room);
+            produced += n;
+            return n;
+        }
+        if (inPos == inLen && !decoder.Pending()) {
+            inLen = Fetch(input, sizeof(input));
+            inPos = 0;
+        }
+        unsigned long start = micros();
+        size_t used;
+        size_t n = decoder.Decode(input + inPos, inLen - inPos, &used, dst, room);
+        decodeUs += micros() - start;
+        inPos += used;
+        produced += n;
+        return n;
+    }
+
+    SlideDecoder::Codec GetCodec(void) const {
+        return decoder.GetCodec();
+    }
+
+    void SetBase(Stream* frame, uint32_t crc) {
+        decoder.SetBase(frame, crc);
+    }
+
+    bool Failed(void) const {
+        return decoder.Failed();
+    }
+
+    /**
+     *  @brief: body bytes still to come, -1 when the length is unknown
+     */
+    long Remaining(void) const {
+        return remaining;
+    }
+
+    long received;              // bytes taken from the socket
+    long produced;              // panel bytes handed out
+    unsigned long decodeUs;     // time spent in the decoder
+
+private:
+    size_t Fetch(uint8_t* dst, size_t room) {
+        size_t size = stream->available();
+        if (size == 0) {
+            return 0;
+        }
+        if (size > room) {
+            size = room;
+        }
+        if (remaining >= 0 && size > (size_t)remaining) {
+            size = remaining;
+        }
+        int n = stream->readBytes(dst, size);
+        if (n <= 0) {
+            return 0;
+        }
+        if (remaining > 0) {
+            remaining -= n;
+        }
+        received += n;
+        return n;
+    }
+
+    WiFiClient* stream;
+    long remaining;
+    SlideDecoder decoder;
+    uint8_t input[SLIDE_INPUT_SIZE];
+    size_t inPos;
+    size_t inLen;
+};
+
+#endif
+
+/* END OF FILE */
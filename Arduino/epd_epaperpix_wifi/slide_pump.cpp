@@ -0,0 +1,214 @@
+/**
+ *  @filename   :   slide_pump.cpp
+ *  @brief      :   Moves a slide body to the panel step by step
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include "slide_pump.h"
+
+SlidePump::SlidePump(int n, unsigned long size, unsigned long stall) : moved(0), stalled(false), ended(false),
+    steps(n), blockSize(size), stallMs(stall), read(NULL), readArg(NULL) {
+}
+
+void SlidePump::Source(PumpRead r, void* arg) {
+    read = r;
+    readArg = arg;
+}
+
+// one read: the count, 0 after waiting a little, -1 when the body ended
+// or sent nothing for stallMs
+int SlidePump::Read(uint8_t* dst, size_t len, unsigned long* lastData) {
+    int n = read(dst, len, readArg);
+    if (n > 0) {
+        *lastData = millis();
+        return n;
+    }
+    if (n < 0) {
+        ended = true;
+        return -1;
+    }
+    if (millis() - *lastData > stallMs) {
+        stalled = true;
+        return -1;
+    }
+    delay(1);
+    return 0;
+}
+
+/**
+ *  @brief: read and drop count bytes, the panel bytes a full body repeats
+ *          from an earlier attempt. False when the body stopped first.
+ */
+bool SlidePump::Skip(long count) {
+    stalled = false;
+    ended = false;
+    uint8_t scratch[256];
+    unsigned long lastData = millis();
+    while (count > 0) {
+        int n = Read(scratch, min(count, (long)sizeof(scratch)), &lastData);
+        if (n < 0) {
+            return false;
+        }
+        count -= n;
+    }
+    return true;
+}
+
+/**
+ *  @brief: read exactly len body bytes into dst, e.g. one source row for
+ *          DitherStream. False when the body stopped first.
+ */
+bool SlidePump::ReadFull(uint8_t* dst, size_t len) {
+    stalled = false;
+    ended = false;
+    unsigned long lastData = millis();
+    while (len > 0) {
+        int n = Read(dst, len, &lastData);
+        if (n < 0) {
+            return false;
+        }
+        dst += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ *  @brief: send the frame from panel offset startAt to its end through
+ *          two bufSize buffers: while one is out to the sink the other
+ *          fills. A startAt above 0 continues a step whose data command
+ *          Epd::ResumeStep() sent. True when the frame is complete.
+ */
+bool SlidePump::Run(uint8_t* const bufs[2], size_t bufSize, const PumpSink& sink, long startAt) {
+    moved = 0;
+    stalled = false;
+    ended = false;
+    int first = startAt / blockSize;
+    unsigned long lastData = millis();
+    for (int step = first; step < steps && !stalled && !ended; step++) {
+        long stepLen = blockSize;
+        if (step == first && startAt > 0) {
+            stepLen -= startAt % blockSize;
+        } else {
+            sink.startStep(step, sink.arg);
+        }
+        int cur = 0;
+        size_t fill = 0;
+        while (stepLen > 0) {
+            size_t target = min(bufSize, (size_t)stepLen);
+            int n = Read(bufs[cur] + fill, target - fill, &lastData);
+            if (n < 0) {
+                break;
+            }
+            fill += n;
+            if (fill == target) {
+                // out to the sink, the other buffer fills meanwhile
+                sink.send(bufs[cur], fill, sink.arg);
+                moved += fill;
+                stepLen -= fill;
+                cur ^= 1;
+                fill = 0;
+            }
+        }
+        if (fill > 0) {
+            // the body stopped mid-buffer, send what arrived
+            sink.send(bufs[cur], fill, sink.arg);
+            moved += fill;
+        }
+        sink.wait(sink.arg);
+    }
+    return startAt + moved >= (long)Total();
+}
+
+/**
+ *  @brief: network end of the ring. The frame continues at *produced,
+ *          skip bytes of the body are dropped first (a full body after
+ *          an attempt that got that far). Waits for the panel do not
+ *          count as a stall. True once the ring holds the whole frame.
+ */
+bool SlidePump::Fill(SpscRing& ring, long* produced, long skip, const PumpLink& link, PumpTap tap, void* tapArg) {
+    moved = 0;
+    if (!Skip(skip)) {
+        return false;
+    }
+    unsigned long lastData = millis();
+    while (*produced < (long)Total()) {
+        size_t room;
+        uint8_t* dst = ring.WritePtr(&room);
+        if (room == 0) {
+            // the panel is behind
+            link.wait(link.arg);
+            lastData = millis();
+            continue;
+        }
+        int n = Read(dst, min(room, (size_t)(Total() - *produced)), &lastData);
+        if (n < 0) {
+            break;
+        }
+        if (n > 0) {
+            tap(dst, n, tapArg);
+            ring.Commit(n);
+            *produced += n;
+            moved += n;
+            link.signal(link.arg);
+        }
+    }
+    return *produced >= (long)Total();
+}
+
+/**
+ *  @brief: panel end of the ring, every step from the first one in chunks
+ *          of at most chunk bytes until the ring is closed and empty.
+ *          Returns the bytes sent.
+ */
+long SlidePump::Drain(SpscRing& ring, size_t chunk, const PumpSink& sink, const PumpLink& link) {
+    moved = 0;
+    for (int step = 0; step < steps && !ring.Drained(); step++) {
+        long stepLen = blockSize;
+        sink.startStep(step, sink.arg);
+        while (stepLen > 0) {
+            size_t n;
+            const uint8_t* src = ring.ReadPtr(&n);
+            if (n == 0) {
+                if (ring.Drained()) {
+                    break;
+                }
+                link.wait(link.arg);
+                continue;
+            }
+            n = min(n, min((size_t)stepLen, chunk));
+            sink.send(src, n, sink.arg);
+            // the ring space is only handed back once the bytes are out
+            sink.wait(sink.arg);
+            ring.Consume(n);
+            link.signal(link.arg);
+            stepLen -= n;
+            moved += n;
+        }
+    }
+    return moved;
+}
+
+/* END OF FILE */
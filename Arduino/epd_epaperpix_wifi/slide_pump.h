@@ -0,0 +1,103 @@
+/**
+ *  @filename   :   slide_pump.h
+ *  @brief      :   Header file of slide_pump.cpp, moves a slide body to
+ *                  the panel step by step
+ *
+ *  The download loops of the sketch without HTTPClient or FreeRTOS in
+ *  them: bytes come from a PumpRead callback and go to a PumpSink, so the
+ *  same code runs against a fake stream and a fake DMA on a PC (see
+ *  tools/slide_pump_test.cpp). Run() fills two buffers in turn, one from
+ *  the network while the other goes out by DMA. Fill() and Drain() are
+ *  the two ends of the SPSC ring when download and upload are separate
+ *  tasks. All of them give up when the body sends nothing for stallMs,
+ *  and continue a frame from a panel offset an earlier attempt reached.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef SLIDE_PUMP_H
+#define SLIDE_PUMP_H
+
+#include <Arduino.h>
+#include "spsc_ring.h"
+
+// up to len body bytes into dst: the count, 0 while nothing came in yet,
+// -1 once the body ended
+typedef int (*PumpRead)(uint8_t* dst, size_t len, void* arg);
+// bytes on their way, e.g. to hash them or keep them in flash
+typedef void (*PumpTap)(const uint8_t* src, size_t len, void* arg);
+
+/**
+ *  @brief: where panel bytes go. send() may return before the bytes are
+ *          out, but not before the ones of the send() before; wait()
+ *          returns once all are out.
+ */
+struct PumpSink {
+    void (*startStep)(int step, void* arg);     // data command of step
+    PumpTap send;
+    void (*wait)(void* arg);
+    void* arg;
+};
+
+/**
+ *  @brief: the other task across a ring
+ */
+struct PumpLink {
+    void (*wait)(void* arg);        // sleep until signalled, or briefly
+    void (*signal)(void* arg);      // wake the other side
+    void* arg;
+};
+
+class SlidePump {
+public:
+    SlidePump(int steps, unsigned long blockSize, unsigned long stallMs);
+
+    void Source(PumpRead read, void* arg);
+    unsigned long Total(void) const {
+        return (unsigned long)steps * blockSize;
+    }
+
+    bool Skip(long count);
+    bool ReadFull(uint8_t* dst, size_t len);
+    bool Run(uint8_t* const bufs[2], size_t bufSize, const PumpSink& sink, long startAt);
+    bool Fill(SpscRing& ring, long* produced, long skip, const PumpLink& link, PumpTap tap, void* tapArg);
+    long Drain(SpscRing& ring, size_t chunk, const PumpSink& sink, const PumpLink& link);
+
+    long moved;                     // panel bytes the last call passed on
+    bool stalled;                   // it stopped after stallMs without data
+    bool ended;                     // it stopped at the end of the body
+
+private:
+    int Read(uint8_t* dst, size_t len, unsigned long* lastData);
+
+    int steps;
+    unsigned long blockSize;
+    unsigned long stallMs;
+    PumpRead read;
+    void* readArg;
+};
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,205 @@
+/**
+ *  @filename   :   slide_store.cpp
+ *  @brief      :   The next slide kept in flash for a wake without WiFi
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <time.h>
+#include <esp_attr.h>
+#include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
+#include "slide_store.h"
+#include "wall_clock.h"
+
+/**
+ *  What the stored file holds. RTC slow memory keeps it through deep
+ *  sleep but holds garbage after power-on, hence the checksum.
+ */
+struct StoredSlide {
+    char filename[64];
+    uint32_t size;              // panel bytes in the file, 0 for none
+    uint32_t crc;               // CRC32 of those bytes
+    int32_t secondsdelay;       // sleep after showing it
+    uint32_t savedAt;           // time() when it was written
+    uint32_t showIn;            // seconds from savedAt to the wake that shows it
+    uint32_t check;
+};
+
+RTC_DATA_ATTR static StoredSlide storedSlide;
+
+static uint32_t StoredCrc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&storedSlide, offsetof(StoredSlide, check));
+}
+
+bool SlideStore::Mount(void) {
+    if (!mounted) {
+        // an unformatted partition is formatted on first use
+        mounted = LittleFS.begin(true);
+        if (!mounted) {
+            Serial.println("[STORE] no flash file system");
+        }
+    }
+    return mounted;
+}
+
+/**
+ *  @brief: start writing a new slide, the stored one is dropped first
+ */
+bool SlideStore::Create(void) {
+    Drop();
+    if (!Mount()) {
+        return false;
+    }
+    file = LittleFS.open(SLIDE_STORE_PATH, "w");
+    size = 0;
+    crc = 0;
+    return (bool)file;
+}
+
+bool SlideStore::Append(const uint8_t* buf, size_t len) {
+    if (file.write(buf, len) != len) {
+        Serial.println("[STORE] flash write failed");
+        return false;
+    }
+    crc = esp_rom_crc32_le(crc, buf, len);
+    size += len;
+    return true;
+}
+
+/**
+ *  @brief: close the file and make it the slide for the wake in showIn
+ *          seconds. Without a set clock that wake could not be told from
+ *          any other, the slide is not kept.
+ */
+bool SlideStore::Commit(const char* filename, long secondsdelay, long showIn) {
+    file.close();
+    if (strlen(filename) >= sizeof(storedSlide.filename)) {
+        return false;
+    }
+    if (!WallClock::Valid()) {
+        Serial.println("[STORE] clock not set, slide not kept");
+        return false;
+    }
+    memset(&storedSlide, 0, sizeof(storedSlide));
+    strcpy(storedSlide.filename, filename);
+    storedSlide.size = size;
+    storedSlide.crc = crc;
+    storedSlide.secondsdelay = secondsdelay;
+    storedSlide.savedAt = (uint32_t)time(NULL);
+    storedSlide.showIn = showIn;
+    storedSlide.check = StoredCrc();
+    Serial.printf("[STORE] %s stored, %lu bytes\n", filename, (unsigned long)size);
+    return true;
+}
+
+void SlideStore::Drop(void) {
+    if (file) {
+        file.close();
+    }
+    memset(&storedSlide, 0, sizeof(storedSlide));
+    storedSlide.check = StoredCrc();
+}
+
+/**
+ *  @brief: true when a slide is stored for this wake. A wake far off the
+ *          schedule goes online instead, the slideshow may have moved on.
+ */
+bool SlideStore::Ready(void) {
+    if (storedSlide.check != StoredCrc() || storedSlide.size == 0) {
+        return false;
+    }
+    uint32_t now = (uint32_t)time(NULL);
+    uint32_t due = storedSlide.savedAt + storedSlide.showIn;
+    if (!WallClock::Valid() || now < storedSlide.savedAt || now > due + PREFETCH_SLACK) {
+        Serial.println("[STORE] stored slide is off schedule");
+        Drop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief: check the stored file against its CRC, then send it to the
+ *          panel step by step. Nothing reaches the panel when the check
+ *          fails.
+ */
+bool SlideStore::Upload(Epd& epd) {
+    if (!Mount() || storedSlide.size != (uint32_t)epd.steps * epd.blockSize) {
+        return false;
+    }
+    File in = LittleFS.open(SLIDE_STORE_PATH, "r");
+    if (!in || in.size() != storedSlide.size) {
+        return false;
+    }
+    size_t bufSize = epd.streamBufferSize;
+    uint8_t* buf = (uint8_t*)heap_caps_malloc(bufSize, MALLOC_CAP_DMA);
+    if (buf == NULL) {
+        in.close();
+        return false;
+    }
+
+    uint32_t check = 0;
+    size_t n;
+    while ((n = in.read(buf, bufSize)) > 0) {
+        check = esp_rom_crc32_le(check, buf, n);
+    }
+    bool ok = check == storedSlide.crc;
+    if (!ok) {
+        Serial.println("[STORE] stored slide is corrupt");
+    }
+
+    in.seek(0);
+    for (int step = 0; ok && step < epd.steps; step++) {
+        epd.SendCommand(epd.stepCommands[step]);
+        epd.SetToDataMode();
+        unsigned long left = epd.blockSize;
+        while (left > 0) {
+            n = in.read(buf, left < bufSize ? left : bufSize);
+            if (n == 0) {
+                ok = false;
+                break;
+            }
+            epd.SendBuffer(buf, n);
+            left -= n;
+        }
+    }
+    heap_caps_free(buf);
+    in.close();
+    return ok;
+}
+
+const char* SlideStore::Filename(void) {
+    return storedSlide.filename;
+}
+
+long SlideStore::SecondsDelay(void) {
+    return storedSlide.secondsdelay;
+}
+
+uint32_t SlideStore::Crc(void) {
+    return storedSlide.crc;
+}
+
+/* END OF FILE */
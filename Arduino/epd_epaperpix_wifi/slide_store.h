@@ -0,0 +1,76 @@
+/**
+ *  @filename   :   slide_store.h
+ *  @brief      :   Header file of slide_store.cpp, the next slide kept in
+ *                  flash for a wake without WiFi
+ *
+ *  While the panel refreshes, the sketch already asks for the following
+ *  slide and writes it, decoded, to a file. If the next wake is on
+ *  schedule it sends that file to the panel and goes back to sleep
+ *  without turning the radio on. The file's name, size and CRC are kept
+ *  in RTC memory; a file that does not match them is never shown.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef SLIDE_STORE_H
+#define SLIDE_STORE_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "epd_base.h"
+
+// fetch the next slide during the refresh (comment out to disable)
+#define PREFETCH_NEXT
+
+#define SLIDE_STORE_PATH        "/next.bin"
+// how late a wake may be and still show the stored slide, in seconds
+#define PREFETCH_SLACK          120
+
+class SlideStore {
+public:
+    SlideStore() : mounted(false), size(0), crc(0) {}
+
+    bool Create(void);
+    bool Append(const uint8_t* buf, size_t len);
+    bool Commit(const char* filename, long secondsdelay, long showIn);
+    void Drop(void);
+    bool Ready(void);
+    bool Upload(Epd& epd);
+
+    const char* Filename(void);
+    long SecondsDelay(void);
+    uint32_t Crc(void);
+
+private:
+    bool Mount(void);
+
+    bool mounted;
+    File file;
+    uint32_t size;
+    uint32_t crc;
+};
+
+#endif
+
+/* END OF FILE */
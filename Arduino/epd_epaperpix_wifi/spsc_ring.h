@@ -0,0 +1,188 @@
+/**
+ *  @filename   :   spsc_ring.h
+ *  @brief      :   Lock-free single producer / single consumer byte ring
+ *
+ *  Used to hand image data from the network task to the panel task.
+ *  Only depends on the C++ standard library so it can be built on a host.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+/**
+ *  @brief: One task writes, another task reads. Each index has a single
+ *          writer so no lock is needed. The indices run freely and are
+ *          masked on access, which keeps full and empty apart without
+ *          wasting a slot. Capacity must be a power of two.
+ */
+class SpscRing {
+public:
+    SpscRing() : buf(NULL), mask(0), head(0), tail(0), closed(false) {}
+
+    /**
+     *  @brief: attach storage; only call while neither side is running
+     */
+    bool Init(uint8_t* buffer, size_t capacity) {
+        if (buffer == NULL || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            return false;
+        }
+        buf = buffer;
+        mask = capacity - 1;
+        Reset();
+        return true;
+    }
+
+    void Reset(void) {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        closed.store(false, std::memory_order_release);
+    }
+
+    size_t Capacity(void) const {
+        return buf ? mask + 1 : 0;
+    }
+
+    /**
+     *  @brief: bytes ready for the consumer
+     */
+    size_t Available(void) const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+
+    /**
+     *  @brief: free bytes for the producer
+     */
+    size_t Space(void) const {
+        return Capacity() - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    /* ---- producer side ---- */
+
+    /**
+     *  @brief: contiguous free region; fill it and then call Commit()
+     */
+    uint8_t* WritePtr(size_t* len) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t free = Capacity() - (h - tail.load(std::memory_order_acquire));
+        size_t toEnd = Capacity() - (h & mask);
+        *len = free < toEnd ? free : toEnd;
+        return buf + (h & mask);
+    }
+
+    void Commit(size_t len) {
+        head.store(head.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    /**
+     *  @brief: copy in as much as fits, returns the number of bytes taken
+     */
+    size_t Write(const uint8_t* data, size_t len) {
+        size_t done = 0;
+        while (done < len) {
+            size_t n;
+            uint8_t* dst = WritePtr(&n);
+            if (n == 0) {
+                break;
+            }
+            if (n > len - done) {
+                n = len - done;
+            }
+            memcpy(dst, data + done, n);
+            Commit(n);
+            done += n;
+        }
+        return done;
+    }
+
+    /**
+     *  @brief: no more data will be written; readers drain what is left
+     */
+    void Close(void) {
+        closed.store(true, std::memory_order_release);
+    }
+
+    /* ---- consumer side ---- */
+
+    /**
+     *  @brief: contiguous readable region; use it and then call Consume()
+     */
+    const uint8_t* ReadPtr(size_t* len) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t used = head.load(std::memory_order_acquire) - t;
+        size_t toEnd = Capacity() - (t & mask);
+        *len = used < toEnd ? used : toEnd;
+        return buf + (t & mask);
+    }
+
+    void Consume(size_t len) {
+        tail.store(tail.load(std::memory_order_relaxed) + len, std::memory_order_release);
+    }
+
+    /**
+     *  @brief: copy out up to len bytes, returns the number of bytes read
+     */
+    size_t Read(uint8_t* data, size_t len) {
+        size_t done = 0;
+        while (done < len) {
+            size_t n;
+            const uint8_t* src = ReadPtr(&n);
+            if (n == 0) {
+                break;
+            }
+            if (n > len - done) {
+                n = len - done;
+            }
+            memcpy(data + done, src, n);
+            Consume(n);
+            done += n;
+        }
+        return done;
+    }
+
+    /**
+     *  @brief: true once the producer closed the ring and it is empty
+     */
+    bool Drained(void) const {
+        // check closed first so the acquire also covers the last Commit()
+        return closed.load(std::memory_order_acquire) && Available() == 0;
+    }
+
+private:
+    uint8_t* buf;
+    size_t mask;
+    std::atomic<size_t> head;   // written by the producer only
+    std::atomic<size_t> tail;   // written by the consumer only
+    std::atomic<bool> closed;
+};
+
+#endif
+
+/* END OF FILE */
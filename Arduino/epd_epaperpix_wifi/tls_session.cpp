@@ -0,0 +1,495 @@
+/**
+ *  @filename   :   tls_session.cpp
+ *  @brief      :   TLS client with session resumption across deep sleep
+ *
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <string.h>
+#include <time.h>
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include "mbedtls/net_sockets.h"
+#include "tls_session.h"
+#include "wall_clock.h"
+
+// session fields became private in mbedtls 3
+#if MBEDTLS_VERSION_MAJOR >= 3
+#define TLS_FIELD(s, f) ((s).MBEDTLS_PRIVATE(f))
+#else
+#define TLS_FIELD(s, f) ((s).f)
+#endif
+
+/**
+ *  One cached session per host. RTC slow memory keeps it through deep
+ *  sleep but holds garbage after power-on, hence the checksum.
+ */
+struct TlsCacheEntry {
+    char host[TLS_CACHE_HOST_LEN];
+    uint32_t savedAt;               // time() when stored
+    uint32_t len;                   // bytes used in data
+    uint32_t crc;                   // over everything above and data[0..len)
+    unsigned char data[TLS_CACHE_BYTES];
+};
+
+RTC_DATA_ATTR static TlsCacheEntry tlsCache[TLS_CACHE_HOSTS];
+
+int TlsClient::resumedCount = 0;
+
+static uint32_t EntryCrc(const TlsCacheEntry& e) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)e.host, sizeof(e.host));
+    crc = esp_rom_crc32_le(crc, (const uint8_t*)&e.savedAt, sizeof(e.savedAt));
+    crc = esp_rom_crc32_le(crc, (const uint8_t*)&e.len, sizeof(e.len));
+    return esp_rom_crc32_le(crc, e.data, e.len);
+}
+
+static bool EntryValid(const TlsCacheEntry& e) {
+    return e.len > 0 && e.len <= TLS_CACHE_BYTES && e.crc == EntryCrc(e);
+}
+
+/**
+ *  @brief: cached entry of a host, NULL when there is none or it expired.
+ *          Without a set clock the age is unknown, the entry is kept for
+ *          a later wake.
+ */
+static TlsCacheEntry* FindSession(const char* host) {
+    if (!WallClock::Valid()) {
+        return NULL;
+    }
+    uint32_t now = (uint32_t)time(NULL);
+    for (int i = 0; i < TLS_CACHE_HOSTS; i++) {
+        TlsCacheEntry& e = tlsCache[i];
+        if (!EntryValid(e) || strncmp(e.host, host, TLS_CACHE_HOST_LEN) != 0) {
+            continue;
+        }
+        // a clock that went backwards also makes the entry useless
+        if (now < e.savedAt || now - e.savedAt > TLS_SESSION_MAX_AGE) {
+            e.len = 0;
+            return NULL;
+        }
+        return &e;
+    }
+    return NULL;
+}
+
+static void ForgetSession(const char* host) {
+    for (int i = 0; i < TLS_CACHE_HOSTS; i++) {
+        if (strncmp(tlsCache[i].host, host, TLS_CACHE_HOST_LEN) == 0) {
+            tlsCache[i].len = 0;
+        }
+    }
+}
+
+/**
+ *  @brief: store the session of an established connection
+ */
+static void SaveSession(const char* host, mbedtls_ssl_session* session) {
+    // savedAt would be meaningless and the entry never expire
+    if (strlen(host) >= TLS_CACHE_HOST_LEN || !WallClock::Valid()) {
+        return;
+    }
+    // same host, else an empty slot, else the oldest one
+    TlsCacheEntry* slot = NULL;
+    for (int i = 0; i < TLS_CACHE_HOSTS && slot == NULL; i++) {
+        if (EntryValid(tlsCache[i]) && strcmp(tlsCache[i].host, host) == 0) {
+            slot = &tlsCache[i];
+        }
+    }
+    for (int i = 0; i < TLS_CACHE_HOSTS && slot == NULL; i++) {
+        if (!EntryValid(tlsCache[i])) {
+            slot = &tlsCache[i];
+        }
+    }
+    if (slot == NULL) {
+        slot = &tlsCache[0];
+        for (int i = 1; i < TLS_CACHE_HOSTS; i++) {
+            if (tlsCache[i].savedAt < slot->savedAt) {
+                slot = &tlsCache[i];
+            }
+        }
+    }
+
+#if defined(MBEDTLS_SSL_KEEP_PEER_CERTIFICATE)
+    // certificates are not verified, so the copy of the server certificate
+    // is dead weight; without it a session fits in a few hundred bytes
+    if (TLS_FIELD(*session, peer_cert) != NULL) {
+        mbedtls_x509_crt_free(TLS_FIELD(*session, peer_cert));
+        mbedtls_free(TLS_FIELD(*session, peer_cert));
+        TLS_FIELD(*session, peer_cert) = NULL;
+    }
+#endif
+    size_t len = 0;
+    memset(slot, 0, sizeof(*slot));
+    if (mbedtls_ssl_session_save(session, slot->data, sizeof(slot->data), &len) != 0) {
+        Serial.printf("[TLS] session of %s too large to cache\n", host);
+        return;
+    }
+    strncpy(slot->host, host, TLS_CACHE_HOST_LEN - 1);
+    slot->savedAt = (uint32_t)time(NULL);
+    slot->len = len;
+    slot->crc = EntryCrc(*slot);
+}
+
+// mbedtls I/O on top of the plain TCP client
+static int TcpSend(void* ctx, const unsigned char* buf, size_t len) {
+    WiFiClient* tcp = (WiFiClient*)ctx;
+    size_t n = tcp->write(buf, len);
+    if (n == 0) {
+        return tcp->connected() ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    return (int)n;
+}
+
+static int TcpRecv(void* ctx, unsigned char* buf, size_t len) {
+    WiFiClient* tcp = (WiFiClient*)ctx;
+    int avail = tcp->available();
+    if (avail <= 0) {
+        return tcp->connected() ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    int n = tcp->read(buf, len < (size_t)avail ? len : (size_t)avail);
+    return n > 0 ? n : MBEDTLS_ERR_SSL_WANT_READ;
+}
+
+static int Random(void* ctx, unsigned char* buf, size_t len) {
+    (void)ctx;
+    while (len > 0) {
+        uint32_t r = esp_random();
+        size_t n = len < sizeof(r) ? len : sizeof(r);
+        memcpy(buf, &r, n);
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+TlsClient::TlsClient() : resumed(false), handshakeMs(0), active(false), peerClosed(false), handshaking(false),
+        peeked(-1), startMs(0), offeredStart(0) {
+}
+
+TlsClient::~TlsClient() {
+    stop();
+}
+
+/**
+ *  @brief: set up mbedtls on the connected TCP socket, offering the cached
+ *          session of the host when offer is set
+ */
+bool TlsClient::HandshakeStart(const char* host, bool offer) {
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    active = true;
+    if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT,
+            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        return false;
+    }
+    // certificates are not checked, same as WiFiClientSecure::setInsecure()
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&conf, Random, NULL);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0 || mbedtls_ssl_set_hostname(&ssl, host) != 0) {
+        return false;
+    }
+    mbedtls_ssl_set_bio(&ssl, &tcp, TcpSend, TcpRecv, NULL);
+
+    // a resumed session keeps the start time of the full handshake
+    offeredStart = 0;
+    TlsCacheEntry* cached = offer ? FindSession(host) : NULL;
+    if (cached != NULL) {
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        if (mbedtls_ssl_session_load(&session, cached->data, cached->len) == 0 &&
+                mbedtls_ssl_set_session(&ssl, &session) == 0) {
+            offeredStart = TLS_FIELD(session, start);
+        }
+        mbedtls_ssl_session_free(&session);
+    }
+    startMs = millis();
+    handshaking = true;
+    return true;
+}
+
+/**
+ *  @brief: advance the handshake as far as the received bytes allow.
+ *          Returns 1 when done, 0 while waiting on the server, -1 on error.
+ */
+int TlsClient::HandshakeStep(const char* host) {
+    int ret = mbedtls_ssl_handshake(&ssl);
+    if (ret == 0) {
+        HandshakeDone(host);
+        return 1;
+    }
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        Serial.printf("[TLS] handshake with %s failed: -0x%04x\n", host, -ret);
+        return -1;
+    }
+    if (millis() - startMs > TLS_HANDSHAKE_TIMEOUT) {
+        Serial.printf("[TLS] handshake with %s timed out\n", host);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  @brief: TLS handshake on the connected TCP socket
+ */
+bool TlsClient::Handshake(const char* host, bool offer) {
+    if (!HandshakeStart(host, offer)) {
+        return false;
+    }
+    int ret;
+    while ((ret = HandshakeStep(host)) == 0) {
+        delay(1);
+    }
+    return ret > 0;
+}
+
+/**
+ *  @brief: note how the handshake went and cache the session
+ */
+void TlsClient::HandshakeDone(const char* host) {
+    handshakeMs = millis() - startMs;
+    handshaking = false;
+
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    resumed = false;
+    if (mbedtls_ssl_get_session(&ssl, &session) == 0) {
+        resumed = offeredStart != 0 && TLS_FIELD(session, start) == offeredStart;
+#ifdef TLS_SESSION_RESUME
+        SaveSession(host, &session);
+#endif
+    }
+    mbedtls_ssl_session_free(&session);
+    if (resumed) {
+        resumedCount++;
+    }
+    Serial.printf("[TLS] %s: %s handshake in %lu ms\n", host, resumed ? "resumed" : "full", handshakeMs);
+}
+
+/**
+ *  @brief: release the mbedtls state of the connection
+ */
+void TlsClient::Free(void) {
+    if (active) {
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_config_free(&conf);
+        active = false;
+    }
+    peerClosed = false;
+    handshaking = false;
+    peeked = -1;
+}
+
+int TlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    stop();
+    if (!tcp.connect(host, port, timeout)) {
+        return 0;
+    }
+#ifdef TLS_SESSION_RESUME
+    bool offer = true;
+#else
+    bool offer = false;
+#endif
+    if (Handshake(host, offer)) {
+        return 1;
+    }
+    stop();
+    if (!offer || FindSession(host) == NULL) {
+        return 0;
+    }
+    // a server that chokes on the cached session gets a clean second try
+    ForgetSession(host);
+    if (!tcp.connect(host, port, timeout)) {
+        return 0;
+    }
+    if (Handshake(host, false)) {
+        return 1;
+    }
+    stop();
+    return 0;
+}
+
+/**
+ *  @brief: open the TCP connection and send the client hello without
+ *          waiting for the server, see ConnectStep()
+ */
+bool TlsClient::ConnectStart(const char* host, uint16_t port, int32_t timeout) {
+    stop();
+    if (!tcp.connect(host, port, timeout)) {
+        return false;
+    }
+#ifdef TLS_SESSION_RESUME
+    bool offer = true;
+#else
+    bool offer = false;
+#endif
+    if (!HandshakeStart(host, offer) || HandshakeStep(host) < 0) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief: poll a connection begun with ConnectStart(). Returns 1 once
+ *          it is up, 0 while the handshake is running, -1 when it failed.
+ */
+int TlsClient::ConnectStep(const char* host) {
+    if (!active) {
+        return -1;
+    }
+    if (!handshaking) {
+        return 1;
+    }
+    int ret = HandshakeStep(host);
+    if (ret < 0) {
+#ifdef TLS_SESSION_RESUME
+        // as in connect(), the next try goes without the cached session
+        if (offeredStart != 0) {
+            ForgetSession(host);
+        }
+#endif
+        stop();
+    }
+    return ret;
+}
+
+int TlsClient::connect(const char* host, uint16_t port) {
+    return connect(host, port, TLS_HANDSHAKE_TIMEOUT);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port, int32_t timeout) {
+    return connect(ip.toString().c_str(), port, timeout);
+}
+
+int TlsClient::connect(IPAddress ip, uint16_t port) {
+    return connect(ip, port, TLS_HANDSHAKE_TIMEOUT);
+}
+
+size_t TlsClient::write(const uint8_t* buf, size_t size) {
+    if (!active) {
+        return 0;
+    }
+    size_t sent = 0;
+    unsigned long writeMs = millis();
+    while (sent < size) {
+        int ret = mbedtls_ssl_write(&ssl, buf + sent, size - sent);
+        if (ret > 0) {
+            sent += ret;
+        } else if ((ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) || !tcp.connected()) {
+            break;
+        } else if (millis() - writeMs > TLS_WRITE_TIMEOUT) {
+            // a peer that stopped reading would hold the caller forever
+            Serial.printf("[TLS] write timed out after %u of %u bytes\n", (unsigned)sent, (unsigned)size);
+            break;
+        } else {
+            delay(1);
+        }
+    }
+    return sent;
+}
+
+size_t TlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+int TlsClient::available() {
+    if (!active) {
+        return 0;
+    }
+    size_t pending = mbedtls_ssl_get_bytes_avail(&ssl);
+    if (pending == 0 && !peerClosed && tcp.available() > 0) {
+        // a zero length read decrypts the next record, if it is complete
+        int ret = mbedtls_ssl_read(&ssl, NULL, 0);
+        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            peerClosed = true;
+        }
+        pending = mbedtls_ssl_get_bytes_avail(&ssl);
+    }
+    return (int)pending + (peeked >= 0 ? 1 : 0);
+}
+
+int TlsClient::read(uint8_t* buf, size_t size) {
+    if (!active) {
+        return -1;
+    }
+    int n = 0;
+    if (peeked >= 0 && size > 0) {
+        buf[n++] = (uint8_t)peeked;
+        peeked = -1;
+    }
+    if ((size_t)n < size && !peerClosed) {
+        int ret = mbedtls_ssl_read(&ssl, buf + n, size - n);
+        if (ret > 0) {
+            n += ret;
+        } else if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            // close_notify or a broken record, either way nothing more comes
+            peerClosed = true;
+        }
+    }
+    return n;
+}
+
+int TlsClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int TlsClient::peek() {
+    if (peeked < 0) {
+        peeked = read();
+    }
+    return peeked;
+}
+
+void TlsClient::flush() {
+    tcp.flush();
+}
+
+void TlsClient::stop() {
+    if (active && !peerClosed && tcp.connected()) {
+        mbedtls_ssl_close_notify(&ssl);
+    }
+    Free();
+    tcp.stop();
+}
+
+uint8_t TlsClient::connected() {
+    if (!active) {
+        return 0;
+    }
+    if (available() > 0) {
+        return 1;
+    }
+    return !peerClosed && tcp.connected();
+}
+
+int TlsClient::setTimeout(uint32_t seconds) {
+    return tcp.setTimeout(seconds);
+}
+
+/* END OF FILE */
@@ -0,0 +1,105 @@
+/**
+ *  @filename   :   tls_session.h
+ *  @brief      :   Header file of tls_session.cpp, a TLS client that resumes
+ *                  its sessions after deep sleep
+ *
+ *  Every update is a fresh boot, so WiFiClientSecure starts each wake with
+ *  a full handshake. TlsClient keeps the negotiated session of each host in
+ *  RTC memory and offers it again on the next wake; a server that no longer
+ *  knows it simply answers with a full handshake.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef TLS_SESSION_H
+#define TLS_SESSION_H
+
+#include <WiFi.h>
+#include "mbedtls/ssl.h"
+
+// Offer the cached session on the next wake (comment out to time full
+// handshakes for comparison)
+#define TLS_SESSION_RESUME
+
+#define TLS_CACHE_HOSTS         2       // one entry per host, API and blob
+#define TLS_CACHE_HOST_LEN      48
+#define TLS_CACHE_BYTES         640     // serialized session with its ticket
+#define TLS_SESSION_MAX_AGE     (4 * 3600UL)    // seconds, then handshake in full
+#define TLS_HANDSHAKE_TIMEOUT   15000   // ms
+#define TLS_WRITE_TIMEOUT       5000    // ms for one write() to go out
+
+/**
+ *  @brief: drop-in for WiFiClientSecure with setInsecure(), so HTTPClient
+ *          can use it through begin(client, url). The TCP side is a plain
+ *          WiFiClient, mbedtls runs on top of it.
+ */
+class TlsClient : public WiFiClient {
+public:
+    TlsClient();
+    ~TlsClient();
+
+    int connect(IPAddress ip, uint16_t port);
+    int connect(IPAddress ip, uint16_t port, int32_t timeout);
+    int connect(const char* host, uint16_t port);
+    int connect(const char* host, uint16_t port, int32_t timeout);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* buf, size_t size);
+    int available();
+    int read();
+    int read(uint8_t* buf, size_t size);
+    int peek();
+    void flush();
+    void stop();
+    uint8_t connected();
+    int setTimeout(uint32_t seconds);
+
+    // non-blocking connect, so several hosts can handshake side by side
+    bool ConnectStart(const char* host, uint16_t port, int32_t timeout);
+    int ConnectStep(const char* host);
+
+    bool resumed;                   // last handshake reused a cached session
+    unsigned long handshakeMs;      // duration of the last handshake
+    static int resumedCount;        // resumed handshakes this wake
+
+private:
+    bool Handshake(const char* host, bool offer);
+    bool HandshakeStart(const char* host, bool offer);
+    int HandshakeStep(const char* host);
+    void HandshakeDone(const char* host);
+    void Free(void);
+
+    WiFiClient tcp;
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config conf;
+    bool active;
+    bool peerClosed;
+    bool handshaking;
+    int peeked;
+    unsigned long startMs;
+    mbedtls_time_t offeredStart;
+};
+
+#endif
+
+/* END OF FILE */
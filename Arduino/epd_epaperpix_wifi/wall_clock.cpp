@@ -0,0 +1,113 @@
+/**
+ *  @filename   :   wall_clock.cpp
+ *  @brief      :   Keeps wall-clock time across deep sleep and resyncs NTP
+ *                  in the background
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <limits.h>
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include <esp_sntp.h>
+#include "wall_clock.h"
+
+/**
+ *  Last NTP sync. RTC slow memory keeps it through deep sleep but holds
+ *  garbage after power-on, hence the checksum.
+ */
+struct ClockState {
+    uint32_t syncedAt;      // time() right after the last sync, 0 for never
+    uint32_t syncs;         // NTP syncs since power-on
+    uint32_t check;
+};
+
+RTC_DATA_ATTR static ClockState clockState;
+
+static uint32_t StateCrc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&clockState, offsetof(ClockState, check));
+}
+
+// runs in the lwIP task whenever SNTP set the clock
+static void OnSync(struct timeval* tv) {
+    clockState.syncedAt = tv->tv_sec;
+    clockState.syncs++;
+    clockState.check = StateCrc();
+    Serial.printf("[CLOCK] NTP sync #%lu\n", (unsigned long)clockState.syncs);
+}
+
+bool WallClock::Valid(void) {
+    return (unsigned long)time(NULL) > CLOCK_VALID_AFTER;
+}
+
+/**
+ *  @brief: seconds the clock may be off by, ULONG_MAX when never synced
+ */
+unsigned long WallClock::ErrorBound(void) {
+    if (clockState.check != StateCrc() || clockState.syncedAt == 0 || !Valid()) {
+        return ULONG_MAX;
+    }
+    uint32_t now = (uint32_t)time(NULL);
+    if (now < clockState.syncedAt) {
+        return ULONG_MAX;
+    }
+    return (unsigned long)((uint64_t)(now - clockState.syncedAt) * CLOCK_DRIFT_PPM / 1000000);
+}
+
+/**
+ *  @brief: call once WiFi is up. Starts SNTP when the clock is due for a
+ *          sync and returns right away, the clock is set whenever the
+ *          answer comes in.
+ */
+void WallClock::Start(void) {
+    if (syncing) {
+        return;
+    }
+    unsigned long bound = ErrorBound();
+    if (bound <= CLOCK_MAX_ERROR) {
+        Serial.printf("[CLOCK] within %lu s, NTP not needed\n", bound);
+        return;
+    }
+    syncing = true;
+    sntp_set_time_sync_notification_cb(OnSync);
+    configTime(0, 0, CLOCK_NTP_SERVER);
+    Serial.println("[CLOCK] NTP sync started");
+}
+
+void WallClock::Print(void) {
+    if (!Valid()) {
+        Serial.println("[CLOCK] not set yet");
+        return;
+    }
+    time_t now = time(NULL);
+    struct tm timeinfo;
+    gmtime_r(&now, &timeinfo);
+    unsigned long bound = ErrorBound();
+    Serial.printf("[CLOCK] %s", asctime(&timeinfo));
+    if (bound != ULONG_MAX) {
+        Serial.printf("[CLOCK] error bound %lu s, %lu syncs\n", bound, (unsigned long)clockState.syncs);
+    }
+}
+
+/* END OF FILE */
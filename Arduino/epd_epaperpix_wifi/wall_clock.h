@@ -0,0 +1,63 @@
+/**
+ *  @filename   :   wall_clock.h
+ *  @brief      :   Header file of wall_clock.cpp, keeps wall-clock time
+ *                  across deep sleep and resyncs NTP in the background
+ *
+ *  The system clock keeps running off the RTC timer through deep sleep,
+ *  only its drift grows. The last NTP sync is kept in RTC memory, and a
+ *  new one is started, without waiting for it, once the drift could
+ *  exceed CLOCK_MAX_ERROR.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef WALL_CLOCK_H
+#define WALL_CLOCK_H
+
+#include <Arduino.h>
+#include <time.h>
+
+#define CLOCK_NTP_SERVER        "pool.ntp.org"
+// worst case error of the RTC slow clock, parts per million
+#define CLOCK_DRIFT_PPM         1000
+// resync once the clock may be off by more than this, in seconds
+#define CLOCK_MAX_ERROR         120
+// earlier times mean the clock was never set
+#define CLOCK_VALID_AFTER       1700000000UL
+
+class WallClock {
+public:
+    WallClock() : syncing(false) {}
+
+    void Start(void);
+    static bool Valid(void);
+    unsigned long ErrorBound(void);
+    void Print(void);
+
+    bool syncing;           // SNTP was started this wake
+};
+
+#endif
+
+/* END OF FILE */
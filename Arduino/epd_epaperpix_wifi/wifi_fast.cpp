@@ -0,0 +1,171 @@
+/**
+ *  @filename   :   wifi_fast.cpp
+ *  @brief      :   Reconnects after deep sleep without a channel scan or DHCP
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <time.h>
+#include <esp_attr.h>
+#include <esp_rom_crc.h>
+#include "wifi_fast.h"
+#include "wall_clock.h"
+
+/**
+ *  Last good connection plus connect stats for both paths. RTC slow memory
+ *  keeps it through deep sleep but holds garbage after power-on, hence the
+ *  checksum.
+ */
+struct WiFiCache {
+    uint8_t bssid[6];
+    uint8_t channel;            // 0 when no settings are cached
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+    uint32_t savedAt;           // time() of the DHCP lease, 0 when the clock was not set
+    uint16_t fastOk;            // wakes connected on the cached settings
+    uint16_t fastFailed;        // cached settings tried but not working
+    uint16_t scans;             // wakes that needed a scan and DHCP
+    uint32_t fastMs;            // smoothed connect time of each path
+    uint32_t scanMs;
+    uint32_t check;
+};
+
+RTC_DATA_ATTR static WiFiCache wifiCache;
+
+static uint32_t CacheCrc(void) {
+    return esp_rom_crc32_le(0, (const uint8_t*)&wifiCache, offsetof(WiFiCache, check));
+}
+
+static uint32_t Smooth(uint32_t old, uint32_t sample) {
+    return old == 0 ? sample : (old * 3 + sample) / 4;
+}
+
+/**
+ *  @brief: join the access point of the last wake with its IP settings
+ */
+bool WiFiFast::TryFast(const char* ssid, const char* password) {
+    if (wifiCache.check != CacheCrc()) {
+        memset(&wifiCache, 0, sizeof(wifiCache));
+        wifiCache.check = CacheCrc();
+        return false;
+    }
+    if (wifiCache.channel == 0) {
+        return false;
+    }
+    // a lease saved or checked before the clock was set has no known age
+    uint32_t now = (uint32_t)time(NULL);
+    if (wifiCache.savedAt == 0 || !WallClock::Valid() || now < wifiCache.savedAt ||
+        now - wifiCache.savedAt > WIFI_LEASE_REUSE) {
+        Serial.println("[WIFI] cached lease too old, using DHCP");
+        wifiCache.channel = 0;
+        wifiCache.check = CacheCrc();
+        return false;
+    }
+    WiFi.config(IPAddress(wifiCache.ip), IPAddress(wifiCache.gateway), IPAddress(wifiCache.mask),
+                IPAddress(wifiCache.dns));
+    WiFi.begin(ssid, password, wifiCache.channel, wifiCache.bssid, true);
+    while (millis() - startMs < WIFI_FAST_TIMEOUT) {
+        if (WiFi.status() == WL_CONNECTED) {
+            return true;
+        }
+        delay(10);
+    }
+    // access point moved or went away, start over the slow way
+    Serial.println("[WIFI] cached access point did not answer, scanning");
+    wifiCache.fastFailed++;
+    wifiCache.channel = 0;
+    wifiCache.check = CacheCrc();
+    WiFi.disconnect();
+    WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
+    return false;
+}
+
+/**
+ *  @brief: drop-in for WiFiMulti::run(), tries the cached settings once
+ *          per wake before falling back to it
+ */
+wl_status_t WiFiFast::Run(WiFiMulti& multi, const char* ssid, const char* password) {
+    if (WiFi.status() == WL_CONNECTED) {
+        return WL_CONNECTED;
+    }
+    bool first = !tried;
+    if (first) {
+        tried = true;
+        startMs = millis();
+        if (TryFast(ssid, password)) {
+            fast = true;
+            connectMs = millis() - startMs;
+            wifiCache.fastOk++;
+            wifiCache.fastMs = Smooth(wifiCache.fastMs, connectMs);
+            wifiCache.check = CacheCrc();
+            Serial.printf("[WIFI] fast connect in %lu ms\n", connectMs);
+            return WL_CONNECTED;
+        }
+    }
+    wl_status_t status = (wl_status_t)multi.run();
+    if (status == WL_CONNECTED && !fast && connectMs == 0) {
+        connectMs = millis() - startMs;
+        wifiCache.scans++;
+        wifiCache.scanMs = Smooth(wifiCache.scanMs, connectMs);
+        Save();
+        Serial.printf("[WIFI] scan and DHCP in %lu ms\n", connectMs);
+    }
+    return status;
+}
+
+/**
+ *  @brief: remember the connection DHCP just set up
+ */
+void WiFiFast::Save(void) {
+    uint8_t* bssid = WiFi.BSSID();
+    if (bssid == NULL || WiFi.channel() <= 0) {
+        return;
+    }
+    memcpy(wifiCache.bssid, bssid, sizeof(wifiCache.bssid));
+    wifiCache.channel = WiFi.channel();
+    wifiCache.ip = WiFi.localIP();
+    wifiCache.gateway = WiFi.gatewayIP();
+    wifiCache.mask = WiFi.subnetMask();
+    wifiCache.dns = WiFi.dnsIP(0);
+    wifiCache.savedAt = WallClock::Valid() ? (uint32_t)time(NULL) : 0;
+    wifiCache.check = CacheCrc();
+}
+
+/**
+ *  @brief: stop using the cached settings, e.g. after new credentials
+ */
+void WiFiFast::Forget(void) {
+    memset(&wifiCache, 0, sizeof(wifiCache));
+    wifiCache.check = CacheCrc();
+}
+
+void WiFiFast::Print(void) {
+    Serial.printf("[WIFI] %s connect in %lu ms; fast %u ok / %u failed (avg %lu ms), scan %u (avg %lu ms)\n",
+                  fast ? "fast" : "scan", connectMs, wifiCache.fastOk, wifiCache.fastFailed,
+                  (unsigned long)wifiCache.fastMs, wifiCache.scans, (unsigned long)wifiCache.scanMs);
+}
+
+/* END OF FILE */
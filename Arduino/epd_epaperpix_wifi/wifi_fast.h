@@ -0,0 +1,68 @@
+/**
+ *  @filename   :   wifi_fast.h
+ *  @brief      :   Header file of wifi_fast.cpp, reconnects after deep sleep
+ *                  without a channel scan or DHCP
+ *
+ *  The access point, channel and IP settings of the last good connection
+ *  are kept in RTC memory. The next wake joins that access point directly
+ *  with a static IP; only when that does not work within a short deadline
+ *  does it scan and ask DHCP like a cold start.
+ *
+ *  MIT License
+ *
+ *  Copyright (c) 2025 EpaperPix
+ *
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#ifndef WIFI_FAST_H
+#define WIFI_FAST_H
+
+#include <WiFi.h>
+#include <WiFiMulti.h>
+
+// give up on the cached settings after this long, in ms
+#define WIFI_FAST_TIMEOUT       1500
+// take a fresh DHCP lease after this long, so the address is not reused
+// after the router handed it to someone else, in seconds
+#define WIFI_LEASE_REUSE        (6 * 3600UL)
+
+class WiFiFast {
+public:
+    WiFiFast() : fast(false), connectMs(0), tried(false), startMs(0) {}
+
+    wl_status_t Run(WiFiMulti& multi, const char* ssid, const char* password);
+    void Forget(void);
+    void Print(void);
+
+    bool fast;                  // this wake connected on the cached settings
+    unsigned long connectMs;    // time from the first Run() to connected
+
+private:
+    bool TryFast(const char* ssid, const char* password);
+    void Save(void);
+
+    bool tried;
+    unsigned long startMs;
+};
+
+#endif
+
+/* END OF FILE */
@@ -61,6 +61,28 @@
 #define EPD_HEIGHT      200
 #define EPD_STEPS      2
 #define EPD_BLOCK_SIZE  5000
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    20000000,   // max write clock (SSD1681, 50 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          HIGH    // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    10,     // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    0,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 Epd::~Epd() {
 };
@@ -74,58 +96,41 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x24;
     stepCommands[1] = 0x26;
+    // RAM rows as set up by the init script, see ResumeStep()
+    ramRowBytes = 25;
+    ramYStart = 199;
+    ramYDown = true;
+};
+
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_RESET,
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, SW_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, DRIVER_OUTPUT_CONTROL, EPD_DATA, 3, 0xC7, 0x00, 0x01,
+    EPD_CMD, DATA_ENTRY_MODE_SETTING, EPD_DATA, 1, 0x01,
+    EPD_CMD, SET_RAM_X_ADDRESS_START_END_POSITION, EPD_DATA, 2, 0x00, 0x18,  // 0x18-->(24+1)*8=200
+    EPD_CMD, SET_RAM_Y_ADDRESS_START_END_POSITION, EPD_DATA, 4, 0xC7, 0x00, 0x00, 0x00,  // 0xC7-->(199+1)=200
+    EPD_CMD, BORDER_WAVEFORM_CONTROL, EPD_DATA, 1, 0x05,
+    EPD_CMD, TEMPERATURE_SENSOR_CONTROL, EPD_DATA, 1, 0x80,
+    EPD_CMD, SET_RAM_X_ADDRESS_COUNTER, EPD_DATA, 1, 0x00,
+    EPD_CMD, SET_RAM_Y_ADDRESS_COUNTER, EPD_DATA, 2, 0xC7, 0x00,
+    EPD_WAIT_BUSY,
+    EPD_END
 };
 
 int Epd::Init(void) {
      Serial.print("IfInit before \r\n");
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Serial.print("Reset before \r\n");
-    Reset();
-    Reset();
-    Reset();
-    Serial.print("Reset after \r\n");
-
-    WaitUntilIdle();   
-    Serial.print("SW_RESET before \r\n");
-    SendCommand(SW_RESET);
-    Serial.print("SW_RESET after \r\n");
-    WaitUntilIdle();   
-
-    SendCommand(DRIVER_OUTPUT_CONTROL);      
-    SendData(0xC7);
-    SendData(0x00);
-    SendData(0x01);
-
-    SendCommand(DATA_ENTRY_MODE_SETTING);       
-    SendData(0x01);
-
-    SendCommand(SET_RAM_X_ADDRESS_START_END_POSITION);   
-    SendData(0x00);
-    SendData(0x18);    //0x18-->(24+1)*8=200
-
-    SendCommand(SET_RAM_Y_ADDRESS_START_END_POSITION);          
-    SendData(0xC7);    //0xC7-->(199+1)=200
-    SendData(0x00);
-    SendData(0x00);
-    SendData(0x00); 
-
-    SendCommand(BORDER_WAVEFORM_CONTROL);
-    SendData(0x05);
-
-    SendCommand(TEMPERATURE_SENSOR_CONTROL);
-    SendData(0x80);
-
-    SendCommand(SET_RAM_X_ADDRESS_COUNTER);
-    SendData(0x00);
-    SendCommand(SET_RAM_Y_ADDRESS_COUNTER);    
-    SendData(0xC7);
-    SendData(0x00);
-    WaitUntilIdle();
-
+    RunScript(initScript);
     return 0;
 }
 
@@ -157,19 +162,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-
-    while(1) {
-        if(DigitalRead(busy_pin) == 0)
-            break;
-        DelayMs(100);
-    }  
-    /*
-    while(DigitalRead(busy_pin) == 0) {      //0: busy, 1: idle
-        DelayMs(1000);
-         Serial.print("WaitUntilIdle\r\n");
-
-    } 
-    */     
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -178,15 +171,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200); 
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(10);
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);    
-
-      
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -202,13 +191,11 @@ void Epd::SetLut(void) {
 
 void Epd::ClearFrame() {
     SendCommand(WRITE_RAM);
-    for(int i = 0; i < width * height / 8; i++) {               
-        SendData(0xff);
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xff, width * height / 8);
     SendCommand(WRITE_RAM_RED);
-    for(int i = 0; i < width * height / 8; i++) {               
-        SendData(0x00);
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0x00, width * height / 8);
 }
 
 void Epd::Clear(unsigned char color) {
@@ -225,7 +212,7 @@ void Epd::Clear(unsigned char color) {
 void Epd::Sleep() {
     SendCommand(DEEP_SLEEP_MODE);
     SendData(0x01);
-    DelayMs(100);
+    DelayMs(epdTiming.sleepWaitMs);
 }
 
 #endif
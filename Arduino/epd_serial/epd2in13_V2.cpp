@@ -64,10 +64,54 @@
 #define EPD_HEIGHT      250
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  4000  // 128 * 250 / 8
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    20000000,   // max write clock (SSD1675B, 50 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          HIGH    // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     15000   // longest monochrome refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    10,     // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    0,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 extern const unsigned char lut_full_update[];
 extern const unsigned char lut_partial_update[];
 
+// Partial refresh: own LUT, VCOM and border, and the analog part is
+// powered up here since the partial sequence does not, see
+// Epd::SetPartial()
+static void PartialMode(Epd& epd, bool partial) {
+    const unsigned char* lut = partial ? lut_partial_update : lut_full_update;
+    epd.SendCommand(WRITE_VCOM_REGISTER);
+    epd.SendData(partial ? 0x26 : 0x55);
+    epd.WaitUntilIdle();
+    epd.SendCommand(WRITE_LUT_REGISTER);
+    for (int i = 0; i < 70; i++) {
+        epd.SendData(lut[i]);
+    }
+    if (partial) {
+        epd.SendCommand(DISPLAY_UPDATE_CONTROL_2);
+        epd.SendData(0xC0);
+        epd.SendCommand(MASTER_ACTIVATION);
+        epd.WaitUntilIdle();
+    }
+    epd.SendCommand(BORDER_WAVEFORM_CONTROL);
+    epd.SendData(partial ? 0x01 : 0x03);
+}
+
 Epd::~Epd() {
 };
 
@@ -80,49 +124,47 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x24;
+    // RAM rows as set up by the init script, see ResumeStep()
+    ramRowBytes = 16;
+    ramYStart = 249;
+    ramYDown = true;
+    // partial refresh compares RAM 0x24 with the previous image in 0x26
+    partialMode = PartialMode;
+    partialRefresh = 0x0C;
+    previousRam = WRITE_RAM_RED;
+};
+
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, SW_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, SET_ANALOG_BLOCK_CONTROL, EPD_DATA, 1, 0x54,
+    EPD_CMD, SET_DIGITAL_BLOCK_CONTROL, EPD_DATA, 1, 0x3B,
+    EPD_CMD, DRIVER_OUTPUT_CONTROL, EPD_DATA, 3, 0xF9, 0x00, 0x00,
+    EPD_CMD, DATA_ENTRY_MODE_SETTING, EPD_DATA, 1, 0x01,
+    EPD_CMD, SET_RAM_X_ADDRESS_START_END_POSITION, EPD_DATA, 2, 0x00, 0x0F,  // 0x0F-->(15+1)*8=128
+    EPD_CMD, SET_RAM_Y_ADDRESS_START_END_POSITION, EPD_DATA, 4, 0xF9, 0x00, 0x00, 0x00,  // 0xF9-->(249+1)=250
+    EPD_CMD, BORDER_WAVEFORM_CONTROL, EPD_DATA, 1, 0x03,
+    EPD_CMD, WRITE_VCOM_REGISTER, EPD_DATA, 1, 0x55,
+    EPD_END
+};
+
+static constexpr unsigned char initScript2[] = {
+    EPD_CMD, SET_RAM_X_ADDRESS_COUNTER, EPD_DATA, 1, 0x00,
+    EPD_CMD, SET_RAM_Y_ADDRESS_COUNTER, EPD_DATA, 2, 0xF9, 0x00,
+    EPD_WAIT_BUSY,
+    EPD_END
 };
 
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    
-    Reset();
-    
-    WaitUntilIdle();
-    SendCommand(SW_RESET);
-    WaitUntilIdle();
-
-    SendCommand(SET_ANALOG_BLOCK_CONTROL);
-    SendData(0x54);
-    SendCommand(SET_DIGITAL_BLOCK_CONTROL);
-    SendData(0x3B);
-
-    SendCommand(DRIVER_OUTPUT_CONTROL);
-    SendData(0xF9);
-    SendData(0x00);
-    SendData(0x00);
-
-    SendCommand(DATA_ENTRY_MODE_SETTING);
-    SendData(0x01);
-
-    SendCommand(SET_RAM_X_ADDRESS_START_END_POSITION);
-    SendData(0x00);
-    SendData(0x0F);    //0x0F-->(15+1)*8=128
-
-    SendCommand(SET_RAM_Y_ADDRESS_START_END_POSITION);
-    SendData(0xF9);   //0xF9-->(249+1)=250
-    SendData(0x00);
-    SendData(0x00);
-    SendData(0x00);
-
-    SendCommand(BORDER_WAVEFORM_CONTROL);
-    SendData(0x03);
-
-    SendCommand(WRITE_VCOM_REGISTER);
-    SendData(0x55);
-
+    RunScript(initScript);
     SendCommand(GATE_DRIVING_VOLTAGE_CONTROL);
     SendData(lut_full_update[70]);
 
@@ -138,13 +180,7 @@ int Epd::Init(void) {
 
     SetLut();
 
-    SendCommand(SET_RAM_X_ADDRESS_COUNTER);
-    SendData(0x00);
-    SendCommand(SET_RAM_Y_ADDRESS_COUNTER);
-    SendData(0xF9);
-    SendData(0x00);
-    WaitUntilIdle();
-
+    RunScript(initScript2);
     return 0;
 }
 
@@ -176,11 +212,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(1) {      //LOW: idle, HIGH: busy
-        if(DigitalRead(busy_pin) == 0)
-            break;
-        DelayMs(100);
-    }
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -189,12 +221,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);
     DigitalWrite(reset_pin, LOW);
-    DelayMs(10);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -215,11 +246,8 @@ void Epd::ClearFrame() {
     int w = (width % 8 == 0)? (width / 8 ): (width / 8 + 1);
     int h = height;
     SendCommand(WRITE_RAM);
-    for (int j = 0; j < h; j++) {
-        for (int i = 0; i < w; i++) {
-            SendData(0xff);
-        }
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xff, (unsigned long)w * h);
 }
 
 void Epd::Clear(unsigned char color) {
@@ -236,7 +264,7 @@ void Epd::Clear(unsigned char color) {
 void Epd::Sleep() {
     SendCommand(DEEP_SLEEP_MODE);
     SendData(0x01);
-    DelayMs(200);
+    DelayMs(epdTiming.sleepWaitMs);
     DigitalWrite(reset_pin, LOW);
 }
 
@@ -71,6 +71,28 @@
 #define EPD_HEIGHT      360
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  16560  // 152 * 296 / 4 (4 colors per byte)
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    8000000,    // max write clock (no datasheet figure, known good)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 Epd::~Epd() {
 };
@@ -84,73 +106,38 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x10;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0x4D, EPD_DATA, 1, 0x78,
+    EPD_CMD, PANEL_SETTING_REGISTER, EPD_DATA, 2, 0x0F, 0x29,
+    EPD_CMD, POWER_SETTING_REGISTER, EPD_DATA, 2, 0x07, 0x00,
+    EPD_CMD, POWER_OFF_SEQUENCE_SETTING, EPD_DATA, 3, 0x10, 0x54, 0x44,
+    EPD_CMD, BOOSTER_SOFT_START, EPD_DATA, 7, 0x05, 0x00, 0x3F, 0x0A, 0x25, 0x12, 0x1A,
+    EPD_CMD, VCOM_DATA_INTERVAL_SETTING, EPD_DATA, 1, 0x37,
+    EPD_CMD, TCON_SETTING, EPD_DATA, 2, 0x02, 0x02,
+    EPD_CMD, TCON_RESOLUTION, EPD_DATA, 4, EPD_WIDTH/256, EPD_WIDTH%256, EPD_HEIGHT/256, EPD_HEIGHT%256,
+    EPD_CMD, LUT_FOR_VCOM, EPD_DATA, 1, 0x1C,
+    EPD_CMD, POWER_SAVING, EPD_DATA, 1, 0x22,
+    EPD_CMD, 0xB4, EPD_DATA, 1, 0xD0,
+    EPD_CMD, 0xB5, EPD_DATA, 1, 0x03,
+    EPD_CMD, 0xE9, EPD_DATA, 1, 0x01,
+    EPD_CMD, PLL_CONTROL, EPD_DATA, 1, 0x08,
+    EPD_CMD, POWER_ON,
+    EPD_WAIT_BUSY,
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-    WaitUntilIdle();
-
-    SendCommand(0x4D);
-    SendData(0x78);
-
-    SendCommand(PANEL_SETTING_REGISTER);
-    SendData(0x0F);
-    SendData(0x29);
-
-    SendCommand(POWER_SETTING_REGISTER);
-    SendData(0x07);
-    SendData(0x00);
-
-    SendCommand(POWER_OFF_SEQUENCE_SETTING);
-    SendData(0x10);
-    SendData(0x54);
-    SendData(0x44);
-
-    SendCommand(BOOSTER_SOFT_START);
-    SendData(0x05);
-    SendData(0x00);
-    SendData(0x3F);
-    SendData(0x0A);
-    SendData(0x25);
-    SendData(0x12);
-    SendData(0x1A); 
-
-    SendCommand(VCOM_DATA_INTERVAL_SETTING);
-    SendData(0x37);
-
-    SendCommand(TCON_SETTING);
-    SendData(0x02);
-    SendData(0x02);
-
-    SendCommand(TCON_RESOLUTION);
-    SendData(width/256);
-    SendData(width%256);
-    SendData(height/256);
-    SendData(height%256);
-
-    SendCommand(LUT_FOR_VCOM);
-    SendData(0x1C);
-
-    SendCommand(POWER_SAVING);
-    SendData(0x22);
-
-    SendCommand(0xB4);
-    SendData(0xD0);
-    SendCommand(0xB5);
-    SendData(0x03);
-
-    SendCommand(0xE9);
-    SendData(0x01); 
-
-    SendCommand(PLL_CONTROL);
-    SendData(0x08);  
-
-    SendCommand(POWER_ON);
-    WaitUntilIdle();
+    RunScript(initScript);
     return 0;
 }
 
@@ -182,9 +169,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes LOW
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == LOW) {      //LOW: busy, HIGH: idle
-        DelayMs(5);
-    }     
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -193,12 +178,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);    
     DigitalWrite(reset_pin, LOW);
-    DelayMs(2);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(20);     
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -217,11 +201,8 @@ void Epd::ClearFrame() {
     Height = height;
 
     SendCommand(DATA_START_TRANSMISSION);
-    for (unsigned int j = 0; j < Height; j++) {
-        for (unsigned int i = 0; i < Width; i++) {
-            SendData(0x55);  // White color (01 01 01 01)
-        }
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0x55, (unsigned long)Width * Height);  // White color (01 01 01 01)
 }
 
 void Epd::Clear(unsigned char color) {
@@ -79,6 +79,28 @@
 #define EPD_HEIGHT      264
 #define EPD_STEPS      2
 #define EPD_BLOCK_SIZE  5808
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    10000000,   // max write clock (IL91874, 100 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 extern const unsigned char lut_vcom_dc[];
 extern const unsigned char lut_ww[];
@@ -99,75 +121,51 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x10;
     stepCommands[1] = 0x13;
 };
 
-int Epd::Init(void) {
-    /* this calls the peripheral hardware interface, see epdif */
-    if (IfInit() != 0) {
-        return -1;
-    }
-    /* EPD hardware init start */
-    Reset();
-     
-    SendCommand(POWER_ON);
-    WaitUntilIdle();
-   
-    SendCommand(PANEL_SETTING);
-    SendData(0xaf);        //KW-BF   KWR-AF    BWROTP 0f
-    
-    SendCommand(PLL_CONTROL);
-    SendData(0x3a);       //3A 100HZ   29 150Hz 39 200HZ    31 171HZ
-    
-    SendCommand(POWER_SETTING);
-    SendData(0x03);                  // VDS_EN, VDG_EN
-    SendData(0x00);                  // VCOM_HV, VGHL_LV[1], VGHL_LV[0]
-    SendData(0x2b);                  // VDH
-    SendData(0x2b);                  // VDL
-    SendData(0x09);                  // VDHR
-    
-    SendCommand(BOOSTER_SOFT_START);
-    SendData(0x07);
-    SendData(0x07);
-    SendData(0x17);
-    
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    // EPD hardware init start
+    EPD_RESET,
+    EPD_CMD, POWER_ON,
+    EPD_WAIT_BUSY,
+    EPD_CMD, PANEL_SETTING, EPD_DATA, 1, 0xaf,  // KW-BF   KWR-AF    BWROTP 0f
+    EPD_CMD, PLL_CONTROL, EPD_DATA, 1, 0x3a,  // 3A 100HZ   29 150Hz 39 200HZ    31 171HZ
+    EPD_CMD, POWER_SETTING, EPD_DATA, 5, 0x03, 0x00, 0x2b, 0x2b, 0x09,  // VDS_EN, VDG_EN; VCOM_HV, VGHL_LV[1], VGHL_LV[0]; VDH; VDL; VDHR
+    EPD_CMD, BOOSTER_SOFT_START, EPD_DATA, 3, 0x07, 0x07, 0x17,
     // Power optimization
-    SendCommand(0xF8);
-    SendData(0x60);
-    SendData(0xA5);
-    
+    EPD_CMD, 0xF8, EPD_DATA, 2, 0x60, 0xA5,
     // Power optimization
-    SendCommand(0xF8);
-    SendData(0x89);
-    SendData(0xA5);
-    
+    EPD_CMD, 0xF8, EPD_DATA, 2, 0x89, 0xA5,
     // Power optimization
-    SendCommand(0xF8);
-    SendData(0x90);
-    SendData(0x00);
-    
+    EPD_CMD, 0xF8, EPD_DATA, 2, 0x90, 0x00,
     // Power optimization
-    SendCommand(0xF8);
-    SendData(0x93);
-    SendData(0x2A);
-    
+    EPD_CMD, 0xF8, EPD_DATA, 2, 0x93, 0x2A,
     // Power optimization
-    SendCommand(0xF8);
-    SendData(0x73);
-    SendData(0x41);
-    
-    SendCommand(VCM_DC_SETTING_REGISTER);
-    SendData(0x12);                   
-    SendCommand(VCOM_AND_DATA_INTERVAL_SETTING);
-    SendData(0x87);        // define by OTP
-    
+    EPD_CMD, 0xF8, EPD_DATA, 2, 0x73, 0x41,
+    EPD_CMD, VCM_DC_SETTING_REGISTER, EPD_DATA, 1, 0x12,
+    EPD_CMD, VCOM_AND_DATA_INTERVAL_SETTING, EPD_DATA, 1, 0x87,  // define by OTP
+    EPD_END
+};
+
+static constexpr unsigned char initScript2[] = {
+    EPD_CMD, PARTIAL_DISPLAY_REFRESH, EPD_DATA, 1, 0x00,
+    // EPD hardware init end
+    EPD_END
+};
+
+int Epd::Init(void) {
+    /* this calls the peripheral hardware interface, see epdif */
+    if (IfInit(epdSpiProfile) != 0) {
+        return -1;
+    }
+    RunScript(initScript);
     SetLut();
-    
-    SendCommand(PARTIAL_DISPLAY_REFRESH);
-    SendData(0x00);  
-    /* EPD hardware init end */
-    
+
+    RunScript(initScript2);
     return 0;
 
 }
@@ -200,9 +198,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-    while(DigitalRead(busy_pin) == 0) {      //0: busy, 1: idle
-        DelayMs(100);
-    }      
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -211,12 +207,11 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);   
     DigitalWrite(reset_pin, LOW);
-    DelayMs(10);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);   
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -262,17 +257,11 @@ void Epd::ClearFrame() {
     SendData(height & 0xff);         //264
 
     SendCommand(DATA_START_TRANSMISSION_1);           
-    DelayMs(2);
-    for(int i = 0; i < width * height / 8; i++) {
-        SendData(0x00);  
-    }  
-    DelayMs(2);
+    SetToDataMode();
+    SpiTransferRepeat(0x00, width * height / 8);
     SendCommand(DATA_START_TRANSMISSION_2);           
-    DelayMs(2);
-    for(int i = 0; i < width * height / 8; i++) {
-        SendData(0x00);  
-    }  
-    DelayMs(2);
+    SetToDataMode();
+    SpiTransferRepeat(0x00, width * height / 8);
 }
 void Epd::Clear(unsigned char color) {
     TurnOnDisplay();
@@ -63,6 +63,28 @@
 #define EPD_HEIGHT      272
 #define EPD_STEPS      2
 #define EPD_BLOCK_SIZE  13600 // 6800 //  6732  // 792 * 272 / 8 / 4 (split into 4 parts)
+#define EPD_STREAM_BUFFER_SIZE  1024   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    20000000,   // max write clock (SSD1683, 50 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          HIGH    // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    10,     // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    0,      // refresh/power command until BUSY is asserted (ms)
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 Epd::~Epd() {
 };
@@ -76,65 +98,39 @@ Epd::Epd() {
     height = EPD_HEIGHT;
     steps = EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0] = 0x24;
     stepCommands[1] = 0xA4;
    //  stepCommands[2] = 0xA4;
   //  stepCommands[3] = 0XA6;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_WAIT_BUSY,
+    EPD_CMD, POWER_ON,
+    EPD_WAIT_BUSY,
+    EPD_CMD, DATA_ENTRY_MODE_SETTING, EPD_DATA, 1, 0x01,
+    EPD_CMD, SET_RAM_X_ADDRESS_START_END_POSITION, EPD_DATA, 2, 0x00, 0x31,  // 400/8-1
+    EPD_CMD, SET_RAM_Y_ADDRESS_START_END_POSITION, EPD_DATA, 4, 0x0f, 0x01, 0x00, 0x00,  // 300-1
+    EPD_CMD, SET_RAM_X_ADDRESS_COUNTER, EPD_DATA, 1, 0x00,
+    EPD_CMD, SET_RAM_Y_ADDRESS_COUNTER, EPD_DATA, 2, 0x0f, 0x01,
+    EPD_WAIT_BUSY,
+    EPD_CMD, DISPLAY_OPTION, EPD_DATA, 1, 0x00,
+    EPD_CMD, SET_RAM_X_ADDRESS_START_END_POSITION_S, EPD_DATA, 2, 0x31, 0x00,  // 400/8-1
+    EPD_CMD, SET_RAM_Y_ADDRESS_START_END_POSITION_S, EPD_DATA, 4, 0x0f, 0x01, 0x00, 0x00,  // 300-1
+    EPD_CMD, SET_RAM_X_ADDRESS_COUNTER_S, EPD_DATA, 1, 0x31,
+    EPD_CMD, SET_RAM_Y_ADDRESS_COUNTER_S, EPD_DATA, 2, 0x0f, 0x01,
+    EPD_WAIT_BUSY,
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-     Serial.print("Before Reset\r\n");
-    Reset();
-    Serial.print("After Reset\r\n");
-    WaitUntilIdle();
-    SendCommand(POWER_ON);
-    WaitUntilIdle();
-
-    SendCommand(DATA_ENTRY_MODE_SETTING);
-    SendData(0x01);
-
-    SendCommand(SET_RAM_X_ADDRESS_START_END_POSITION);
-    SendData(0x00);
-    SendData(0x31); //400/8-1
-
-    SendCommand(SET_RAM_Y_ADDRESS_START_END_POSITION);
-    SendData(0x0f);
-    SendData(0x01);  //300-1
-    SendData(0x00);
-    SendData(0x00);
-
-    SendCommand(SET_RAM_X_ADDRESS_COUNTER);
-    SendData(0x00);
-    SendCommand(SET_RAM_Y_ADDRESS_COUNTER);
-    SendData(0x0f);
-    SendData(0x01);
-
-    WaitUntilIdle();
-
-    SendCommand(DISPLAY_OPTION);
-    SendData(0x00);
-
-    SendCommand(SET_RAM_X_ADDRESS_START_END_POSITION_S);
-    SendData(0x31);
-    SendData(0x00); //400/8-1
-
-    SendCommand(SET_RAM_Y_ADDRESS_START_END_POSITION_S);
-    SendData(0x0f);
-    SendData(0x01);  //300-1
-    SendData(0x00);
-    SendData(0x00);
-
-    SendCommand(SET_RAM_X_ADDRESS_COUNTER_S);
-    SendData(0x31);
-    SendCommand(SET_RAM_Y_ADDRESS_COUNTER_S);
-    SendData(0x0f);
-    SendData(0x01);
-
-    WaitUntilIdle();
-
+    RunScript(initScript);
     return 0;
 }
 
@@ -166,10 +162,7 @@ void Epd::SetToDataMode() {
  *  @brief: Wait until the busy_pin goes HIGH
  */
 void Epd::WaitUntilIdle(void) {
-   while(DigitalRead(busy_pin) == 1) {      //0: busy, 1: idle
-        DelayMs(100);
-         
-    }           
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -179,9 +172,10 @@ void Epd::WaitUntilIdle(void) {
  */
 void Epd::Reset(void) {
     DigitalWrite(reset_pin, LOW);
-    DelayMs(200);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);    
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 void Epd::TurnOnDisplay(void) {
@@ -198,25 +192,21 @@ void Epd::SetLut(void) {
 void Epd::ClearFrame() {
     // M part (main section)
     SendCommand(WRITE_RAM_BW_M);
-    for(int i = 0; i < 13600; i++) {
-        SendData(0xFF);
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xFF, 13600);
 
     SendCommand(WRITE_RAM_RED_M);
-    for(int i = 0; i < 13600; i++) {
-        SendData(0x00);
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0x00, 13600);
 
     // S part (secondary section)
     SendCommand(WRITE_RAM_BW_S);
-    for(int i = 0; i < 13600; i++) {
-        SendData(0xFF);
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0xFF, 13600);
 
     SendCommand(WRITE_RAM_RED_S);
-    for(int i = 0; i < 13600; i++) {
-        SendData(0x00);
-    }
+    SetToDataMode();
+    SpiTransferRepeat(0x00, 13600);
 }
 
 void Epd::Clear(unsigned char color) {
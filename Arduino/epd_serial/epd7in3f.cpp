@@ -41,6 +41,28 @@
 #define EPD_HEIGHT      480
 #define EPD_STEPS      1
 #define EPD_BLOCK_SIZE  192000
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    8000000,    // max write clock (no datasheet figure, known good)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     60000   // longest 7-colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    20,     // RST high until BUSY is valid (ms), as in the vendor reset
+    20,     // refresh/power command until BUSY is asserted (ms), the slack SendCommand() had
+    0,      // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 Epd::~Epd() {
 };
@@ -54,6 +76,7 @@ Epd::Epd() {
     height = EPD_HEIGHT;
      steps=EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     stepCommands[0]=0x10;
     
 };
@@ -63,105 +86,40 @@ function :  Initialize the e-Paper register
 parameter:
 ******************************************************************************/
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, 0x04,                            // POWER_ON
+    EPD_DELAY_MS(epdTiming.busyStartMs),
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0xAA, EPD_DATA, 6, 0x49, 0x55, 0x20, 0x08, 0x09, 0x18,  // CMDH
+    EPD_CMD, 0x01, EPD_DATA, 6, 0x3F, 0x00, 0x32, 0x2A, 0x0E, 0x2A,
+    EPD_CMD, 0x00, EPD_DATA, 2, 0x5F, 0x69,
+    EPD_CMD, 0x03, EPD_DATA, 4, 0x00, 0x54, 0x00, 0x44,
+    EPD_CMD, 0x05, EPD_DATA, 4, 0x40, 0x1F, 0x1F, 0x2C,
+    EPD_CMD, 0x06, EPD_DATA, 4, 0x6F, 0x1F, 0x16, 0x25,
+    EPD_CMD, 0x08, EPD_DATA, 4, 0x6F, 0x1F, 0x1F, 0x22,
+    EPD_CMD, 0x13, EPD_DATA, 2, 0x00, 0x04,   // IPC
+    EPD_CMD, 0x30, EPD_DATA, 1, 0x02,
+    EPD_CMD, 0x41, EPD_DATA, 1, 0x00,         // TSE
+    EPD_CMD, 0x50, EPD_DATA, 1, 0x3F,
+    EPD_CMD, 0x60, EPD_DATA, 2, 0x02, 0x00,
+    EPD_CMD, 0x61, EPD_DATA, 4, 0x03, 0x20, 0x01, 0xE0,
+    EPD_CMD, 0x82, EPD_DATA, 1, 0x1E,
+    EPD_CMD, 0x84, EPD_DATA, 1, 0x00,
+    EPD_CMD, 0x86, EPD_DATA, 1, 0x00,         // AGID
+    EPD_CMD, 0xE3, EPD_DATA, 1, 0x2F,
+    EPD_CMD, 0xE0, EPD_DATA, 1, 0x00,         // CCSET
+    EPD_CMD, 0xE6, EPD_DATA, 1, 0x00,         // TSSET
+    EPD_END
+};
+
 int Epd::Init(void) {
     
-     if (IfInit() != 0) {
+     if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-   SendCommand(0x04);  // POWER_ON
-    WaitUntilIdle();
-       
-    SendCommand(0xAA);    // CMDH
-    SendData(0x49);
-    SendData(0x55);
-    SendData(0x20);
-    SendData(0x08);
-    SendData(0x09);
-    SendData(0x18);
-
-    SendCommand(0x01);
-    SendData(0x3F);
-    SendData(0x00);
-    SendData(0x32);
-    SendData(0x2A);
-    SendData(0x0E);
-    SendData(0x2A);
-
-    SendCommand(0x00);
-    SendData(0x5F);
-    SendData(0x69);
-
-    SendCommand(0x03);
-    SendData(0x00);
-    SendData(0x54);
-    SendData(0x00);
-    SendData(0x44); 
-
-    SendCommand(0x05);
-    SendData(0x40);
-    SendData(0x1F);
-    SendData(0x1F);
-    SendData(0x2C);
-
-    SendCommand(0x06);
-    SendData(0x6F);
-    SendData(0x1F);
-    SendData(0x16);
-    SendData(0x25);
-
-    SendCommand(0x08);
-    SendData(0x6F);
-    SendData(0x1F);
-    SendData(0x1F);
-    SendData(0x22);
-
-    SendCommand(0x13);    // IPC
-    SendData(0x00);
-    SendData(0x04);
-
-    SendCommand(0x30);
-    SendData(0x02);
-
-    SendCommand(0x41);     // TSE
-    SendData(0x00);
-
-    SendCommand(0x50);
-    SendData(0x3F);
-
-    SendCommand(0x60);
-    SendData(0x02);
-    SendData(0x00);
-
-    SendCommand(0x61);
-    SendData(0x03);
-    SendData(0x20);
-    SendData(0x01); 
-    SendData(0xE0);
-
-    SendCommand(0x82);
-    SendData(0x1E); 
-
-    SendCommand(0x84);
-    SendData(0x00);
-
-    SendCommand(0x86);    // AGID
-    SendData(0x00);
-
-    SendCommand(0xE3);
-    SendData(0x2F);
-
-    SendCommand(0xE0);   // CCSET
-    SendData(0x00); 
-
-    SendCommand(0xE6);   // TSSET
-    SendData(0x00);
-
-
-    
-        DelayMs(2000);  
-     
-    
+    RunScript(initScript);
     return 0;
 
 }
@@ -169,12 +127,10 @@ int Epd::Init(void) {
  *  @brief: basic function for sending commands
  */
 void Epd::SendCommand(unsigned char command) {
-  DelayMs(200);
     DigitalWrite(dc_pin, LOW);
-    DelayMs(2);
     SpiTransfer(command);
-     DelayMs(20);
-      DigitalWrite(dc_pin, HIGH);
+    // SendData() relies on DC being left high
+    DigitalWrite(dc_pin, HIGH);
 }
 void Epd::SetToDataMode() {
    DigitalWrite(dc_pin, HIGH);
@@ -188,11 +144,8 @@ void Epd::SendData(unsigned char data) {
     SpiTransfer(data);
 }
 
-void Epd::WaitUntilIdle(void)// If BUSYN=0 then waiting
-{
-    while(!DigitalRead(BUSY_PIN)) {
-        DelayMs(1);
-    }
+void Epd::WaitUntilIdle(void) {
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
 }
 
 /**
@@ -201,15 +154,10 @@ void Epd::WaitUntilIdle(void)// If BUSYN=0 then waiting
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-   DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(1);
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(1);   
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(1);
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-      
-
+    DelayMs(epdTiming.resetWaitMs);
     WaitUntilIdle();
 }
 
@@ -217,12 +165,14 @@ void Epd::TurnOnDisplay(void) {
   
   
     SendCommand(0x04);  // POWER_ON
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
     
     SendCommand(0x12);  // DISPLAY_REFRESH
     SendData(0x01);
  
  // Serial.print("DISPLAY_REFRESH=");
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
   
 }
@@ -234,11 +184,7 @@ function :
 void Epd::Clear(unsigned char color) {
     SendCommand(0x10);
     SetToDataMode();
-    for(int i=0; i<width/2; i++) {
-        for(int j=0; j<height; j++) {
-           SendData((color<<4)|color);  //SendData(color);  //  
-		}
-	}
+    SpiTransferRepeat((color<<4)|color, width / 2 * height);
     TurnOnDisplay();
 }
 
@@ -252,7 +198,7 @@ void Epd::Clear(unsigned char color) {
 void Epd::Sleep(void) {
     SendCommand(0x07);
     SendData(0xA5);
-    DelayMs(1000);
+    DelayMs(epdTiming.sleepWaitMs);
 	  DigitalWrite(RST_PIN, 0); // Reset
 }
 
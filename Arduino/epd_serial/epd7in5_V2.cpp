@@ -41,12 +41,34 @@
 #define EPD_HEIGHT      480
 #define EPD_STEPS      2
 #define EPD_BLOCK_SIZE 48000 // 96000
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    10000000,   // max write clock (UC8179, 100 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     15000   // longest monochrome refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    20,     // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 // Pixel format for this display
 #define EPD_BITS_PER_PIXEL 1    // Monochrome: 1 byte per pixel  
 #define EPD_PIXELS_PER_BYTE 8   // Each byte is one pixel
 
-unsigned char Voltage_Frame_7IN5_V2[]={
+static constexpr unsigned char Voltage_Frame_7IN5_V2[]={
 	0x6, 0x3F, 0x3F, 0x11, 0x24, 0x7, 0x17,
 };
 
@@ -114,48 +136,35 @@ Epd::Epd() {
     pixels_per_byte = EPD_PIXELS_PER_BYTE;
     steps=EPD_STEPS;
     blockSize = EPD_BLOCK_SIZE;
+    streamBufferSize = EPD_STREAM_BUFFER_SIZE;
     //stepCommands[0]=0x13;
     stepCommands[0]=0x10;
     stepCommands[1]=0x13;
+    ramPartialWindow = true;
     ShowDebug = false;
     qr_color = 0xFF;
 };
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, 0x01, EPD_DATA, 4, 0x07, 0x07, 0x3f, 0x3f,
+    EPD_CMD, 0x04,
+    EPD_DELAY_MS(epdTiming.busyStartMs),
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0X00, EPD_DATA, 1, 0x0F,         // PANNEL SETTING; KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
+    EPD_CMD, 0x61, EPD_DATA, 4, 0x03, 0x20, 0x01, 0xE0,  // tres; source 800; gate 480
+    EPD_CMD, 0X15, EPD_DATA, 1, 0x00,
+    EPD_CMD, 0X50, EPD_DATA, 2, 0x10, 0x07,   // VCOM AND DATA INTERVAL SETTING
+    EPD_CMD, 0X60, EPD_DATA, 1, 0x22,         // TCON SETTING
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-
-    SendCommand(0x01); 
-    SendData(0x07);
-    SendData(0x07);
-    SendData(0x3f);
-    SendData(0x3f);
-
-    SendCommand(0x04);
-    DelayMs(100);
-    WaitUntilIdle();
-    
-    SendCommand(0X00);			//PANNEL SETTING
-    SendData(0x0F);   //KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
-
-    SendCommand(0x61);        	//tres
-    SendData(0x03);		//source 800
-    SendData(0x20);
-    SendData(0x01);		//gate 480
-    SendData(0xE0);
-
-    SendCommand(0X15);
-    SendData(0x00);
-
-    SendCommand(0X50);			//VCOM AND DATA INTERVAL SETTING
-    SendData(0x10);
-    SendData(0x07);
-
-    SendCommand(0X60);			//TCON SETTING
-    SendData(0x22);
-
+    RunScript(initScript);
      return 0;
 
 	SendCommand(0x01);  // power setting
@@ -178,7 +187,7 @@ int Epd::Init(void) {
 	SendData(*(Voltage_Frame_7IN5_V2+0));  // 2-0=100: N=4  ; 5-3=111: M=7  ;  3C=50Hz     3A=100HZ
 
     SendCommand(0x04); //POWER ON
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 
     SendCommand(0X00);			//PANNEL SETTING
@@ -237,7 +246,7 @@ void Epd::SetLut_by_host(unsigned char* lut_vcom,  unsigned char* lut_ww, unsign
 }
 /*
 int Epd::Init4G(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
     Reset();
@@ -249,7 +258,7 @@ int Epd::Init4G(void) {
     SendData(0x3f);
 
     SendCommand(0x04);
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
     
     SendCommand(0x00);      //PANNEL SETTING
@@ -319,14 +328,10 @@ void Epd::SendDataFast(unsigned char data) {
 //     DelayMs(200);
 // }
 void Epd::WaitUntilIdle(void) {
-    unsigned char busy;
     Serial.print("e-Paper Busy\r\n ");
-    do{
-        SendCommand(0x71);
-        busy = DigitalRead(busy_pin);
-    }while(busy == 0);
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
     Serial.print("e-Paper Busy Release\r\n ");
-    DelayMs(20);
+    DelayMs(epdTiming.busySettleMs);
 }
 /**
  *  @brief: module reset.
@@ -334,18 +339,16 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
-   Serial.print("e-Paper Reset\r\n ");
-   DelayMs(40);
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(4);
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);    
-    Serial.print("e-Paper Reset Release\r\n ");
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 void Epd::TurnOnDisplay(void) {
    Serial.print("e-Paper TurnOnDisplay\r\n ");
    SendCommand(0x12);
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
    
   Serial.print("e-Paper TurnOnDisplay  Release\r\n ");
@@ -372,24 +375,18 @@ void Epd::Clear( unsigned char color) {
     
     SendCommand(0x10);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++) {
-        SendData(color);
-    }
+    SpiTransferRepeat(color, height*width / 8);
     SendCommand(0x13);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++)	{
-        SendData(color);
-    }
+    SpiTransferRepeat(color, height*width / 8);
     SendCommand(0x12);
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 }
 void Epd::ClearFrame() {
        SendCommand(0x10);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++) {
-        SendData(0xFF);
-    }
+    SpiTransferRepeat(0xFF, height*width / 8);
     // SendCommand(0x13);
     // SetToDataMode();
     // for(unsigned long i=0; i<height*width / 8; i++)	{
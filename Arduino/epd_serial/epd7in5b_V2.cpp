@@ -37,6 +37,28 @@
 #define EPD_HEIGHT      480
 #define EPD_STEPS      2
 #define EPD_BLOCK_SIZE  48000
+#define EPD_STREAM_BUFFER_SIZE  4096   // download/DMA chunk size
+
+// SPI write timing for this controller, applied by IfInit()
+static const EpdSpiProfile epdSpiProfile = {
+    10000000,   // max write clock (UC8179, 100 ns write cycle)
+    0,          // DC change to first data clock (ns)
+    60,         // CS low to first clock (ns)
+    65          // last clock to CS high (ns)
+};
+
+#define EPD_BUSY_LEVEL          LOW     // BUSY pin level while the controller works
+#define EPD_BUSY_TIMEOUT_MS     40000   // longest colour refresh plus margin
+
+// Controller waits, from the datasheet or vendor reference code; anything
+// longer is covered by polling BUSY
+static constexpr EpdTiming epdTiming = {
+    2,      // RST low (ms)
+    10,     // RST high until BUSY is valid (ms)
+    5,      // refresh/power command until BUSY is asserted (ms)
+    20,     // BUSY released until the next command (ms)
+    0       // power off/deep sleep command until the next step (ms)
+};
 
 // Pixel format for this display
 #define EPD_BITS_PER_PIXEL 1    // Monochrome: 1 byte per pixel  
@@ -57,48 +79,34 @@ Epd::Epd() {
     pixels_per_byte = EPD_PIXELS_PER_BYTE;
     stepCommands[0]=0x10;
     stepCommands[1]=0x13;
+    ramPartialWindow = true;
      blockSize = EPD_BLOCK_SIZE;
+     streamBufferSize = EPD_STREAM_BUFFER_SIZE;
      qr_color = 0xFF;
     
 };
 //unsigned char Epd::StepCommands[] ={0x10,0x13}; 
 
+// Controller setup run by Init(), see Epd::RunScript()
+static constexpr unsigned char initScript[] = {
+    EPD_RESET,
+    EPD_CMD, 0x01, EPD_DATA, 4, 0x07, 0x07, 0x3f, 0x3f,
+    EPD_CMD, 0x04,
+    EPD_DELAY_MS(epdTiming.busyStartMs),
+    EPD_WAIT_BUSY,
+    EPD_CMD, 0X00, EPD_DATA, 1, 0x0F,         // PANNEL SETTING; KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
+    EPD_CMD, 0x61, EPD_DATA, 4, 0x03, 0x20, 0x01, 0xE0,  // tres; source 800; gate 480
+    EPD_CMD, 0X15, EPD_DATA, 1, 0x00,
+    EPD_CMD, 0X50, EPD_DATA, 2, 0x10, 0x07,   // VCOM AND DATA INTERVAL SETTING
+    EPD_CMD, 0X60, EPD_DATA, 1, 0x22,         // TCON SETTING
+    EPD_END
+};
+
 int Epd::Init(void) {
-    if (IfInit() != 0) {
+    if (IfInit(epdSpiProfile) != 0) {
         return -1;
     }
-    Reset();
-
-    
-    SendCommand(0x01); 
-    SendData(0x07);
-    SendData(0x07);
-    SendData(0x3f);
-    SendData(0x3f);
-
-    SendCommand(0x04);
-    DelayMs(100);
-    WaitUntilIdle();
-    
-    SendCommand(0X00);			//PANNEL SETTING
-    SendData(0x0F);   //KW-3f   KWR-2F	BWROTP 0f	BWOTP 1f
-
-    SendCommand(0x61);        	//tres
-    SendData(0x03);		//source 800
-    SendData(0x20);
-    SendData(0x01);		//gate 480
-    SendData(0xE0);
-
-    SendCommand(0X15);
-    SendData(0x00);
-
-    SendCommand(0X50);			//VCOM AND DATA INTERVAL SETTING
-    SendData(0x10);
-    SendData(0x07);
-
-    SendCommand(0X60);			//TCON SETTING
-    SendData(0x22);
-
+    RunScript(initScript);
      return 0;
 
     SendCommand(0x01);			//POWER SETTING
@@ -108,7 +116,7 @@ int Epd::Init(void) {
     SendData(0x3f);		//VDL=-15V
 
     SendCommand(0x04); //POWER ON
-    DelayMs(100);
+    DelayMs(epdTiming.busyStartMs);
     WaitUntilIdle();
 
    // SendCommand(0X00);			//PANNEL SETTING
@@ -157,7 +165,7 @@ void Epd::SetToDataMode() {
  *  @brief: basic function for sending data
  */
 void Epd::SendData(unsigned char data) {
-   // DigitalWrite(dc_pin, HIGH);
+   DigitalWrite(dc_pin, HIGH);
     SpiTransfer(data);
 }
 
@@ -172,13 +180,8 @@ void Epd::SendDataFast(unsigned char data) {
  
  */
 void Epd::WaitUntilIdle(void) {
-	unsigned char busy;
-	do	{
-		SendCommand(0x71);
-		busy = DigitalRead(busy_pin);
-		busy =!(busy & 0x01);        
-	}while(busy);
-	DelayMs(200);      
+    WaitBusy(busy_pin, EPD_BUSY_LEVEL, EPD_BUSY_TIMEOUT_MS);
+    DelayMs(epdTiming.busySettleMs);
 }
 
 /**
@@ -187,34 +190,27 @@ void Epd::WaitUntilIdle(void) {
  *          see Epd::Sleep();
  */
 void Epd::Reset(void) {
+    DigitalWrite(reset_pin, LOW);
+    DelayMs(epdTiming.resetPulseMs);
     DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);
-    DigitalWrite(reset_pin, LOW);                //module reset    
-    DelayMs(2);
-    DigitalWrite(reset_pin, HIGH);
-    DelayMs(200);
+    DelayMs(epdTiming.resetWaitMs);
+    WaitUntilIdle();
 }
 
 
 void Epd::Clear( unsigned char color) {
        SendCommand(0x10);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++) {
-        SendData(0xFF);
-    }
+    SpiTransferRepeat(0xFF, height*width / 8);
     SendCommand(0x13);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++)	{
-        SendData(0x00);
-    }
+    SpiTransferRepeat(0x00, height*width / 8);
 }
 
 void Epd::ClearFrame() {
        SendCommand(0x10);
     SetToDataMode();
-    for(unsigned long i=0; i<height*width / 8; i++) {
-        SendData(0xFF);
-    }
+    SpiTransferRepeat(0xFF, height*width / 8);
     // SendCommand(0x13);
     // SetToDataMode();
     // for(unsigned long i=0; i<height*width / 8; i++)	{
@@ -224,7 +220,7 @@ void Epd::ClearFrame() {
 
 void Epd::TurnOnDisplay(void) {
        SendCommand(0x12);
-        DelayMs(100);
+        DelayMs(epdTiming.busyStartMs);
         WaitUntilIdle();
 }
 /**
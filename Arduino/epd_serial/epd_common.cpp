@@ -0,0 +1,226 @@
+/**
+ *  @filename   :   epd_common.cpp
+ *  @brief      :   Panel-independent Epd functions
+ *  
+ *
+ *  MIT License
+ *  
+ *  Copyright (c) 2025 EpaperPix
+ * 
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "epd_base.h"
+
+/**
+ *  @brief: send a block of pixel data in one SPI burst.
+ *          Like SendDataFast, the caller must already be in data mode
+ *          (SendCommand + SetToDataMode).
+ */
+void Epd::SendBuffer(unsigned char* buffer, int size) {
+    if (size <= 0) {
+        return;
+    }
+    SpiTransferBuffer(buffer, (unsigned long)size);
+}
+
+/**
+ *  @brief: start sending a block of pixel data and return while it is
+ *          still going out (by DMA when EPD_SPI_DMA is enabled).
+ *          The buffer must stay untouched until the next SendBuffer*,
+ *          WaitBuffer or command.
+ */
+void Epd::SendBufferAsync(unsigned char* buffer, int size) {
+    if (size <= 0) {
+        return;
+    }
+    SpiTransferBufferAsync(buffer, (unsigned long)size);
+}
+
+/**
+ *  @brief: wait until the last SendBufferAsync block has been sent
+ */
+void Epd::WaitBuffer(void) {
+    SpiTransferWait();
+}
+
+/**
+ *  @brief: run a controller script built from the EPD_* opcodes.
+ *          Each data run goes out as one SPI burst instead of one
+ *          transfer per byte.
+ */
+void Epd::RunScript(const unsigned char* script) {
+    // scripts live in flash, which the DMA engine cannot read
+    unsigned char run[255];
+    for (;;) {
+        switch (*script++) {
+        case EPD_CMD:
+            SendCommand(*script++);
+            break;
+        case EPD_DATA: {
+            unsigned char len = *script++;
+            memcpy(run, script, len);
+            script += len;
+            SetToDataMode();
+            SpiTransferBuffer(run, len);
+            break;
+        }
+        case EPD_DELAY:
+            DelayMs(((unsigned int)script[0] << 8) | script[1]);
+            script += 2;
+            break;
+        case EPD_WAIT_BUSY:
+            WaitUntilIdle();
+            break;
+        case EPD_RESET:
+            Reset();
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+/**
+ *  @brief: continue an interrupted upload at byte offset of step. Returns
+ *          the offset within the step the data must restart from, or -1
+ *          when the controller cannot be repositioned and needs Init().
+ */
+long Epd::ResumeStep(int step, unsigned long offset) {
+    if (step >= steps) {
+        return -1;
+    }
+    if (ramRowBytes > 0) {
+        // SSD168x: point the RAM address counters at the next byte
+        unsigned int row = offset / ramRowBytes;
+        unsigned int y = ramYDown ? ramYStart - row : ramYStart + row;
+        SendCommand(0x4E);
+        SendData(offset % ramRowBytes);
+        SendCommand(0x4F);
+        SendData(y & 0xFF);
+        SendData((y >> 8) & 0xFF);
+        SendCommand(stepCommands[step]);
+        SetToDataMode();
+        return offset;
+    }
+    if (stepCommands[step] == 0x10 || stepCommands[step] == 0x13) {
+        // UC81xx: the data command rewinds to the start of its plane
+        SendCommand(stepCommands[step]);
+        SetToDataMode();
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ *  @brief: limit the next plane write to cols bytes of rows rows, from
+ *          byte col of row in the order the image streams. Returns false
+ *          when the controller has no RAM window to do that with.
+ */
+bool Epd::SetWindow(unsigned long col, unsigned long row, unsigned long cols, unsigned long rows) {
+    if (ramPartialWindow) {
+        return SetPartialWindow(col, row, cols, rows);
+    }
+    if (ramRowBytes == 0 || cols == 0 || rows == 0 || col + cols > ramRowBytes ||
+        (row + rows) * ramRowBytes > blockSize) {
+        return false;
+    }
+    // SSD168x: X in bytes, Y in the direction the driver set up
+    unsigned int last = row + rows - 1;
+    unsigned int y0 = ramYDown ? ramYStart - row : ramYStart + row;
+    unsigned int y1 = ramYDown ? ramYStart - last : ramYStart + last;
+    SendCommand(0x44);
+    SendData(col);
+    SendData(col + cols - 1);
+    SendCommand(0x45);
+    SendData(y0 & 0xFF);
+    SendData((y0 >> 8) & 0xFF);
+    SendData(y1 & 0xFF);
+    SendData((y1 >> 8) & 0xFF);
+    SendCommand(0x4E);
+    SendData(col);
+    SendCommand(0x4F);
+    SendData(y0 & 0xFF);
+    SendData((y0 >> 8) & 0xFF);
+    return true;
+}
+
+/**
+ *  @brief: UC81xx side of SetWindow(). Columns are bytes of 8 pixels, the
+ *          controller's horizontal unit; the whole plane leaves partial
+ *          mode.
+ */
+bool Epd::SetPartialWindow(unsigned long col, unsigned long row, unsigned long cols, unsigned long rows) {
+    if (pixels_per_byte != 8 || cols == 0 || rows == 0 || (col + cols) * 8 > width || row + rows > height) {
+        return false;
+    }
+    if (col == 0 && row == 0 && cols * 8 == width && rows == height) {
+        SendCommand(0x92);      // PARTIAL OUT
+        return true;
+    }
+    unsigned int x0 = col * 8;
+    unsigned int x1 = (col + cols) * 8 - 1;
+    unsigned int y1 = row + rows - 1;
+    SendCommand(0x91);          // PARTIAL IN
+    SendCommand(0x90);          // PARTIAL WINDOW; HRST, HRED, VRST, VRED, PT_SCAN
+    SendData((x0 >> 8) & 0x03);
+    SendData(x0 & 0xF8);
+    SendData((x1 >> 8) & 0x03);
+    SendData((x1 & 0xFF) | 0x07);
+    SendData((row >> 8) & 0x03);
+    SendData(row & 0xFF);
+    SendData((y1 >> 8) & 0x03);
+    SendData(y1 & 0xFF);
+    SendData(0x01);             // gates scan inside and outside the window
+    return true;
+}
+
+/**
+ *  @brief: switch between the partial and the full waveform. Returns
+ *          false when the panel has no partial refresh.
+ */
+bool Epd::SetPartial(bool partial) {
+    if (partialMode == NULL) {
+        return false;
+    }
+    partialMode(*this, partial);
+    return true;
+}
+
+/**
+ *  @brief: refresh with the partial waveform, only the pixels that differ
+ *          from the previous image change. Needs SetPartial(true).
+ *          UC81xx refresh the last SetWindow() window only.
+ */
+void Epd::TurnOnPartial(void) {
+    if (partialRefresh == 0) {
+        // UC81xx: the normal refresh, limited to the window SetWindow() set
+        TurnOnDisplay();
+        return;
+    }
+    SendCommand(0x22);
+    SendData(partialRefresh);
+    SendCommand(0x20);
+    WaitUntilIdle();
+}
+
+/* END OF FILE */
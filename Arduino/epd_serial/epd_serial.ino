@@ -14,8 +14,66 @@
 #include "epd_base.h"
 
 #define USE_SERIAL Serial
+#define SERIAL_BUFFER_SIZE 256  /* Bytes read from serial per SPI burst */
+
+// Uncomment to time a full-frame push at each SPI clock on start-up and
+// print bytes/s, to find the fastest clock a panel takes reliably
+//#define SPI_BENCHMARK
+
+#ifdef SPI_BENCHMARK
+const unsigned long benchmarkClocks[] = {
+  1000000, 2000000, 4000000, 8000000, 10000000, 16000000, 20000000, 26666666, 40000000
+};
+#endif
 
 Epd epd;
+
+#ifdef SPI_BENCHMARK
+// Pushes a test pattern through every step at each clock, the last frame
+// is shown so a corrupted image points at a clock that is too fast.
+void SpiBenchmark() {
+  unsigned char buff[SERIAL_BUFFER_SIZE];
+  for(unsigned int i = 0; i < sizeof(buff); i++)
+    buff[i] = (i / (epd.width / 8)) & 1 ? 0xAA : 0x55;
+
+  USE_SERIAL.print("SPI benchmark, profile max clock: ");
+  USE_SERIAL.println(EpdIf::spiProfile.maxClockHz);
+  for(unsigned int c = 0; c < sizeof(benchmarkClocks) / sizeof(benchmarkClocks[0]); c++) {
+    if(EpdIf::SetSpiClock(benchmarkClocks[c]) != 0) {
+      USE_SERIAL.println("SetSpiClock failed");
+      continue;
+    }
+    unsigned long bytes = 0;
+    unsigned long start = micros();
+    for(int i = 0; i < epd.steps; i++) {
+      unsigned long len = epd.blockSize;
+      epd.SendCommand(epd.stepCommands[i]);
+      epd.SetToDataMode();
+      while(len > 0) {
+        unsigned long n = min((unsigned long)sizeof(buff), len);
+        epd.SendBuffer(buff, n);
+        len -= n;
+        bytes += n;
+      }
+    }
+    unsigned long elapsed = micros() - start;
+    USE_SERIAL.print(benchmarkClocks[c]);
+    USE_SERIAL.print(" Hz: ");
+    USE_SERIAL.print(bytes);
+    USE_SERIAL.print(" bytes in ");
+    USE_SERIAL.print(elapsed);
+    USE_SERIAL.print(" us, ");
+    USE_SERIAL.print((unsigned long)((unsigned long long)bytes * 1000000 / (elapsed ? elapsed : 1)));
+    USE_SERIAL.print(" bytes/s");
+    if(benchmarkClocks[c] > EpdIf::spiProfile.maxClockHz)
+      USE_SERIAL.print(" (above profile)");
+    USE_SERIAL.println();
+  }
+  epd.TurnOnDisplay();
+  EpdIf::SetSpiClock(EpdIf::spiProfile.maxClockHz);
+}
+#endif
+
 void setup() {
   USE_SERIAL.begin(115200);
 
@@ -30,6 +88,9 @@ void setup() {
     return;
   }
   epd.ShowDebug = true;
+#ifdef SPI_BENCHMARK
+  SpiBenchmark();
+#endif
  // epd.TurnOnDisplay();
  //Some screens needs the buffer to clear
 //  USE_SERIAL.println("ClearFrame");
@@ -46,7 +107,7 @@ void setup() {
 
 
 void loop() {
-  char byte1;
+  unsigned char buff[SERIAL_BUFFER_SIZE];
   unsigned long len;
   unsigned long cnt = 0;
 
@@ -56,6 +117,12 @@ void loop() {
   USE_SERIAL.println(epd.steps);
   USE_SERIAL.print("Block size: ");
   USE_SERIAL.println(epd.blockSize);
+#ifdef EPD_SPI_STATS
+  EpdIf::SpiStatsReset();
+#endif
+#ifdef EPD_SPI_TRACE
+  EpdIf::TraceReset();
+#endif
   epd.SendCommand(0x24); 
   for(int i = 0; i < epd.steps; i++) {
     len = epd.blockSize;
@@ -63,14 +130,17 @@ void loop() {
     epd.SetToDataMode();
     
     while (len > 0) {
-      if (USE_SERIAL.available() > 0) {
-        byte1 = USE_SERIAL.read();
-        if(i==0)
-          byte1 = ~byte1;
-
-        epd.SendDataFast(byte1);
-        len--;
-        cnt++;
+      int avail = USE_SERIAL.available();
+      if (avail > 0) {
+        int n = USE_SERIAL.readBytes(buff, min((unsigned long)avail, min((unsigned long)sizeof(buff), len)));
+        if(i==0) {
+          for(int j = 0; j < n; j++)
+            buff[j] = ~buff[j];
+        }
+
+        epd.SendBuffer(buff, n);
+        len -= n;
+        cnt += n;
       } else {
         if (cnt == 0) {
           USE_SERIAL.print(".");
@@ -84,4 +154,10 @@ void loop() {
   
  // epd.TurnOnDisplay();
   USE_SERIAL.println("\nDisplay updated");
+#ifdef EPD_SPI_STATS
+  EpdIf::SpiStatsPrint();
+#endif
+#ifdef EPD_SPI_TRACE
+  EpdIf::TraceDump();
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+/**
+ *  @filename   :   api_json_bench.cpp
+ *  @brief      :   Parse time and peak heap of the slideshow API parsers
+ *
+ *  Runs the parsers of Arduino/epd_epaperpix_wifi/api_json.h on a PC
+ *  against recorded API answers. For comparison it also runs the old
+ *  way: the body copied into a heap string, then an unfiltered parse into
+ *  a 200 byte document. Capture answers with e.g.
+ *
+ *      curl -s -X POST -d '{}' "https://api.epaperpix.app/epaper2/DSlideShow/..." > file.json
+ *
+ *  then build and run (ArduinoJson 6 is header only):
+ *
+ *      g++ -O2 -std=c++11 -I<ArduinoJson>/src -IArduino/epd_epaperpix_wifi \
+ *          tools/api_json_bench.cpp -o api_json_bench
+ *      ./api_json_bench start.json file.json device.json
+ *
+ *  Without arguments a few built-in sample answers are used.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "api_json.h"
+
+// heap use of everything that goes through operator new, e.g. std::string
+static size_t heapNow = 0;
+static size_t heapPeak = 0;
+
+void* operator new(size_t size) {
+    size_t* p = (size_t*)malloc(size + sizeof(size_t));
+    if (p == NULL) {
+        throw std::bad_alloc();
+    }
+    *p = size;
+    heapNow += size;
+    if (heapNow > heapPeak) {
+        heapPeak = heapNow;
+    }
+    return p + 1;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != NULL) {
+        size_t* p = (size_t*)ptr - 1;
+        heapNow -= *p;
+        free(p);
+    }
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+static const char* samples[][2] = {
+    { "sample start", "{\"gotoSleep\":true,\"secondsDelay\":900,\"slideShowName\":\"Kitchen\","
+                      "\"slides\":12,\"message\":\"ok\"}" },
+    { "sample file", "{\"fileName\":\"3f2a9c1e-7d41-4b8e-9a0c-5e6f1d2b7a90.bin\",\"gotoSleep\":true,"
+                     "\"secondsDelay\":900,\"slideIndex\":4,\"width\":800,\"height\":480,"
+                     "\"format\":\"epd7in5_V2\",\"updated\":\"2025-05-01T08:30:00Z\"}" },
+    { "sample device", "{\"AccountID\":\"a1b2c3d4e5f6\",\"SlideShowId\":\"kitchen-01\","
+                       "\"subscriptionKey\":\"0123456789abcdef0123456789abcdef\",\"Model\":\"XIAO\","
+                       "\"Firmware\":\"2.3\",\"Owner\":{\"Name\":\"x\",\"Mail\":\"x@example.com\"}}" },
+};
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result {
+    double usPerParse;
+    size_t peakHeap;
+};
+
+// the old path: String copy of the body, unfiltered parse into a shared doc
+static Result BenchOld(const std::string& body, int rounds) {
+    Result r;
+    heapPeak = heapNow;
+    size_t base = heapNow;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rounds; i++) {
+        std::string result(body);
+        StaticJsonDocument<200> doc;
+        deserializeJson(doc, result.c_str());
+        const char* filename = doc["fileName"];
+        bool gotosleep = doc["gotoSleep"];
+        long secondsdelay = doc["secondsDelay"];
+        (void)filename;
+        (void)gotosleep;
+        (void)secondsdelay;
+    }
+    r.usPerParse = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rounds;
+    r.peakHeap = heapPeak - base;
+    return r;
+}
+
+// the new path: body in a fixed buffer, filtered parse in place
+static Result BenchNew(const std::string& body, bool device, int rounds, bool* ok) {
+    Result r;
+    heapPeak = heapNow;
+    size_t base = heapNow;
+    char buf[API_BODY_SIZE];
+    size_t len = body.size() < sizeof(buf) ? body.size() : sizeof(buf) - 1;
+    *ok = body.size() < sizeof(buf);
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < rounds; i++) {
+        // the parse works in place, so every round gets a fresh copy
+        memcpy(buf, body.data(), len);
+        if (device) {
+            DeviceInfo info;
+            DeserializationError err;
+            *ok &= ParseDeviceInfo(buf, len, &info, &err);
+        } else {
+            SlideShowStatus status;
+            *ok &= !ParseSlideShow(buf, len, &status);
+        }
+    }
+    r.usPerParse = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rounds;
+    r.peakHeap = heapPeak - base;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::pair<std::string, std::string> > inputs;
+    for (int i = 1; i < argc; i++) {
+        std::ifstream f(argv[i], std::ios::binary);
+        if (!f) {
+            fprintf(stderr, "cannot read %s\n", argv[i]);
+            return 1;
+        }
+        std::stringstream ss;
+        ss << f.rdbuf();
+        inputs.push_back(std::make_pair(std::string(argv[i]), ss.str()));
+    }
+    if (inputs.empty()) {
+        for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+            inputs.push_back(std::make_pair(std::string(samples[i][0]), std::string(samples[i][1])));
+        }
+    }
+
+    const int rounds = 20000;
+    printf("%-24s %6s  %12s %10s  %12s %10s\n", "answer", "bytes", "old us", "old heap", "new us", "new heap");
+    int failed = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        const std::string& body = inputs[i].second;
+        bool device = body.find("\"AccountID\"") != std::string::npos;
+        bool ok;
+        Result before = BenchOld(body, rounds);
+        Result after = BenchNew(body, device, rounds, &ok);
+        printf("%-24s %6zu  %12.2f %10zu  %12.2f %10zu%s\n", inputs[i].first.substr(0, 24).c_str(),
+               body.size(), before.usPerParse, before.peakHeap, after.usPerParse, after.peakHeap,
+               ok ? "" : "  PARSE FAILED");
+        failed += !ok;
+    }
+    printf("stack: %zu byte body buffer, %zu byte document\n", (size_t)API_BODY_SIZE,
+           sizeof(StaticJsonDocument<API_DOC_SIZE>));
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""
+blob_standin.py - local stand-in for a blob mirror, with slow links on tap
+
+Serves the slides of a directory the way the blob store does: ETag,
+If-None-Match, Range/If-Range and an optional Content-Encoding. Latency,
+bandwidth and failures are configurable, so two instances make a pair of
+mirrors to check how the WiFi sketch picks between them, e.g.
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 365 -subj /CN=standin \\
+        -keyout standin.key -out standin.crt
+    python3 tools/blob_standin.py slides --port 8443 --latency 400 --rate 40000
+    python3 tools/blob_standin.py slides --port 8444 --latency 60 --rate 200000
+
+and build the sketch with
+    -DBLOB_URL_PRIMARY='"https://<host>:8443/epaperfiles/"'
+    -DBLOB_URL_SECONDARY='"https://<host>:8444/epaperfiles/"'
+
+The device does not verify certificates, a self-signed one will do.
+--drop-after cuts every body after that many bytes, to exercise resumed
+downloads. With --diff a request naming a base frame (X-Epd-Base) gets
+a diff against it when one of the slides in the directory is that frame
+and the diff is smaller, see epd_diff.py.
+
+MIT License, Copyright (c) 2025 EpaperPix
+"""
+
+import argparse
+import hashlib
+import http.server
+import os
+import random
+import ssl
+import sys
+import time
+
+from epd_diff import ENCODING as DIFF_ENCODING, diff_encode, frame_crc
+
+PREFIX = "/epaperfiles/"
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"       # keep-alive, like the real store
+
+    def do_GET(self):
+        opts = self.server.opts
+        time.sleep(opts.latency / 1000.0)
+        if random.random() < opts.fail:
+            self.reply_empty(503)
+            return
+        name = self.path.split("?")[0]
+        if not name.startswith(PREFIX):
+            self.reply_empty(404)
+            return
+        path = os.path.join(opts.root, os.path.basename(name[len(PREFIX):]))
+        try:
+            with open(path, "rb") as f:
+                data = f.read()
+        except OSError:
+            self.reply_empty(404)
+            return
+
+        etag = '"%s"' % hashlib.sha1(data).hexdigest()[:16]
+        mtime = self.date_time_string(os.path.getmtime(path))
+        if self.headers.get("If-None-Match") == etag:
+            self.reply_empty(304, etag)
+            return
+
+        start = 0
+        rng = self.headers.get("Range", "")
+        if_range = self.headers.get("If-Range")
+        if rng.startswith("bytes=") and (if_range is None or if_range == etag):
+            start = int(rng[6:].split("-")[0] or 0)
+            if start >= len(data):
+                self.reply_empty(416, etag)
+                return
+        body = data[start:]
+        encoding = opts.encoding
+        if opts.diff and not start:
+            patch = self.diff_for(data)
+            if patch is not None and len(patch) < len(body):
+                body = patch
+                encoding = DIFF_ENCODING
+
+        self.send_response(206 if start else 200)
+        self.send_header("ETag", etag)
+        self.send_header("Last-Modified", mtime)
+        self.send_header("Content-Length", str(len(body)))
+        if start:
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, len(data) - 1, len(data)))
+        if encoding:
+            self.send_header("Content-Encoding", encoding)
+        self.end_headers()
+        self.send_slow(body)
+
+    def diff_for(self, data):
+        try:
+            crc = int(self.headers.get("X-Epd-Base", ""), 16)
+        except ValueError:
+            return None
+        for name in sorted(os.listdir(self.server.opts.root)):
+            path = os.path.join(self.server.opts.root, name)
+            if not os.path.isfile(path) or os.path.getsize(path) != len(data):
+                continue
+            with open(path, "rb") as f:
+                base = f.read()
+            if frame_crc(base) == crc:
+                sys.stderr.write("diff against %s\n" % name)
+                return diff_encode(base, data)
+        return None
+
+    def reply_empty(self, code, etag=None):
+        self.send_response(code)
+        if etag:
+            self.send_header("ETag", etag)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def send_slow(self, body):
+        opts = self.server.opts
+        limit = len(body) if opts.drop_after <= 0 else min(len(body), opts.drop_after)
+        chunk = 1024
+        sent = 0
+        begin = time.time()
+        while sent < limit:
+            n = min(chunk, limit - sent)
+            self.wfile.write(body[sent:sent + n])
+            self.wfile.flush()
+            sent += n
+            if opts.rate > 0:
+                # hold the average at --rate bytes per second
+                ahead = sent / opts.rate - (time.time() - begin)
+                if ahead > 0:
+                    time.sleep(ahead)
+        if limit < len(body):
+            self.close_connection = True
+            sys.stderr.write("dropped after %d of %d bytes\n" % (limit, len(body)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("root", help="directory with the slides")
+    ap.add_argument("--port", type=int, default=8443)
+    ap.add_argument("--cert", default="standin.crt")
+    ap.add_argument("--key", default="standin.key")
+    ap.add_argument("--latency", type=float, default=0, help="ms before each answer")
+    ap.add_argument("--rate", type=float, default=0, help="body bytes per second, 0 = unlimited")
+    ap.add_argument("--fail", type=float, default=0, help="share of requests answered with 503")
+    ap.add_argument("--drop-after", type=int, default=0, help="close the connection after this many body bytes")
+    ap.add_argument("--encoding", help="Content-Encoding to announce, e.g. x-epd-lz")
+    ap.add_argument("--diff", action="store_true", help="answer X-Epd-Base requests with a diff")
+    opts = ap.parse_args()
+
+    server = http.server.ThreadingHTTPServer(("", opts.port), Handler)
+    server.opts = opts
+    ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    ctx.load_cert_chain(opts.cert, opts.key)
+    server.socket = ctx.wrap_socket(server.socket, server_side=True)
+    print("serving %s on https://0.0.0.0:%d%s" % (opts.root, opts.port, PREFIX))
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,329 @@
+/**
+ *  @filename   :   dither_bench.cpp
+ *  @brief      :   Speed and accuracy of the on-device dithering engine
+ *
+ *  Runs Arduino/epd_epaperpix_wifi/dither.h on a PC over synthetic test
+ *  images for the colour panels and compares every frame with a float
+ *  reference of the same algorithm:
+ *
+ *    - blur error: the mean distance, per channel, of the 8x8 block means
+ *      of the dithered frame from those of the source, for the fixed
+ *      point engine and for the reference; the engine may not be more
+ *      than DITHER_TOLERANCE worse
+ *    - same: pixels with the same colour as in the reference. Error
+ *      diffusion drifts apart after the first difference of 1/16 level,
+ *      so only FS_SAME is asked of it, enough to catch a broken error
+ *      path; ordered dithering must match almost exactly
+ *    - the frame dithered by two threads, even and odd rows, must be the
+ *      same as from one
+ *
+ *      g++ -O2 -std=c++11 -pthread -IArduino/epd_epaperpix_wifi \
+ *          tools/dither_bench.cpp -o dither_bench
+ *      ./dither_bench [dir]
+ *
+ *  With a directory the source, engine and reference frames are written
+ *  there as PPM files. The exit code is 1 when a check fails.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+// a host may have fewer cores than threads, let the other one run
+#define DITHER_WAIT() std::this_thread::yield()
+#include "dither.h"
+
+// blur error the engine may add to the reference's, in levels of 255
+#define DITHER_TOLERANCE    0.25
+// share of pixels ordered dithering must have the same as the reference
+#define ORDERED_SAME        0.995
+// the same for error diffusion
+#define FS_SAME             0.30
+
+struct Panel {
+    const char* name;
+    int width;
+    int height;
+    const DitherPalette* palette;
+};
+
+static const Panel panels[] = {
+    { "epd7in3f 800x480", 800, 480, &ditherAcep },
+    { "epd4in01f 640x400", 640, 400, &ditherAcep },
+    { "epd7in3g 800x480", 800, 480, &ditherBwry },
+    { "epd2in66g 184x360", 184, 360, &ditherBwry },
+};
+
+struct Image {
+    const char* name;
+    int channels;
+    std::vector<uint8_t> pixels;
+};
+
+static uint8_t Clamp(double v) {
+    return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t)(v + 0.5));
+}
+
+static std::vector<Image> MakeImages(int w, int h) {
+    std::vector<Image> images;
+
+    // hue across, dark to light down
+    Image hues = { "hue sweep", 3, std::vector<uint8_t>(w * h * 3) };
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            double hue = 6.0 * x / w, light = (double)y / (h - 1);
+            double rgb[3];
+            for (int c = 0; c < 3; c++) {
+                double d = std::fabs(std::fmod(hue + 4 - 2 * c, 6.0) - 3) - 1;
+                d = d < 0 ? 0 : (d > 1 ? 1 : d);
+                rgb[c] = light < 0.5 ? d * light * 2 : d + (1 - d) * (light - 0.5) * 2;
+            }
+            for (int c = 0; c < 3; c++) {
+                hues.pixels[(y * w + x) * 3 + c] = Clamp(rgb[c] * 255);
+            }
+        }
+    }
+    images.push_back(hues);
+
+    Image ramp = { "gray ramp", 1, std::vector<uint8_t>(w * h) };
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            ramp.pixels[y * w + x] = Clamp(255.0 * x / (w - 1));
+        }
+    }
+    images.push_back(ramp);
+
+    // smooth shapes with sensor noise, close to a photo
+    Image photo = { "photo-like", 3, std::vector<uint8_t>(w * h * 3) };
+    srand(2025);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            double u = (double)x / w, v = (double)y / h;
+            double r = 128 + 90 * std::sin(6 * u + 2 * v) + 30 * std::sin(23 * u * v);
+            double g = 110 + 80 * std::cos(5 * v - 3 * u) + 25 * std::sin(17 * u);
+            double b = 100 + 100 * std::sin(4 * u * u + 7 * v);
+            double n = (rand() % 17) - 8;
+            uint8_t* p = &photo.pixels[(y * w + x) * 3];
+            p[0] = Clamp(r + n);
+            p[1] = Clamp(g + n);
+            p[2] = Clamp(b + n);
+        }
+    }
+    images.push_back(photo);
+    return images;
+}
+
+// the same algorithm in floats, one code per pixel
+static std::vector<uint8_t> Reference(const Panel& p, const Image& img, DitherMode mode) {
+    const DitherPalette& pal = *p.palette;
+    int w = p.width, h = p.height;
+    std::vector<uint8_t> codes(w * h);
+    std::vector<double> cur(w * 3, 0.0), next(w * 3, 0.0);
+    for (int y = 0; y < h; y++) {
+        double carry[3] = { 0, 0, 0 };
+        for (int x = 0; x < w; x++) {
+            double v[3];
+            for (int c = 0; c < 3; c++) {
+                double in = img.pixels[(y * w + x) * img.channels + (img.channels == 3 ? c : 0)];
+                if (mode == DITHER_FLOYD_STEINBERG) {
+                    in += cur[x * 3 + c] + carry[c];
+                } else {
+                    in += (2.0 * ditherBayer[y & 7][x & 7] + 1 - 64) * DITHER_ORDERED_SPREAD / 128;
+                }
+                v[c] = in < 0 ? 0 : (in > 255 ? 255 : in);
+            }
+            int best = 0;
+            double bestDist = 1e30;
+            for (int i = 0; i < pal.count; i++) {
+                double d = 0;
+                for (int c = 0; c < 3; c++) {
+                    d += (v[c] - pal.rgb[i][c]) * (v[c] - pal.rgb[i][c]);
+                }
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = i;
+                }
+            }
+            codes[y * w + x] = best;
+            if (mode == DITHER_FLOYD_STEINBERG) {
+                for (int c = 0; c < 3; c++) {
+                    double err = v[c] - pal.rgb[best][c];
+                    if (x > 0) {
+                        next[(x - 1) * 3 + c] += err * 3 / 16;
+                    }
+                    next[x * 3 + c] += err * 5 / 16;
+                    if (x + 1 < w) {
+                        next[(x + 1) * 3 + c] += err / 16;
+                    }
+                    carry[c] = err * 7 / 16;
+                }
+            }
+        }
+        cur.swap(next);
+        std::fill(next.begin(), next.end(), 0.0);
+    }
+    return codes;
+}
+
+static std::vector<uint8_t> Unpack(const Panel& p, const std::vector<uint8_t>& frame) {
+    int bpp = p.palette->bpp, ppb = 8 / bpp;
+    int rowBytes = (p.width * bpp + 7) / 8;
+    std::vector<uint8_t> codes(p.width * p.height);
+    for (int y = 0; y < p.height; y++) {
+        for (int x = 0; x < p.width; x++) {
+            int shift = (ppb - 1 - x % ppb) * bpp;
+            codes[y * p.width + x] = (frame[y * rowBytes + x / ppb] >> shift) & ((1 << bpp) - 1);
+        }
+    }
+    return codes;
+}
+
+static std::vector<uint8_t> Dither(const Panel& p, const Image& img, DitherMode mode, int threads, double* rowsPerSec) {
+    Ditherer d;
+    std::vector<int16_t> errors(Ditherer::ErrorSize(p.width));
+    d.Begin(*p.palette, p.width, img.channels, mode, errors.data());
+    unsigned long rowBytes = d.RowBytes();
+    std::vector<uint8_t> frame(rowBytes * p.height);
+    int stride = p.width * img.channels;
+    uint32_t progress[2] = { 0, 0 };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (threads == 1) {
+        for (int y = 0; y < p.height; y++) {
+            d.Row(y, &img.pixels[y * stride], &frame[y * rowBytes]);
+        }
+    } else {
+        // the sketch's split: the caller on even rows, a helper on odd ones
+        auto rows = [&](int first) {
+            for (int y = first; y < p.height; y += 2) {
+                d.Row(y, &img.pixels[y * stride], &frame[y * rowBytes], &progress[1 - first], &progress[first]);
+            }
+        };
+        std::thread helper(rows, 1);
+        rows(0);
+        helper.join();
+    }
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    *rowsPerSec = p.height / s;
+    return frame;
+}
+
+// mean over blocks and channels of |block mean of a - block mean of b|
+static double BlurError(const Panel& p, const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0;
+    int n = 0;
+    for (int by = 0; by + 8 <= p.height; by += 8) {
+        for (int bx = 0; bx + 8 <= p.width; bx += 8) {
+            for (int c = 0; c < 3; c++) {
+                double ma = 0, mb = 0;
+                for (int y = by; y < by + 8; y++) {
+                    for (int x = bx; x < bx + 8; x++) {
+                        ma += a[(y * p.width + x) * 3 + c];
+                        mb += b[(y * p.width + x) * 3 + c];
+                    }
+                }
+                sum += std::fabs(ma - mb) / 64;
+                n++;
+            }
+        }
+    }
+    return sum / n;
+}
+
+static std::vector<double> ToRgb(const Panel& p, const std::vector<uint8_t>& codes) {
+    std::vector<double> rgb(codes.size() * 3);
+    for (size_t i = 0; i < codes.size(); i++) {
+        for (int c = 0; c < 3; c++) {
+            rgb[i * 3 + c] = p.palette->rgb[codes[i]][c];
+        }
+    }
+    return rgb;
+}
+
+static void WritePpm(const std::string& path, int w, int h, const std::vector<double>& rgb) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == NULL) {
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", w, h);
+    for (double v : rgb) {
+        fputc(Clamp(v), f);
+    }
+    fclose(f);
+}
+
+int main(int argc, char** argv) {
+    const char* dir = argc > 1 ? argv[1] : NULL;
+    int failed = 0;
+    printf("%-18s %-12s %-8s %10s %10s %8s %8s %7s %s\n", "panel", "image", "mode", "rows/s", "2 threads",
+           "blur", "float", "same", "");
+    for (const Panel& p : panels) {
+        for (const Image& img : MakeImages(p.width, p.height)) {
+            std::vector<double> source(p.width * p.height * 3);
+            for (int i = 0; i < p.width * p.height; i++) {
+                for (int c = 0; c < 3; c++) {
+                    source[i * 3 + c] = img.pixels[i * img.channels + (img.channels == 3 ? c : 0)];
+                }
+            }
+            for (int m = 0; m < 2; m++) {
+                DitherMode mode = m == 0 ? DITHER_FLOYD_STEINBERG : DITHER_ORDERED;
+                double one, two;
+                std::vector<uint8_t> frame = Dither(p, img, mode, 1, &one);
+                std::vector<uint8_t> shared = Dither(p, img, mode, 2, &two);
+                std::vector<uint8_t> codes = Unpack(p, frame);
+                std::vector<uint8_t> ref = Reference(p, img, mode);
+                long same = 0;
+                for (size_t i = 0; i < codes.size(); i++) {
+                    same += codes[i] == ref[i];
+                }
+                double sameShare = (double)same / codes.size();
+                std::vector<double> rgb = ToRgb(p, codes), refRgb = ToRgb(p, ref);
+                double blur = BlurError(p, rgb, source), refBlur = BlurError(p, refRgb, source);
+
+                std::string problem;
+                if (shared != frame) {
+                    problem += " TWO THREADS DIFFER";
+                }
+                if (blur > refBlur + DITHER_TOLERANCE) {
+                    problem += " BLUR ERROR";
+                }
+                if (mode == DITHER_ORDERED && sameShare < ORDERED_SAME) {
+                    problem += " ORDERED MISMATCH";
+                }
+                if (mode == DITHER_FLOYD_STEINBERG && sameShare < FS_SAME) {
+                    problem += " FS MISMATCH";
+                }
+                failed += !problem.empty();
+                printf("%-18s %-12s %-8s %10.0f %10.0f %8.2f %8.2f %6.2f%%%s\n", p.name, img.name,
+                       m == 0 ? "FS" : "ordered", one, two, blur, refBlur, 100.0 * sameShare, problem.c_str());
+
+                if (dir != NULL) {
+                    // e.g. epd7in3f_hue_sweep_fs.ppm
+                    std::string stem = std::string(dir) + "/" + std::string(p.name, strchr(p.name, ' ') - p.name) + "_" +
+                                       img.name;
+                    for (size_t i = strlen(dir) + 1; i < stem.size(); i++) {
+                        stem[i] = stem[i] == ' ' ? '_' : stem[i];
+                    }
+                    if (m == 0) {
+                        WritePpm(stem + "_source.ppm", p.width, p.height, source);
+                    }
+                    stem += m == 0 ? "_fs" : "_ordered";
+                    WritePpm(stem + ".ppm", p.width, p.height, rgb);
+                    WritePpm(stem + "_float.ppm", p.width, p.height, refRgb);
+                }
+            }
+        }
+    }
+    if (failed) {
+        printf("%d frames failed a check\n", failed);
+    }
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+epd_diff.py - diff updates of panel-native slides for the WiFi sketch
+
+The sketch keeps the frame on the panel in flash and names it by CRC32 in
+the X-Epd-Base request header. A server that still has that frame may
+answer with a diff against it, Content-Encoding x-epd-diff (see
+slide_codec.h and frame_store.h):
+
+    "EPDF", CRC32 of the base (little endian), then ops
+    0x00 n          copy the next n bytes of the base
+    0x01 n bytes    n new bytes, replacing the next n of the base
+
+n is a LEB128 varint. Frames of a slideshow have the same size, so the
+ops walk base and new frame side by side.
+
+    python3 tools/epd_diff.py diff old.bin new.bin -o new.epd
+    python3 tools/epd_diff.py apply old.bin new.epd -o check.bin
+
+The bench command takes a slide sequence in display order, diffs every
+slide against the one before and compares with a full download, raw and
+compressed:
+
+    python3 tools/epd_diff.py bench dashboard/*.bin
+
+MIT License, Copyright (c) 2025 EpaperPix
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+from epd_pack import lz_encode
+
+MAGIC = b"EPDF"
+OP_COPY = 0x00
+OP_LITERAL = 0x01
+# unchanged bytes shorter than this stay inside a literal, a copy op and
+# the next literal header would cost as much
+MIN_COPY = 4
+
+ENCODING = "x-epd-diff"
+
+
+def frame_crc(data):
+    # zlib's CRC32 is the one esp_rom_crc32_le(0, ...) computes
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def put_varint(out, n):
+    while n >= 0x80:
+        out.append((n & 0x7F) | 0x80)
+        n >>= 7
+    out.append(n)
+
+
+def get_varint(data, i):
+    n, shift = 0, 0
+    while True:
+        b = data[i]
+        i += 1
+        n |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return n, i
+
+
+def diff_encode(base, data):
+    if len(base) != len(data):
+        raise ValueError("frames differ in size: %d and %d" % (len(base), len(data)))
+    out = bytearray(MAGIC + struct.pack("<I", frame_crc(base)))
+    n = len(data)
+    i = 0
+    while i < n:
+        j = i
+        while j < n and base[j] == data[j]:
+            j += 1
+        if j > i:
+            out.append(OP_COPY)
+            put_varint(out, j - i)
+        if j == n:
+            break
+        # the literal ends at the first unchanged run worth a copy
+        k = j
+        while k < n:
+            if base[k] != data[k]:
+                k += 1
+                continue
+            e = k
+            while e < n and base[e] == data[e] and e - k < MIN_COPY:
+                e += 1
+            if e - k >= MIN_COPY or e == n:
+                break
+            k = e
+        out.append(OP_LITERAL)
+        put_varint(out, k - j)
+        out += data[j:k]
+        i = k
+    return bytes(out)
+
+
+def diff_apply(base, patch):
+    if patch[:4] != MAGIC:
+        raise ValueError("not a diff")
+    crc = struct.unpack("<I", patch[4:8])[0]
+    if crc != frame_crc(base):
+        raise ValueError("diff is for base %08x, not %08x" % (crc, frame_crc(base)))
+    out = bytearray()
+    i = 8
+    while i < len(patch):
+        op = patch[i]
+        n, i = get_varint(patch, i + 1)
+        pos = len(out)
+        if op == OP_COPY:
+            out += base[pos:pos + n]
+        elif op == OP_LITERAL:
+            out += patch[i:i + n]
+            i += n
+        else:
+            raise ValueError("bad op %02x at %d" % (op, i))
+    if len(out) != len(base):
+        raise ValueError("diff covers %d of %d bytes" % (len(out), len(base)))
+    return bytes(out)
+
+
+def read(path):
+    if path == "-":
+        return sys.stdin.buffer.read()
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def write(path, data):
+    if path:
+        with open(path, "wb") as f:
+            f.write(data)
+    else:
+        sys.stdout.buffer.write(data)
+
+
+def cmd_diff(args):
+    base = read(args.base)
+    data = read(args.input)
+    patch = diff_encode(base, data)
+    write(args.output, patch)
+    sys.stderr.write("%d -> %d bytes against base %08x, Content-Encoding: %s\n"
+                     % (len(data), len(patch), frame_crc(base), ENCODING))
+
+
+def cmd_apply(args):
+    write(args.output, diff_apply(read(args.base), read(args.input)))
+
+
+def cmd_bench(args):
+    frames = [read(path) for path in args.files]
+    print("%-32s %8s %8s %8s %8s %7s %9s"
+          % ("slide", "raw", "changed", "lz", "diff", "saved", "encode"))
+    failed = False
+    total_raw = total_lz = total_diff = 0
+    for k in range(1, len(frames)):
+        base, data = frames[k - 1], frames[k]
+        name = args.files[k][-32:]
+        if len(base) != len(data):
+            print("%-32s size differs from the slide before, skipped" % name)
+            continue
+        changed = sum(1 for a, b in zip(base, data) if a != b)
+        packed = len(lz_encode(data))
+        start = time.time()
+        patch = diff_encode(base, data)
+        elapsed = time.time() - start
+        ok = diff_apply(base, patch) == data
+        failed |= not ok
+        # the server picks whichever body is smaller
+        best = min(len(patch), packed, len(data))
+        total_raw += len(data)
+        total_lz += min(packed, len(data))
+        total_diff += best
+        print("%-32s %8d %8d %8d %8d %6.1f%% %6.0f ms%s"
+              % (name, len(data), changed, packed, len(patch),
+                 100.0 * (1 - best / max(1, min(packed, len(data)))), elapsed * 1000,
+                 "" if ok else "  ROUND TRIP FAILED"))
+    if total_raw:
+        print("sequence: %d raw, %d compressed, %d with diffs (%.1fx less than compressed)"
+              % (total_raw, total_lz, total_diff, total_lz / max(1, total_diff)))
+    if failed:
+        sys.exit(1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    sub = ap.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("diff", help="diff a slide against the one on the panel")
+    p.add_argument("base", help="raw panel bytes the device has")
+    p.add_argument("input", help="raw panel bytes of the new slide, - for stdin")
+    p.add_argument("-o", "--output", help="file to write (default stdout)")
+    p.set_defaults(func=cmd_diff)
+
+    p = sub.add_parser("apply", help="apply a diff the way the device does")
+    p.add_argument("base", help="raw panel bytes the diff was made against")
+    p.add_argument("input", help="diff, - for stdin")
+    p.add_argument("-o", "--output", help="file to write (default stdout)")
+    p.set_defaults(func=cmd_apply)
+
+    p = sub.add_parser("bench", help="diff sizes along a slide sequence, with a round trip check")
+    p.add_argument("files", nargs="+", help="raw slides in display order")
+    p.set_defaults(func=cmd_bench)
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+"""
+epd_pack.py - compress panel-native slides for the WiFi sketch
+
+The sketch decodes a slide on the fly when its blob is served with
+Content-Encoding x-epd-packbits or x-epd-lz (see slide_codec.h). Encode a
+raw slide, the same bytes the panel gets, and store it with the matching
+Content-Encoding, e.g.
+
+    python3 tools/epd_pack.py encode slide.bin -o slide.epz --codec lz
+    az storage blob upload -f slide.epz -n slide.bin -c epaperfiles \\
+        --content-encoding x-epd-lz
+
+The bench command compares both codecs on a set of slides and checks that
+every file decodes back to the original:
+
+    python3 tools/epd_pack.py bench slides/*.bin
+
+MIT License, Copyright (c) 2025 EpaperPix
+"""
+
+import argparse
+import sys
+import time
+
+LZ_WINDOW = 4096        # SLIDE_LZ_WINDOW
+LZ_MIN_MATCH = 4        # SLIDE_LZ_MIN_MATCH
+LZ_MAX_MATCH = 0x7F + LZ_MIN_MATCH
+MAX_LITERAL = 128
+
+ENCODINGS = {"packbits": "x-epd-packbits", "lz": "x-epd-lz"}
+
+
+def packbits_encode(data):
+    out = bytearray()
+    i, n = 0, len(data)
+    lit_start = 0
+    while i < n:
+        run = 1
+        while i + run < n and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 3:
+            flush_literals(out, data, lit_start, i)
+            out += bytes((257 - run, data[i]))
+            i += run
+            lit_start = i
+        else:
+            i += run
+    flush_literals(out, data, lit_start, n)
+    return bytes(out)
+
+
+def flush_literals(out, data, start, end):
+    # PackBits and LZ both use c = count - 1 for up to 128 literals
+    while start < end:
+        count = min(MAX_LITERAL, end - start)
+        out.append(count - 1)
+        out += data[start:start + count]
+        start += count
+
+
+def packbits_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        c = data[i]
+        i += 1
+        if c < 0x80:
+            out += data[i:i + c + 1]
+            i += c + 1
+        elif c > 0x80:
+            out += bytes((data[i],)) * (257 - c)
+            i += 1
+    return bytes(out)
+
+
+def lz_encode(data, chain=32):
+    """Greedy LZ77 with hash chains over 4 byte prefixes."""
+    out = bytearray()
+    n = len(data)
+    head = {}
+    prev = [-1] * n
+    i = 0
+    lit_start = 0
+
+    def insert(p):
+        if p + LZ_MIN_MATCH <= n:
+            key = data[p:p + LZ_MIN_MATCH]
+            prev[p] = head.get(key, -1)
+            head[key] = p
+
+    while i < n:
+        best_len, best_off = 0, 0
+        if i + LZ_MIN_MATCH <= n:
+            cand = head.get(data[i:i + LZ_MIN_MATCH], -1)
+            tries = chain
+            limit = min(LZ_MAX_MATCH, n - i)
+            while cand >= 0 and i - cand <= LZ_WINDOW and tries > 0:
+                length = 0
+                while length < limit and data[cand + length] == data[i + length]:
+                    length += 1
+                if length > best_len:
+                    best_len, best_off = length, i - cand
+                    if length == limit:
+                        break
+                cand = prev[cand]
+                tries -= 1
+        if best_len >= LZ_MIN_MATCH:
+            flush_literals(out, data, lit_start, i)
+            off = best_off - 1
+            out += bytes((0x80 | (best_len - LZ_MIN_MATCH), off & 0xFF, off >> 8))
+            for p in range(i, i + best_len):
+                insert(p)
+            i += best_len
+            lit_start = i
+        else:
+            insert(i)
+            i += 1
+    flush_literals(out, data, lit_start, n)
+    return bytes(out)
+
+
+def lz_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        c = data[i]
+        i += 1
+        if c < 0x80:
+            out += data[i:i + c + 1]
+            i += c + 1
+        else:
+            length = (c & 0x7F) + LZ_MIN_MATCH
+            off = data[i] | (data[i + 1] << 8)
+            i += 2
+            start = len(out) - off - 1
+            for k in range(length):
+                out.append(out[start + k])
+    return bytes(out)
+
+
+CODECS = {
+    "packbits": (packbits_encode, packbits_decode),
+    "lz": (lz_encode, lz_decode),
+}
+
+
+def read(path):
+    if path == "-":
+        return sys.stdin.buffer.read()
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def cmd_encode(args):
+    data = read(args.input)
+    packed = CODECS[args.codec][0](data)
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(packed)
+    else:
+        sys.stdout.buffer.write(packed)
+    sys.stderr.write("%d -> %d bytes (%.1fx), Content-Encoding: %s\n"
+                     % (len(data), len(packed), len(data) / max(1, len(packed)),
+                        ENCODINGS[args.codec]))
+
+
+def cmd_decode(args):
+    data = CODECS[args.codec][1](read(args.input))
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(data)
+    else:
+        sys.stdout.buffer.write(data)
+
+
+def cmd_bench(args):
+    print("%-32s %8s  %-9s %8s %7s %9s" % ("file", "raw", "codec", "packed", "ratio", "encode"))
+    failed = False
+    for path in args.files:
+        data = read(path)
+        for name, (enc, dec) in CODECS.items():
+            start = time.time()
+            packed = enc(data)
+            elapsed = time.time() - start
+            ok = dec(packed) == data
+            failed |= not ok
+            print("%-32s %8d  %-9s %8d %6.1fx %7.0f ms%s"
+                  % (path[-32:], len(data), name, len(packed),
+                     len(data) / max(1, len(packed)), elapsed * 1000,
+                     "" if ok else "  ROUND TRIP FAILED"))
+    print("decode time on the device is logged after each download")
+    if failed:
+        sys.exit(1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    sub = ap.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("encode", help="compress a raw slide")
+    p.add_argument("input", help="raw panel bytes, - for stdin")
+    p.add_argument("-o", "--output", help="file to write (default stdout)")
+    p.add_argument("--codec", choices=CODECS, default="lz")
+    p.set_defaults(func=cmd_encode)
+
+    p = sub.add_parser("decode", help="expand a compressed slide")
+    p.add_argument("input", help="compressed slide, - for stdin")
+    p.add_argument("-o", "--output", help="file to write (default stdout)")
+    p.add_argument("--codec", choices=CODECS, default="lz")
+    p.set_defaults(func=cmd_decode)
+
+    p = sub.add_parser("bench", help="ratio of both codecs, with a round trip check")
+    p.add_argument("files", nargs="+", help="raw slides")
+    p.set_defaults(func=cmd_bench)
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
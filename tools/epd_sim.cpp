@@ -0,0 +1,788 @@
+/**
+ *  @filename   :   epd_sim.cpp
+ *  @brief      :   Host simulator of the panel controllers: runs a driver
+ *                  on the simulated bus, rebuilds the controller RAM from
+ *                  the SPI stream and writes what a refresh shows to a PNG
+ *
+ *  Links the real epdif.cpp, epd_common.cpp, qrset.cpp, framebuffer.cpp
+ *  and one driver against tools/host. The controller is picked from the driver's data
+ *  commands and pixel format:
+ *
+ *      SSD168x     0x24/0x26 RAM with the 0x11 entry mode, 0x44/0x45 X/Y
+ *                  window and 0x4E/0x4F counters; 0x20 refreshes
+ *      UC81xx      1 bpp 0x10/0x13 planes, 0x90/0x91/0x92 partial window,
+ *                  0x61 resolution; 0x12 refreshes
+ *      packed      0x10 plane of 2 bpp (black, white, yellow, red) or
+ *                  4 bpp ACeP pixels, as dither.h packs them; 0x12 refreshes.
+ *                  epd7in5's 2 bpp codes are drawn in the same colours.
+ *
+ *  A frame (a file of steps * blockSize panel bytes, or a test pattern) is
+ *  uploaded the way DownloadAndDisplay() does it and refreshed. Optionally
+ *  the upload is cut and continued with ResumeStep(), and a window is then
+ *  rewritten inverted through SetWindow() and refreshed again. With -f a
+ *  block is inverted in the next frame instead, which goes through
+ *  FrameBuffer::Update() and Refresh() as a FRAME_BUFFER download does;
+ *  the frame shown so far is its FrameLoad, and the step the frame
+ *  buffer does not draw (the 7.5" V2 old data) is not compared. The RAM
+ *  must end up holding exactly the bytes sent, in the order they stream;
+ *  any difference, a write outside the RAM or a RAM origin that is not
+ *  the driver's ramYStart/ramYDown fails the run.
+ *
+ *  The PNG follows the repo's convention, which QRset() and FrameBuffer
+ *  use too: a 1 bpp bit of 1 is white, and 0xFF is a blank second plane,
+ *  so a 0 bit there is red. Waveforms are not simulated, and BUSY reads
+ *  alternate so every wait ends at once. Time is the simulated bus time:
+ *  bytes at the SPI clock, plus the drivers' delays.
+ *
+ *      g++ -O2 -std=c++11 -DSIM_FRAME_BUFFER -Itools/host -IArduino/epd_epaperpix_wifi \
+ *          tools/epd_sim.cpp tools/host/host_bus.cpp \
+ *          Arduino/epd_epaperpix_wifi/epdif.cpp Arduino/epd_epaperpix_wifi/epd_common.cpp \
+ *          Arduino/epd_epaperpix_wifi/qrset.cpp Arduino/epd_epaperpix_wifi/framebuffer.cpp \
+ *          Arduino/epd_epaperpix_wifi/epd7in5_V2.cpp -lz -o epd_sim
+ *      ./epd_sim [-o panel.png] [-i frame.bin] [-c SPI clock Hz] [-q QR scale]
+ *                [-r resume offset] [-w col,row,cols,rows] [-f col,row,cols,rows]
+ *
+ *  For another panel add -DEPD7IN5_V2_C and its own macro and file, as in
+ *  spi_burst_bench.cpp; leave qrset.cpp out for epd4in01f, which includes
+ *  it. For Arduino/epd_serial put its folder first and keep the wifi one
+ *  after it for dither.h, and leave -DSIM_FRAME_BUFFER and
+ *  framebuffer.cpp out, which takes -f away. -w and
+ *  -f are in bytes and rows, like Epd::SetWindow(). The exit code is 1
+ *  when a check fails and 2 for a controller the simulator has no model of.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+#include "host_bus.h"
+#include "epd_base.h"
+#include "dither.h"
+#ifdef SIM_FRAME_BUFFER
+#include "framebuffer.h"
+#endif
+
+#define SIM_PLANES  3
+#define SIM_ARGS    16
+
+enum SimFamily { SIM_SSD168X, SIM_UC81XX, SIM_PACKED };
+
+static const char* const familyNames[] = { "SSD168x", "UC81xx", "packed" };
+
+static int failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("  FAILED line %d: %s\n", __LINE__, #cond); \
+            failed++; \
+        } \
+    } while (0)
+
+class SimController {
+public:
+    SimFamily family;
+    int bpp;
+    unsigned long width;
+    unsigned long height;
+    unsigned long rowBytes;
+    int planes;                         // shown planes are the first steps ones
+    uint8_t planeCmd[SIM_PLANES];
+    std::vector<uint8_t> ram[SIM_PLANES];
+    std::vector<uint8_t> shown[SIM_PLANES];   // RAM at the last refresh
+    unsigned long refreshes;
+    unsigned long partialRefreshes;
+    unsigned long written;              // RAM bytes sent
+    unsigned long outside;              // of them, the ones that fell outside the RAM
+    unsigned long tresWidth;            // 0x61, 0 when not sent
+    unsigned long tresHeight;
+    unsigned long gates;                // SSD168x 0x01, 0 when not sent
+
+    // SSD168x counters and window, RAM origin of the first write after reset
+    int x, y, xStart, xEnd, yStart, yEnd;
+    uint8_t entry;
+    bool originSet;
+    int xOrigin, yOrigin;
+    bool xDown, yDown;
+    // UC81xx partial window, in bytes and rows
+    bool partialIn;
+    unsigned long winCol, winRow, winCols, winRows;
+
+    bool Begin(const Epd& epd, int bitsPerPixel);
+    uint8_t View(const std::vector<uint8_t>* from, int plane, unsigned long row, unsigned long col) const;
+    void Render(std::vector<uint8_t>& rgb) const;
+    static void OnByte(uint8_t data, bool dc, void* arg);
+
+private:
+    uint8_t cmd;
+    int plane;                          // RAM the current command writes, -1 for none
+    uint8_t args[SIM_ARGS];
+    unsigned long argc;
+    unsigned long pos;                  // UC81xx: bytes into the plane or window
+
+    void Command(uint8_t c);
+    void Data(uint8_t d);
+    void Arg(uint8_t d);
+    void SsdReset(void);
+    void SsdWrite(uint8_t d);
+    void UcWrite(uint8_t d);
+    void Refresh(void);
+};
+
+bool SimController::Begin(const Epd& epd, int bitsPerPixel) {
+    bpp = bitsPerPixel;
+    width = epd.width;
+    height = epd.height;
+    rowBytes = (width * bpp + 7) / 8;
+    planes = epd.steps;
+    if (bpp == 1 && epd.stepCommands[0] == 0x24) {
+        family = SIM_SSD168X;
+    } else if (bpp == 1) {
+        family = SIM_UC81XX;
+    } else if (bpp == 2 || bpp == 4) {
+        family = SIM_PACKED;
+    } else {
+        printf("no model for %d bits per pixel\n", bpp);
+        return false;
+    }
+    for (int i = 0; i < epd.steps; i++) {
+        planeCmd[i] = epd.stepCommands[i];
+    }
+    // the RAM a partial refresh compares with takes data but is not shown
+    int hidden = epd.steps;
+    if (epd.previousRam != 0 && epd.previousRam != planeCmd[0] && epd.steps < SIM_PLANES) {
+        planeCmd[hidden++] = epd.previousRam;
+    }
+    for (int i = 0; i < hidden; i++) {
+        uint8_t c = planeCmd[i];
+        bool known = family == SIM_SSD168X ? (c == 0x24 || c == 0x26) :
+                     family == SIM_UC81XX ? (c == 0x10 || c == 0x13) : c == 0x10;
+        if (!known) {
+            printf("no model for data command 0x%02X on a %s controller\n", c, familyNames[family]);
+            return false;
+        }
+        // power-on RAM is taken as blank
+        ram[i].assign(rowBytes * height, 0xFF);
+    }
+    for (int i = hidden; i < SIM_PLANES; i++) {
+        ram[i].clear();
+    }
+    refreshes = 0;
+    partialRefreshes = 0;
+    written = 0;
+    outside = 0;
+    tresWidth = 0;
+    tresHeight = 0;
+    gates = 0;
+    partialIn = false;
+    winCol = winRow = winCols = winRows = 0;
+    cmd = 0;
+    plane = -1;
+    argc = 0;
+    pos = 0;
+    SsdReset();
+    return true;
+}
+
+void SimController::SsdReset(void) {
+    entry = 0x03;
+    xStart = 0;
+    xEnd = rowBytes - 1;
+    yStart = 0;
+    yEnd = height - 1;
+    x = 0;
+    y = 0;
+    originSet = false;
+}
+
+void SimController::OnByte(uint8_t data, bool dc, void* arg) {
+    SimController* sim = (SimController*)arg;
+    if (dc) {
+        sim->Data(data);
+    } else {
+        sim->Command(data);
+    }
+}
+
+void SimController::Command(uint8_t c) {
+    cmd = c;
+    argc = 0;
+    pos = 0;
+    plane = -1;
+    for (int i = 0; i < SIM_PLANES && !ram[i].empty(); i++) {
+        if (planeCmd[i] == c) {
+            plane = i;
+        }
+    }
+    if (plane >= 0) {
+        return;
+    }
+    if (family == SIM_SSD168X) {
+        if (c == 0x12) {
+            SsdReset();
+        } else if (c == 0x20) {
+            Refresh();
+        }
+    } else {
+        if (c == 0x12) {
+            Refresh();
+        } else if (c == 0x91) {
+            partialIn = true;
+        } else if (c == 0x92) {
+            partialIn = false;
+        }
+    }
+}
+
+void SimController::Data(uint8_t d) {
+    if (plane < 0) {
+        Arg(d);
+        return;
+    }
+    written++;
+    if (family == SIM_SSD168X) {
+        SsdWrite(d);
+    } else {
+        UcWrite(d);
+    }
+}
+
+// register data, applied as soon as enough of it has come
+void SimController::Arg(uint8_t d) {
+    if (argc < SIM_ARGS) {
+        args[argc] = d;
+    }
+    argc++;
+    if (family == SIM_SSD168X) {
+        switch (cmd) {
+        case 0x01:      // driver output control: gates - 1
+            if (argc == 2) {
+                gates = (args[0] | (args[1] << 8)) + 1;
+            }
+            break;
+        case 0x11:      // data entry mode
+            if (argc == 1) {
+                entry = args[0];
+            }
+            break;
+        case 0x44:      // X window in bytes, one byte each or 16-bit pairs
+            if (argc == 2) {
+                xStart = args[0];
+                xEnd = args[1];
+            } else if (argc == 4) {
+                xStart = args[0] | (args[1] << 8);
+                xEnd = args[2] | (args[3] << 8);
+            }
+            break;
+        case 0x45:      // Y window
+            if (argc == 4) {
+                yStart = args[0] | (args[1] << 8);
+                yEnd = args[2] | (args[3] << 8);
+            }
+            break;
+        case 0x4E:
+            if (argc == 1) {
+                x = args[0];
+            } else if (argc == 2) {
+                x = args[0] | (args[1] << 8);
+            }
+            break;
+        case 0x4F:
+            if (argc == 2) {
+                y = args[0] | (args[1] << 8);
+            }
+            break;
+        }
+        return;
+    }
+    switch (cmd) {
+    case 0x61:          // resolution: 8-bit width and 16-bit height, or both 16-bit
+        if (argc == 3) {
+            tresWidth = args[0];
+            tresHeight = (args[1] << 8) | args[2];
+        } else if (argc == 4) {
+            tresWidth = (args[0] << 8) | args[1];
+            tresHeight = (args[2] << 8) | args[3];
+        }
+        break;
+    case 0x90:          // partial window: HRST, HRED, VRST, VRED in pixels
+        if (argc == 8) {
+            unsigned long x0 = ((args[0] & 0x03) << 8) | args[1];
+            unsigned long x1 = ((args[2] & 0x03) << 8) | args[3];
+            unsigned long y0 = ((args[4] & 0x03) << 8) | args[5];
+            unsigned long y1 = ((args[6] & 0x03) << 8) | args[7];
+            winCol = x0 / 8;
+            winCols = x1 >= x0 ? x1 / 8 - winCol + 1 : 0;
+            winRow = y0;
+            winRows = y1 >= y0 ? y1 - y0 + 1 : 0;
+        }
+        break;
+    }
+}
+
+void SimController::SsdWrite(uint8_t d) {
+    if (!originSet) {
+        originSet = true;
+        xOrigin = x;
+        yOrigin = y;
+        xDown = !(entry & 0x01);
+        yDown = !(entry & 0x02);
+    }
+    if (x >= 0 && y >= 0 && (unsigned long)x < rowBytes && (unsigned long)y < height) {
+        ram[plane][y * rowBytes + x] = d;
+    } else {
+        outside++;
+    }
+    // the counter runs from start to end, then wraps and steps the other one
+    int dx = entry & 0x01 ? 1 : -1;
+    int dy = entry & 0x02 ? 1 : -1;
+    if (!(entry & 0x04)) {
+        if (x == xEnd) {
+            x = xStart;
+            y = y == yEnd ? yStart : y + dy;
+        } else {
+            x += dx;
+        }
+    } else {
+        if (y == yEnd) {
+            y = yStart;
+            x = x == xEnd ? xStart : x + dx;
+        } else {
+            y += dy;
+        }
+    }
+}
+
+void SimController::UcWrite(uint8_t d) {
+    unsigned long row, col;
+    if (partialIn && family == SIM_UC81XX) {
+        if (winCols == 0 || pos >= winCols * winRows) {
+            outside++;
+            return;
+        }
+        row = winRow + pos / winCols;
+        col = winCol + pos % winCols;
+    } else {
+        row = pos / rowBytes;
+        col = pos % rowBytes;
+    }
+    pos++;
+    if (row < height && col < rowBytes) {
+        ram[plane][row * rowBytes + col] = d;
+    } else {
+        outside++;
+    }
+}
+
+void SimController::Refresh(void) {
+    refreshes++;
+    if (partialIn) {
+        partialRefreshes++;
+    }
+    for (int i = 0; i < SIM_PLANES; i++) {
+        shown[i] = ram[i];
+    }
+}
+
+// byte col of row in the order the image streams
+uint8_t SimController::View(const std::vector<uint8_t>* from, int p, unsigned long row, unsigned long col) const {
+    const std::vector<uint8_t>& r = from[p];
+    if (family != SIM_SSD168X) {
+        return r.empty() ? 0xFF : r[row * rowBytes + col];
+    }
+    long rx = xDown ? xOrigin - (long)col : xOrigin + (long)col;
+    long ry = yDown ? yOrigin - (long)row : yOrigin + (long)row;
+    if (r.empty() || rx < 0 || ry < 0 || (unsigned long)rx >= rowBytes || (unsigned long)ry >= height) {
+        return 0xFF;
+    }
+    return r[ry * rowBytes + rx];
+}
+
+void SimController::Render(std::vector<uint8_t>& rgb) const {
+    static const uint8_t white[3] = { 255, 255, 255 };
+    static const uint8_t black[3] = { 0, 0, 0 };
+    static const uint8_t red[3] = { 255, 0, 0 };
+    static const uint8_t gray[3] = { 128, 128, 128 };
+    const DitherPalette& pal = bpp == 4 ? ditherAcep : ditherBwry;
+    int ppb = 8 / bpp;
+    rgb.resize(width * height * 3);
+    for (unsigned long row = 0; row < height; row++) {
+        for (unsigned long px = 0; px < width; px++) {
+            const uint8_t* c;
+            int shift = 8 - bpp * (px % ppb + 1);
+            if (bpp == 1) {
+                bool on = (View(shown, 0, row, px / 8) >> shift) & 1;
+                c = on ? white : black;
+                if (planes > 1 && !((View(shown, 1, row, px / 8) >> shift) & 1)) {
+                    c = red;
+                }
+            } else {
+                int idx = (View(shown, 0, row, px / ppb) >> shift) & ((1 << bpp) - 1);
+                c = idx < pal.count ? pal.rgb[idx] : gray;
+            }
+            memcpy(&rgb[(row * width + px) * 3], c, 3);
+        }
+    }
+}
+
+static void PutBe32(std::vector<uint8_t>& out, uint32_t v) {
+    out.push_back(v >> 24);
+    out.push_back(v >> 16);
+    out.push_back(v >> 8);
+    out.push_back(v);
+}
+
+static void PutChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    PutBe32(out, data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    PutBe32(out, crc32(0, &out[start], out.size() - start));
+}
+
+// 8-bit RGB, no filtering
+static bool WritePng(const char* path, unsigned long w, unsigned long h, const std::vector<uint8_t>& rgb) {
+    std::vector<uint8_t> raw;
+    raw.reserve(h * (w * 3 + 1));
+    for (unsigned long row = 0; row < h; row++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb.begin() + row * w * 3, rgb.begin() + (row + 1) * w * 3);
+    }
+    uLongf packedSize = compressBound(raw.size());
+    std::vector<uint8_t> packed(packedSize);
+    if (compress2(&packed[0], &packedSize, &raw[0], raw.size(), 9) != Z_OK) {
+        return false;
+    }
+    packed.resize(packedSize);
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> png(signature, signature + 8);
+    std::vector<uint8_t> header;
+    PutBe32(header, w);
+    PutBe32(header, h);
+    header.push_back(8);    // bit depth
+    header.push_back(2);    // RGB
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    PutChunk(png, "IHDR", header);
+    PutChunk(png, "IDAT", packed);
+    PutChunk(png, "IEND", std::vector<uint8_t>());
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return false;
+    }
+    bool ok = fwrite(&png[0], 1, png.size(), f) == png.size();
+    return fclose(f) == 0 && ok;
+}
+
+// colour bands across and down, every colour of the format, so a shifted
+// or turned plane shows
+static void Pattern(const Epd& epd, int bpp, std::vector<uint8_t>& frame) {
+    unsigned long rowBytes = epd.blockSize / epd.height;
+    int colours = bpp == 1 ? 2 : bpp == 2 ? ditherBwry.count : ditherAcep.count;
+    frame.assign(epd.steps * epd.blockSize, 0);
+    for (unsigned long row = 0; row < epd.height; row++) {
+        for (unsigned long px = 0; px < rowBytes * 8 / bpp; px++) {
+            unsigned long band = px * 8 / epd.width + row * 4 / epd.height;
+            int shift = 8 - bpp * (px % (8 / bpp) + 1);
+            unsigned long at = row * rowBytes + px * bpp / 8;
+            if (bpp == 1) {
+                frame[at] |= (band % colours != 0) << shift;
+                if (epd.steps > 1) {
+                    // red bands where the first plane is white
+                    frame[epd.blockSize + at] |= (band % 3 != 2) << shift;
+                }
+            } else {
+                frame[at] |= (band % colours) << shift;
+            }
+        }
+    }
+}
+
+static void Upload(Epd& epd, const uint8_t* data, unsigned long from, unsigned long to) {
+    for (unsigned long i = from; i < to; i += epd.streamBufferSize) {
+        epd.SendBuffer((unsigned char*)data + i, (int)min(epd.streamBufferSize, to - i));
+    }
+    epd.WaitBuffer();
+}
+
+#ifdef SIM_FRAME_BUFFER
+struct Shown {
+    std::vector<uint8_t> frame;         // what the panel shows, FrameStore on the device
+    unsigned long blockSize;
+};
+
+static bool LoadShown(int step, unsigned long offset, uint8_t* dst, size_t len, void* arg) {
+    const Shown* shown = (const Shown*)arg;
+    memcpy(dst, &shown->frame[step * shown->blockSize + offset], len);
+    return true;
+}
+#endif
+
+static void Usage(void) {
+    printf("usage: epd_sim [-o panel.png] [-i frame.bin] [-c SPI clock Hz] [-q QR scale]\n"
+           "               [-r resume offset] [-w col,row,cols,rows] [-f col,row,cols,rows]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* out = "epd_sim.png";
+    const char* in = NULL;
+    unsigned long clock = 0;
+    int qrScale = 0;
+    long cut = -1;
+    bool window = false;
+    unsigned long winCol = 0, winRow = 0, winCols = 0, winRows = 0;
+    bool update = false;
+    unsigned long fbCol = 0, fbRow = 0, fbCols = 0, fbRows = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:i:c:q:r:w:f:h")) != -1) {
+        switch (opt) {
+        case 'o': out = optarg; break;
+        case 'i': in = optarg; break;
+        case 'c': clock = strtoul(optarg, NULL, 10); break;
+        case 'q': qrScale = atoi(optarg); break;
+        case 'r': cut = atol(optarg); break;
+        case 'w':
+            window = sscanf(optarg, "%lu,%lu,%lu,%lu", &winCol, &winRow, &winCols, &winRows) == 4;
+            if (!window) {
+                Usage();
+                return 2;
+            }
+            break;
+#ifdef SIM_FRAME_BUFFER
+        case 'f':
+            update = sscanf(optarg, "%lu,%lu,%lu,%lu", &fbCol, &fbRow, &fbCols, &fbRows) == 4;
+            if (!update) {
+                Usage();
+                return 2;
+            }
+            break;
+#endif
+        default:
+            Usage();
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    HostBus::Reset();
+    Epd epd;
+    int bpp = epd.bits_per_pixel;
+    if (bpp == 0 && epd.width > 0 && epd.height > 0) {
+        bpp = epd.blockSize * 8 / (epd.width * epd.height);
+    }
+    if (bpp == 0 && epd.stepCommands[0] == 0x24) {
+        // a width that is no multiple of 8 leaves the plane short of a byte per row
+        bpp = 1;
+    }
+    SimController sim;
+    if (!sim.Begin(epd, bpp)) {
+        return 2;
+    }
+    printf("%lux%lu %s controller, %d bpp, data command(s)", epd.width, epd.height, familyNames[sim.family], bpp);
+    for (int i = 0; i < epd.steps; i++) {
+        printf(" 0x%02X", epd.stepCommands[i]);
+    }
+    printf(", %lu bytes each\n", epd.blockSize);
+    if (sim.rowBytes * epd.height != epd.blockSize) {
+        printf("the RAM is %lu rows of %lu bytes, a %lu byte plane does not fill it row by row\n",
+               epd.height, sim.rowBytes, epd.blockSize);
+        return 2;
+    }
+
+    HostBus::onByte = SimController::OnByte;
+    HostBus::onByteArg = &sim;
+    if (epd.Init() != 0) {
+        printf("Init failed\n");
+        return 1;
+    }
+    HostBus::Print("init");
+    if (clock != 0) {
+        EpdIf::SetSpiClock(clock);
+    }
+    HostBus::ClearCounts();
+
+    std::vector<uint8_t> frame;
+    if (qrScale > 0) {
+        // QRset() draws into the last plane; the sketch refreshes after it
+        unsigned long before = sim.written;
+        epd.QRset(qrScale);
+        epd.TurnOnDisplay();
+        HostBus::Print("QR");
+        if (sim.written == before) {
+            printf("QRset() sent no pixels, the driver leaves bits_per_pixel at %d\n", epd.bits_per_pixel);
+            failed++;
+        }
+    } else {
+        if (in != NULL) {
+            FILE* f = fopen(in, "rb");
+            if (f == NULL) {
+                printf("cannot open %s\n", in);
+                return 2;
+            }
+            frame.resize(epd.steps * epd.blockSize + 1);
+            size_t n = fread(&frame[0], 1, frame.size(), f);
+            fclose(f);
+            if (n != epd.steps * epd.blockSize) {
+                printf("%s has %zu bytes, the panel takes %d x %lu\n", in, n, epd.steps, epd.blockSize);
+                return 2;
+            }
+            frame.resize(n);
+        } else {
+            Pattern(epd, bpp, frame);
+        }
+        for (int step = 0; step < epd.steps; step++) {
+            const uint8_t* plane = &frame[step * epd.blockSize];
+            epd.SendCommand(epd.stepCommands[step]);
+            epd.SetToDataMode();
+            unsigned long from = 0;
+            if (step == 0 && cut > 0 && (unsigned long)cut < epd.blockSize) {
+                // as if the download broke off here and came back
+                Upload(epd, plane, 0, cut);
+                long at = epd.ResumeStep(step, cut);
+                if (at < 0) {
+                    printf("ResumeStep() cannot continue at %ld, Init() again\n", cut);
+                    epd.Init();
+                    epd.SendCommand(epd.stepCommands[step]);
+                    epd.SetToDataMode();
+                } else {
+                    printf("ResumeStep() continues at %ld of %ld\n", at, cut);
+                    from = at;
+                }
+            }
+            Upload(epd, plane, from, epd.blockSize);
+        }
+        epd.TurnOnDisplay();
+        HostBus::Print("frame");
+    }
+
+    if (window && qrScale == 0) {
+        HostBus::ClearCounts();
+        bool partial = epd.SetPartial(true);
+        if (!epd.SetWindow(winCol, winRow, winCols, winRows)) {
+            // panels without RAM windows refuse every window
+            printf("SetWindow(%lu, %lu, %lu, %lu) refused, no window written\n", winCol, winRow, winCols, winRows);
+        } else {
+            std::vector<uint8_t> win(winCols * winRows);
+            for (int step = 0; step < epd.steps; step++) {
+                for (unsigned long r = 0; r < winRows; r++) {
+                    for (unsigned long c = 0; c < winCols; c++) {
+                        uint8_t* b = &frame[step * epd.blockSize + (winRow + r) * sim.rowBytes + winCol + c];
+                        *b ^= 0xFF;
+                        win[r * winCols + c] = *b;
+                    }
+                }
+                epd.SendCommand(epd.stepCommands[step]);
+                epd.SetToDataMode();
+                Upload(epd, &win[0], 0, win.size());
+            }
+            if (partial) {
+                epd.TurnOnPartial();
+            } else {
+                epd.TurnOnDisplay();
+            }
+            HostBus::Print("window");
+        }
+    }
+
+    // the step FrameBuffer leaves to the controller, the 7.5" V2 old data
+    int fbFirst = 0;
+#ifdef SIM_FRAME_BUFFER
+    if (update && qrScale == 0) {
+        HostBus::ClearCounts();
+        if (fbCol + fbCols > sim.rowBytes || fbRow + fbRows > epd.height) {
+            printf("-f %lu,%lu,%lu,%lu does not fit the %lu x %lu byte frame\n",
+                   fbCol, fbRow, fbCols, fbRows, sim.rowBytes, epd.height);
+            return 2;
+        }
+        Shown shown = { frame, epd.blockSize };
+        FrameBuffer fb;
+        if (!fb.Begin(epd, LoadShown, &shown) || fb.Banded()) {
+            printf("FrameBuffer::Begin() failed\n");
+            return 1;
+        }
+        fbFirst = epd.steps > 1 && epd.previousRam != 0 && epd.stepCommands[0] == epd.previousRam ? 1 : 0;
+        // the first Refresh() after power-on is a full one; the block goes
+        // back in the second slide, which the partial path may take
+        for (int pass = 0; pass < 2; pass++) {
+            for (int step = 0; step < epd.steps; step++) {
+                for (unsigned long r = 0; r < fbRows; r++) {
+                    for (unsigned long c = 0; c < fbCols; c++) {
+                        frame[step * epd.blockSize + (fbRow + r) * sim.rowBytes + fbCol + c] ^= 0xFF;
+                    }
+                }
+            }
+            // the next slide, streamed in download chunks
+            for (unsigned long i = 0; i < frame.size(); i += epd.streamBufferSize) {
+                fb.Update(i, &frame[i], min(epd.streamBufferSize, frame.size() - i));
+            }
+            if (!fb.Refresh()) {
+                printf("FrameBuffer::Refresh() failed\n");
+                failed++;
+            }
+            printf("frame buffer: %lu bytes in %lu windows, %s refresh\n",
+                   fb.uploaded, fb.windows, fb.lastPartial ? "partial" : "full");
+            HostBus::Print("frame buffer");
+            HostBus::ClearCounts();
+            CHECK(!fb.lastPartial || fb.windows > 0);
+        }
+    }
+#endif
+    HostBus::onByte = NULL;
+
+    if (sim.family == SIM_UC81XX) {
+        printf("refreshes: %lu, %lu of them partial\n", sim.refreshes, sim.partialRefreshes);
+    } else {
+        // SSD168x picks the update in 0x22, which is not modelled
+        printf("refreshes: %lu\n", sim.refreshes);
+    }
+    if (sim.tresWidth != 0 && (sim.tresWidth != epd.width || sim.tresHeight != epd.height)) {
+        printf("note: resolution register says %lux%lu\n", sim.tresWidth, sim.tresHeight);
+    }
+    if (sim.gates != 0 && sim.gates != epd.height) {
+        printf("note: driver output control sets %lu gates\n", sim.gates);
+    }
+    CHECK(HostBus::strayBytes == 0);
+    CHECK(sim.outside == 0);
+    CHECK(sim.refreshes > 0);
+    if (sim.family == SIM_SSD168X && epd.ramRowBytes > 0 && sim.originSet) {
+        // ResumeStep() and SetWindow() count rows from here
+        CHECK(sim.xOrigin == 0 && !sim.xDown);
+        CHECK(sim.yOrigin == (int)epd.ramYStart && sim.yDown == epd.ramYDown);
+        CHECK(epd.ramRowBytes == sim.rowBytes);
+    }
+    if (!frame.empty()) {
+        unsigned long differ = 0;
+        for (int step = fbFirst; step < epd.steps; step++) {
+            for (unsigned long row = 0; row < epd.height; row++) {
+                for (unsigned long col = 0; col < sim.rowBytes; col++) {
+                    uint8_t want = frame[step * epd.blockSize + row * sim.rowBytes + col];
+                    uint8_t got = sim.View(sim.ram, step, row, col);
+                    if (got != want && differ++ == 0) {
+                        printf("  RAM 0x%02X row %lu byte %lu: 0x%02X, sent 0x%02X\n",
+                               epd.stepCommands[step], row, col, got, want);
+                    }
+                }
+            }
+        }
+        printf("RAM: %s\n", differ ? "differs from the frame" : "holds the frame as sent");
+        if (differ) {
+            printf("  %lu bytes differ\n", differ);
+            failed++;
+        }
+    }
+
+    std::vector<uint8_t> rgb;
+    sim.Render(rgb);
+    if (!WritePng(out, epd.width, epd.height, rgb)) {
+        printf("cannot write %s\n", out);
+        return 2;
+    }
+    printf("wrote %s\n", out);
+    if (failed) {
+        printf("%d checks failed\n", failed);
+    }
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */
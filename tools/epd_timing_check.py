@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+epd_timing_check.py - host comparison of the fixed waits in Init(),
+TurnOnDisplay() and Sleep() before and after the per-controller timing
+
+Each driver is built twice against the simulated bus in tools/host, once
+from the tree before EpdTiming (commit 0a5389e, "Replace blanket delays
+with per-controller timing", so its parent by default) and once from the
+working tree. tools/host/timing_dump.cpp runs Init(), TurnOnDisplay() and
+Sleep() and reports the simulated time of each. BUSY always reads idle,
+so a wait on BUSY costs nothing and the figures are the fixed delays the
+driver adds on top of the controller's own busy time. Wire time at the
+driver's SPI clock is listed as well.
+
+    python3 tools/epd_timing_check.py
+    python3 tools/epd_timing_check.py --old 0a5389e~1 --new 0a5389e epd7in3f
+
+Runs from anywhere inside the git checkout and needs g++. The exit code
+is 1 when a driver now waits longer in total than before.
+
+MIT License, Copyright (c) 2025 EpaperPix
+"""
+
+import argparse
+import glob
+import os
+import shutil
+import sys
+import tempfile
+
+from init_script_check import SKETCHES, Builder, busy_idle, export_tree, git
+
+PHASES = ("init", "refresh", "sleep")
+
+
+def parse(lines):
+    """phase -> (delay ms, wire ms, BUSY reads)"""
+    phases = {}
+    for line in lines:
+        if line:
+            name, delay_ns, wire_ns, reads = line.split()
+            phases[name] = (int(delay_ns) / 1e6, int(wire_ns) / 1e6, int(reads))
+    return phases
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("drivers", nargs="*", help="drivers to compare, e.g. epd7in3f (default all)")
+    ap.add_argument("--old", default="0a5389e~1", help="revision with the fixed delays")
+    ap.add_argument("--new", help="revision to compare (default the working tree)")
+    ap.add_argument("--keep", action="store_true", help="leave the build directory behind")
+    args = ap.parse_args()
+
+    tools = os.path.dirname(os.path.abspath(__file__))
+    root = git(tools, "rev-parse", "--show-toplevel").decode().strip()
+    work = tempfile.mkdtemp(prefix="epd_timing_check.")
+    old_root = export_tree(root, args.old, os.path.join(work, "old"))
+    if args.new:
+        new_root = export_tree(root, args.new, os.path.join(work, "new"))
+    else:
+        new_root = root
+
+    longer = 0
+    compared = 0
+    skipped = []
+    print("delays in ms, old -> new; BUSY waits excluded")
+    print("%-20s %-14s %15s %15s %15s %15s %11s" % (
+        "sketch", "driver", "Init()", "TurnOnDisplay()", "Sleep()", "total", "wire"))
+    for sketch in SKETCHES:
+        builders = {}
+        for name, tree in (("old", old_root), ("new", new_root)):
+            out = os.path.join(work, name + "-" + sketch)
+            os.makedirs(out)
+            builders[name] = Builder(tools, os.path.join(tree, "Arduino", sketch), out,
+                                     "timing_dump.cpp", parse)
+            err = builders[name].build_common()
+            if err:
+                print("%s: %s epdif.cpp does not build:\n%s" % (sketch, name, err))
+                return 1
+        drivers = args.drivers or sorted(
+            os.path.basename(p)[:-4]
+            for p in glob.glob(os.path.join(root, "Arduino", sketch, "epd[0-9]*.cpp")))
+        for driver in drivers:
+            idle = busy_idle(os.path.join(root, "Arduino", sketch, driver + ".cpp"))
+            old, old_err = builders["old"].run(driver, idle)
+            new, new_err = builders["new"].run(driver, idle)
+            if old_err or new_err:
+                why = ("old " + old_err) if old_err else ("new " + new_err)
+                skipped.append("%s/%s" % (sketch, driver))
+                print("%-20s %-14s skipped, %s" % (sketch, driver, why))
+                continue
+            compared += 1
+            cells = ["%6.0f -> %5.0f" % (old[p][0], new[p][0]) for p in PHASES]
+            old_total = sum(old[p][0] for p in PHASES)
+            new_total = sum(new[p][0] for p in PHASES)
+            wire = "%4.1f -> %4.1f" % (sum(old[p][1] for p in PHASES), sum(new[p][1] for p in PHASES))
+            mark = ""
+            if new_total > old_total:
+                longer += 1
+                mark = "  longer"
+            print("%-20s %-14s %15s %15s %15s %6.0f -> %5.0f %11s%s" % (
+                sketch, driver, cells[0], cells[1], cells[2], old_total, new_total, wire, mark))
+
+    print("%d drivers compared, %d wait longer, %d skipped" % (compared, longer, len(skipped)))
+    if args.keep:
+        print("build directory: " + work)
+    else:
+        shutil.rmtree(work)
+    return 1 if longer else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+epd_trace.py - convert an EpdIf trace dump to Chrome trace JSON
+
+Build a sketch with EPD_SPI_TRACE defined in epdif.h, capture the serial
+output of a wake cycle to a file (any terminal logger will do, the text
+around the dump is skipped), then run
+
+    python3 tools/epd_trace.py capture.bin -o trace.json
+
+and open trace.json in https://ui.perfetto.dev or chrome://tracing.
+Every dump found in the capture becomes its own process in the trace.
+
+MIT License, Copyright (c) 2025 EpaperPix
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+MAGIC = b"EPDT"
+HEADER = struct.Struct("<4sBBHII")     # magic, version, event size, count, dropped, SPI clock
+EVENT = struct.Struct("<IIIBBH")       # startUs, durUs, len, type, value, reserved
+
+CMD, DATA, DC, RST, DELAY, BUSY = range(1, 7)
+
+# event type -> (thread id, thread name)
+THREADS = {
+    CMD: (1, "SPI"),
+    DATA: (1, "SPI"),
+    DC: (2, "GPIO"),
+    RST: (2, "GPIO"),
+    DELAY: (3, "Waits"),
+    BUSY: (3, "Waits"),
+}
+
+
+def parse_dumps(raw):
+    """Yield (header fields, [events]) for every dump in a serial capture."""
+    pos = raw.find(MAGIC)
+    while pos >= 0 and pos + HEADER.size <= len(raw):
+        _, version, size, count, dropped, clock = HEADER.unpack_from(raw, pos)
+        body = pos + HEADER.size
+        if version != 1 or size != EVENT.size or body + count * size > len(raw):
+            # text that happens to contain the magic, or a cut-off dump
+            pos = raw.find(MAGIC, pos + 1)
+            continue
+        events = [EVENT.unpack_from(raw, body + i * size) for i in range(count)]
+        yield (count, dropped, clock), events
+        pos = raw.find(MAGIC, body + count * size)
+
+
+def to_chrome(dumps):
+    out = []
+    for pid, ((count, dropped, clock), events) in enumerate(dumps, 1):
+        out.append({"ph": "M", "pid": pid, "name": "process_name",
+                    "args": {"name": "wake %d (%d events, %d dropped, SPI %.1f MHz)"
+                             % (pid, count, dropped, clock / 1e6)}})
+        for tid, name in set(THREADS.values()):
+            out.append({"ph": "M", "pid": pid, "tid": tid, "name": "thread_name",
+                        "args": {"name": name}})
+
+        t0 = events[0][0] if events else 0
+        for start, dur, length, kind, value, _ in events:
+            tid = THREADS.get(kind, (4, "?"))[0]
+            ts = (start - t0) & 0xFFFFFFFF      # micros() wraps after ~71 minutes
+            if kind == CMD:
+                ev = {"name": "CMD 0x%02X" % value, "args": {"bytes": length}}
+            elif kind == DATA:
+                ev = {"name": "DATA", "args": {"bytes": length, "first": "0x%02X" % value}}
+            elif kind == DELAY:
+                ev = {"name": "DelayMs"}
+            elif kind == BUSY:
+                ev = {"name": "BUSY timeout" if value else "BUSY"}
+            elif kind in (DC, RST):
+                out.append({"ph": "i", "s": "t", "pid": pid, "tid": tid, "ts": ts,
+                            "name": "%s %s" % ("DC" if kind == DC else "RST",
+                                               "high" if value else "low")})
+                continue
+            else:
+                ev = {"name": "type %d" % kind}
+            ev.update({"ph": "X", "pid": pid, "tid": tid, "ts": ts, "dur": dur})
+            out.append(ev)
+    return {"traceEvents": out, "displayTimeUnit": "ms"}
+
+
+def summary(dumps):
+    for n, ((count, dropped, clock), events) in enumerate(dumps, 1):
+        totals = {}
+        for _, dur, length, kind, _, _ in events:
+            t = totals.setdefault(kind, [0, 0, 0])
+            t[0] += 1
+            t[1] += dur
+            t[2] += length
+        names = {CMD: "commands", DATA: "data", DELAY: "delays", BUSY: "busy waits"}
+        sys.stderr.write("wake %d: %d events, %d dropped\n" % (n, count, dropped))
+        for kind, name in names.items():
+            c, us, b = totals.get(kind, (0, 0, 0))
+            sys.stderr.write("  %-10s %6d  %10.1f ms  %8d bytes\n" % (name, c, us / 1000.0, b))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("capture", help="serial capture containing one or more dumps, - for stdin")
+    ap.add_argument("-o", "--output", help="JSON file to write (default stdout)")
+    args = ap.parse_args()
+
+    if args.capture == "-":
+        raw = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            raw = f.read()
+
+    dumps = list(parse_dumps(raw))
+    if not dumps:
+        sys.exit("no EPDT trace dump found in %s" % args.capture)
+    summary(dumps)
+
+    trace = to_chrome(dumps)
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
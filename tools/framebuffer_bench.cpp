@@ -0,0 +1,207 @@
+/**
+ *  @filename   :   framebuffer_bench.cpp
+ *  @brief      :   Upload bytes of dirty windows on synthetic edit traces
+ *
+ *  Runs the rectangle merging of Arduino/epd_epaperpix_wifi/dirty_rects.h
+ *  on a PC. Each trace is a series of updates, every update a set of
+ *  changed pixel rectangles. For every update the merged windows are
+ *  checked to cover each changed byte, and their cost (bytes plus
+ *  DIRTY_WINDOW_COST per window) is compared with one window per
+ *  rectangle, one bounding box and the full plane.
+ *
+ *      g++ -O2 -std=c++11 -IArduino/epd_epaperpix_wifi \
+ *          tools/framebuffer_bench.cpp -o framebuffer_bench
+ *      ./framebuffer_bench
+ *
+ *  The exit code is 1 when a window set misses a changed byte, or when
+ *  the merged windows of a trace cost more than one window per
+ *  rectangle or the full plane every time.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "dirty_rects.h"
+
+struct Panel {
+    const char* name;
+    int width;
+    int height;
+    int bpp;
+};
+
+static const Panel panels[] = {
+    { "epd7in5_V2 800x480 1bpp", 800, 480, 1 },
+    { "epd1in54 200x200 1bpp", 200, 200, 1 },
+    { "epd7in3f 800x480 4bpp", 800, 480, 4 },
+};
+
+struct PixelRect {
+    int x, y, w, h;
+};
+
+typedef std::vector<PixelRect> Update;
+
+struct Trace {
+    const char* name;
+    std::vector<Update> updates;
+};
+
+// the traces scale with the panel so the small one sees the same layouts
+static std::vector<Trace> MakeTraces(const Panel& p) {
+    std::mt19937 rng(2025);
+    std::vector<Trace> traces;
+    int sw = p.width, sh = p.height;
+
+    // HH:MM in the top right corner, the minute digit every update and
+    // the tens digit every tenth
+    Trace clock = { "clock", {} };
+    int dw = sw / 16, dh = sh / 6, cx = sw - 5 * dw - 8;
+    for (int m = 1; m <= 60; m++) {
+        Update u;
+        u.push_back({ cx + 4 * dw, 8, dw, dh });
+        if (m % 10 == 0) {
+            u.push_back({ cx + 3 * dw, 8, dw, dh });
+        }
+        clock.updates.push_back(u);
+    }
+    traces.push_back(clock);
+
+    // room sign: status box and the next-meeting line under it
+    Trace status = { "status area", {} };
+    for (int i = 0; i < 20; i++) {
+        Update u;
+        u.push_back({ sw / 8, sh / 3, sw * 3 / 8, sh / 6 });
+        u.push_back({ sw / 8, sh / 3 + sh / 6 + 12, sw / 4, sh / 20 });
+        status.updates.push_back(u);
+    }
+    traces.push_back(status);
+
+    // six readings in a 3x2 grid, two to four of them change
+    Trace dash = { "dashboard", {} };
+    for (int i = 0; i < 40; i++) {
+        Update u;
+        int n = 2 + rng() % 3;
+        for (int k = 0; k < n; k++) {
+            int cell = rng() % 6;
+            int gx = (cell % 3) * sw / 3, gy = (cell / 3) * sh / 2;
+            u.push_back({ gx + sw / 24, gy + sh / 6, sw / 6, sh / 12 });
+        }
+        dash.updates.push_back(u);
+    }
+    traces.push_back(dash);
+
+    // words changing across a text page
+    Trace text = { "text edits", {} };
+    int line = sh / 30;
+    for (int i = 0; i < 20; i++) {
+        Update u;
+        for (int k = 0; k < 30; k++) {
+            int w = sw / 40 + rng() % (sw / 10);
+            u.push_back({ (int)(rng() % (sw - w)), (int)(rng() % 28) * line + 4, w, line - 2 });
+        }
+        text.updates.push_back(u);
+    }
+    traces.push_back(text);
+
+    // noise: single pixels anywhere
+    Trace pixels = { "scattered pixels", {} };
+    for (int i = 0; i < 10; i++) {
+        Update u;
+        for (int k = 0; k < 300; k++) {
+            u.push_back({ (int)(rng() % sw), (int)(rng() % sh), 1, 1 });
+        }
+        pixels.updates.push_back(u);
+    }
+    traces.push_back(pixels);
+
+    Trace full = { "full redraw", {} };
+    full.updates.push_back(Update(1, PixelRect{ 0, 0, sw, sh }));
+    traces.push_back(full);
+    return traces;
+}
+
+struct Totals {
+    long changed;       // distinct changed bytes
+    long merged;        // DirtyRects windows, with window cost
+    long separate;      // one window per rectangle
+    long bbox;          // one window around everything
+    long full;          // whole plane every time
+    long windows;
+};
+
+int main() {
+    int failed = 0;
+    int costly = 0;
+    printf("%-18s %5s %9s %10s %10s %10s %10s %7s %6s\n", "trace", "upd", "changed", "merged",
+           "separate", "bbox", "full", "saved", "win");
+    for (const Panel& p : panels) {
+        int ppb = 8 / p.bpp;
+        int rowBytes = (p.width + ppb - 1) / ppb;
+        long plane = (long)rowBytes * p.height;
+        printf("%s, plane %ld bytes\n", p.name, plane);
+        for (const Trace& t : MakeTraces(p)) {
+            Totals s = {};
+            for (const Update& u : t.updates) {
+                std::vector<char> changed(plane, 0);
+                DirtyRects dirty;
+                int c0 = rowBytes, r0 = p.height, c1 = 0, r1 = 0;
+                for (const PixelRect& r : u) {
+                    // the same byte alignment FrameBuffer::MarkDirty uses
+                    int col0 = r.x / ppb, col1 = (r.x + r.w + ppb - 1) / ppb;
+                    dirty.Add(col0, r.y, col1, r.y + r.h);
+                    for (int y = r.y; y < r.y + r.h; y++) {
+                        for (int c = col0; c < col1; c++) {
+                            changed[(long)y * rowBytes + c] = 1;
+                        }
+                    }
+                    s.separate += (long)(col1 - col0) * r.h + DIRTY_WINDOW_COST;
+                    c0 = col0 < c0 ? col0 : c0;
+                    r0 = r.y < r0 ? r.y : r0;
+                    c1 = col1 > c1 ? col1 : c1;
+                    r1 = r.y + r.h > r1 ? r.y + r.h : r1;
+                }
+                s.bbox += (long)(c1 - c0) * (r1 - r0) + DIRTY_WINDOW_COST;
+                s.full += plane;
+                // FrameBuffer::Windowed() sends the whole plane when that is cheaper
+                long cost = dirty.Bytes() + (long)dirty.Count() * DIRTY_WINDOW_COST;
+                s.merged += cost < plane ? cost : plane;
+                s.windows += dirty.Count();
+
+                std::vector<char> covered(plane, 0);
+                for (int i = 0; i < dirty.Count(); i++) {
+                    for (int y = dirty[i].row0; y < dirty[i].row1; y++) {
+                        for (int c = dirty[i].col0; c < dirty[i].col1; c++) {
+                            covered[(long)y * rowBytes + c] = 1;
+                        }
+                    }
+                }
+                for (long b = 0; b < plane; b++) {
+                    s.changed += changed[b];
+                    if (changed[b] && !covered[b]) {
+                        failed++;
+                        break;
+                    }
+                }
+            }
+            printf("%-18s %5zu %9ld %10ld %10ld %10ld %10ld %6.1f%% %6.1f\n", t.name, t.updates.size(),
+                   s.changed, s.merged, s.separate, s.bbox, s.full, 100.0 * (1 - (double)s.merged / s.full),
+                   (double)s.windows / t.updates.size());
+            if (s.merged > s.separate || s.merged > s.full) {
+                printf("  merging costs more than it saves\n");
+                costly++;
+            }
+        }
+    }
+    if (failed) {
+        printf("%d updates with changed bytes outside every window\n", failed);
+    }
+    if (costly) {
+        printf("%d traces where merging costs more than it saves\n", costly);
+    }
+    return failed || costly ? 1 : 0;
+}
+
+/* END OF FILE */
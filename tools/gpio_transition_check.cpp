@@ -0,0 +1,120 @@
+/**
+ *  @filename   :   gpio_transition_check.cpp
+ *  @brief      :   Host count of CS/DC/RST pin writes per frame, with
+ *                  and without the DC level cache
+ *
+ *  Links the real epdif.cpp, epd_common.cpp and one driver against the
+ *  simulated bus in tools/host and runs two whole frames: Init(), the
+ *  planes, TurnOnDisplay() and Sleep(). One frame sends the planes with
+ *  SendData() per byte, the path the drivers' own loops use. The other
+ *  uses SendBuffer() bursts. "requested" is every DC write the driver
+ *  asks for. Before the cache each one reached the pin. "at the pin" is
+ *  what the bus sees now. With -DEPD_FAST_GPIO the check also expects
+ *  every CS/DC/RST write to go through the register path.
+ *
+ *      g++ -O2 -std=c++11 -DEPD_SPI_STATS [-DEPD_FAST_GPIO] -Itools/host \
+ *          -IArduino/epd_epaperpix_wifi tools/gpio_transition_check.cpp \
+ *          tools/host/host_bus.cpp Arduino/epd_epaperpix_wifi/epdif.cpp \
+ *          Arduino/epd_epaperpix_wifi/epd_common.cpp \
+ *          Arduino/epd_epaperpix_wifi/epd7in5_V2.cpp -o gpio_transition_check
+ *      ./gpio_transition_check
+ *
+ *  Other panels build as in spi_burst_bench.cpp. The exit code is 1 when
+ *  a DC write that changes nothing reaches the pin, or a pin write takes
+ *  the wrong path.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include "host_bus.h"
+#include "epd_base.h"
+
+#ifndef EPD_SPI_STATS
+#error "build with -DEPD_SPI_STATS"
+#endif
+
+static int failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("  FAILED line %d: %s\n", __LINE__, #cond); \
+            failed++; \
+        } \
+    } while (0)
+
+static void Frame(Epd& epd, const uint8_t* plane, bool perByte) {
+    HostBus::Reset();
+    EpdIf::SpiStatsReset();
+    epd.Init();
+    for (int step = 0; step < epd.steps; step++) {
+        epd.SendCommand(epd.stepCommands[step]);
+        if (perByte) {
+            for (unsigned long i = 0; i < epd.blockSize; i++) {
+                epd.SendData(plane[i]);
+            }
+        } else {
+            epd.SetToDataMode();
+            for (unsigned long i = 0; i < epd.blockSize; i += epd.streamBufferSize) {
+                epd.SendBuffer((unsigned char*)plane + i, (int)min(epd.streamBufferSize, epd.blockSize - i));
+            }
+            epd.WaitBuffer();
+        }
+    }
+    epd.TurnOnDisplay();
+    epd.Sleep();
+
+    const HostPin* cs = &HostBus::pins[CS_PIN];
+    const HostPin* dc = &HostBus::pins[DC_PIN];
+    const HostPin* rst = &HostBus::pins[RST_PIN];
+    unsigned long requested = EpdIf::spiStats.dcWrites + EpdIf::spiStats.dcSkipped;
+    printf("%-9s %10lu %10lu %10lu %10lu %10lu %10lu\n", perByte ? "per byte" : "burst",
+           HostBus::bytes, requested, dc->writes, dc->changes, cs->writes, rst->writes);
+
+    // only level changes reach DC, and the stats see the same
+    CHECK(dc->writes == dc->changes);
+    CHECK(dc->writes == EpdIf::spiStats.dcWrites);
+    // CS goes low and high once per transfer
+    CHECK(cs->writes == 2 * EpdIf::spiStats.csToggles);
+#ifdef EPD_FAST_GPIO
+    CHECK(cs->regWrites == cs->writes);
+    CHECK(dc->regWrites == dc->writes);
+    CHECK(rst->regWrites == rst->writes);
+#else
+    CHECK(cs->regWrites == 0 && dc->regWrites == 0 && rst->regWrites == 0);
+#endif
+}
+
+int main(void) {
+    HostBus::Reset();
+    Epd epd;
+    if (epd.Init() != 0) {
+        printf("Init failed\n");
+        return 1;
+    }
+    uint8_t* plane = (uint8_t*)malloc(epd.blockSize);
+    for (unsigned long i = 0; i < epd.blockSize; i++) {
+        plane[i] = (uint8_t)(i * 37);
+    }
+    printf("%lux%lu, %d step(s) of %lu bytes, pin writes through %s\n", epd.width, epd.height,
+           epd.steps, epd.blockSize,
+#ifdef EPD_FAST_GPIO
+           "the GPIO registers"
+#else
+           "digitalWrite()"
+#endif
+           );
+    printf("%-9s %10s %10s %10s %10s %10s %10s\n", "frame", "bytes", "DC asked", "DC at pin",
+           "DC changes", "CS writes", "RST writes");
+    Frame(epd, plane, true);
+    unsigned long requested = EpdIf::spiStats.dcWrites + EpdIf::spiStats.dcSkipped;
+    unsigned long reached = HostBus::pins[DC_PIN].writes;
+    Frame(epd, plane, false);
+    printf("per byte frame: %lu DC pin writes before the cache, %lu now\n", requested, reached);
+    free(plane);
+    if (failed) {
+        printf("%d checks failed\n", failed);
+    }
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */
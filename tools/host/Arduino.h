@@ -0,0 +1,77 @@
+/**
+ *  @filename   :   Arduino.h
+ *  @brief      :   Just enough of the Arduino core to build the panel
+ *                  drivers on a PC
+ *
+ *  Pins, SPI and time go to the simulated bus in host_bus.cpp. The
+ *  network sources link host_net.cpp instead, with the real clock and
+ *  sockets behind WiFi.h and HTTPClient.h. Sketch sources that need
+ *  FreeRTOS do not build against this.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include "WString.h"
+
+using std::min;
+using std::max;
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0
+#define OUTPUT  1
+#define INPUT_PULLUP 2
+#define HEX     16
+#define DEC     10
+#define PROGMEM
+#define F(s)    (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+unsigned long millis(void);
+unsigned long micros(void);
+void yield(void);
+uint32_t esp_random(void);
+
+// Serial goes to stdout
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    size_t print(const char* s) { return fputs(s, stdout) >= 0 ? strlen(s) : 0; }
+    size_t print(char c) { return putchar(c) != EOF; }
+    size_t print(long n, int base = DEC) { return printf(base == HEX ? "%lX" : "%ld", n); }
+    size_t print(unsigned long n, int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", n); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(double n, int digits = 2) { return printf("%.*f", digits, n); }
+    template <class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <class T> size_t println(T v, int base) { size_t n = print(v, base); return n + println(); }
+    size_t println(void) { return putchar('\n') != EOF; }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+    size_t write(const uint8_t* buf, size_t len) { return fwrite(buf, 1, len, stdout); }
+    void flush(void) { fflush(stdout); }
+};
+
+extern HostSerial Serial;
+
+#endif
+
+/* END OF FILE */
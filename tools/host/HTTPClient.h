@@ -0,0 +1,68 @@
+/**
+ *  @filename   :   HTTPClient.h
+ *  @brief      :   Host HTTPClient, the ESP32 core's request and keep-alive
+ *                  behaviour on any WiFiClient, see host_net.cpp
+ *
+ *  As in the core, begin() does not look at which host a connected
+ *  client belongs to, and end() keeps the socket open when reuse is on
+ *  and the server did not ask to close, dropping whatever of the body was
+ *  left unread. Bodies need a Content-Length; chunked ones are not read.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_HTTPCLIENT_H
+#define HOST_HTTPCLIENT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "WiFi.h"
+
+#define HTTP_CODE_OK                    200
+#define HTTP_CODE_PARTIAL_CONTENT       206
+#define HTTP_CODE_NOT_MODIFIED          304
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED  (-2)
+#define HTTPC_ERROR_NOT_CONNECTED       (-4)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+class HTTPClient {
+public:
+    HTTPClient() : client(NULL), port(443), reuse(true), canReuse(false), size(-1), timeoutMs(5000) {}
+    ~HTTPClient() { end(); }
+
+    bool begin(WiFiClient& c, const String& url);
+    void end(void);
+    void setReuse(bool on) { reuse = on; }
+    void setTimeout(uint16_t ms) { timeoutMs = ms; }
+    void addHeader(const String& name, const String& value);
+    void collectHeaders(const char* keys[], size_t count) {}
+    String header(const char* name);
+    int GET(void) { return sendRequest("GET", String()); }
+    int POST(const String& body) { return sendRequest("POST", body); }
+    int sendRequest(const char* type, const String& body);
+    int getSize(void) { return size; }
+    WiFiClient* getStreamPtr(void) { return connected() ? client : NULL; }
+    WiFiClient& getStream(void) { return *client; }
+    String getString(void);
+    bool connected(void) { return client != NULL && client->connected(); }
+
+private:
+    bool ReadLine(std::string& line);
+
+    WiFiClient* client;
+    String host;
+    uint16_t port;
+    String uri;
+    bool reuse;
+    bool canReuse;
+    int size;
+    unsigned long timeoutMs;
+    std::string requestHeaders;
+    std::vector<std::pair<String, String> > responseHeaders;
+};
+
+#endif
+
+/* END OF FILE */
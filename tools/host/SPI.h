@@ -0,0 +1,35 @@
+/**
+ *  @filename   :   SPI.h
+ *  @brief      :   Host SPIClass, bytes go to the simulated bus
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+#define MSBFIRST    1
+#define SPI_MODE0   0
+
+struct SPISettings {
+    uint32_t clock;
+    SPISettings() : clock(4000000) {}
+    SPISettings(uint32_t hz, uint8_t, uint8_t) : clock(hz) {}
+};
+
+class SPIClass {
+public:
+    void begin(void) {}
+    void end(void) {}
+    void beginTransaction(SPISettings settings);
+    void endTransaction(void) {}
+    uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,75 @@
+/**
+ *  @filename   :   WString.h
+ *  @brief      :   Host String, the part of the Arduino class the network
+ *                  sources use, on top of std::string
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_WSTRING_H
+#define HOST_WSTRING_H
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string>
+
+class String {
+public:
+    String(const char* s = "") : s(s ? s : "") {}
+    String(const std::string& str) : s(str) {}
+    String(char c) : s(1, c) {}
+    String(int n) : s(std::to_string(n)) {}
+    String(unsigned int n) : s(std::to_string(n)) {}
+    String(long n) : s(std::to_string(n)) {}
+    String(unsigned long n) : s(std::to_string(n)) {}
+
+    const char* c_str(void) const { return s.c_str(); }
+    unsigned int length(void) const { return s.size(); }
+    char operator[](unsigned int i) const { return i < s.size() ? s[i] : 0; }
+    long toInt(void) const { return atol(s.c_str()); }
+
+    int indexOf(char c, unsigned int from = 0) const { return Pos(s.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return Pos(s.find(str.s, from)); }
+    int lastIndexOf(char c) const { return Pos(s.rfind(c)); }
+    String substring(unsigned int from) const { return from < s.size() ? s.substr(from) : std::string(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < s.size() ? s.substr(from, to - from) : std::string();
+    }
+    bool startsWith(const String& str) const { return s.compare(0, str.s.size(), str.s) == 0; }
+    bool equalsIgnoreCase(const String& str) const {
+        if (s.size() != str.s.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < s.size(); i++) {
+            if (tolower((unsigned char)s[i]) != tolower((unsigned char)str.s[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    void trim(void) {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+
+    String& operator+=(const String& str) { s += str.s; return *this; }
+    String& operator+=(const char* str) { s += str; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    friend String operator+(const String& a, const String& b) { return a.s + b.s; }
+    friend String operator+(const String& a, const char* b) { return a.s + b; }
+    friend String operator+(const char* a, const String& b) { return a + b.s; }
+    bool operator==(const String& str) const { return s == str.s; }
+    bool operator==(const char* str) const { return s == str; }
+    bool operator!=(const String& str) const { return s != str.s; }
+    bool operator!=(const char* str) const { return s != str; }
+
+private:
+    static int Pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+
+    std::string s;
+};
+
+#endif
+
+/* END OF FILE */
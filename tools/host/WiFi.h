@@ -0,0 +1,62 @@
+/**
+ *  @filename   :   WiFi.h
+ *  @brief      :   Host WiFiClient on a POSIX TCP socket, see host_net.cpp
+ *
+ *  Behaves like the ESP32 core's: connect() blocks up to the timeout,
+ *  read() and available() never block, flush() drops what was received
+ *  and connected() turns false once the peer has closed and nothing is
+ *  left to read. Nagle is off, so timings show round trips only.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) { octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d; }
+    String toString(void) const {
+        char s[16];
+        snprintf(s, sizeof(s), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+        return String(s);
+    }
+
+private:
+    uint8_t octets[4];
+};
+
+class WiFiClient {
+public:
+    WiFiClient() : fd(-1), timeoutMs(5000) {}
+    virtual ~WiFiClient() { stop(); }
+
+    virtual int connect(IPAddress ip, uint16_t port) { return connect(ip.toString().c_str(), port); }
+    virtual int connect(IPAddress ip, uint16_t port, int32_t timeout) { return connect(ip.toString().c_str(), port, timeout); }
+    virtual int connect(const char* host, uint16_t port) { return connect(host, port, timeoutMs); }
+    virtual int connect(const char* host, uint16_t port, int32_t timeout);
+    virtual size_t write(uint8_t data) { return write(&data, 1); }
+    virtual size_t write(const uint8_t* buf, size_t size);
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    virtual int available();
+    virtual int read();
+    virtual int read(uint8_t* buf, size_t size);
+    virtual int peek();
+    virtual void flush();
+    virtual void stop();
+    virtual uint8_t connected();
+    virtual int setTimeout(uint32_t seconds) { timeoutMs = seconds * 1000; return 0; }
+
+private:
+    WiFiClient(const WiFiClient&);
+    WiFiClient& operator=(const WiFiClient&);
+
+    int fd;
+    unsigned long timeoutMs;
+};
+
+#endif
+
+/* END OF FILE */
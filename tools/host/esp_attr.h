@@ -0,0 +1,18 @@
+/**
+ *  @filename   :   esp_attr.h
+ *  @brief      :   Host stand-in: RTC memory is ordinary memory, so it
+ *                  lasts as long as the process does
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_ESP_ATTR_H
+#define HOST_ESP_ATTR_H
+
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+#define IRAM_ATTR
+
+#endif
+
+/* END OF FILE */
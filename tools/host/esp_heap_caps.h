@@ -0,0 +1,29 @@
+/**
+ *  @filename   :   esp_heap_caps.h
+ *  @brief      :   Host stand-in: every capability is plain heap, so a
+ *                  PSRAM request always succeeds
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+
+static inline void* heap_caps_malloc(size_t size, unsigned caps) {
+    return malloc(size);
+}
+
+static inline void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+#endif
+
+/* END OF FILE */
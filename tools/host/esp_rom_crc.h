@@ -0,0 +1,20 @@
+/**
+ *  @filename   :   esp_rom_crc.h
+ *  @brief      :   Host stand-in for the ROM CRC, zlib's CRC-32 is the same
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_ESP_ROM_CRC_H
+#define HOST_ESP_ROM_CRC_H
+
+#include <stdint.h>
+#include <zlib.h>
+
+static inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    return crc32(crc, buf, len);
+}
+
+#endif
+
+/* END OF FILE */
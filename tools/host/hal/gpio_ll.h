@@ -0,0 +1,22 @@
+/**
+ *  @filename   :   gpio_ll.h
+ *  @brief      :   Host stand-in for the ESP-IDF GPIO register writes
+ *                  used by EPD_FAST_GPIO
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_GPIO_LL_H
+#define HOST_GPIO_LL_H
+
+#include "soc/gpio_struct.h"
+
+void HostGpioSetLevel(int pin, int level);
+
+static inline void gpio_ll_set_level(gpio_dev_t*, gpio_num_t pin, uint32_t level) {
+    HostGpioSetLevel((int)pin, (int)level);
+}
+
+#endif
+
+/* END OF FILE */
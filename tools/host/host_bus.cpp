@@ -0,0 +1,179 @@
+/**
+ *  @filename   :   host_bus.cpp
+ *  @brief      :   Simulated pins, SPI bus and clock behind the host
+ *                  Arduino.h
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <stdarg.h>
+#include "host_bus.h"
+#include "epdif.h"
+#include "SPI.h"
+#include "hal/gpio_ll.h"
+
+HostSerial Serial;
+SPIClass SPI;
+gpio_dev_t GPIO;
+
+HostPin HostBus::pins[HOST_PINS];
+unsigned long long HostBus::nowNs;
+unsigned long long HostBus::wireNs;
+unsigned long long HostBus::delayNs;
+unsigned long HostBus::spiHz = 4000000;
+unsigned long HostBus::transfers;
+unsigned long HostBus::bytes;
+unsigned long HostBus::commandBytes;
+unsigned long HostBus::csBursts;
+unsigned long HostBus::maxBurst;
+unsigned long HostBus::strayBytes;
+unsigned long HostBus::busyReads;
+HostByteHook HostBus::onByte = NULL;
+void* HostBus::onByteArg = NULL;
+HostBusyHook HostBus::busyLevel = NULL;
+void* HostBus::busyArg = NULL;
+
+// bytes since CS went low
+static unsigned long burst = 0;
+
+void HostBus::Reset(void) {
+    for (int i = 0; i < HOST_PINS; i++) {
+        pins[i].level = -1;
+    }
+    nowNs = 0;
+    ClearCounts();
+}
+
+void HostBus::ClearCounts(void) {
+    for (int i = 0; i < HOST_PINS; i++) {
+        pins[i].writes = 0;
+        pins[i].changes = 0;
+        pins[i].regWrites = 0;
+    }
+    wireNs = 0;
+    delayNs = 0;
+    transfers = 0;
+    bytes = 0;
+    commandBytes = 0;
+    csBursts = 0;
+    maxBurst = 0;
+    strayBytes = 0;
+    busyReads = 0;
+    burst = 0;
+}
+
+int HostBus::Pin(int pin) {
+    return pin >= 0 && pin < HOST_PINS ? pins[pin].level : -1;
+}
+
+void HostBus::Write(int pin, int level, bool reg) {
+    if (pin < 0 || pin >= HOST_PINS) {
+        return;
+    }
+    HostPin* p = &pins[pin];
+    level = level ? HIGH : LOW;
+    p->writes++;
+    if (reg) {
+        p->regWrites++;
+    }
+    if (p->level != level) {
+        p->changes++;
+        // CS rising closes a burst
+        if (pin == CS_PIN && level == HIGH && burst > 0) {
+            csBursts++;
+            maxBurst = max(maxBurst, burst);
+            burst = 0;
+        }
+    }
+    p->level = level;
+}
+
+void HostBus::Clock(uint8_t data) {
+    transfers++;
+    unsigned long long ns = 8000000000ULL / spiHz;
+    nowNs += ns;
+    wireNs += ns;
+    if (pins[CS_PIN].level != LOW) {
+        strayBytes++;
+        return;
+    }
+    bool dc = pins[DC_PIN].level == HIGH;
+    bytes++;
+    burst++;
+    if (!dc) {
+        commandBytes++;
+    }
+    if (onByte != NULL) {
+        onByte(data, dc, onByteArg);
+    }
+}
+
+void HostBus::Print(const char* label) {
+    printf("%s: %lu bytes (%lu command), %lu CS bursts, %.1f bytes/burst, "
+           "CS %lu / DC %lu / RST %lu pin changes, %.2f ms on the wire at %lu kHz, %.1f ms delays\n",
+           label, bytes, commandBytes, csBursts, csBursts ? (double)bytes / csBursts : 0.0,
+           pins[CS_PIN].changes, pins[DC_PIN].changes, pins[RST_PIN].changes,
+           wireNs / 1e6, spiHz / 1000, delayNs / 1e6);
+}
+
+void pinMode(int, int) {
+}
+
+void digitalWrite(int pin, int value) {
+    HostBus::Write(pin, value, false);
+}
+
+int digitalRead(int pin) {
+    if (pin != BUSY_PIN) {
+        return HostBus::Pin(pin) == HIGH ? HIGH : LOW;
+    }
+    HostBus::busyReads++;
+    if (HostBus::busyLevel != NULL) {
+        return HostBus::busyLevel(HostBus::busyArg);
+    }
+    return HostBus::busyReads & 1 ? HIGH : LOW;
+}
+
+void delay(unsigned long ms) {
+    HostBus::nowNs += ms * 1000000ULL;
+    HostBus::delayNs += ms * 1000000ULL;
+}
+
+void delayMicroseconds(unsigned int us) {
+    HostBus::nowNs += us * 1000ULL;
+    HostBus::delayNs += us * 1000ULL;
+}
+
+unsigned long millis(void) {
+    return (unsigned long)(HostBus::nowNs / 1000000ULL);
+}
+
+unsigned long micros(void) {
+    return (unsigned long)(HostBus::nowNs / 1000ULL);
+}
+
+void yield(void) {
+}
+
+void HostGpioSetLevel(int pin, int level) {
+    HostBus::Write(pin, level, true);
+}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+    HostBus::spiHz = settings.clock ? settings.clock : 1;
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+    HostBus::Clock(data);
+    return 0;
+}
+
+size_t HostSerial::printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n > 0 ? (size_t)n : 0;
+}
+
+/* END OF FILE */
@@ -0,0 +1,66 @@
+/**
+ *  @filename   :   host_bus.h
+ *  @brief      :   Simulated pins, SPI bus and clock behind the host
+ *                  Arduino.h, for building epdif.cpp and the drivers on a PC
+ *
+ *  Every pin write is counted, whether it came through digitalWrite() or
+ *  the EPD_FAST_GPIO register path. Bytes clocked out while CS is low are
+ *  handed to onByte with the DC level they went out with. Time only moves
+ *  when something would take time on the board: delay(), and SPI bytes at
+ *  the clock of the last beginTransaction().
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_BUS_H
+#define HOST_BUS_H
+
+#include "Arduino.h"
+
+#define HOST_PINS   64
+
+struct HostPin {
+    int level;                  // -1 before the first write
+    unsigned long writes;       // every write, either path
+    unsigned long changes;      // writes that changed the level
+    unsigned long regWrites;    // writes through gpio_ll_set_level()
+};
+
+// byte clocked out with CS low, dc is the DC level at the time
+typedef void (*HostByteHook)(uint8_t data, bool dc, void* arg);
+// level of the BUSY pin at this read
+typedef int (*HostBusyHook)(void* arg);
+
+class HostBus {
+public:
+    static HostPin pins[HOST_PINS];
+    static unsigned long long nowNs;    // simulated time since Reset()
+    static unsigned long long wireNs;   // of which bytes on the wire
+    static unsigned long long delayNs;  // of which delay() and delayMicroseconds()
+    static unsigned long spiHz;         // clock of the last beginTransaction()
+    static unsigned long transfers;     // SPI.transfer() calls
+    static unsigned long bytes;         // bytes clocked out with CS low
+    static unsigned long commandBytes;  // of which with DC low
+    static unsigned long csBursts;      // CS low periods that carried bytes
+    static unsigned long maxBurst;      // most bytes in one CS low period
+    static unsigned long strayBytes;    // bytes clocked out with CS high
+    static unsigned long busyReads;     // digitalRead() of BUSY
+    static HostByteHook onByte;
+    static void* onByteArg;
+    // nothing set: BUSY reads alternate, so any wait ends on the next read
+    static HostBusyHook busyLevel;
+    static void* busyArg;
+
+    // counters, clock and pin levels back to power-on, the hooks stay
+    static void Reset(void);
+    // counters only, e.g. between the phases of a run
+    static void ClearCounts(void);
+    static int Pin(int pin);
+    static void Write(int pin, int level, bool reg);
+    static void Clock(uint8_t data);
+    static void Print(const char* label);
+};
+
+#endif
+
+/* END OF FILE */
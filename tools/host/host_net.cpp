@@ -0,0 +1,307 @@
+/**
+ *  @filename   :   host_net.cpp
+ *  @brief      :   Real clock, WiFiClient and HTTPClient behind the host
+ *                  Arduino.h, WiFi.h and HTTPClient.h
+ *
+ *  For the network sources; the panel sources link host_bus.cpp instead.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include "HTTPClient.h"
+
+HostSerial Serial;
+
+size_t HostSerial::printf(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int n = vprintf(fmt, args);
+    va_end(args);
+    return n < 0 ? 0 : n;
+}
+
+static unsigned long long NowUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+unsigned long millis(void) {
+    return NowUs() / 1000;
+}
+
+unsigned long micros(void) {
+    return NowUs();
+}
+
+void delay(unsigned long ms) {
+    usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+    usleep(us);
+}
+
+void yield(void) {
+}
+
+uint32_t esp_random(void) {
+    static uint32_t s = (uint32_t)NowUs() | 1;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port, int32_t timeout) {
+    stop();
+    struct addrinfo hints;
+    struct addrinfo* list;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &list) != 0) {
+        return 0;
+    }
+    for (struct addrinfo* a = list; a != NULL && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype | SOCK_NONBLOCK, a->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        bool up = ::connect(fd, a->ai_addr, a->ai_addrlen) == 0;
+        if (!up && errno == EINPROGRESS) {
+            struct pollfd p = { fd, POLLOUT, 0 };
+            int err = 0;
+            socklen_t len = sizeof(err);
+            up = poll(&p, 1, timeout) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0;
+        }
+        if (!up) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(list);
+    if (fd < 0) {
+        return 0;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return 1;
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t size) {
+    size_t sent = 0;
+    unsigned long start = millis();
+    while (fd >= 0 && sent < size && millis() - start < timeoutMs) {
+        ssize_t n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            break;
+        } else {
+            struct pollfd p = { fd, POLLOUT, 0 };
+            poll(&p, 1, 10);
+        }
+    }
+    return sent;
+}
+
+int WiFiClient::available() {
+    int n = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &n) < 0) {
+        return 0;
+    }
+    return n;
+}
+
+int WiFiClient::read(uint8_t* buf, size_t size) {
+    if (fd < 0) {
+        return -1;
+    }
+    ssize_t n = recv(fd, buf, size, MSG_DONTWAIT);
+    return n > 0 ? (int)n : -1;
+}
+
+int WiFiClient::read() {
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::peek() {
+    uint8_t c;
+    return fd >= 0 && recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+void WiFiClient::flush() {
+    uint8_t drop[256];
+    while (read(drop, sizeof(drop)) > 0) {
+    }
+}
+
+void WiFiClient::stop() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+uint8_t WiFiClient::connected() {
+    if (fd < 0) {
+        return 0;
+    }
+    uint8_t c;
+    ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))) {
+        return 1;
+    }
+    return 0;
+}
+
+// "https://host:port/path"
+bool HTTPClient::begin(WiFiClient& c, const String& url) {
+    int start = url.indexOf("://");
+    if (start < 0) {
+        return false;
+    }
+    String scheme = url.substring(0, start);
+    start += 3;
+    int slash = url.indexOf('/', start);
+    String hostPort = slash < 0 ? url.substring(start) : url.substring(start, slash);
+    uri = slash < 0 ? String("/") : url.substring(slash);
+    int colon = hostPort.indexOf(':');
+    host = colon < 0 ? hostPort : hostPort.substring(0, colon);
+    port = colon < 0 ? (scheme == "https" ? 443 : 80) : hostPort.substring(colon + 1).toInt();
+    client = &c;
+    requestHeaders.clear();
+    responseHeaders.clear();
+    size = -1;
+    return true;
+}
+
+void HTTPClient::end(void) {
+    if (connected()) {
+        if (client->available() > 0) {
+            client->flush();
+        }
+        if (!reuse || !canReuse) {
+            client->stop();
+        }
+    }
+    client = NULL;
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+    requestHeaders += std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+}
+
+String HTTPClient::header(const char* name) {
+    for (size_t i = 0; i < responseHeaders.size(); i++) {
+        if (responseHeaders[i].first.equalsIgnoreCase(name)) {
+            return responseHeaders[i].second;
+        }
+    }
+    return String();
+}
+
+bool HTTPClient::ReadLine(std::string& line) {
+    line.clear();
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs) {
+        int c = client->read();
+        if (c < 0) {
+            if (!client->connected()) {
+                return false;
+            }
+            delay(1);
+        } else if (c == '\n') {
+            if (!line.empty() && line[line.size() - 1] == '\r') {
+                line.erase(line.size() - 1);
+            }
+            return true;
+        } else {
+            line += (char)c;
+        }
+    }
+    return false;
+}
+
+int HTTPClient::sendRequest(const char* type, const String& body) {
+    if (client == NULL) {
+        return HTTPC_ERROR_NOT_CONNECTED;
+    }
+    // like the core: a connected client is used as it is
+    if (!client->connected() && !client->connect(host.c_str(), port, timeoutMs)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+    std::string req = std::string(type) + " " + uri.c_str() + " HTTP/1.1\r\nHost: " + host.c_str();
+    if (port != 443 && port != 80) {
+        req += ":" + std::to_string(port);
+    }
+    req += "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: ";
+    req += reuse ? "keep-alive" : "close";
+    req += "\r\n";
+    if (body.length() > 0 || strcmp(type, "POST") == 0) {
+        req += "Content-Length: " + std::to_string(body.length()) + "\r\n";
+    }
+    req += requestHeaders + "\r\n" + body.c_str();
+    if (client->write((const uint8_t*)req.data(), req.size()) != req.size()) {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+
+    std::string line;
+    if (!ReadLine(line) || line.compare(0, 5, "HTTP/") != 0) {
+        return HTTPC_ERROR_READ_TIMEOUT;
+    }
+    int code = atoi(line.c_str() + line.find(' ') + 1);
+    canReuse = reuse && line.compare(0, 8, "HTTP/1.0") != 0;
+    size = -1;
+    responseHeaders.clear();
+    while (ReadLine(line) && !line.empty()) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        String name = line.substr(0, colon);
+        String value = line.substr(colon + 1);
+        value.trim();
+        responseHeaders.push_back(std::make_pair(name, value));
+        if (name.equalsIgnoreCase("Content-Length")) {
+            size = value.toInt();
+        } else if (name.equalsIgnoreCase("Connection") && value.indexOf("close") >= 0) {
+            canReuse = false;
+        }
+    }
+    return code;
+}
+
+String HTTPClient::getString(void) {
+    std::string body;
+    unsigned long start = millis();
+    uint8_t buf[1024];
+    while (size >= 0 && body.size() < (size_t)size && millis() - start < timeoutMs) {
+        int n = client->read(buf, min(sizeof(buf), (size_t)size - body.size()));
+        if (n > 0) {
+            body.append((const char*)buf, n);
+        } else if (!client->connected()) {
+            break;
+        } else {
+            delay(1);
+        }
+    }
+    return body;
+}
+
+/* END OF FILE */
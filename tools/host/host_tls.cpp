@@ -0,0 +1,317 @@
+/**
+ *  @filename   :   host_tls.cpp
+ *  @brief      :   The mbedtls SSL calls of mbedtls/ssl.h, run by OpenSSL
+ *
+ *  OpenSSL reads and writes through a BIO that calls the send and recv
+ *  callbacks given to mbedtls_ssl_set_bio(), so the socket side is the
+ *  sketch's own. OpenSSL draws its own random numbers; the one given to
+ *  mbedtls_ssl_conf_rng() is not used.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <string.h>
+#include <vector>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include "mbedtls/net_sockets.h"
+
+static BIO_METHOD* callbackMethod = NULL;
+
+// mbedtls return codes to BIO results, the WANT_* ones as retries
+static int BioWrite(BIO* bio, const char* buf, int len) {
+    mbedtls_ssl_context* ssl = (mbedtls_ssl_context*)BIO_get_data(bio);
+    BIO_clear_retry_flags(bio);
+    int ret = ssl->send(ssl->bio, (const unsigned char*)buf, len);
+    if (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ) {
+        BIO_set_retry_write(bio);
+        return -1;
+    }
+    return ret < 0 ? -1 : ret;
+}
+
+static int BioRead(BIO* bio, char* buf, int len) {
+    mbedtls_ssl_context* ssl = (mbedtls_ssl_context*)BIO_get_data(bio);
+    BIO_clear_retry_flags(bio);
+    int ret = ssl->recv(ssl->bio, (unsigned char*)buf, len);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        BIO_set_retry_read(bio);
+        return -1;
+    }
+    return ret < 0 ? 0 : ret;
+}
+
+static long BioCtrl(BIO*, int cmd, long, void*) {
+    return cmd == BIO_CTRL_FLUSH ? 1 : 0;
+}
+
+static int BioCreate(BIO* bio) {
+    BIO_set_init(bio, 1);
+    return 1;
+}
+
+// OpenSSL's outcome of a call as an mbedtls return code
+static int Result(mbedtls_ssl_context* ssl, int ret) {
+    switch (SSL_get_error(ssl->ssl, ret)) {
+    case SSL_ERROR_WANT_READ:
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    case SSL_ERROR_WANT_WRITE:
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    case SSL_ERROR_ZERO_RETURN:
+        return MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY;
+    case SSL_ERROR_SYSCALL:
+        ERR_clear_error();
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    default:
+        ERR_clear_error();
+        return MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE;
+    }
+}
+
+void mbedtls_ssl_init(mbedtls_ssl_context* ssl) {
+    memset(ssl, 0, sizeof(*ssl));
+}
+
+void mbedtls_ssl_free(mbedtls_ssl_context* ssl) {
+    SSL_free(ssl->ssl);
+    memset(ssl, 0, sizeof(*ssl));
+}
+
+void mbedtls_ssl_config_init(mbedtls_ssl_config* conf) {
+    memset(conf, 0, sizeof(*conf));
+}
+
+void mbedtls_ssl_config_free(mbedtls_ssl_config* conf) {
+    SSL_CTX_free(conf->ctx);
+    memset(conf, 0, sizeof(*conf));
+}
+
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int, int, int) {
+    conf->ctx = SSL_CTX_new(TLS_client_method());
+    if (conf->ctx == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    SSL_CTX_set_max_proto_version(conf->ctx, TLS1_2_VERSION);
+    // sessions are kept by the caller, as with mbedtls
+    SSL_CTX_set_session_cache_mode(conf->ctx, SSL_SESS_CACHE_OFF);
+    return 0;
+}
+
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int) {
+    SSL_CTX_set_verify(conf->ctx, SSL_VERIFY_NONE, NULL);
+}
+
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config*, int (*)(void*, unsigned char*, size_t), void*) {
+}
+
+void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config* conf, int use) {
+    conf->tickets = use;
+    if (use) {
+        SSL_CTX_clear_options(conf->ctx, SSL_OP_NO_TICKET);
+    } else {
+        SSL_CTX_set_options(conf->ctx, SSL_OP_NO_TICKET);
+    }
+}
+
+int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf) {
+    if (callbackMethod == NULL) {
+        callbackMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "mbedtls callbacks");
+        BIO_meth_set_write(callbackMethod, BioWrite);
+        BIO_meth_set_read(callbackMethod, BioRead);
+        BIO_meth_set_ctrl(callbackMethod, BioCtrl);
+        BIO_meth_set_create(callbackMethod, BioCreate);
+    }
+    ssl->ssl = SSL_new(conf->ctx);
+    if (ssl->ssl == NULL) {
+        return MBEDTLS_ERR_SSL_ALLOC_FAILED;
+    }
+    BIO* bio = BIO_new(callbackMethod);
+    BIO_set_data(bio, ssl);
+    SSL_set_bio(ssl->ssl, bio, bio);
+    SSL_set_connect_state(ssl->ssl);
+    return 0;
+}
+
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname) {
+    return SSL_set_tlsext_host_name(ssl->ssl, hostname) == 1 ? 0 : MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+}
+
+void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* bio, mbedtls_ssl_send_t* send,
+                         mbedtls_ssl_recv_t* recv, mbedtls_ssl_recv_timeout_t*) {
+    ssl->bio = bio;
+    ssl->send = send;
+    ssl->recv = recv;
+}
+
+int mbedtls_ssl_handshake(mbedtls_ssl_context* ssl) {
+    if (ssl->start == 0) {
+        ssl->start = time(NULL);
+    }
+    int ret = SSL_do_handshake(ssl->ssl);
+    return ret == 1 ? 0 : Result(ssl, ret);
+}
+
+int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len) {
+    if (len == 0) {
+        // mbedtls decrypts the next record for a zero length read
+        unsigned char c;
+        int ret = SSL_peek(ssl->ssl, &c, 1);
+        return ret > 0 ? 0 : Result(ssl, ret);
+    }
+    int ret = SSL_read(ssl->ssl, buf, (int)len);
+    return ret > 0 ? ret : Result(ssl, ret);
+}
+
+int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len) {
+    int ret = SSL_write(ssl->ssl, buf, (int)len);
+    return ret > 0 ? ret : Result(ssl, ret);
+}
+
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl) {
+    return ssl->ssl ? SSL_pending(ssl->ssl) : 0;
+}
+
+int mbedtls_ssl_close_notify(mbedtls_ssl_context* ssl) {
+    int ret = SSL_shutdown(ssl->ssl);
+    return ret >= 0 ? 0 : Result(ssl, ret);
+}
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session) {
+    memset(session, 0, sizeof(*session));
+}
+
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session) {
+    SSL_SESSION_free(session->s);
+    memset(session, 0, sizeof(*session));
+}
+
+// DER length at p, moving p past it; 0 for a form not used here
+static size_t DerLength(const unsigned char*& p, const unsigned char* end) {
+    if (p >= end) {
+        return 0;
+    }
+    size_t n = *p++;
+    if (n < 0x80) {
+        return n;
+    }
+    int bytes = n & 0x7F;
+    n = 0;
+    while (bytes-- > 0 && p < end) {
+        n = (n << 8) | *p++;
+    }
+    return n;
+}
+
+static void PutDerLength(std::vector<unsigned char>& out, size_t n) {
+    if (n < 0x80) {
+        out.push_back((unsigned char)n);
+    } else if (n < 0x100) {
+        out.push_back(0x81);
+        out.push_back((unsigned char)n);
+    } else {
+        out.push_back(0x82);
+        out.push_back((unsigned char)(n >> 8));
+        out.push_back((unsigned char)n);
+    }
+}
+
+/**
+ *  @brief: the session in DER without the server certificate, element [3]
+ *          of the session sequence. SaveSession() drops it on the device
+ *          too; without it a session fits in TLS_CACHE_BYTES.
+ */
+static bool SessionDer(SSL_SESSION* s, std::vector<unsigned char>& out) {
+    int len = i2d_SSL_SESSION(s, NULL);
+    if (len <= 0) {
+        return false;
+    }
+    std::vector<unsigned char> der(len);
+    unsigned char* w = &der[0];
+    i2d_SSL_SESSION(s, &w);
+    const unsigned char* p = &der[0];
+    const unsigned char* end = p + len;
+    if (*p++ != 0x30) {
+        return false;
+    }
+    size_t seqLen = DerLength(p, end);
+    if (p + seqLen != end) {
+        return false;
+    }
+    std::vector<unsigned char> body;
+    while (p < end) {
+        const unsigned char* item = p++;
+        size_t n = DerLength(p, end);
+        if (p + n > end) {
+            return false;
+        }
+        p += n;
+        if (*item != 0xA3) {
+            body.insert(body.end(), item, p);
+        }
+    }
+    out.clear();
+    out.push_back(0x30);
+    PutDerLength(out, body.size());
+    out.insert(out.end(), body.begin(), body.end());
+    return true;
+}
+
+// 8 bytes of start time, then the session in DER
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t len, size_t* olen) {
+    std::vector<unsigned char> der;
+    if (!SessionDer(session->s, der)) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    *olen = 8 + der.size();
+    if (*olen > len) {
+        return MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL;
+    }
+    uint64_t start = (uint64_t)session->start;
+    for (int i = 0; i < 8; i++) {
+        buf[i] = (unsigned char)(start >> (8 * i));
+    }
+    memcpy(buf + 8, &der[0], der.size());
+    return 0;
+}
+
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len) {
+    if (len <= 8) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    uint64_t start = 0;
+    for (int i = 0; i < 8; i++) {
+        start |= (uint64_t)buf[i] << (8 * i);
+    }
+    const unsigned char* p = buf + 8;
+    SSL_SESSION* s = d2i_SSL_SESSION(NULL, &p, (long)(len - 8));
+    if (s == NULL) {
+        ERR_clear_error();
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    SSL_SESSION_free(session->s);
+    session->s = s;
+    session->start = (mbedtls_time_t)start;
+    return 0;
+}
+
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session) {
+    if (SSL_set_session(ssl->ssl, session->s) != 1) {
+        ERR_clear_error();
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    ssl->offeredStart = session->start;
+    return 0;
+}
+
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session) {
+    SSL_SESSION* s = SSL_get1_session(ssl->ssl);
+    if (s == NULL) {
+        return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+    }
+    SSL_SESSION_free(session->s);
+    session->s = s;
+    session->start = SSL_session_reused(ssl->ssl) ? ssl->offeredStart : ssl->start;
+    return 0;
+}
+
+/* END OF FILE */
@@ -0,0 +1,166 @@
+/**
+ *  @filename   :   https_wake.cpp
+ *  @brief      :   Runs the requests of a few wakes through the sketch's
+ *                  HttpsPool and TlsClient, for tools/https_wake_check.py
+ *
+ *  Each wake is the sketch's: DSlideShowStart and DSlideShow posted to
+ *  the API host, the slide read from the blob host (after a race of the
+ *  two mirrors when a second one is given), then CloseAll() before deep
+ *  sleep. The pool is new every wake, the TLS session cache lives on as
+ *  RTC memory does. time() is wrapped, so deep sleep moves the clock on
+ *  without waiting. WallClock stands in for wall_clock.cpp, which needs
+ *  SNTP; -k leaves the clock unset.
+ *
+ *  One line per wake on stdout, then "sleep" and, with -w, a wait for a
+ *  line on stdin so the caller can read its server's counters.
+ *
+ *      https_wake [-n wakes] [-s sleep seconds] [-k] [-w] <api URL> <blob URL> [<mirror URL>]
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <unistd.h>
+#include "https_pool.h"
+#include "wall_clock.h"
+
+static bool clockSet = true;
+static long slept = 0;
+
+extern "C" time_t __real_time(time_t* t);
+
+extern "C" time_t __wrap_time(time_t* t) {
+    time_t now = __real_time(NULL) + slept;
+    if (t != NULL) {
+        *t = now;
+    }
+    return now;
+}
+
+bool WallClock::Valid(void) {
+    return clockSet && time(NULL) > (time_t)CLOCK_VALID_AFTER;
+}
+
+struct WakeResult {
+    int requests;
+    int handshakes;
+    int resumed;
+    int failed;
+    long blobBytes;
+    double firstByteMs;     // wake to the first response
+    double totalMs;
+};
+
+// one API call as GetStart()/GetFile() make it
+static bool PostApi(HttpsPool& pool, HTTPClient& https, const String& url, WakeResult& r, unsigned long wakeUs) {
+    if (!pool.Begin(https, url)) {
+        return false;
+    }
+    https.addHeader("Content-Type", "application/json");
+    int code = https.POST("{\"battery\":3.9}");
+    if (r.firstByteMs < 0 && code > 0) {
+        r.firstByteMs = (micros() - wakeUs) / 1000.0;
+    }
+    String body = https.getString();
+    https.end();
+    return code == HTTP_CODE_OK && body.length() > 0;
+}
+
+static long GetBlob(HttpsPool& pool, HTTPClient& https, const String& url) {
+    pool.Begin(https, url);
+    if (https.GET() != HTTP_CODE_OK) {
+        https.end();
+        pool.Close(url);
+        return -1;
+    }
+    long len = https.getSize();
+    long got = 0;
+    uint8_t buf[4096];
+    unsigned long start = millis();
+    WiFiClient* stream = https.getStreamPtr();
+    while (stream != NULL && got < len && millis() - start < 10000) {
+        int n = stream->read(buf, min((long)sizeof(buf), len - got));
+        if (n > 0) {
+            got += n;
+        } else {
+            delay(1);
+        }
+    }
+    https.end();
+    if (got < len) {
+        pool.Close(url);
+    }
+    return got;
+}
+
+static WakeResult Wake(const String& api, const String& blob, const String& mirror) {
+    WakeResult r = { 0, 0, 0, 0, 0, -1, 0 };
+    unsigned long wakeUs = micros();
+    // a fresh boot: statics are back to their initial values, RTC memory is not
+    TlsClient::resumedCount = 0;
+    HttpsPool pool;
+    HTTPClient https;
+    r.failed += !PostApi(pool, https, api + "/epaper2/DSlideShowStart/user/screen/?subscription-key=host", r, wakeUs);
+    r.failed += !PostApi(pool, https, api + "/epaper2/DSlideShow/user/screen/?subscription-key=host", r, wakeUs);
+    String base = blob;
+    if (mirror.length() > 0) {
+        int won = pool.Race(blob + "/epaperfiles/slide.bin", mirror + "/epaperfiles/slide.bin");
+        // when both fail the sketch stays with its mirror, as here
+        if (won == 1) {
+            base = mirror;
+        }
+    }
+    r.blobBytes = GetBlob(pool, https, base + "/epaperfiles/slide.bin");
+    r.failed += r.blobBytes <= 0;
+    // GoToSleep()
+    pool.CloseAll();
+    r.totalMs = (micros() - wakeUs) / 1000.0;
+    r.requests = pool.requests;
+    r.handshakes = pool.handshakes;
+    r.resumed = TlsClient::resumedCount;
+    return r;
+}
+
+int main(int argc, char** argv) {
+    int wakes = 3;
+    long sleepSeconds = 600;
+    bool wait = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:kw")) != -1) {
+        switch (opt) {
+        case 'n': wakes = atoi(optarg); break;
+        case 's': sleepSeconds = atol(optarg); break;
+        case 'k': clockSet = false; break;
+        case 'w': wait = true; break;
+        default:
+            printf("usage: https_wake [-n wakes] [-s sleep seconds] [-k] [-w] <api URL> <blob URL> [<mirror URL>]\n");
+            return 2;
+        }
+    }
+    if (argc - optind < 2) {
+        printf("usage: https_wake [-n wakes] [-s sleep seconds] [-k] [-w] <api URL> <blob URL> [<mirror URL>]\n");
+        return 2;
+    }
+    String api = argv[optind];
+    String blob = argv[optind + 1];
+    String mirror = argc - optind > 2 ? argv[optind + 2] : "";
+
+    int failed = 0;
+    for (int i = 1; i <= wakes; i++) {
+        WakeResult r = Wake(api, blob, mirror);
+        printf("wake %d: requests %d handshakes %d resumed %d failed %d blob %ld first %.2f ms total %.2f ms\n",
+               i, r.requests, r.handshakes, r.resumed, r.failed, r.blobBytes, r.firstByteMs, r.totalMs);
+        printf("sleep\n");
+        fflush(stdout);
+        failed += r.failed;
+        if (wait) {
+            char line[16];
+            if (fgets(line, sizeof(line), stdin) == NULL) {
+                break;
+            }
+        }
+        slept += sleepSeconds;
+    }
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */
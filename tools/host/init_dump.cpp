@@ -0,0 +1,45 @@
+/**
+ *  @filename   :   init_dump.cpp
+ *  @brief      :   Writes the bus traffic of one Epd::Init() to a file,
+ *                  for tools/init_script_check.py
+ *
+ *  One line per event: "C xx" for a byte sent with DC low, "D xx" for one
+ *  with DC high and "B" for a read of the BUSY pin. BUSY always reads
+ *  idle, so every wait ends at its first read.
+ *
+ *      init_dump <out file> <BUSY idle level, 0 or 1>
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include "host_bus.h"
+#include "epd_base.h"
+
+static FILE* out;
+static int idleLevel;
+
+static void DumpByte(uint8_t data, bool dc, void*) {
+    fprintf(out, "%c %02x\n", dc ? 'D' : 'C', data);
+}
+
+static int DumpBusy(void*) {
+    fprintf(out, "B\n");
+    return idleLevel;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || (out = fopen(argv[1], "w")) == NULL) {
+        printf("usage: init_dump <out file> <BUSY idle level>\n");
+        return 2;
+    }
+    idleLevel = atoi(argv[2]) ? HIGH : LOW;
+    HostBus::Reset();
+    HostBus::onByte = DumpByte;
+    HostBus::busyLevel = DumpBusy;
+    Epd epd;
+    int ret = epd.Init();
+    fclose(out);
+    return ret == 0 ? 0 : 1;
+}
+
+/* END OF FILE */
@@ -0,0 +1,17 @@
+/**
+ *  @filename   :   net_sockets.h
+ *  @brief      :   Host stand-in for the mbedtls network error codes
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_MBEDTLS_NET_SOCKETS_H
+#define HOST_MBEDTLS_NET_SOCKETS_H
+
+#include "mbedtls/ssl.h"
+
+#define MBEDTLS_ERR_NET_CONN_RESET  -0x0050
+
+#endif
+
+/* END OF FILE */
@@ -0,0 +1,95 @@
+/**
+ *  @filename   :   ssl.h
+ *  @brief      :   Host stand-in for the mbedtls SSL calls tls_session.cpp
+ *                  makes, run by OpenSSL, see host_tls.cpp
+ *
+ *  The client speaks TLS 1.2 at most, like the mbedtls 2.x the ESP32
+ *  Arduino core ships. A saved session is its start time and the OpenSSL
+ *  session in DER, without the server certificate as on the device. As
+ *  in mbedtls, a resumed session keeps the start time of the full
+ *  handshake it came from.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_MBEDTLS_SSL_H
+#define HOST_MBEDTLS_SSL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define MBEDTLS_VERSION_MAJOR                   2
+#define MBEDTLS_SSL_SESSION_TICKETS
+
+#define MBEDTLS_SSL_IS_CLIENT                   0
+#define MBEDTLS_SSL_TRANSPORT_STREAM            0
+#define MBEDTLS_SSL_PRESET_DEFAULT              0
+#define MBEDTLS_SSL_VERIFY_NONE                 0
+#define MBEDTLS_SSL_SESSION_TICKETS_DISABLED    0
+#define MBEDTLS_SSL_SESSION_TICKETS_ENABLED     1
+
+#define MBEDTLS_ERR_SSL_BAD_INPUT_DATA          -0x7100
+#define MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL        -0x6A00
+#define MBEDTLS_ERR_SSL_ALLOC_FAILED            -0x7F00
+#define MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE     -0x7780
+#define MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY       -0x7880
+#define MBEDTLS_ERR_SSL_WANT_READ               -0x6900
+#define MBEDTLS_ERR_SSL_WANT_WRITE              -0x6880
+
+typedef time_t mbedtls_time_t;
+typedef int mbedtls_ssl_send_t(void* ctx, const unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_t(void* ctx, unsigned char* buf, size_t len);
+typedef int mbedtls_ssl_recv_timeout_t(void* ctx, unsigned char* buf, size_t len, uint32_t timeout);
+
+struct ssl_ctx_st;
+struct ssl_st;
+struct ssl_session_st;
+
+typedef struct mbedtls_ssl_config {
+    struct ssl_ctx_st* ctx;
+    int tickets;
+} mbedtls_ssl_config;
+
+typedef struct mbedtls_ssl_session {
+    struct ssl_session_st* s;
+    mbedtls_time_t start;
+} mbedtls_ssl_session;
+
+typedef struct mbedtls_ssl_context {
+    struct ssl_st* ssl;
+    void* bio;
+    mbedtls_ssl_send_t* send;
+    mbedtls_ssl_recv_t* recv;
+    mbedtls_time_t offeredStart;    // start of the session set, 0 for none
+    mbedtls_time_t start;           // when this handshake began
+} mbedtls_ssl_context;
+
+void mbedtls_ssl_init(mbedtls_ssl_context* ssl);
+void mbedtls_ssl_free(mbedtls_ssl_context* ssl);
+void mbedtls_ssl_config_init(mbedtls_ssl_config* conf);
+void mbedtls_ssl_config_free(mbedtls_ssl_config* conf);
+int mbedtls_ssl_config_defaults(mbedtls_ssl_config* conf, int endpoint, int transport, int preset);
+void mbedtls_ssl_conf_authmode(mbedtls_ssl_config* conf, int authmode);
+void mbedtls_ssl_conf_rng(mbedtls_ssl_config* conf, int (*rng)(void*, unsigned char*, size_t), void* arg);
+void mbedtls_ssl_conf_session_tickets(mbedtls_ssl_config* conf, int use);
+int mbedtls_ssl_setup(mbedtls_ssl_context* ssl, const mbedtls_ssl_config* conf);
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname);
+void mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* bio, mbedtls_ssl_send_t* send,
+                         mbedtls_ssl_recv_t* recv, mbedtls_ssl_recv_timeout_t* recvTimeout);
+int mbedtls_ssl_handshake(mbedtls_ssl_context* ssl);
+int mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len);
+int mbedtls_ssl_write(mbedtls_ssl_context* ssl, const unsigned char* buf, size_t len);
+size_t mbedtls_ssl_get_bytes_avail(const mbedtls_ssl_context* ssl);
+int mbedtls_ssl_close_notify(mbedtls_ssl_context* ssl);
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session);
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session);
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t len, size_t* olen);
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len);
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session);
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session);
+
+#endif
+
+/* END OF FILE */
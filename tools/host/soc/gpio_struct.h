@@ -0,0 +1,20 @@
+/**
+ *  @filename   :   gpio_struct.h
+ *  @brief      :   Host stand-in for the ESP-IDF GPIO register block
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#ifndef HOST_GPIO_STRUCT_H
+#define HOST_GPIO_STRUCT_H
+
+#include <stdint.h>
+
+typedef int gpio_num_t;
+typedef struct { uint32_t unused; } gpio_dev_t;
+
+extern gpio_dev_t GPIO;
+
+#endif
+
+/* END OF FILE */
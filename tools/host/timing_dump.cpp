@@ -0,0 +1,64 @@
+/**
+ *  @filename   :   timing_dump.cpp
+ *  @brief      :   Writes the simulated time of Epd::Init(), TurnOnDisplay()
+ *                  and Sleep() to a file, for tools/epd_timing_check.py
+ *
+ *  One line per phase: its name, the nanoseconds spent in delay() and
+ *  delayMicroseconds(), the nanoseconds of bytes on the wire and the
+ *  reads of BUSY. BUSY reads idle, so every wait ends at its first read
+ *  and only the fixed delays are left. A loop that waits for BUSY to be
+ *  asserted instead gets a busy read after BUSY_SPIN idle ones with no
+ *  byte sent in between, which costs the host WaitBusy() a 1 ms poll.
+ *
+ *      timing_dump <out file> <BUSY idle level, 0 or 1>
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include "host_bus.h"
+#include "epd_base.h"
+
+#define BUSY_SPIN   2
+
+static FILE* out;
+static int idleLevel;
+static unsigned long spin;
+static unsigned long spinBytes;
+
+static int IdleBusy(void*) {
+    if (HostBus::bytes != spinBytes) {
+        spinBytes = HostBus::bytes;
+        spin = 0;
+    }
+    if (++spin <= BUSY_SPIN) {
+        return idleLevel;
+    }
+    spin = 0;
+    return idleLevel == HIGH ? LOW : HIGH;
+}
+
+static void Phase(const char* name) {
+    fprintf(out, "%s %llu %llu %lu\n", name, HostBus::delayNs, HostBus::wireNs, HostBus::busyReads);
+    HostBus::ClearCounts();
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || (out = fopen(argv[1], "w")) == NULL) {
+        printf("usage: timing_dump <out file> <BUSY idle level>\n");
+        return 2;
+    }
+    idleLevel = atoi(argv[2]) ? HIGH : LOW;
+    HostBus::Reset();
+    HostBus::busyLevel = IdleBusy;
+    Epd epd;
+    int ret = epd.Init();
+    Phase("init");
+    epd.TurnOnDisplay();
+    Phase("refresh");
+    epd.Sleep();
+    Phase("sleep");
+    fclose(out);
+    return ret == 0 ? 0 : 1;
+}
+
+/* END OF FILE */
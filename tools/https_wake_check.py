@@ -0,0 +1,502 @@
+#!/usr/bin/env python3
+"""
+https_wake_check.py - host check that a wake's HTTPS requests share one
+keep-alive connection per host, against local stand-in servers
+
+Local TLS servers stand in for the API host and the blob host (and a
+second blob mirror with --race). tools/host/https_wake.cpp runs the
+sketch's https_pool.h and tls_session.cpp on top of them: per wake
+DSlideShowStart and DSlideShow are posted to the API, the slide is read
+from the blob host and CloseAll() runs before deep sleep. The servers
+count per wake:
+
+    handshakes  TLS connections, which must match the client's count
+                and be one per host (plus the mirror that lost the race)
+    requests    and how many went over each connection
+    closes      every connection must have ended with a close_notify
+                before the wake went to sleep
+
+Each stand-in is reached through a relay that holds every packet for half
+of --rtt and reads the client hello, so the check also sees which
+handshakes offered a cached TLS session:
+
+    resumed     from the second wake every host is offered its session
+                and the server takes it. --resume reject gives the
+                servers a new session cache per connection, --resume choke
+                makes the relay drop a connection that offers a session;
+                either way no request may fail. Nothing is offered with
+                --no-clock, or after a --sleep longer than
+                TLS_SESSION_MAX_AGE.
+
+--latency runs the wakes at a few RTTs with the servers taking and
+rejecting the sessions, and prints wake-to-first-byte (the first API
+response) for both. The relay cannot hold back the TCP handshake, so each
+figure is one RTT short of a real link in both columns.
+
+    python3 tools/https_wake_check.py
+    python3 tools/https_wake_check.py --race --wakes 5
+    python3 tools/https_wake_check.py --resume choke --rtt 50
+    python3 tools/https_wake_check.py --latency
+
+Needs g++, the openssl command and OpenSSL 3 headers; --openssl DIR (or
+OPENSSL_DIR) points at an install outside the compiler's paths. The exit
+code is 1 when a check fails.
+
+MIT License, Copyright (c) 2025 EpaperPix
+"""
+
+import argparse
+import json
+import os
+import queue
+import re
+import shutil
+import socket
+import ssl
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+# the client reaches each stand-in under its own name, so the pool and
+# the TLS session cache see different hosts
+HOSTS = (("api", "localhost", "127.0.0.1"), ("blob", "127.0.0.1", "127.0.0.1"),
+         ("mirror", "127.0.0.2", "127.0.0.2"))
+API_CALLS = 2
+
+
+class Conn:
+    def __init__(self, host):
+        self.host = host
+        self.handshake = False
+        self.resumed = False
+        self.requests = 0
+        self.clean = False
+        self.open = True
+
+
+class StandIn:
+    """TLS server for one host, keep-alive HTTP/1.1"""
+
+    def __init__(self, name, bind, cert, key, blob_size, reject):
+        self.name = name
+        self.cert = cert
+        self.key = key
+        self.reject = reject
+        self.blob = bytes(i * 7 & 0xFF for i in range(blob_size))
+        self.conns = []
+        self.lock = threading.Lock()
+        self.ctx = self.context()
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind((bind, 0))
+        self.sock.listen(8)
+        self.port = self.sock.getsockname()[1]
+        threading.Thread(target=self.accept, daemon=True).start()
+
+    def context(self):
+        # TLS 1.2, as the device's mbedtls speaks it
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.maximum_version = ssl.TLSVersion.TLSv1_2
+        ctx.load_cert_chain(self.cert, self.key)
+        return ctx
+
+    def accept(self):
+        while True:
+            sock, _ = self.sock.accept()
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            conn = Conn(self.name)
+            with self.lock:
+                self.conns.append(conn)
+            threading.Thread(target=self.serve, args=(sock, conn), daemon=True).start()
+
+    def serve(self, sock, conn):
+        sock.settimeout(30)
+        # a new context has its own session cache and ticket key
+        ctx = self.context() if self.reject else self.ctx
+        try:
+            tls = ctx.wrap_socket(sock, server_side=True, do_handshake_on_connect=False,
+                                       suppress_ragged_eofs=False)
+            tls.do_handshake()
+            conn.handshake = True
+            conn.resumed = tls.session_reused
+            stream = tls.makefile("rb")
+            while self.request(tls, stream, conn):
+                pass
+            tls.close()
+        except (OSError, ssl.SSLError):
+            sock.close()
+        conn.open = False
+
+    def request(self, tls, stream, conn):
+        """one request and its response, False once the connection ends"""
+        try:
+            line = stream.readline()
+        except ssl.SSLEOFError:
+            return False
+        if not line:
+            # read() returns nothing only after a close_notify
+            conn.clean = True
+            return False
+        headers = {}
+        while True:
+            h = stream.readline().decode("latin-1").strip()
+            if not h:
+                break
+            k, _, v = h.partition(":")
+            headers[k.strip().lower()] = v.strip()
+        stream.read(int(headers.get("content-length", "0")))
+        conn.requests += 1
+        path = line.split()[1].decode()
+        if "/epaperfiles/" in path:
+            status, body, kind = "200 OK", self.blob, "application/octet-stream"
+        elif "/DSlideShow" in path:
+            status, kind = "200 OK", "application/json"
+            body = json.dumps({"filename": "slide.bin", "sleepseconds": 600}).encode()
+        else:
+            status, body, kind = "404 Not Found", b"", "text/plain"
+        close = headers.get("connection", "").lower() == "close"
+        # the server ends a connection the client asked to close
+        conn.clean = close
+        tls.sendall(("HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %d\r\nETag: \"%08x\"\r\n"
+                     "Connection: %s\r\n\r\n" % (status, kind, len(body), len(body),
+                                                 "close" if close else "keep-alive")).encode() + body)
+        return not close
+
+    def take(self):
+        """connections since the last call"""
+        with self.lock:
+            conns, self.conns = self.conns, []
+        return conns
+
+    def busy(self):
+        with self.lock:
+            return any(c.open for c in self.conns)
+
+
+def offers_session(hello):
+    """True when a TLS client hello record carries a session ID or ticket"""
+    if len(hello) < 44 or hello[0] != 0x16 or hello[5] != 1:
+        return False
+    at = 43
+    if hello[at] > 0:
+        return True
+    at += 1 + hello[at]
+    at += 2 + int.from_bytes(hello[at:at + 2], "big")
+    at += 1 + hello[at]
+    end = at + 2 + int.from_bytes(hello[at:at + 2], "big")
+    at += 2
+    while at + 4 <= min(end, len(hello)):
+        kind = int.from_bytes(hello[at:at + 2], "big")
+        size = int.from_bytes(hello[at + 2:at + 4], "big")
+        if kind == 35 and size > 0:
+            return True
+        at += 4 + size
+    return False
+
+
+def read_exactly(sock, n):
+    data = b""
+    while len(data) < n:
+        part = sock.recv(n - len(data))
+        if not part:
+            return None
+        data += part
+    return data
+
+
+class Hello:
+    def __init__(self, host, offered, choked):
+        self.host = host
+        self.offered = offered
+        self.choked = choked
+
+
+class Relay:
+    """TCP relay in front of a stand-in, delays each way by half the RTT"""
+
+    def __init__(self, name, bind, port, rtt_ms, choke):
+        self.name = name
+        self.upstream = (bind, port)
+        self.delay = rtt_ms / 2000.0
+        self.choke = choke
+        self.hellos = []
+        self.lock = threading.Lock()
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.sock.bind((bind, 0))
+        self.sock.listen(8)
+        self.port = self.sock.getsockname()[1]
+        threading.Thread(target=self.accept, daemon=True).start()
+
+    def accept(self):
+        while True:
+            sock, _ = self.sock.accept()
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            threading.Thread(target=self.relay, args=(sock,), daemon=True).start()
+
+    def relay(self, client):
+        arrived = time.time()
+        head = read_exactly(client, 5)
+        body = read_exactly(client, int.from_bytes(head[3:5], "big")) if head else None
+        if body is None:
+            client.close()
+            return
+        hello = Hello(self.name, offers_session(head + body), False)
+        hello.choked = self.choke and hello.offered
+        with self.lock:
+            self.hellos.append(hello)
+        if hello.choked:
+            client.close()
+            return
+        up = socket.create_connection(self.upstream)
+        up.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        done = threading.Semaphore(0)
+        self.pipe(client, up, arrived, head + body, done)
+        self.pipe(up, client, None, None, done)
+        done.acquire()
+        done.acquire()
+        client.close()
+        up.close()
+
+    def pipe(self, src, dst, arrived, first, done):
+        """forward src to dst, each chunk self.delay after it came in"""
+        held = queue.Queue()
+        if first is not None:
+            held.put((arrived + self.delay, first))
+
+        def receive():
+            while True:
+                try:
+                    data = src.recv(65536)
+                except OSError:
+                    data = b""
+                held.put((time.time() + self.delay, data))
+                if not data:
+                    return
+
+        def send():
+            while True:
+                due, data = held.get()
+                time.sleep(max(0.0, due - time.time()))
+                try:
+                    if not data:
+                        dst.shutdown(socket.SHUT_WR)
+                        break
+                    dst.sendall(data)
+                except OSError:
+                    break
+            done.release()
+
+        threading.Thread(target=receive, daemon=True).start()
+        threading.Thread(target=send, daemon=True).start()
+
+    def take(self):
+        """client hellos since the last call"""
+        with self.lock:
+            hellos, self.hellos = self.hellos, []
+        return hellos
+
+
+def max_age(root):
+    """TLS_SESSION_MAX_AGE from tls_session.h, in seconds"""
+    with open(os.path.join(root, "Arduino", "epd_epaperpix_wifi", "tls_session.h")) as f:
+        m = re.search(r"#define\s+TLS_SESSION_MAX_AGE\s+\(?([0-9 *]+)UL", f.read())
+    seconds = 1
+    for factor in m.group(1).split("*"):
+        seconds *= int(factor)
+    return seconds
+
+
+def make_cert(work):
+    key = os.path.join(work, "key.pem")
+    cert = os.path.join(work, "cert.pem")
+    subprocess.run(("openssl", "req", "-x509", "-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1",
+                    "-nodes", "-subj", "/CN=epaperpix-standin", "-days", "1", "-keyout", key, "-out", cert),
+                   check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def build(tools, work, openssl):
+    root = os.path.dirname(tools)
+    sketch = os.path.join(root, "Arduino", "epd_epaperpix_wifi")
+    exe = os.path.join(work, "https_wake")
+    cmd = ["g++", "-O2", "-std=gnu++11", "-I" + os.path.join(tools, "host"), "-I" + sketch,
+           os.path.join(tools, "host", "https_wake.cpp"), os.path.join(tools, "host", "host_net.cpp"),
+           os.path.join(tools, "host", "host_tls.cpp"), os.path.join(sketch, "tls_session.cpp")]
+    if openssl:
+        lib = os.path.join(openssl, "lib")
+        cmd += ["-I" + os.path.join(openssl, "include"), "-L" + lib, "-Wl,-rpath," + lib]
+    cmd += ["-lssl", "-lcrypto", "-lz", "-Wl,--wrap=time", "-o", exe]
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    if res.returncode != 0:
+        sys.stdout.write(res.stdout.decode(errors="replace"))
+        return None
+    return exe
+
+
+def parse_wake(line):
+    """'wake 1: requests 3 handshakes 2 ...' -> dict"""
+    words = line.split(":", 1)[1].split()
+    return {a: float(b) for a, b in zip(words, words[1:])
+            if b.replace(".", "", 1).lstrip("-").isdigit()}
+
+
+def check_wake(n, client, conns, hellos, args, resume, offer):
+    """list of what is wrong with one wake"""
+    errors = []
+    hosts = 3 if args.race else 2
+    done = [c for c in conns if c.handshake]
+    used = [c for c in conns if c.requests > 0]
+    offered = sum(h.offered for h in hellos)
+    choked = sum(h.choked for h in hellos)
+    if client["failed"]:
+        errors.append("%d requests failed" % client["failed"])
+    # the pool counts a choked race handshake the servers never see
+    seen = (len(conns), len(conns) + choked) if args.race else (len(conns), len(conns))
+    if not seen[0] <= client["handshakes"] <= seen[1]:
+        errors.append("client counted %d handshakes, servers %d connections" % (client["handshakes"], len(conns)))
+    if client["requests"] != sum(c.requests for c in conns):
+        errors.append("client sent %d requests, servers got %d" % (client["requests"], sum(c.requests for c in conns)))
+    # a choked race is not tried again, the winner's host is
+    if len(conns) != hosts and not (choked and args.race):
+        errors.append("%d connections for %d hosts" % (len(conns), hosts))
+    api = [c for c in used if c.host == "api"]
+    if len(api) != 1 or api[0].requests != API_CALLS:
+        errors.append("API calls went over %d connections" % len(api))
+    if len(used) != 2:
+        errors.append("%d connections carried requests" % len(used))
+    for c in used:
+        if not c.clean:
+            errors.append("%s connection not closed with close_notify" % c.host)
+    # the mirror that lost the race is dropped mid-handshake
+    if len(conns) - len(used) > (1 if args.race else 0):
+        errors.append("%d connections without a request" % (len(conns) - len(used)))
+    if client["resumed"] != sum(c.resumed for c in done):
+        errors.append("client counted %d resumed handshakes, servers %d" % (client["resumed"], sum(c.resumed for c in done)))
+    if not offer or n == 1:
+        if offered:
+            errors.append("%d cached sessions offered, none expected" % offered)
+    elif not args.race:
+        # with three hosts the two-entry cache may have lost one
+        if offered != hosts:
+            errors.append("%d of %d hosts offered their cached session" % (offered, hosts))
+        if resume == "accept" and client["resumed"] != hosts:
+            errors.append("%d of %d handshakes resumed" % (client["resumed"], hosts))
+    if resume != "accept" and client["resumed"]:
+        errors.append("%d handshakes resumed, the servers reject sessions" % client["resumed"])
+    return errors
+
+
+def run(root, exe, cert, key, args, rtt, resume, show):
+    """one run of https_wake, returns the failed wake count and the wakes"""
+    servers = {name: StandIn(name, bind, cert, key, args.blob, resume == "reject") for name, _, bind in HOSTS}
+    relays = {name: Relay(name, bind, servers[name].port, rtt, resume == "choke") for name, _, bind in HOSTS}
+    urls = ["https://%s:%d" % (host, relays[name].port) for name, host, _ in HOSTS]
+    cmd = [exe, "-w", "-n", str(args.wakes), "-s", str(args.sleep)]
+    if args.no_clock:
+        cmd.append("-k")
+    cmd += urls[:3 if args.race else 2]
+    # nothing is offered without a clock or once the session is too old
+    offer = not args.no_clock and args.sleep <= max_age(root)
+    proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True)
+
+    failed = 0
+    wakes = []
+    if show:
+        print("%-5s %9s %11s %15s %10s %11s %9s %9s" % ("wake", "requests", "handshakes", "offered/resumed",
+                                                         "api/conn", "close", "first ms", "total ms"))
+    client = None
+    for line in proc.stdout:
+        if args.verbose:
+            sys.stdout.write("  | " + line)
+        if line.startswith("wake "):
+            client = parse_wake(line)
+            n = int(line.split()[1].rstrip(":"))
+        elif line.strip() == "sleep" and client is not None:
+            # the servers see the closes a moment later
+            deadline = time.time() + 5 + rtt / 100.0
+            while any(s.busy() for s in servers.values()) and time.time() < deadline:
+                time.sleep(0.01)
+            conns = [c for s in servers.values() for c in s.take()]
+            hellos = [h for r in relays.values() for h in r.take()]
+            errors = check_wake(n, client, conns, hellos, args, resume, offer)
+            if any(c.open for c in conns):
+                errors.append("connections still open at sleep")
+            api = [c.requests for c in conns if c.host == "api" and c.requests]
+            clean = sum(c.clean for c in conns if c.requests)
+            if show:
+                print("%-5d %9d %5d / %-3d %7d / %-5d %10s %5d / %-3d %9.2f %9.2f" % (
+                    n, client["requests"], client["handshakes"], len(conns), sum(h.offered for h in hellos),
+                    client["resumed"], "/".join(map(str, api)) or "-", clean, sum(1 for c in conns if c.requests),
+                    client["first"], client["total"]))
+            for e in errors:
+                print("      " + e)
+            failed += len(errors) > 0
+            wakes.append(client)
+            client = None
+            proc.stdin.write("\n")
+            proc.stdin.flush()
+    if proc.wait() != 0:
+        print("https_wake failed")
+        failed += 1
+    return failed, wakes
+
+
+def median(values):
+    values = sorted(values)
+    return values[len(values) // 2] if values else float("nan")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--wakes", type=int, default=3, help="wakes to run (default 3)")
+    ap.add_argument("--race", action="store_true", help="race two blob mirrors as MIRROR_RACE does")
+    ap.add_argument("--blob", type=int, default=48000, help="slide size in bytes (default 48000)")
+    ap.add_argument("--rtt", type=float, default=0, help="round trip the relays add, ms (default 0)")
+    ap.add_argument("--resume", choices=("accept", "reject", "choke"), default="accept",
+                    help="what the servers do with an offered session (default accept)")
+    ap.add_argument("--sleep", type=int, default=600, help="deep sleep between wakes, seconds (default 600)")
+    ap.add_argument("--no-clock", action="store_true", help="wake without a set clock")
+    ap.add_argument("--latency", action="store_true", help="wake-to-first-byte with and without resumption")
+    ap.add_argument("-v", "--verbose", action="store_true", help="show the client's log")
+    ap.add_argument("--openssl", default=os.environ.get("OPENSSL_DIR"), help="OpenSSL install prefix")
+    args = ap.parse_args()
+
+    tools = os.path.dirname(os.path.abspath(__file__))
+    work = tempfile.mkdtemp(prefix="https_wake_check.")
+    try:
+        exe = build(tools, work, args.openssl)
+        if exe is None:
+            print("https_wake does not build")
+            return 1
+        cert, key = make_cert(work)
+        root = os.path.dirname(tools)
+        if not args.latency:
+            failed, _ = run(root, exe, cert, key, args, args.rtt, args.resume, True)
+            print("%d wakes, %d failed" % (args.wakes, failed))
+            return 1 if failed else 0
+
+        # the first wake has nothing cached, the later ones are compared
+        args.wakes = max(args.wakes, 4)
+        failed = 0
+        print("%-7s %14s %14s %9s %14s %14s" % ("rtt ms", "full first", "resumed first", "saved",
+                                                "full total", "resumed total"))
+        for rtt in ((args.rtt,) if args.rtt else (10, 50, 100, 200)):
+            figures = {}
+            for resume in ("reject", "accept"):
+                f, wakes = run(root, exe, cert, key, args, rtt, resume, False)
+                failed += f
+                figures[resume] = (median([w["first"] for w in wakes[1:]]), median([w["total"] for w in wakes[1:]]))
+            print("%-7g %14.1f %14.1f %8.0f%% %14.1f %14.1f" % (
+                rtt, figures["reject"][0], figures["accept"][0],
+                100.0 * (1 - figures["accept"][0] / figures["reject"][0]), figures["reject"][1], figures["accept"][1]))
+        print("%d failed" % failed)
+        return 1 if failed else 0
+    finally:
+        shutil.rmtree(work)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
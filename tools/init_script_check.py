@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""
+init_script_check.py - host check that the init scripts send what the
+hand-written Init() sequences sent
+
+Each driver is built twice against the simulated bus in tools/host, once
+from the tree before the scripts (commit 1e38cb1, "Run controller init
+from constexpr scripts", so its parent by default) and once from the
+working tree. tools/host/init_dump.cpp runs Epd::Init() and records every
+byte with its DC level and every read of BUSY. The bytes and DC levels
+must match; delays are not compared.
+
+BUSY always reads idle, at the level opposite to the driver's
+EPD_BUSY_LEVEL. Before WaitBusy() the UC81xx drivers polled BUSY by sending
+0x71 (get status) before each read; such a 0x71 is dropped. Where the
+waits are is only compared with --busy, since the per-controller timing
+that came after the scripts replaced fixed delays with BUSY waits.
+
+Some vendor SendData() left DC low, so their init data went out as
+commands; RunScript() sends it with DC high. For the drivers in DC_FIXED
+the old and new bytes must match with DC high wherever the old had it low.
+
+    python3 tools/init_script_check.py
+    python3 tools/init_script_check.py --busy --old 1e38cb1~1 --new 1e38cb1 epd7in3f
+
+Runs from anywhere inside the git checkout and needs g++. The exit code
+is 1 when a driver sends something different.
+
+MIT License, Copyright (c) 2025 EpaperPix
+"""
+
+import argparse
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+SKETCHES = ("epd_epaperpix_wifi", "epd_serial")
+# builds without its own macro, every other driver needs this one defined
+DEFAULT_DRIVER_MACRO = "EPD7IN5_V2_C"
+GET_STATUS = ("C", 0x71)
+# drivers whose hand-written init sent its data with DC low
+DC_FIXED = ("epd_epaperpix_wifi/epd2in13_V3", "epd_epaperpix_wifi/epd7in5",
+            "epd_serial/epd2in13_V3", "epd_serial/epd7in5", "epd_serial/epd7in5b_V2")
+
+
+def git(root, *args):
+    return subprocess.run(("git", "-C", root) + args, check=True,
+                          stdout=subprocess.PIPE).stdout
+
+
+def export_tree(root, rev, dest):
+    """sketch folders as they were at rev, under dest"""
+    archive = git(root, "archive", rev, *["Arduino/" + s for s in SKETCHES])
+    os.makedirs(dest)
+    subprocess.run(("tar", "-x", "-C", dest), input=archive, check=True)
+    return dest
+
+
+def driver_flags(path):
+    with open(path, errors="replace") as f:
+        m = re.search(r"^#if(n?)def (EPD[A-Z0-9_]+_C)", f.read(), re.M)
+    if m is None or m.group(1) == "n":
+        return []
+    return ["-D" + DEFAULT_DRIVER_MACRO, "-D" + m.group(2)]
+
+
+def busy_idle(path):
+    """BUSY level of an idle controller, from the working tree driver"""
+    with open(path, errors="replace") as f:
+        m = re.search(r"#define EPD_BUSY_LEVEL\s+(HIGH|LOW)", f.read())
+    return "0" if m and m.group(1) == "HIGH" else "1"
+
+
+class Builder:
+    """builds each driver with a tools/host dump program and runs it,
+    the dump file goes through parse_dump"""
+    def __init__(self, tools, sketch_dir, work, dump="init_dump.cpp", parse_dump=None):
+        self.tools = tools
+        self.dir = sketch_dir
+        self.work = work
+        self.dump = dump
+        self.parse = parse_dump or parse
+        self.common = None
+
+    def flags(self):
+        return ["g++", "-O0", "-std=gnu++11", "-w", "-I" + os.path.join(self.tools, "host"),
+                "-I" + self.dir]
+
+    def build_common(self):
+        """objects every driver links, built once per tree"""
+        self.common = []
+        sources = [os.path.join(self.tools, "host", self.dump),
+                   os.path.join(self.tools, "host", "host_bus.cpp"),
+                   os.path.join(self.dir, "epdif.cpp")]
+        if os.path.exists(os.path.join(self.dir, "epd_common.cpp")):
+            sources.append(os.path.join(self.dir, "epd_common.cpp"))
+        for src in sources:
+            obj = os.path.join(self.work, os.path.basename(src) + ".o")
+            res = subprocess.run(self.flags() + ["-c", src, "-o", obj],
+                                 stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+            if res.returncode != 0:
+                return res.stdout.decode(errors="replace")
+            self.common.append(obj)
+        return None
+
+    def run(self, driver, idle):
+        src = os.path.join(self.dir, driver + ".cpp")
+        if not os.path.exists(src):
+            return None, "missing"
+        exe = os.path.join(self.work, driver)
+        res = subprocess.run(self.flags() + driver_flags(src) + [src] + self.common + ["-o", exe],
+                             stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        if res.returncode != 0:
+            err = [l for l in res.stdout.decode(errors="replace").splitlines() if "error" in l]
+            return None, "does not build: " + (err[0] if err else "?")
+        dump = exe + ".txt"
+        res = subprocess.run((exe, dump, idle), stdout=subprocess.DEVNULL,
+                             stderr=subprocess.DEVNULL, timeout=60)
+        if res.returncode != 0 or not os.path.exists(dump):
+            return None, "Init() failed"
+        with open(dump) as f:
+            return self.parse(f.read().split("\n")), None
+
+
+def parse(lines):
+    events = []
+    for line in lines:
+        if not line:
+            continue
+        kind = line[0]
+        if kind == "B":
+            # the old busy loops sent 0x71 before every read
+            if events and events[-1] == GET_STATUS:
+                events.pop()
+            if not events or events[-1] != ("B", None):
+                events.append(("B", None))
+        else:
+            events.append((kind, int(line[2:], 16)))
+    return events
+
+
+def show(e):
+    return "BUSY" if e[0] == "B" else "%s %02X" % e
+
+
+def comparable(events, busy, dc_fixed):
+    if not busy:
+        events = [e for e in events if e[0] != "B"]
+    if dc_fixed:
+        events = [("D", e[1]) if e[0] == "C" else e for e in events]
+    return events
+
+
+def compare(old, new):
+    """None when equal, else a line saying where they part"""
+    n = next((i for i, (a, b) in enumerate(zip(old, new)) if a != b), min(len(old), len(new)))
+    if n == len(old) == len(new):
+        return None
+    before = " ".join(show(e) for e in old[max(0, n - 4):n])
+    a = show(old[n]) if n < len(old) else "end"
+    b = show(new[n]) if n < len(new) else "end"
+    return "event %d after [%s]: old %s, new %s" % (n, before, a, b)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("drivers", nargs="*", help="drivers to check, e.g. epd7in3f (default all)")
+    ap.add_argument("--old", default="1e38cb1~1", help="revision with the hand-written Init()")
+    ap.add_argument("--new", help="revision to check (default the working tree)")
+    ap.add_argument("--busy", action="store_true", help="compare where the BUSY waits are as well")
+    ap.add_argument("--keep", action="store_true", help="leave the build directory behind")
+    args = ap.parse_args()
+
+    tools = os.path.dirname(os.path.abspath(__file__))
+    root = git(tools, "rev-parse", "--show-toplevel").decode().strip()
+    work = tempfile.mkdtemp(prefix="init_script_check.")
+    old_root = export_tree(root, args.old, os.path.join(work, "old"))
+    if args.new:
+        new_root = export_tree(root, args.new, os.path.join(work, "new"))
+    else:
+        new_root = root
+
+    differ = 0
+    checked = 0
+    skipped = []
+    print("%-20s %-14s %8s  %s" % ("sketch", "driver", "events", "result"))
+    for sketch in SKETCHES:
+        builders = {}
+        for name, tree in (("old", old_root), ("new", new_root)):
+            out = os.path.join(work, name + "-" + sketch)
+            os.makedirs(out)
+            builders[name] = Builder(tools, os.path.join(tree, "Arduino", sketch), out)
+            err = builders[name].build_common()
+            if err:
+                print("%s: %s epdif.cpp does not build:\n%s" % (sketch, name, err))
+                return 1
+        drivers = args.drivers or sorted(
+            os.path.basename(p)[:-4]
+            for p in glob.glob(os.path.join(root, "Arduino", sketch, "epd[0-9]*.cpp")))
+        for driver in drivers:
+            idle = busy_idle(os.path.join(root, "Arduino", sketch, driver + ".cpp"))
+            old, old_err = builders["old"].run(driver, idle)
+            new, new_err = builders["new"].run(driver, idle)
+            if old_err or new_err:
+                why = ("old " + old_err) if old_err else ("new " + new_err)
+                skipped.append("%s/%s" % (sketch, driver))
+                print("%-20s %-14s %8s  skipped, %s" % (sketch, driver, "", why))
+                continue
+            checked += 1
+            fixed = "%s/%s" % (sketch, driver) in DC_FIXED
+            diff = compare(comparable(old, args.busy, False), comparable(new, args.busy, False))
+            if diff and fixed:
+                # both with every byte as data: only the DC level may differ
+                diff = compare(comparable(old, args.busy, True), comparable(new, args.busy, True))
+                if diff is None:
+                    diff = "same bytes, data now with DC high"
+                else:
+                    differ += 1
+            elif diff:
+                differ += 1
+            print("%-20s %-14s %8d  %s" % (sketch, driver, len(new), diff or "same"))
+
+    print("%d drivers checked, %d differ, %d skipped" % (checked, differ, len(skipped)))
+    if args.keep:
+        print("build directory: " + work)
+    else:
+        shutil.rmtree(work)
+    return 1 if differ else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,502 @@
+/**
+ *  @filename   :   slide_pump_test.cpp
+ *  @brief      :   Host test of the download-to-panel pump against a fake
+ *                  stream and a fake DMA
+ *
+ *  Runs Arduino/epd_epaperpix_wifi/slide_pump.cpp on a PC with a simulated
+ *  clock. The fake stream delivers a pseudo-random body at a set rate in
+ *  random short reads, can pause for a while and can end early. The fake
+ *  DMA takes each buffer at a set SPI rate and checks that the pump does
+ *  not touch a buffer before its transfer is over. Cases:
+ *
+ *      whole frames    every byte lands at its panel offset, one data
+ *                      command per step; the time is close to
+ *                      max(network, SPI) rather than their sum
+ *      short reads     reads of a few bytes at most
+ *      stalls          a pause longer than the stall time stops the pump
+ *                      where the data stopped, a shorter one does not
+ *      truncation      a body that ends early is reported, not complete
+ *      resume          a 206 body from a panel offset, a full body with
+ *                      the start skipped, and a UC81xx step restarted
+ *                      from its beginning
+ *      rows            ReadFull() hands out whole rows, and stops at a
+ *                      stall or the end of the body
+ *      ring            Fill() and Drain() on two threads through the SPSC
+ *                      ring, a cut first attempt and a second one that
+ *                      skips what the first delivered
+ *
+ *      g++ -O2 -std=c++11 -pthread -Itools/host -IArduino/epd_epaperpix_wifi \
+ *          tools/slide_pump_test.cpp Arduino/epd_epaperpix_wifi/slide_pump.cpp \
+ *          -o slide_pump_test
+ *      ./slide_pump_test
+ *
+ *  The exit code is 1 when a check fails.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "slide_pump.h"
+
+static int failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("  FAILED line %d: %s\n", __LINE__, #cond); \
+            failed++; \
+        } \
+    } while (0)
+
+// simulated clock; delay() and the fake DMA move it on
+static std::atomic<unsigned long long> nowUs(0);
+
+unsigned long millis(void) {
+    return nowUs / 1000;
+}
+
+unsigned long micros(void) {
+    return nowUs;
+}
+
+void delay(unsigned long ms) {
+    nowUs += ms * 1000ULL;
+}
+
+static void AdvanceTo(unsigned long long us) {
+    unsigned long long now = nowUs;
+    while (now < us && !nowUs.compare_exchange_weak(now, us)) {
+    }
+}
+
+// byte n of the frame, the same for the stream and the check
+static uint8_t FrameByte(uint64_t n) {
+    uint64_t x = (n + 1) * 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 29;
+    return (uint8_t)(x * 0xBF58476D1CE4E5B9ULL >> 56);
+}
+
+struct Random {
+    uint32_t s;
+    explicit Random(uint32_t seed) : s(seed ? seed : 1) {}
+    uint32_t Next(void) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        return s;
+    }
+};
+
+/**
+ *  @brief: a body from frame offset base: rate bytes per ms (0 for all at
+ *          once), reads of 1..maxRead bytes, a pause of pauseMs after
+ *          pauseAt bytes, and the end after length bytes
+ */
+struct FakeStream {
+    long base;
+    long length;
+    long pos;
+    unsigned long rate;
+    size_t maxRead;
+    long pauseAt;
+    unsigned long pauseMs;
+    unsigned long long startUs;
+    Random random;
+
+    FakeStream(long from, long len, unsigned long bytesPerMs, size_t most)
+        : base(from), length(len), pos(0), rate(bytesPerMs), maxRead(most), pauseAt(-1), pauseMs(0),
+          startUs(nowUs), random(len + from + 1) {}
+
+    // bytes that came in by now
+    long Arrived(void) {
+        if (rate == 0) {
+            return length;
+        }
+        unsigned long long t = nowUs - startUs;
+        unsigned long long n = t * rate / 1000;
+        if (pauseAt >= 0 && n > (unsigned long long)pauseAt) {
+            unsigned long long pauseUs = (unsigned long long)pauseAt * 1000 / rate;
+            unsigned long long resumeUs = pauseUs + pauseMs * 1000ULL;
+            n = t < resumeUs ? pauseAt : pauseAt + (t - resumeUs) * rate / 1000;
+        }
+        return (long)min(n, (unsigned long long)length);
+    }
+
+    int Read(uint8_t* dst, size_t len) {
+        if (pos >= length) {
+            return -1;
+        }
+        size_t n = min(len, (size_t)(Arrived() - pos));
+        n = min(n, (size_t)(random.Next() % maxRead + 1));
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = FrameByte(base + pos + i);
+        }
+        pos += n;
+        return (int)n;
+    }
+
+    static int Callback(uint8_t* dst, size_t len, void* arg) {
+        return ((FakeStream*)arg)->Read(dst, len);
+    }
+};
+
+/**
+ *  @brief: the panel behind a DMA of nsPerByte per byte. A buffer counts
+ *          as in flight until the transfer after it starts or wait(); it
+ *          must not change meanwhile.
+ */
+struct FakeDma {
+    std::vector<uint8_t> panel;
+    std::vector<bool> written;
+    unsigned long blockSize;
+    long pos;
+    int stepsStarted;
+    unsigned long nsPerByte;
+    const uint8_t* flying;
+    std::vector<uint8_t> flyingCopy;
+    unsigned long long doneUs;
+    int touched;                    // buffers changed while in flight
+
+    FakeDma(int steps, unsigned long size, unsigned long ns)
+        : panel(steps * size), written(steps * size), blockSize(size), pos(-1), stepsStarted(0), nsPerByte(ns),
+          flying(NULL), doneUs(0), touched(0) {}
+
+    void Land(void) {
+        if (flying == NULL) {
+            return;
+        }
+        AdvanceTo(doneUs);
+        if (memcmp(flying, flyingCopy.data(), flyingCopy.size()) != 0) {
+            touched++;
+        }
+        flying = NULL;
+    }
+
+    void Send(const uint8_t* src, size_t len, bool async) {
+        Land();
+        CHECK(pos >= 0 && pos + (long)len <= (long)panel.size());
+        if (pos < 0 || pos + (long)len > (long)panel.size()) {
+            return;
+        }
+        memcpy(&panel[pos], src, len);
+        for (size_t i = 0; i < len; i++) {
+            written[pos + i] = true;
+        }
+        pos += len;
+        doneUs = max((unsigned long long)nowUs, doneUs) + len * nsPerByte / 1000;
+        flying = src;
+        flyingCopy.assign(src, src + len);
+        if (!async) {
+            Land();
+        }
+    }
+
+    // panel[from, to) holds the frame bytes and nothing else was written
+    bool Holds(long from, long to) {
+        for (long i = 0; i < (long)panel.size(); i++) {
+            bool in = i >= from && i < to;
+            if (written[i] != in || (in && panel[i] != FrameByte(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void StartStep(int step, void* arg) {
+        FakeDma* d = (FakeDma*)arg;
+        d->Land();
+        d->pos = step * d->blockSize;
+        d->stepsStarted++;
+    }
+    static void SendAsync(const uint8_t* src, size_t len, void* arg) {
+        ((FakeDma*)arg)->Send(src, len, true);
+    }
+    static void SendSync(const uint8_t* src, size_t len, void* arg) {
+        ((FakeDma*)arg)->Send(src, len, false);
+    }
+    static void Wait(void* arg) {
+        ((FakeDma*)arg)->Land();
+    }
+    PumpSink AsyncSink(void) {
+        PumpSink s = { StartStep, SendAsync, Wait, this };
+        return s;
+    }
+    PumpSink SyncSink(void) {
+        PumpSink s = { StartStep, SendSync, Wait, this };
+        return s;
+    }
+};
+
+#define STALL_MS    10000
+#define BUF_SIZE    4096
+
+struct Buffers {
+    uint8_t a[BUF_SIZE];
+    uint8_t b[BUF_SIZE];
+    uint8_t* bufs[2];
+    Buffers() {
+        bufs[0] = a;
+        bufs[1] = b;
+    }
+};
+
+// one Run() from startAt over a body starting at frame offset base; the
+// panel already points at startAt when started is set (ResumeStep())
+static bool RunOnce(FakeStream& stream, FakeDma& dma, int steps, unsigned long blockSize, long startAt,
+                    long skip, SlidePump* out = NULL) {
+    Buffers b;
+    SlidePump pump(steps, blockSize, STALL_MS);
+    pump.Source(FakeStream::Callback, &stream);
+    if (startAt > 0) {
+        dma.pos = startAt;
+    }
+    if (skip > 0 && !pump.Skip(skip)) {
+        if (out != NULL) {
+            *out = pump;
+        }
+        return false;
+    }
+    bool ok = pump.Run(b.bufs, BUF_SIZE, dma.AsyncSink(), startAt);
+    CHECK(dma.touched == 0);
+    if (out != NULL) {
+        *out = pump;
+    }
+    return ok;
+}
+
+static void WholeFrames(void) {
+    printf("whole frames: network and SPI overlap\n");
+    printf("  %-26s %9s %9s %9s %9s\n", "", "net ms", "SPI ms", "sum ms", "pump ms");
+    struct Case {
+        const char* name;
+        int steps;
+        unsigned long blockSize;
+        unsigned long rate;         // bytes per ms
+        unsigned long nsPerByte;
+    } cases[] = {
+        { "epd7in3f 192000, net fast", 1, 192000, 4000, 400 },
+        { "epd7in3f 192000, SPI fast", 1, 192000, 1000, 400 },
+        { "epd7in3f 192000, even", 1, 192000, 2500, 400 },
+        { "epd7in5_V2 2 x 48000", 2, 48000, 2000, 800 },
+        { "epd7in5b_V2 2 x 48000", 2, 48000, 1500, 800 },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const Case& c = cases[i];
+        long total = c.steps * c.blockSize;
+        FakeDma dma(c.steps, c.blockSize, c.nsPerByte);
+        unsigned long long start = nowUs;
+        FakeStream stream(0, total, c.rate, 1460);
+        CHECK(RunOnce(stream, dma, c.steps, c.blockSize, 0, 0));
+        double pumpMs = (nowUs - start) / 1000.0;
+        double netMs = (double)total / c.rate;
+        double spiMs = total * c.nsPerByte / 1e6;
+        printf("  %-26s %9.1f %9.1f %9.1f %9.1f\n", c.name, netMs, spiMs, netMs + spiMs, pumpMs);
+        CHECK(dma.Holds(0, total));
+        CHECK(dma.stepsStarted == c.steps);
+        // one buffer of the slower side plus the read polling
+        double bufMs = BUF_SIZE * max(1.0 / c.rate, c.nsPerByte / 1e6);
+        CHECK(pumpMs <= max(netMs, spiMs) + 2 * bufMs + 2);
+    }
+}
+
+static void ShortReads(void) {
+    printf("short reads\n");
+    for (size_t most = 1; most <= 7; most += 3) {
+        FakeDma dma(2, 48000, 0);
+        FakeStream stream(0, 96000, 0, most);
+        CHECK(RunOnce(stream, dma, 2, 48000, 0, 0));
+        CHECK(dma.Holds(0, 96000));
+        CHECK(dma.stepsStarted == 2);
+    }
+}
+
+static void Stalls(void) {
+    printf("stalls\n");
+    SlidePump pump(2, 48000, STALL_MS);
+    {
+        FakeDma dma(2, 48000, 800);
+        FakeStream stream(0, 96000, 2000, 1460);
+        stream.pauseAt = 30000;
+        stream.pauseMs = STALL_MS + 500;
+        CHECK(!RunOnce(stream, dma, 2, 48000, 0, 0, &pump));
+        CHECK(pump.stalled && !pump.ended);
+        CHECK(pump.moved == 30000);
+        CHECK(dma.Holds(0, 30000));
+    }
+    {
+        FakeDma dma(2, 48000, 800);
+        FakeStream stream(0, 96000, 2000, 1460);
+        stream.pauseAt = 50000;
+        stream.pauseMs = STALL_MS - 500;
+        CHECK(RunOnce(stream, dma, 2, 48000, 0, 0, &pump));
+        CHECK(!pump.stalled);
+        CHECK(dma.Holds(0, 96000));
+    }
+    {
+        // the skipped start of a full body stalls too
+        FakeDma dma(2, 48000, 800);
+        FakeStream stream(0, 96000, 2000, 1460);
+        stream.pauseAt = 1000;
+        stream.pauseMs = STALL_MS + 500;
+        CHECK(!RunOnce(stream, dma, 2, 48000, 20000, 20000, &pump));
+        CHECK(pump.stalled);
+        CHECK(dma.Holds(0, 0));
+    }
+}
+
+static void Truncation(void) {
+    printf("truncation\n");
+    SlidePump pump(2, 48000, STALL_MS);
+    long cuts[] = { 0, 1, 4095, 4096, 47999, 48000, 60000, 95999 };
+    for (size_t i = 0; i < sizeof(cuts) / sizeof(cuts[0]); i++) {
+        FakeDma dma(2, 48000, 800);
+        FakeStream stream(0, cuts[i], 2000, 1460);
+        CHECK(!RunOnce(stream, dma, 2, 48000, 0, 0, &pump));
+        CHECK(pump.ended && !pump.stalled);
+        CHECK(pump.moved == cuts[i]);
+        CHECK(dma.Holds(0, cuts[i]));
+    }
+}
+
+static void Resume(void) {
+    printf("resume\n");
+    SlidePump pump(3, 48000, STALL_MS);
+    long offsets[] = { 1, 4096, 20000, 47999, 60000, 100000, 143999 };
+    for (size_t i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+        long at = offsets[i];
+        // 206: the body starts at the offset
+        FakeDma partial(3, 48000, 800);
+        FakeStream range(at, 144000 - at, 2000, 1460);
+        CHECK(RunOnce(range, partial, 3, 48000, at, 0, &pump));
+        CHECK(pump.moved == 144000 - at);
+        CHECK(partial.Holds(at, 144000));
+        // the data commands of the steps after the resumed one only
+        CHECK(partial.stepsStarted == 2 - at / 48000);
+
+        // 200: the whole body, the start dropped
+        FakeDma full(3, 48000, 800);
+        FakeStream body(0, 144000, 2000, 1460);
+        CHECK(RunOnce(body, full, 3, 48000, at, at, &pump));
+        CHECK(full.Holds(at, 144000));
+    }
+    // UC81xx: ResumeStep() rewinds to the start of the step
+    FakeDma dma(3, 48000, 800);
+    FakeStream range(48000, 96000, 2000, 1460);
+    CHECK(RunOnce(range, dma, 3, 48000, 48000, 0, &pump));
+    CHECK(dma.Holds(48000, 144000));
+    CHECK(dma.stepsStarted == 1);
+}
+
+// the source rows of an on-device dithered slide
+static void Rows(void) {
+    printf("rows\n");
+    const size_t rowBytes = 800 * 3;
+    std::vector<uint8_t> row(rowBytes);
+    SlidePump pump(1, 480 * rowBytes, STALL_MS);
+    {
+        FakeStream stream(0, 480 * rowBytes, 2000, 1460);
+        pump.Source(FakeStream::Callback, &stream);
+        bool same = true;
+        for (long r = 0; r < 480; r++) {
+            CHECK(pump.ReadFull(row.data(), rowBytes));
+            for (size_t i = 0; i < rowBytes; i++) {
+                same = same && row[i] == FrameByte(r * rowBytes + i);
+            }
+        }
+        CHECK(same);
+        CHECK(!pump.ReadFull(row.data(), 1));
+        CHECK(pump.ended);
+    }
+    {
+        FakeStream stream(0, 480 * rowBytes, 2000, 1460);
+        stream.pauseAt = 10 * rowBytes + 100;
+        stream.pauseMs = STALL_MS + 500;
+        pump.Source(FakeStream::Callback, &stream);
+        long r = 0;
+        while (pump.ReadFull(row.data(), rowBytes)) {
+            r++;
+        }
+        CHECK(r == 10 && pump.stalled);
+    }
+    {
+        FakeStream stream(0, 2 * rowBytes - 1, 0, 1460);
+        pump.Source(FakeStream::Callback, &stream);
+        CHECK(pump.ReadFull(row.data(), rowBytes));
+        CHECK(!pump.ReadFull(row.data(), rowBytes));
+        CHECK(pump.ended && !pump.stalled);
+    }
+}
+
+struct RingSide {
+    static void Yield(void* arg) {
+        std::this_thread::yield();
+    }
+    static void Nothing(void* arg) {
+    }
+    static void Tap(const uint8_t* src, size_t len, void* arg) {
+        *(long*)arg += len;
+    }
+};
+
+// Fill() and Drain() on two threads; the first attempt is cut at cut
+static void RingRun(size_t ringSize, size_t chunk, long cut, bool range) {
+    const int steps = 2;
+    const unsigned long blockSize = 48000;
+    const long total = steps * blockSize;
+    std::vector<uint8_t> mem(ringSize);
+    SpscRing ring;
+    CHECK(ring.Init(mem.data(), ringSize));
+    FakeDma dma(steps, blockSize, 0);
+    long drained = -1;
+    std::thread panel([&]() {
+        SlidePump pump(steps, blockSize, STALL_MS);
+        PumpLink link = { RingSide::Yield, RingSide::Nothing, NULL };
+        drained = pump.Drain(ring, chunk, dma.SyncSink(), link);
+    });
+
+    SlidePump pump(steps, blockSize, STALL_MS);
+    PumpLink link = { RingSide::Yield, RingSide::Nothing, NULL };
+    long produced = 0;
+    long tapped = 0;
+    FakeStream first(0, cut, 0, 1460);
+    pump.Source(FakeStream::Callback, &first);
+    CHECK(!pump.Fill(ring, &produced, 0, link, RingSide::Tap, &tapped));
+    CHECK(pump.ended && produced == cut);
+    // a 206 continues at produced, a 200 starts over and is skipped
+    FakeStream second(range ? produced : 0, range ? total - produced : total, 0, 1460);
+    pump.Source(FakeStream::Callback, &second);
+    CHECK(pump.Fill(ring, &produced, range ? 0 : produced, link, RingSide::Tap, &tapped));
+    CHECK(produced == total && tapped == total);
+    ring.Close();
+    panel.join();
+    CHECK(drained == total);
+    CHECK(dma.Holds(0, total));
+    CHECK(dma.stepsStarted == steps);
+}
+
+static void Ring(void) {
+    printf("ring\n");
+    Random random(7);
+    size_t sizes[] = { 1024, 4096, 32768 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (int run = 0; run < 4; run++) {
+            long cut = random.Next() % 96000;
+            RingRun(sizes[i], 4096, cut, run % 2 == 0);
+        }
+    }
+}
+
+int main() {
+    WholeFrames();
+    ShortReads();
+    Stalls();
+    Truncation();
+    Resume();
+    Rows();
+    Ring();
+    printf("%s\n", failed ? "FAILED" : "all passed");
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */
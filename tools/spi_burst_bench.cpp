@@ -0,0 +1,151 @@
+/**
+ *  @filename   :   spi_burst_bench.cpp
+ *  @brief      :   Host count of CS toggles and bytes per SPI call for a
+ *                  frame upload, byte by byte and in bursts
+ *
+ *  Links the real epdif.cpp, epd_common.cpp and one driver against the
+ *  simulated bus in tools/host. Each panel step is uploaded three ways:
+ *  SendData() per byte as the sketch did before the burst API, SendBuffer()
+ *  in EPD_STREAM_BUFFER_SIZE chunks as DownloadAndDisplay() does now, and
+ *  the SpiTransferRepeat() fill Clear() uses. The bus counts what reaches
+ *  the pins; EPD_SPI_STATS counts the SpiTransfer* calls behind them.
+ *
+ *      g++ -O2 -std=c++11 -DEPD_SPI_STATS -Itools/host -IArduino/epd_epaperpix_wifi \
+ *          tools/spi_burst_bench.cpp tools/host/host_bus.cpp \
+ *          Arduino/epd_epaperpix_wifi/epdif.cpp Arduino/epd_epaperpix_wifi/epd_common.cpp \
+ *          Arduino/epd_epaperpix_wifi/epd7in5_V2.cpp -o spi_burst_bench
+ *      ./spi_burst_bench
+ *
+ *  For another panel add -DEPD7IN5_V2_C and its own macro and file, e.g.
+ *  -DEPD7IN3F_C .../epd7in3f.cpp. The exit code is 1 when the two uploads
+ *  send different bytes or a burst is split more than its chunks.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include "host_bus.h"
+#include "epd_base.h"
+
+#ifndef EPD_SPI_STATS
+#error "build with -DEPD_SPI_STATS"
+#endif
+
+static int failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("  FAILED line %d: %s\n", __LINE__, #cond); \
+            failed++; \
+        } \
+    } while (0)
+
+// running hash of the DC level and value of every byte on the wire
+static void HashByte(uint8_t data, bool dc, void* arg) {
+    uint64_t* h = (uint64_t*)arg;
+    *h = (*h ^ (data | (dc ? 0x100 : 0))) * 0x100000001B3ULL;
+}
+
+struct Upload {
+    uint64_t hash;
+    unsigned long bytes;
+    unsigned long calls;
+    unsigned long csToggles;
+    unsigned long maxBurst;
+    double wireMs;
+};
+
+static void Start(uint64_t* hash) {
+    *hash = 0xCBF29CE484222325ULL;
+    HostBus::Reset();
+    EpdIf::SpiStatsReset();
+    HostBus::onByte = HashByte;
+    HostBus::onByteArg = hash;
+}
+
+static Upload Finish(const char* label, uint64_t hash) {
+    Upload u;
+    u.hash = hash;
+    u.bytes = HostBus::bytes;
+    u.calls = EpdIf::spiStats.calls;
+    u.csToggles = HostBus::pins[CS_PIN].changes / 2;
+    u.maxBurst = HostBus::maxBurst;
+    u.wireMs = HostBus::wireNs / 1e6;
+    printf("%-10s %10lu %10lu %10lu %10.1f %10lu %10.2f\n", label, u.bytes, u.calls, u.csToggles,
+           u.calls ? (double)u.bytes / u.calls : 0.0, u.maxBurst, u.wireMs);
+    // the stats count the same transfers the pins saw
+    CHECK(EpdIf::spiStats.bytes == u.bytes);
+    CHECK(EpdIf::spiStats.csToggles == u.csToggles);
+    CHECK(HostBus::strayBytes == 0);
+    HostBus::onByte = NULL;
+    return u;
+}
+
+int main(void) {
+    HostBus::Reset();
+    Epd epd;
+    if (epd.Init() != 0) {
+        printf("Init failed\n");
+        return 1;
+    }
+    unsigned long block = epd.blockSize;
+    unsigned long chunk = epd.streamBufferSize;
+    uint8_t* frame = (uint8_t*)malloc(block);
+    uint32_t s = 2025;
+    for (unsigned long i = 0; i < block; i++) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        frame[i] = (uint8_t)s;
+    }
+    printf("%lux%lu, %d step(s) of %lu bytes, %lu byte chunks, SPI at %lu kHz\n",
+           epd.width, epd.height, epd.steps, block, chunk, EpdIf::spiClockHz / 1000);
+    printf("%-10s %10s %10s %10s %10s %10s %10s\n", "upload", "bytes", "calls", "CS toggles",
+           "bytes/call", "max burst", "wire ms");
+
+    uint64_t hash;
+    Start(&hash);
+    for (int step = 0; step < epd.steps; step++) {
+        epd.SendCommand(epd.stepCommands[step]);
+        for (unsigned long i = 0; i < block; i++) {
+            epd.SendData(frame[i]);
+        }
+    }
+    Upload perByte = Finish("per byte", hash);
+
+    Start(&hash);
+    for (int step = 0; step < epd.steps; step++) {
+        epd.SendCommand(epd.stepCommands[step]);
+        epd.SetToDataMode();
+        for (unsigned long i = 0; i < block; i += chunk) {
+            epd.SendBuffer(frame + i, (int)min(chunk, block - i));
+        }
+        epd.WaitBuffer();
+    }
+    Upload burst = Finish("burst", hash);
+
+    Start(&hash);
+    for (int step = 0; step < epd.steps; step++) {
+        epd.SendCommand(epd.stepCommands[step]);
+        epd.SetToDataMode();
+        EpdIf::SpiTransferRepeat(0xFF, block);
+    }
+    Upload fill = Finish("fill", hash);
+
+    unsigned long chunks = (block + chunk - 1) / chunk;
+    CHECK(burst.hash == perByte.hash);
+    CHECK(burst.bytes == perByte.bytes);
+    CHECK(perByte.csToggles == perByte.bytes);
+    // one CS toggle per command and per chunk, nothing more
+    CHECK(burst.csToggles == epd.steps * (1 + chunks));
+    CHECK(fill.csToggles == epd.steps * 2UL);
+    CHECK(fill.maxBurst == block);
+    printf("burst upload: %.0fx fewer CS toggles and SPI calls\n",
+           burst.csToggles ? (double)perByte.csToggles / burst.csToggles : 0.0);
+    free(frame);
+    if (failed) {
+        printf("%d checks failed\n", failed);
+    }
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */
@@ -0,0 +1,239 @@
+/**
+ *  @filename   :   spsc_ring_test.cpp
+ *  @brief      :   Stress test of the network-to-panel ring buffer
+ *
+ *  Runs Arduino/epd_epaperpix_wifi/spsc_ring.h on a PC. First the edges
+ *  on one thread: bad capacities, empty, full, the contiguous regions at
+ *  the wrap point, Close() and Drained(). Then a producer and a consumer
+ *  thread move a pseudo-random byte stream through rings of several
+ *  sizes in random chunks. They mix Write()/Read() with the
+ *  WritePtr()/Commit() and ReadPtr()/Consume() calls the sketch uses.
+ *  The consumer checks every byte against the same generator and
+ *  throughput is printed.
+ *
+ *      g++ -O2 -std=c++11 -pthread -IArduino/epd_epaperpix_wifi \
+ *          tools/spsc_ring_test.cpp -o spsc_ring_test
+ *      ./spsc_ring_test [megabytes per run]
+ *
+ *  Build with -fsanitize=thread as well to have the orderings checked.
+ *  The exit code is 1 when a check fails.
+ *
+ *  MIT License, Copyright (c) 2025 EpaperPix
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "spsc_ring.h"
+
+static int failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("  FAILED line %d: %s\n", __LINE__, #cond); \
+            failed++; \
+        } \
+    } while (0)
+
+// byte n of the test stream, the same on both sides
+static uint8_t StreamByte(uint64_t n) {
+    uint64_t x = (n + 1) * 0x9E3779B97F4A7C15ULL;
+    x ^= x >> 29;
+    return (uint8_t)(x * 0xBF58476D1CE4E5B9ULL >> 56);
+}
+
+// small xorshift, each thread has its own
+struct Random {
+    uint32_t s;
+    explicit Random(uint32_t seed) : s(seed ? seed : 1) {}
+    uint32_t Next(void) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        return s;
+    }
+    // 1..max, small chunks more often than large ones
+    size_t Chunk(size_t max) {
+        size_t n = Next() % 4 == 0 ? Next() % max : Next() % (max < 16 ? max : 16);
+        return n + 1;
+    }
+};
+
+static void Edges(void) {
+    printf("edges\n");
+    uint8_t store[16];
+    SpscRing ring;
+    CHECK(!ring.Init(NULL, 16));
+    CHECK(!ring.Init(store, 0));
+    CHECK(!ring.Init(store, 12));
+    CHECK(ring.Init(store, 16));
+    CHECK(ring.Capacity() == 16);
+
+    // empty
+    size_t n;
+    CHECK(ring.Available() == 0);
+    CHECK(ring.Space() == 16);
+    ring.ReadPtr(&n);
+    CHECK(n == 0);
+    uint8_t out[32];
+    CHECK(ring.Read(out, sizeof(out)) == 0);
+    CHECK(!ring.Drained());
+
+    // full: a write larger than the ring takes what fits
+    uint8_t in[32];
+    for (int i = 0; i < 32; i++) {
+        in[i] = (uint8_t)i;
+    }
+    CHECK(ring.Write(in, 20) == 16);
+    CHECK(ring.Available() == 16);
+    CHECK(ring.Space() == 0);
+    ring.WritePtr(&n);
+    CHECK(n == 0);
+    CHECK(ring.Write(in, 1) == 0);
+
+    // wrap: 10 out, then the free region runs to the end only
+    CHECK(ring.Read(out, 10) == 10);
+    for (int i = 0; i < 10; i++) {
+        CHECK(out[i] == i);
+    }
+    uint8_t* w = ring.WritePtr(&n);
+    CHECK(n == 10 && w == store);
+    CHECK(ring.Write(in + 16, 10) == 10);
+    CHECK(ring.Space() == 0);
+    const uint8_t* r = ring.ReadPtr(&n);
+    CHECK(n == 6 && r == store + 10);
+    CHECK(ring.Read(out, 16) == 16);
+    for (int i = 0; i < 16; i++) {
+        CHECK(out[i] == 10 + i);
+    }
+    CHECK(ring.Available() == 0);
+
+    // the contiguous write region stops at the end of the storage
+    ring.Reset();
+    CHECK(ring.Write(in, 12) == 12);
+    CHECK(ring.Read(out, 12) == 12);
+    w = ring.WritePtr(&n);
+    CHECK(n == 4 && w == store + 12);
+    ring.Commit(4);
+    w = ring.WritePtr(&n);
+    CHECK(n == 12 && w == store);
+
+    // closed: drained only once empty
+    ring.Close();
+    CHECK(!ring.Drained());
+    CHECK(ring.Read(out, 8) == 4);
+    CHECK(ring.Drained());
+    ring.Reset();
+    CHECK(!ring.Drained() && ring.Space() == 16);
+}
+
+struct RunResult {
+    uint64_t bytes;
+    double seconds;
+    uint64_t mismatches;
+    uint64_t fullWaits;
+    uint64_t emptyWaits;
+};
+
+static RunResult Run(size_t capacity, uint64_t total, uint32_t seed) {
+    std::vector<uint8_t> store(capacity);
+    SpscRing ring;
+    ring.Init(store.data(), capacity);
+    RunResult res = { 0, 0, 0, 0, 0 };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        Random rnd(seed);
+        std::vector<uint8_t> chunk(capacity * 2);
+        uint64_t sent = 0;
+        while (sent < total) {
+            size_t want = rnd.Chunk(capacity * 2);
+            if (want > total - sent) {
+                want = (size_t)(total - sent);
+            }
+            size_t n;
+            if (rnd.Next() & 1) {
+                // in place, as StreamToRing() does
+                uint8_t* dst = ring.WritePtr(&n);
+                n = n < want ? n : want;
+                for (size_t i = 0; i < n; i++) {
+                    dst[i] = StreamByte(sent + i);
+                }
+                if (n) {
+                    ring.Commit(n);
+                }
+            } else {
+                for (size_t i = 0; i < want; i++) {
+                    chunk[i] = StreamByte(sent + i);
+                }
+                n = ring.Write(chunk.data(), want);
+            }
+            if (n == 0) {
+                res.fullWaits++;
+                std::this_thread::yield();
+            }
+            sent += n;
+        }
+        ring.Close();
+    });
+
+    Random rnd(seed * 7 + 1);
+    std::vector<uint8_t> chunk(capacity * 2);
+    uint64_t got = 0;
+    while (!ring.Drained()) {
+        size_t want = rnd.Chunk(capacity * 2);
+        size_t n;
+        if (rnd.Next() & 1) {
+            // in place, as the panel task does
+            const uint8_t* src = ring.ReadPtr(&n);
+            n = n < want ? n : want;
+            for (size_t i = 0; i < n; i++) {
+                res.mismatches += src[i] != StreamByte(got + i);
+            }
+            if (n) {
+                ring.Consume(n);
+            }
+        } else {
+            n = ring.Read(chunk.data(), want);
+            for (size_t i = 0; i < n; i++) {
+                res.mismatches += chunk[i] != StreamByte(got + i);
+            }
+        }
+        if (n == 0) {
+            res.emptyWaits++;
+            std::this_thread::yield();
+        }
+        got += n;
+    }
+    producer.join();
+    res.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    res.bytes = got;
+    return res;
+}
+
+int main(int argc, char** argv) {
+    uint64_t total = (argc > 1 ? strtoull(argv[1], NULL, 10) : 64) << 20;
+    Edges();
+
+    static const size_t capacities[] = { 16, 256, 4096, 32768 };
+    printf("%-10s %10s %10s %10s %12s %12s\n", "capacity", "MB", "MB/s", "bad bytes", "full waits", "empty waits");
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++) {
+        size_t cap = capacities[i];
+        // tiny rings wrap on nearly every call, fewer bytes do
+        uint64_t bytes = cap < 4096 ? total / 8 : total;
+        RunResult r = Run(cap, bytes, 2025 + (uint32_t)i);
+        printf("%-10zu %10.1f %10.1f %10llu %12llu %12llu\n", cap, r.bytes / 1048576.0,
+               r.bytes / 1048576.0 / r.seconds, (unsigned long long)r.mismatches,
+               (unsigned long long)r.fullWaits, (unsigned long long)r.emptyWaits);
+        CHECK(r.bytes == bytes);
+        CHECK(r.mismatches == 0);
+    }
+    if (failed) {
+        printf("%d checks failed\n", failed);
+    }
+    return failed ? 1 : 0;
+}
+
+/* END OF FILE */